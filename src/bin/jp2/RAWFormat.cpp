@@ -56,12 +56,60 @@
 
 #include <cstdio>
 #include <cstdlib>
+#include <vector>
 #include "grk_apps_config.h"
 #include "grok.h"
 #include "RAWFormat.h"
 #include "convert.h"
 #include "common.h"
 
+bool RAWFormat::encodePacked(grk_image *  image, const char* filename, bool verbose) {
+	auto comp = image->comps;
+	bool wide = comp->prec > 8;
+	uint64_t row_len = (uint64_t)comp->w << (wide ? 1 : 0);
+	uint64_t num_rows = (uint64_t)comp->h * image->numcomps;
+	if (!image->packed_data || !row_len || !num_rows) {
+		spdlog::error("invalid packed raw image parameters");
+		return false;
+	}
+	bool writeToStdout = grk::useStdio(filename);
+	FILE *rawFile = nullptr;
+	if (writeToStdout) {
+		if (!grok_set_binary_mode(stdout))
+			return false;
+		rawFile = stdout;
+	}
+	else {
+		rawFile = fopen(filename, "wb");
+		if (!rawFile) {
+			spdlog::error("Failed to open {} for writing !!\n", filename);
+			return false;
+		}
+	}
+	if (verbose)
+		spdlog::info("Raw image characteristics: {} components {}x{}x{} {}\n",
+			image->numcomps, comp->w, comp->h, comp->prec, comp->sgnd ? "signed" : "unsigned");
+
+	bool rc = true;
+	std::vector<uint16_t> swapped(wide ? comp->w : 0);
+	for (uint64_t r = 0; rc && r < num_rows; ++r) {
+		auto row = image->packed_data + r * image->packed_stride;
+		if (wide) {
+			auto src = (const uint16_t*)row;
+			for (uint32_t i = 0; i < comp->w; ++i)
+				swapped[i] = grk::endian<uint16_t>(src[i], bigEndian);
+			row = (uint8_t*)swapped.data();
+		}
+		rc = fwrite(row, 1, row_len, rawFile) == row_len;
+	}
+	if (!rc)
+		spdlog::error("failed to write bytes for {}\n", filename);
+	if (!writeToStdout && !grk::safe_fclose(rawFile))
+		rc = false;
+
+	return rc;
+}
+
 bool RAWFormat::encode(grk_image *  image, const char* filename, int compressionParam, bool verbose) {
 	(void)compressionParam;
 	return imagetoraw(image, filename, bigEndian,verbose) ? true : false;
@@ -23,6 +23,11 @@ public:
 	RAWFormat(bool isBig) : bigEndian(isBig) {}
 	virtual ~RAWFormat() {}
 	bool encode(grk_image *  image, const char* filename, int compressionParam, bool verbose);
+	/**
+	 * Write the planar samples that the decoder packed to
+	 * grk_image::packed_data, which must be 8 or 16 bit samples
+	 */
+	bool encodePacked(grk_image *  image, const char* filename, bool verbose);
 	grk_image *  decode(const char* filename,  grk_cparameters  *parameters);
 private:
 	bool bigEndian;
@@ -253,10 +253,12 @@ static void encode_help_display(void)
     fprintf(stdout,"    Different psnr for successive layers (-q 30,40,50).\n");
     fprintf(stdout,"    Increasing PSNR values required.\n");
     fprintf(stdout,"    Options -r and -q cannot be used together.\n");
-	fprintf(stdout, "[-A|-RateControlAlgorithm] <0|1>\n");
+	fprintf(stdout, "[-A|-RateControlAlgorithm] <0|1|2>\n");
 	fprintf(stdout, "    Select algorithm used for rate control\n");
 	fprintf(stdout, "    0: Bisection search for optimal threshold using all code passes in code blocks. (default) (slightly higher PSRN than algorithm 1)\n");
 	fprintf(stdout, "    1: Bisection search for optimal threshold using only feasible truncation points, on convex hull.\n");
+	fprintf(stdout, "    2: As 1, but layer sizes are looked up in a table of feasible truncation points and packet headers are estimated,\n");
+	fprintf(stdout, "       so that packet headers are only encoded to verify the estimate. Faster for many layers.\n");
     fprintf(stdout,"[-n|-Resolutions] <number of resolutions>\n");
     fprintf(stdout,"    Number of resolutions.\n");
     fprintf(stdout,"    It corresponds to the number of DWT decompositions +1. \n");
@@ -295,6 +297,12 @@ static void encode_help_display(void)
     fprintf(stdout,"    Write SOP marker before each packet.\n");
     fprintf(stdout,"[-E|-EPH]\n");
     fprintf(stdout,"    Write EPH marker after each header packet.\n");
+    fprintf(stdout,"[-L|-PLT]\n");
+    fprintf(stdout,"    Write PLT markers (packet lengths) in each tile part header.\n");
+    fprintf(stdout,"    Decoders can then skip the packets they do not need.\n");
+    fprintf(stdout,"[-X|-TLM]\n");
+    fprintf(stdout,"    Write TLM markers (tile part lengths) in the main header.\n");
+    fprintf(stdout,"    Decoders can then locate a tile without reading the tiles before it.\n");
     fprintf(stdout,"[-M|-Mode] <key value>\n");
     fprintf(stdout,"    Mode switch.\n");
     fprintf(stdout,"    [1=BYPASS(LAZY) 2=RESET 4=RESTART(TERMALL)\n");
@@ -361,6 +369,9 @@ static void encode_help_display(void)
 	fprintf(stdout, "    Path to T1 plugin.\n");
 	fprintf(stdout, "[-H|-NumThreads] <number of threads>\n");
 	fprintf(stdout, "    Number of threads to use for T1.\n");
+	fprintf(stdout, "[-j|-TilesInFlight] <number of tiles>\n");
+	fprintf(stdout, "    Maximum number of tiles encoded concurrently. Default: number of threads.\n");
+	fprintf(stdout, "    A value of 1 encodes one tile at a time, which minimizes memory usage.\n");
 	fprintf(stdout, "[-G|-DeviceId] <device ID>\n");
 	fprintf(stdout, "    (GPU) Specify which GPU accelerator to run codec on.\n");
 	fprintf(stdout, "    A value of -1 will specify all devices.\n");
@@ -554,6 +565,9 @@ static int parse_cmdline_encoder_ex(int argc,
 		ValueArg<uint32_t> numThreadsArg("H", "NumThreads",
 									"Number of threads",
 									false, 8, "unsigned integer", cmd);
+		ValueArg<uint32_t> tilesInFlightArg("j", "TilesInFlight",
+									"Maximum number of tiles encoded concurrently",
+									false, 0, "unsigned integer", cmd);
 
 		ValueArg<int32_t> deviceIdArg("G", "DeviceId",
 			"Device ID",
@@ -580,6 +594,12 @@ static int parse_cmdline_encoder_ex(int argc,
 		SwitchArg ephArg("E", "EPH",
 						"Add EPH markers", cmd);
 
+		SwitchArg pltArg("L", "PLT",
+						"Add PLT markers", cmd);
+
+		SwitchArg tlmArg("X", "TLM",
+						"Add TLM markers", cmd);
+
 		ValueArg<char> tpArg("u", "TP",
 									"Tile part generation",
 									false, 0, "char", cmd);
@@ -703,6 +723,10 @@ static int parse_cmdline_encoder_ex(int argc,
 			parameters->numThreads = numThreadsArg.getValue();
 		}
 
+		if (tilesInFlightArg.isSet()) {
+			parameters->max_tiles_in_flight = tilesInFlightArg.getValue();
+		}
+
 		if (deviceIdArg.isSet()) {
 			parameters->deviceId = deviceIdArg.getValue();
 		}
@@ -1071,6 +1095,14 @@ static int parse_cmdline_encoder_ex(int argc,
 			parameters->csty |= 0x04;
 		}
 
+		if (pltArg.isSet()) {
+			parameters->write_plt = true;
+		}
+
+		if (tlmArg.isSet()) {
+			parameters->write_tlm = true;
+		}
+
 		if (irreversibleArg.isSet()) {
 			parameters->irreversible = true;
 		}
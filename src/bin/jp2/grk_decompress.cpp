@@ -218,6 +218,9 @@ static void decode_help_display(void)
 		"    Path to T1 plugin.\n");
 	fprintf(stdout, "  [-H | -NumThreads] <number of threads>\n"
 		"    Number of threads used by T1 decode.\n");
+	fprintf(stdout, "  [-T | -TilesInFlight] <number of tiles>\n"
+		"    Maximum number of tiles decoded concurrently. Default: number of threads.\n"
+		"    A value of 1 decodes one tile at a time, which minimizes memory usage.\n");
 	fprintf(stdout, "  [-c|-Compression] <compression>\n"
 		"    Compress output image data.Currently, this flag is only applicable when output format is set to `TIF`,\n"
 		"    and the only currently supported value is 8, corresponding to COMPRESSION_ADOBE_DEFLATE i.e.zip compression.\n"
@@ -251,6 +254,10 @@ static void decode_help_display(void)
             "    components will be upsampled to image size\n"
 			"  [-s | -split-pnm]\n"
             "    Split output components to different files when writing to PNM\n"
+			"  [-P | -packed-raw]\n"
+            "    Decode RAW and RAWL output straight to 8 or 16 bit samples, without\n"
+            "    32 bit component buffers, when there is no colour conversion, precision\n"
+            "    change or upsampling to apply and all components are alike\n"
 			"  [-c | -compression]\n"
 			"    Compression format for output file. Currently, only zip is supported for TIFF output (set parameter to 8)\n");
 	fprintf(stdout, "  [-X | -XML]\n"
@@ -465,12 +472,17 @@ int parse_cmdline_decoder(int argc,
 								"Upsample", cmd);
 		SwitchArg splitPnmArg("s", "split-pnm",
 								"Split PNM", cmd);
+		SwitchArg packedRawArg("P", "packed-raw",
+								"Packed RAW", cmd);
 		ValueArg<string> pluginPathArg("g", "PluginPath",
 										"Plugin path", 
 										false, "", "string",cmd);
 		ValueArg<uint32_t> numThreadsArg("H", "NumThreads", 
 										"Number of threads",
 										false, 8, "unsigned integer",cmd);
+		ValueArg<uint32_t> tilesInFlightArg("T", "TilesInFlight",
+										"Maximum number of tiles decoded concurrently",
+										false, 0, "unsigned integer",cmd);
 		ValueArg<string> inputFileArg("i", "InputFile", 
 										"Input file", 
 										false, "", "string",cmd);
@@ -543,6 +555,9 @@ int parse_cmdline_decoder(int argc,
 		if (splitPnmArg.isSet()) {
 			parameters->split_pnm = true;
 		}
+		if (packedRawArg.isSet()) {
+			parameters->packed_raw = true;
+		}
 		if (compressionArg.isSet()) {
 			parameters->compression = compressionArg.getValue();
 		}
@@ -694,6 +709,9 @@ int parse_cmdline_decoder(int argc,
 		if (numThreadsArg.isSet()) {
 			parameters->numThreads = numThreadsArg.getValue();
 		}
+		if (tilesInFlightArg.isSet()) {
+			parameters->core.max_tiles_in_flight = tilesInFlightArg.getValue();
+		}
 
 		if (decodeRegionArg.isSet()) {
 			size_t size_optarg = (size_t)strlen(decodeRegionArg.getValue().c_str()) + 1U;
@@ -1342,6 +1360,38 @@ int decode_callback(grk_plugin_decode_callback_info* info) {
 enum grk_stream_type {GRK_FILE_STREAM,
 							GRK_MAPPED_FILE_STREAM };
 
+/*
+Check whether RAW or RAWL output can be written straight from samples packed
+by the decoder: post_decode must have nothing to convert, and all components
+must have the same size, precision and sign
+*/
+static bool can_pack_raw(grk_image *image, grk_decompress_parameters *parameters, int cod_format) {
+	if (cod_format != RAW_DFMT && cod_format != RAWL_DFMT)
+		return false;
+	if (parameters->precision || parameters->upsample || parameters->force_rgb)
+		return false;
+	switch (image->color_space) {
+	case GRK_CLRSPC_SYCC:
+	case GRK_CLRSPC_EYCC:
+	case GRK_CLRSPC_CMYK:
+	case GRK_CLRSPC_DEFAULT_CIE:
+	case GRK_CLRSPC_CUSTOM_CIE:
+		return false;
+	default:
+		break;
+	}
+	if (image->icc_profile_buf)
+		return false;
+	auto comp0 = image->comps;
+	for (uint32_t compno = 0; compno < image->numcomps; ++compno) {
+		auto comp = image->comps + compno;
+		if (comp->dx != 1 || comp->dy != 1 || comp->prec != comp0->prec
+				|| comp->sgnd != comp0->sgnd || comp->prec > 16)
+			return false;
+	}
+	return true;
+}
+
 // return: 0 for success, non-zero for failure
 int pre_decode(grk_plugin_decode_callback_info* info) {
 	if (!info)
@@ -1454,6 +1504,21 @@ int pre_decode(grk_plugin_decode_callback_info* info) {
 		goto cleanup;
 	}
 
+	if (parameters->packed_raw) {
+		int cod_format = info->cod_format != UNKNOWN_FORMAT ? info->cod_format : parameters->cod_format;
+		if (can_pack_raw(info->image, parameters, cod_format)) {
+			GRK_SAMPLE_TYPE sample_type = info->image->comps[0].prec > 8 ?
+					GRK_SAMPLE_UINT16 : GRK_SAMPLE_UINT8;
+			if (!grk_set_output_format(info->l_codec, sample_type, false, 0, nullptr, 0)) {
+				spdlog::error( "grk_decompress: failed to set the output format");
+				failed = 1;
+				goto cleanup;
+			}
+		} else if (parameters->verbose) {
+			spdlog::warn("grk_decompress: output can't be packed by the decoder; decoding to component buffers");
+		}
+	}
+
 	// decode all tiles
 	if (!parameters->nb_tile_to_decode) {
 		if (!(grk_decode(info->l_codec,info->tile, info->image) && grk_end_decompress(info->l_codec))) {
@@ -1514,6 +1579,16 @@ int post_decode(grk_plugin_decode_callback_info* info) {
 	GROK_SUPPORTED_FILE_FORMAT cod_format =
 			(GROK_SUPPORTED_FILE_FORMAT)(info->cod_format != UNKNOWN_FORMAT ? info->cod_format : parameters->cod_format);
 
+	// samples packed by the decoder are written as they are
+	if (image->packed_data) {
+		RAWFormat raw(cod_format == RAW_DFMT);
+		if (store_file_to_disk && !raw.encodePacked(image, outfile, parameters->verbose)) {
+			spdlog::error( "Error generating raw file. Outfile {} not generated\n", outfile);
+			failed = 1;
+		}
+		goto cleanup;
+	}
+
 	if (image->color_space != GRK_CLRSPC_SYCC
 		&& image->numcomps == 3 && image->comps[0].dx == image->comps[0].dy
 		&& image->comps[1].dx != 1)
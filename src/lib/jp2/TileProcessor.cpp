@@ -66,6 +66,23 @@ namespace grk {
 
 
 
+// code blocks claimed at a time by each worker during rate control,
+// where the work per code block is small
+static size_t rate_grain(size_t num_blocks) {
+	return std::max<size_t>(1,
+			num_blocks / (Scheduler::g_tp->num_threads() * 16));
+}
+
+// distortion of a layer, summed in code block order, so that it does
+// not depend on how the code blocks were scheduled
+static double layer_disto(const std::vector<grk_rate_block> &blocks,
+		uint32_t layno) {
+	double disto = 0;
+	for (auto &block : blocks)
+		disto += block.cblk->layers[layno].disto;
+	return disto;
+}
+
 /*
  if
  - r xx, yy, zz, 0   (disto_alloc == 1 and rates == 0)
@@ -104,91 +121,107 @@ bool TileProcessor::make_single_lossless_layer() {
 	return false;
 }
 
-void TileProcessor::makelayer_feasible(uint32_t layno, uint16_t thresh,
-		bool final) {
-	uint32_t compno, resno, bandno, precno, cblkno;
-	uint32_t passno;
-	auto tcd_tile = tile;
-	tcd_tile->distolayer[layno] = 0;
-	for (compno = 0; compno < tcd_tile->numcomps; compno++) {
-		auto tilec = tcd_tile->comps + compno;
-		for (resno = 0; resno < tilec->numresolutions; resno++) {
-			auto res = tilec->resolutions + resno;
-			for (bandno = 0; bandno < res->numbands; bandno++) {
-				auto band = res->bands + bandno;
-
-				for (precno = 0; precno < res->pw * res->ph; precno++) {
-					auto prc = band->precincts + precno;
-
-					for (cblkno = 0; cblkno < prc->cw * prc->ch; cblkno++) {
-						auto cblk = prc->cblks.enc + cblkno;
-						auto layer = cblk->layers + layno;
-						uint32_t cumulative_included_passes_in_block;
+double TileProcessor::prepare_rate_blocks(bool single_lossless,
+		const std::function<void(size_t)> &f) {
+	uint32_t state = grok_plugin_get_debug_state();
+	std::vector<uint32_t> numpix(rate_blocks.size());
+	for (size_t index = 0; index < rate_blocks.size(); ++index) {
+		auto cblk = rate_blocks[index].cblk;
+		numpix[index] = (cblk->x1 - cblk->x0) * (cblk->y1 - cblk->y0);
+	}
+	// the plugin bridge is not reentrant, so the code blocks are
+	// synchronized with the plugin serially, before f runs concurrently
+	if (current_plugin_tile && !(state & GROK_PLUGIN_STATE_PRE_TR1)) {
+		for (size_t index = 0; index < rate_blocks.size(); ++index) {
+			auto &block = rate_blocks[index];
+			encode_synch_with_plugin(this, block.compno, block.resno,
+					block.bandno, block.precno, block.cblkno, block.band,
+					block.cblk, &numpix[index]);
+		}
+	}
+	if (!single_lossless)
+		Scheduler::g_tp->parallel_for(rate_blocks.size(),
+				rate_grain(rate_blocks.size()), f);
 
-						if (layno == 0) {
-							cblk->num_passes_included_in_previous_layers = 0;
-						}
+	double maxSE = 0;
+	tile->numpix = 0;
+	for (uint32_t compno = 0; compno < tile->numcomps; compno++)
+		tile->comps[compno].numpix = 0;
+	if (single_lossless)
+		return maxSE;
+	for (size_t i = 0; i < rate_blocks.size(); ++i) {
+		tile->numpix += numpix[i];
+		tile->comps[rate_blocks[i].compno].numpix += numpix[i];
+	}
+	for (uint32_t compno = 0; compno < tile->numcomps; compno++) {
+		auto tilec = tile->comps + compno;
+		maxSE += (double) (((uint64_t) 1 << image->comps[compno].prec) - 1)
+				* (double) (((uint64_t) 1 << image->comps[compno].prec) - 1)
+				* (double) tilec->numpix;
+	}
+	return maxSE;
+}
 
-						cumulative_included_passes_in_block =
-								cblk->num_passes_included_in_previous_layers;
+void TileProcessor::makelayer_feasible(uint32_t layno, uint16_t thresh,
+		bool final) {
+	Scheduler::g_tp->parallel_for(rate_blocks.size(),
+			rate_grain(rate_blocks.size()),
+			[this, layno, thresh, final](size_t index) {
+		auto cblk = rate_blocks[index].cblk;
+		auto layer = cblk->layers + layno;
+		uint32_t cumulative_included_passes_in_block;
+
+		if (layno == 0) {
+			cblk->num_passes_included_in_previous_layers = 0;
+		}
 
-						for (passno =
-								cblk->num_passes_included_in_previous_layers;
-								passno < cblk->num_passes_encoded; passno++) {
-							auto pass = &cblk->passes[passno];
+		cumulative_included_passes_in_block =
+				cblk->num_passes_included_in_previous_layers;
 
-							//truncate or include feasible, otherwise ignore
-							if (pass->slope) {
-								if (pass->slope <= thresh)
-									break;
-								cumulative_included_passes_in_block = passno
-										+ 1;
-							}
-						}
+		for (uint32_t passno = cblk->num_passes_included_in_previous_layers;
+				passno < cblk->num_passes_encoded; passno++) {
+			auto pass = &cblk->passes[passno];
 
-						layer->numpasses = cumulative_included_passes_in_block
-								- cblk->num_passes_included_in_previous_layers;
+			//truncate or include feasible, otherwise ignore
+			if (pass->slope) {
+				if (pass->slope <= thresh)
+					break;
+				cumulative_included_passes_in_block = passno + 1;
+			}
+		}
 
-						if (!layer->numpasses) {
-							layer->disto = 0;
-							continue;
-						}
+		layer->numpasses = cumulative_included_passes_in_block
+				- cblk->num_passes_included_in_previous_layers;
 
-						// update layer
-						if (cblk->num_passes_included_in_previous_layers == 0) {
-							layer->len =
-									cblk->passes[cumulative_included_passes_in_block
-											- 1].rate;
-							layer->data = cblk->data;
-							layer->disto =
-									cblk->passes[cumulative_included_passes_in_block
-											- 1].distortiondec;
-						} else {
-							layer->len =
-									cblk->passes[cumulative_included_passes_in_block
-											- 1].rate
-											- cblk->passes[cblk->num_passes_included_in_previous_layers
-													- 1].rate;
-							layer->data =
-									cblk->data
-											+ cblk->passes[cblk->num_passes_included_in_previous_layers
-													- 1].rate;
-							layer->disto =
-									cblk->passes[cumulative_included_passes_in_block
-											- 1].distortiondec
-											- cblk->passes[cblk->num_passes_included_in_previous_layers
-													- 1].distortiondec;
-						}
+		if (!layer->numpasses) {
+			layer->disto = 0;
+			return;
+		}
 
-						tcd_tile->distolayer[layno] += layer->disto;
-						if (final)
-							cblk->num_passes_included_in_previous_layers =
-									cumulative_included_passes_in_block;
-					}
-				}
-			}
+		// update layer
+		if (cblk->num_passes_included_in_previous_layers == 0) {
+			layer->len = cblk->passes[cumulative_included_passes_in_block - 1].rate;
+			layer->data = cblk->data;
+			layer->disto =
+					cblk->passes[cumulative_included_passes_in_block - 1].distortiondec;
+		} else {
+			layer->len = cblk->passes[cumulative_included_passes_in_block - 1].rate
+					- cblk->passes[cblk->num_passes_included_in_previous_layers
+							- 1].rate;
+			layer->data = cblk->data
+					+ cblk->passes[cblk->num_passes_included_in_previous_layers
+							- 1].rate;
+			layer->disto =
+					cblk->passes[cumulative_included_passes_in_block - 1].distortiondec
+							- cblk->passes[cblk->num_passes_included_in_previous_layers
+									- 1].distortiondec;
 		}
-	}
+
+		if (final)
+			cblk->num_passes_included_in_previous_layers =
+					cumulative_included_passes_in_block;
+	});
+	tile->distolayer[layno] = layer_disto(rate_blocks, layno);
 }
 
 /*
@@ -200,63 +233,24 @@ bool TileProcessor::pcrd_bisect_feasible(uint64_t *p_data_written,
 	bool single_lossless = make_single_lossless_layer();
 	double cumdisto[100];
 	const double K = 1;
-	double maxSE = 0;
 
 	auto tcd_tile = tile;
 	auto tcd_tcp = m_tcp;
 
-	tcd_tile->numpix = 0;
-	uint32_t state = grok_plugin_get_debug_state();
-
-	RateInfo rateInfo;
-	for (uint32_t compno = 0; compno < tcd_tile->numcomps; compno++) {
-		auto tilec = &tcd_tile->comps[compno];
-		tilec->numpix = 0;
-		for (uint32_t resno = 0; resno < tilec->numresolutions; resno++) {
-			auto res = &tilec->resolutions[resno];
-
-			for (uint32_t bandno = 0; bandno < res->numbands; bandno++) {
-				auto band = &res->bands[bandno];
-
-				for (uint32_t precno = 0; precno < res->pw * res->ph;
-						precno++) {
-					auto prc = &band->precincts[precno];
-					for (uint32_t cblkno = 0; cblkno < prc->cw * prc->ch;
-							cblkno++) {
-						auto cblk = &prc->cblks.enc[cblkno];
-						uint32_t numPix = ((cblk->x1 - cblk->x0)
-								* (cblk->y1 - cblk->y0));
-						if (!(state & GROK_PLUGIN_STATE_PRE_TR1)) {
-							encode_synch_with_plugin(this,compno, resno, bandno,
-									precno, cblkno, band, cblk, &numPix);
-						}
-
-						if (!single_lossless) {
-							RateControl::convexHull(cblk->passes,
-									cblk->num_passes_encoded);
-							rateInfo.synch(cblk);
-
-							tcd_tile->numpix += numPix;
-							tilec->numpix += numPix;
-						}
-					} /* cbklno */
-				} /* precno */
-			} /* bandno */
-		} /* resno */
-
-		if (!single_lossless) {
-			maxSE += (double) (((uint64_t) 1 << image->comps[compno].prec)
-					- 1)
-					* (double) (((uint64_t) 1 << image->comps[compno].prec)
-							- 1) * (double) tilec->numpix;
-		}
-	} /* compno */
+	double maxSE = prepare_rate_blocks(single_lossless, [this](size_t index) {
+		auto cblk = rate_blocks[index].cblk;
+		RateControl::convexHull(cblk->passes, cblk->num_passes_encoded);
+	});
 
 	if (single_lossless) {
 		makelayer_final( 0);
 		return true;
 	}
 
+	RateInfo rateInfo;
+	for (auto &block : rate_blocks)
+		rateInfo.synch(block.cblk);
+
 	uint32_t min_slope = rateInfo.getMinimumThresh();
 	uint32_t max_slope = USHRT_MAX;
 
@@ -329,93 +323,317 @@ bool TileProcessor::pcrd_bisect_feasible(uint64_t *p_data_written,
 }
 
 /*
- Simple bisect algorithm to calculate optimal layer truncation points
+ Rate control with feasible truncation points, without a T2 simulation
+ for every bisection step.
+
+ The feasible truncation points of all code blocks are merged into one
+ table, sorted by decreasing slope, of cumulative rate and distortion,
+ so that the code block data and the distortion of the layers for any
+ threshold are found by a binary search. Packet header sizes are
+ estimated from the number of code blocks that contribute to a layer,
+ at a cost per block that is calibrated against T2. T2 only verifies
+ the thresholds that the estimate picks: the first few are refined
+ with the calibrated estimate, after which the search falls back to
+ plain bisection between the verified bounds.
  */
-bool TileProcessor::pcrd_bisect_simple(uint64_t *p_data_written, uint64_t len) {
-	uint32_t compno, resno, bandno, precno, cblkno, layno;
-	uint32_t passno;
-	double cumdisto[100];
+bool TileProcessor::pcrd_incremental(uint64_t *p_data_written, uint64_t len) {
+
+	bool single_lossless = make_single_lossless_layer();
 	const double K = 1;
-	double maxSE = 0;
 
-	double min_slope = DBL_MAX;
-	double max_slope = -1;
+	auto tcd_tile = tile;
+	auto tcd_tcp = m_tcp;
 
-	tile->numpix = 0;
-	uint32_t state = grok_plugin_get_debug_state();
+	double maxSE = prepare_rate_blocks(single_lossless, [this](size_t index) {
+		auto cblk = rate_blocks[index].cblk;
+		RateControl::convexHull(cblk->passes, cblk->num_passes_encoded);
+	});
 
-	bool single_lossless = make_single_lossless_layer();
+	if (single_lossless) {
+		makelayer_final( 0);
+		return true;
+	}
 
-	for (compno = 0; compno < tile->numcomps; compno++) {
-		auto tilec = &tile->comps[compno];
-		tilec->numpix = 0;
-		for (resno = 0; resno < tilec->numresolutions; resno++) {
+	struct FeasiblePoint {
+		uint16_t slope;
+		// rate and distortion decrease added by this point
+		uint64_t rate;
+		double disto;
+	};
+	struct BlockPoints {
+		uint32_t begin;
+		uint32_t end;
+		// first point not included in previous layers
+		uint32_t next;
+	};
+	std::vector<FeasiblePoint> points;
+	std::vector<BlockPoints> blocks;
+	for (auto &rate_block : rate_blocks) {
+		auto cblk = rate_block.cblk;
+		BlockPoints block;
+		block.begin = (uint32_t) points.size();
+		uint64_t rate = 0;
+		double disto = 0;
+		for (uint32_t passno = 0; passno < cblk->num_passes_encoded;
+				passno++) {
+			auto pass = &cblk->passes[passno];
+			if (!pass->slope)
+				continue;
+			points.push_back( { pass->slope, pass->rate - rate,
+					pass->distortiondec - disto });
+			rate = pass->rate;
+			disto = pass->distortiondec;
+		}
+		block.end = (uint32_t) points.size();
+		block.next = block.begin;
+		blocks.push_back(block);
+	}
+	uint64_t num_packets = 0;
+	for (uint32_t compno = 0; compno < tcd_tile->numcomps; compno++) {
+		auto tilec = &tcd_tile->comps[compno];
+		for (uint32_t resno = 0; resno < tilec->numresolutions; resno++) {
 			auto res = &tilec->resolutions[resno];
-			for (bandno = 0; bandno < res->numbands; bandno++) {
-				auto band = &res->bands[bandno];
-				for (precno = 0; precno < res->pw * res->ph; precno++) {
-					auto prc = &band->precincts[precno];
-					for (cblkno = 0; cblkno < prc->cw * prc->ch; cblkno++) {
-						auto cblk = &prc->cblks.enc[cblkno];
-						uint32_t numPix = ((cblk->x1 - cblk->x0)
-								* (cblk->y1 - cblk->y0));
-						if (!(state & GROK_PLUGIN_STATE_PRE_TR1)) {
-							encode_synch_with_plugin(this,compno, resno, bandno,
-									precno, cblkno, band, cblk, &numPix);
-						}
+			num_packets += (uint64_t) res->pw * res->ph;
+		}
+	}
 
-						if (!single_lossless) {
-							for (passno = 0; passno < cblk->num_passes_encoded;
-									passno++) {
-								grk_tcd_pass *pass = &cblk->passes[passno];
-								int32_t dr;
-								double dd, rdslope;
-
-								if (passno == 0) {
-									dr = (int32_t) pass->rate;
-									dd = pass->distortiondec;
-								} else {
-									dr = (int32_t) (pass->rate
-											- cblk->passes[passno - 1].rate);
-									dd =
-											pass->distortiondec
-													- cblk->passes[passno - 1].distortiondec;
-								}
+	// cumulative rate and distortion decrease of all points
+	// with slope above a threshold
+	std::vector<uint16_t> slopes;
+	std::vector<uint64_t> cumrate(1, 0);
+	std::vector<double> cumdisto(1, 0);
+	{
+		auto merged = points;
+		std::stable_sort(merged.begin(), merged.end(),
+				[](const FeasiblePoint &a, const FeasiblePoint &b) {
+					return a.slope > b.slope;
+				});
+		slopes.reserve(merged.size());
+		cumrate.reserve(merged.size() + 1);
+		cumdisto.reserve(merged.size() + 1);
+		for (auto &p : merged) {
+			slopes.push_back(p.slope);
+			cumrate.push_back(cumrate.back() + p.rate);
+			cumdisto.push_back(cumdisto.back() + p.disto);
+		}
+	}
+	auto num_above = [](const std::vector<uint16_t> &s, uint32_t thresh) {
+		return (size_t) (std::partition_point(s.begin(), s.end(),
+				[thresh](uint16_t slope) {
+					return slope > thresh;
+				}) - s.begin());
+	};
+
+	uint32_t packet_overhead = 1;
+	if (tcd_tcp->csty & J2K_CP_CSTY_SOP)
+		packet_overhead += 6;
+	if (tcd_tcp->csty & J2K_CP_CSTY_EPH)
+		packet_overhead += 2;
+	// header bits per contributing code block, before calibration
+	double block_bits = 16;
+
+	// threshold of the previous layer
+	uint32_t upperBound = USHRT_MAX;
+	// lowest threshold worth trying: everything feasible included
+	uint32_t min_slope = slopes.empty() ? USHRT_MAX : slopes.back() - 1U;
+	// size of the previous layers, packet headers included, and the code
+	// block data that they hold
+	uint64_t prev_written = 0;
+	uint64_t prev_rate = 0;
+	std::vector<uint16_t> pending;
+	for (uint32_t layno = 0; layno < tcd_tcp->numlayers; layno++) {
+		uint64_t maxlen =
+				tcd_tcp->rates[layno] > 0.0f ?
+						std::min<uint64_t>(
+								((uint64_t) ceil(tcd_tcp->rates[layno])), len) :
+						len;
+		if (!layer_needs_rate_control(layno)) {
+			// everything left goes in this layer
+			makelayer_final(layno);
+			upperBound = 0;
+			continue;
+		}
+		uint32_t lowerBound = std::min<uint32_t>(min_slope, upperBound);
+		uint32_t goodthresh = upperBound;
+		if (m_cp->m_coding_param.m_enc.m_fixed_quality) {
+			double distotarget = tcd_tile->distotile
+					- ((K * maxSE)
+							/ pow(10.0, tcd_tcp->distoratio[layno] / 10.0));
+			// highest threshold whose distortion decrease meets the target
+			uint32_t lo = lowerBound, hi = upperBound;
+			while (lo < hi) {
+				uint32_t thresh = (lo + hi + 1) >> 1;
+				if (cumdisto[num_above(slopes, thresh)] >= distotarget)
+					lo = thresh;
+				else
+					hi = thresh - 1;
+			}
+			goodthresh = lo;
+			makelayer_feasible(layno, (uint16_t) goodthresh, true);
+			auto t2 = new T2(image, m_cp);
+			bool rc = t2->encode_packets_simulate(m_tileno, tcd_tile,
+					layno + 1, &prev_written, len, tp_pos);
+			delete t2;
+			if (!rc) {
+				GROK_ERROR("Rate control: layer %u of tile %u does not fit",
+						layno, (uint32_t) m_tileno);
+				return false;
+			}
+			prev_rate = cumrate[num_above(slopes, goodthresh)];
+			*p_data_written = prev_written;
+		} else {
+			// the first point not yet included of each code block decides
+			// whether the block contributes to this layer
+			pending.clear();
+			for (auto &block : blocks) {
+				if (block.next < block.end)
+					pending.push_back(points[block.next].slope);
+			}
+			std::sort(pending.begin(), pending.end(), std::greater<uint16_t>());
+			auto estimate = [&](uint32_t thresh) {
+				return prev_written + cumrate[num_above(slopes, thresh)]
+						- prev_rate + num_packets * packet_overhead
+						+ (uint64_t) ceil(
+								block_bits * (double) num_above(pending, thresh)
+										/ 8);
+			};
+
+			// thresholds at or above fit are known to fit the layer, and
+			// those at or below fail are known not to
+			uint32_t fit = upperBound;
+			int64_t fail = (int64_t) lowerBound - 1;
+			uint64_t fit_written = 0;
+			bool fit_verified = false;
+			auto t2 = new T2(image, m_cp);
+			for (uint32_t i = 0; i < 128 && (int64_t) fit - fail > 1; ++i) {
+				uint32_t thresh;
+				if (i < 3) {
+					// lowest threshold that fits by the estimate
+					uint32_t lo = (uint32_t) (fail + 1), hi = fit;
+					while (lo < hi) {
+						uint32_t mid = (lo + hi) >> 1;
+						if (estimate(mid) <= maxlen)
+							hi = mid;
+						else
+							lo = mid + 1;
+					}
+					thresh = lo;
+					if (thresh == fit && fit_verified)
+						break;
+				} else {
+					if (fit_verified)
+						break;
+					thresh = (uint32_t) ((fail + fit) >> 1);
+				}
+				makelayer_feasible(layno, (uint16_t) thresh, false);
+				uint64_t written = 0;
+				bool rc = t2->encode_packets_simulate(m_tileno, tcd_tile,
+						layno + 1, &written, len, tp_pos);
+				if (rc) {
+					auto contributing = num_above(pending, thresh);
+					if (contributing) {
+						double header_bits = 8.0
+								* ((double) written - (double) prev_written
+										- (double) (cumrate[num_above(slopes,
+												thresh)] - prev_rate)
+										- (double) (num_packets
+												* packet_overhead));
+						block_bits = std::max<double>(1.0,
+								header_bits / (double) contributing);
+					}
+				}
+				if (rc && written <= maxlen) {
+					fit = thresh;
+					fit_written = written;
+					fit_verified = true;
+				} else {
+					fail = thresh;
+				}
+			}
+			goodthresh = fit;
+			makelayer_feasible(layno, (uint16_t) goodthresh, true);
+			// final verification pass, when no threshold has been
+			// verified: the next layer needs the exact size
+			if (!fit_verified && layno + 1 < tcd_tcp->numlayers) {
+				if (!t2->encode_packets_simulate(m_tileno, tcd_tile, layno + 1,
+						&fit_written, len, tp_pos)) {
+					delete t2;
+					GROK_ERROR("Rate control: layer %u of tile %u does not fit",
+							layno, (uint32_t) m_tileno);
+					return false;
+				}
+			}
+			delete t2;
+			prev_written = fit_written;
+			prev_rate = cumrate[num_above(slopes, goodthresh)];
+			*p_data_written = prev_written;
+		}
+		for (auto &block : blocks) {
+			while (block.next < block.end
+					&& points[block.next].slope > goodthresh)
+				block.next++;
+		}
+		upperBound = goodthresh;
+	}
+	return true;
+}
 
-								if (dr == 0) {
-									continue;
-								}
+/*
+ Simple bisect algorithm to calculate optimal layer truncation points
+ */
+bool TileProcessor::pcrd_bisect_simple(uint64_t *p_data_written, uint64_t len) {
+	uint32_t layno;
+	double cumdisto[100];
+	const double K = 1;
 
-								rdslope = dd / dr;
-								if (rdslope < min_slope) {
-									min_slope = rdslope;
-								}
+	bool single_lossless = make_single_lossless_layer();
 
-								if (rdslope > max_slope) {
-									max_slope = rdslope;
-								}
-							} /* passno */
-							tile->numpix += numPix;
-							tilec->numpix += numPix;
-						}
+	// minimum and maximum slope of the passes of each code block
+	std::vector<double> min_slopes(rate_blocks.size(), DBL_MAX);
+	std::vector<double> max_slopes(rate_blocks.size(), -1);
+	double maxSE = prepare_rate_blocks(single_lossless,
+			[this, &min_slopes, &max_slopes](size_t index) {
+		auto cblk = rate_blocks[index].cblk;
+		for (uint32_t passno = 0; passno < cblk->num_passes_encoded; passno++) {
+			grk_tcd_pass *pass = &cblk->passes[passno];
+			int32_t dr;
+			double dd, rdslope;
+
+			if (passno == 0) {
+				dr = (int32_t) pass->rate;
+				dd = pass->distortiondec;
+			} else {
+				dr = (int32_t) (pass->rate - cblk->passes[passno - 1].rate);
+				dd = pass->distortiondec
+						- cblk->passes[passno - 1].distortiondec;
+			}
 
-					} /* cbklno */
-				} /* precno */
-			} /* bandno */
-		} /* resno */
+			if (dr == 0) {
+				continue;
+			}
 
-		if (!single_lossless)
-			maxSE += (double) (((uint64_t) 1 << image->comps[compno].prec)
-					- 1)
-					* (double) (((uint64_t) 1 << image->comps[compno].prec)
-							- 1) * (double) tilec->numpix;
+			rdslope = dd / dr;
+			if (rdslope < min_slopes[index]) {
+				min_slopes[index] = rdslope;
+			}
 
-	} /* compno */
+			if (rdslope > max_slopes[index]) {
+				max_slopes[index] = rdslope;
+			}
+		} /* passno */
+	});
 
 	if (single_lossless) {
 		return true;
 	}
 
+	double min_slope = DBL_MAX;
+	double max_slope = -1;
+	for (size_t i = 0; i < rate_blocks.size(); ++i) {
+		min_slope = std::min<double>(min_slope, min_slopes[i]);
+		max_slope = std::max<double>(max_slope, max_slopes[i]);
+	}
+
 	double upperBound = max_slope;
 	for (layno = 0; layno < m_tcp->numlayers; layno++) {
 		if (layer_needs_rate_control(layno)) {
@@ -502,179 +720,130 @@ static void prepareBlockForFirstLayer(grk_tcd_cblk_enc *cblk) {
  */
 void TileProcessor::make_layer_simple(uint32_t layno, double thresh,
 		bool final) {
-	uint32_t compno, resno, bandno, precno, cblkno;
-	uint32_t passno;
-	tile->distolayer[layno] = 0;
-	for (compno = 0; compno < tile->numcomps; compno++) {
-		auto tilec = tile->comps + compno;
-		for (resno = 0; resno < tilec->numresolutions; resno++) {
-			auto res = tilec->resolutions + resno;
-			for (bandno = 0; bandno < res->numbands; bandno++) {
-				auto band = res->bands + bandno;
-				for (precno = 0; precno < res->pw * res->ph; precno++) {
-					auto prc = band->precincts + precno;
-					for (cblkno = 0; cblkno < prc->cw * prc->ch; cblkno++) {
-						auto cblk = prc->cblks.enc + cblkno;
-						auto layer = cblk->layers + layno;
-						uint32_t cumulative_included_passes_in_block;
-						if (layno == 0) {
-							prepareBlockForFirstLayer(cblk);
-						}
-						if (thresh == 0) {
-							cumulative_included_passes_in_block =
-									cblk->num_passes_encoded;
-						} else {
-							cumulative_included_passes_in_block =
-									cblk->num_passes_included_in_previous_layers;
-							for (passno =
-									cblk->num_passes_included_in_previous_layers;
-									passno < cblk->num_passes_encoded;
-									passno++) {
-								uint32_t dr;
-								double dd;
-								grk_tcd_pass *pass = &cblk->passes[passno];
-								if (cumulative_included_passes_in_block == 0) {
-									dr = pass->rate;
-									dd = pass->distortiondec;
-								} else {
-									dr =
-											pass->rate
-													- cblk->passes[cumulative_included_passes_in_block
-															- 1].rate;
-									dd =
-											pass->distortiondec
-													- cblk->passes[cumulative_included_passes_in_block
-															- 1].distortiondec;
-								}
-
-								if (!dr) {
-									if (dd != 0)
-										cumulative_included_passes_in_block =
-												passno + 1;
-									continue;
-								}
-								auto slope = dd / dr;
-								/* do not rely on float equality, check with DBL_EPSILON margin */
-								if (thresh - slope < DBL_EPSILON)
-									cumulative_included_passes_in_block = passno
-											+ 1;
-							}
-						}
-
-						layer->numpasses = cumulative_included_passes_in_block
-								- cblk->num_passes_included_in_previous_layers;
-						if (!layer->numpasses) {
-							layer->disto = 0;
-							continue;
-						}
-
-						// update layer
-						if (cblk->num_passes_included_in_previous_layers == 0) {
-							layer->len =
-									cblk->passes[cumulative_included_passes_in_block
-											- 1].rate;
-							layer->data = cblk->data;
-							layer->disto =
-									cblk->passes[cumulative_included_passes_in_block
-											- 1].distortiondec;
-						} else {
-							layer->len =
-									cblk->passes[cumulative_included_passes_in_block
-											- 1].rate
-											- cblk->passes[cblk->num_passes_included_in_previous_layers
-													- 1].rate;
-							layer->data =
-									cblk->data
-											+ cblk->passes[cblk->num_passes_included_in_previous_layers
-													- 1].rate;
-							layer->disto =
-									cblk->passes[cumulative_included_passes_in_block
-											- 1].distortiondec
-											- cblk->passes[cblk->num_passes_included_in_previous_layers
-													- 1].distortiondec;
-						}
+	Scheduler::g_tp->parallel_for(rate_blocks.size(),
+			rate_grain(rate_blocks.size()),
+			[this, layno, thresh, final](size_t index) {
+		auto cblk = rate_blocks[index].cblk;
+		auto layer = cblk->layers + layno;
+		uint32_t cumulative_included_passes_in_block;
+		if (layno == 0) {
+			prepareBlockForFirstLayer(cblk);
+		}
+		if (thresh == 0) {
+			cumulative_included_passes_in_block = cblk->num_passes_encoded;
+		} else {
+			cumulative_included_passes_in_block =
+					cblk->num_passes_included_in_previous_layers;
+			for (uint32_t passno = cblk->num_passes_included_in_previous_layers;
+					passno < cblk->num_passes_encoded; passno++) {
+				uint32_t dr;
+				double dd;
+				grk_tcd_pass *pass = &cblk->passes[passno];
+				if (cumulative_included_passes_in_block == 0) {
+					dr = pass->rate;
+					dd = pass->distortiondec;
+				} else {
+					dr = pass->rate
+							- cblk->passes[cumulative_included_passes_in_block
+									- 1].rate;
+					dd = pass->distortiondec
+							- cblk->passes[cumulative_included_passes_in_block
+									- 1].distortiondec;
+				}
 
-						tile->distolayer[layno] += layer->disto;
-						if (final)
-							cblk->num_passes_included_in_previous_layers =
-									cumulative_included_passes_in_block;
-					}
+				if (!dr) {
+					if (dd != 0)
+						cumulative_included_passes_in_block = passno + 1;
+					continue;
 				}
+				auto slope = dd / dr;
+				/* do not rely on float equality, check with DBL_EPSILON margin */
+				if (thresh - slope < DBL_EPSILON)
+					cumulative_included_passes_in_block = passno + 1;
 			}
 		}
-	}
+
+		layer->numpasses = cumulative_included_passes_in_block
+				- cblk->num_passes_included_in_previous_layers;
+		if (!layer->numpasses) {
+			layer->disto = 0;
+			return;
+		}
+
+		// update layer
+		if (cblk->num_passes_included_in_previous_layers == 0) {
+			layer->len = cblk->passes[cumulative_included_passes_in_block - 1].rate;
+			layer->data = cblk->data;
+			layer->disto =
+					cblk->passes[cumulative_included_passes_in_block - 1].distortiondec;
+		} else {
+			layer->len = cblk->passes[cumulative_included_passes_in_block - 1].rate
+					- cblk->passes[cblk->num_passes_included_in_previous_layers
+							- 1].rate;
+			layer->data = cblk->data
+					+ cblk->passes[cblk->num_passes_included_in_previous_layers
+							- 1].rate;
+			layer->disto =
+					cblk->passes[cumulative_included_passes_in_block - 1].distortiondec
+							- cblk->passes[cblk->num_passes_included_in_previous_layers
+									- 1].distortiondec;
+		}
+
+		if (final)
+			cblk->num_passes_included_in_previous_layers =
+					cumulative_included_passes_in_block;
+	});
+	tile->distolayer[layno] = layer_disto(rate_blocks, layno);
 }
 
 // Add all remaining passes to this layer
 void TileProcessor::makelayer_final(uint32_t layno) {
-	uint32_t compno, resno, bandno, precno, cblkno;
-	tile->distolayer[layno] = 0;
-
-	for (compno = 0; compno < tile->numcomps; compno++) {
-		auto tilec = tile->comps + compno;
-		for (resno = 0; resno < tilec->numresolutions; resno++) {
-			auto res = tilec->resolutions + resno;
-			for (bandno = 0; bandno < res->numbands; bandno++) {
-				auto band = res->bands + bandno;
-				for (precno = 0; precno < res->pw * res->ph; precno++) {
-					auto prc = band->precincts + precno;
-					for (cblkno = 0; cblkno < prc->cw * prc->ch; cblkno++) {
-						auto cblk = prc->cblks.enc + cblkno;
-						auto layer = cblk->layers + layno;
-						if (layno == 0) {
-							prepareBlockForFirstLayer(cblk);
-						}
-						uint32_t cumulative_included_passes_in_block =
-								cblk->num_passes_included_in_previous_layers;
-						if (cblk->num_passes_encoded
-								> cblk->num_passes_included_in_previous_layers)
-							cumulative_included_passes_in_block =
-									cblk->num_passes_encoded;
-
-						layer->numpasses = cumulative_included_passes_in_block
-								- cblk->num_passes_included_in_previous_layers;
-
-						if (!layer->numpasses) {
-							layer->disto = 0;
-							continue;
-						}
+	Scheduler::g_tp->parallel_for(rate_blocks.size(),
+			rate_grain(rate_blocks.size()), [this, layno](size_t index) {
+		auto cblk = rate_blocks[index].cblk;
+		auto layer = cblk->layers + layno;
+		if (layno == 0) {
+			prepareBlockForFirstLayer(cblk);
+		}
+		uint32_t cumulative_included_passes_in_block =
+				cblk->num_passes_included_in_previous_layers;
+		if (cblk->num_passes_encoded
+				> cblk->num_passes_included_in_previous_layers)
+			cumulative_included_passes_in_block = cblk->num_passes_encoded;
+
+		layer->numpasses = cumulative_included_passes_in_block
+				- cblk->num_passes_included_in_previous_layers;
+
+		if (!layer->numpasses) {
+			layer->disto = 0;
+			return;
+		}
 
-						// update layer
-						if (cblk->num_passes_included_in_previous_layers == 0) {
-							layer->len =
-									cblk->passes[cumulative_included_passes_in_block
-											- 1].rate;
-							layer->data = cblk->data;
-							layer->disto =
-									cblk->passes[cumulative_included_passes_in_block
-											- 1].distortiondec;
-						} else {
-							layer->len =
-									cblk->passes[cumulative_included_passes_in_block
-											- 1].rate
-											- cblk->passes[cblk->num_passes_included_in_previous_layers
-													- 1].rate;
-							layer->data =
-									cblk->data
-											+ cblk->passes[cblk->num_passes_included_in_previous_layers
-													- 1].rate;
-							layer->disto =
-									cblk->passes[cumulative_included_passes_in_block
-											- 1].distortiondec
-											- cblk->passes[cblk->num_passes_included_in_previous_layers
-													- 1].distortiondec;
-						}
-						tile->distolayer[layno] += layer->disto;
-						cblk->num_passes_included_in_previous_layers =
-								cumulative_included_passes_in_block;
-						assert(
-								cblk->num_passes_included_in_previous_layers
-										== cblk->num_passes_encoded);
-					}
-				}
-			}
+		// update layer
+		if (cblk->num_passes_included_in_previous_layers == 0) {
+			layer->len = cblk->passes[cumulative_included_passes_in_block - 1].rate;
+			layer->data = cblk->data;
+			layer->disto =
+					cblk->passes[cumulative_included_passes_in_block - 1].distortiondec;
+		} else {
+			layer->len = cblk->passes[cumulative_included_passes_in_block - 1].rate
+					- cblk->passes[cblk->num_passes_included_in_previous_layers
+							- 1].rate;
+			layer->data = cblk->data
+					+ cblk->passes[cblk->num_passes_included_in_previous_layers
+							- 1].rate;
+			layer->disto =
+					cblk->passes[cumulative_included_passes_in_block - 1].distortiondec
+							- cblk->passes[cblk->num_passes_included_in_previous_layers
+									- 1].distortiondec;
 		}
-	}
+		cblk->num_passes_included_in_previous_layers =
+				cumulative_included_passes_in_block;
+		assert(
+				cblk->num_passes_included_in_previous_layers
+						== cblk->num_passes_encoded);
+	});
+	tile->distolayer[layno] = layer_disto(rate_blocks, layno);
 }
 bool TileProcessor::init(grk_image *p_image, grk_coding_parameters *p_cp) {
 	image = p_image;
@@ -1155,6 +1324,20 @@ bool TileProcessor::init_decode_tile(grk_image *output_image,
 bool TileProcessor::encode_tile(uint16_t tile_no, BufferedStream *p_stream,
 		uint64_t *p_data_written, uint64_t max_length,
 		 grk_codestream_info  *p_cstr_info) {
+	if (!encode_code_blocks(tile_no, max_length, p_cstr_info))
+		return false;
+	if (p_cstr_info) {
+		p_cstr_info->index_write = 1;
+	}
+	if (!t2_encode(p_stream, p_data_written, max_length,
+			p_cstr_info)) {
+		return false;
+	}
+	return true;
+}
+
+bool TileProcessor::encode_code_blocks(uint16_t tile_no, uint64_t max_length,
+		 grk_codestream_info  *p_cstr_info) {
 	uint32_t state = grok_plugin_get_debug_state();
 	if (cur_tp_num == 0) {
 		m_tileno = tile_no;
@@ -1210,24 +1393,37 @@ bool TileProcessor::encode_tile(uint16_t tile_no, BufferedStream *p_stream,
 					return false;
 				}
 			}
-			if (!t1_encode()) {
+			bool ht_planes = ht_needs_plane_choice();
+			if (!t1_encode(ht_planes ? HT_RATE_CANDIDATES : HT_RATE_REFINE_LSB)) {
 				return false;
 			}
+			if (ht_planes) {
+				if (!rate_allocate_encode(max_length, p_cstr_info)) {
+					return false;
+				}
+				ht_choose_planes();
+				if (!t1_encode(HT_RATE_CHOSEN_PLANE)) {
+					return false;
+				}
+			}
 		}
 		if (!rate_allocate_encode(max_length, p_cstr_info)) {
 			return false;
 		}
 	}
-	if (p_cstr_info) {
-		p_cstr_info->index_write = 1;
-	}
-	if (!t2_encode(p_stream, p_data_written, max_length,
-			p_cstr_info)) {
-		return false;
-	}
 	return true;
 }
 
+bool TileProcessor::get_packet_lengths(uint32_t pino, uint32_t tpnum,
+		uint64_t len, std::vector<uint32_t> *packet_lengths) {
+	auto t2 = new T2(image, m_cp);
+	bool rc = t2->get_packet_lengths(m_tileno, tile, m_tcp->numlayers, len,
+			tpnum, tp_pos, pino, packet_lengths);
+	delete t2;
+
+	return rc;
+}
+
 #if 0
 /** Returns whether a tile component should be fully decoded,
  * taking into account win_* members.
@@ -1347,6 +1543,10 @@ bool TileProcessor::decode_tile(ChunkBuffer *src_buf, uint16_t tile_no) {
 		decode_synch_plugin_with_host(this);
 	}
 
+	if (doT1 && doPostT1 && whole_tile_decoding
+			&& !m_cp->m_coding_param.m_dec.m_disable_pipeline)
+		return t1_decode_pipelined();
+
 	if (doT1) {
 		if (!t1_decode()) {
 			return false;
@@ -1358,10 +1558,7 @@ bool TileProcessor::decode_tile(ChunkBuffer *src_buf, uint16_t tile_no) {
 		if (!dwt_decode()) {
 			return false;
 		}
-		if (!mct_decode()) {
-			return false;
-		}
-		if (!dc_level_shift_decode()) {
+		if (!mct_dc_level_shift_decode()) {
 			return false;
 		}
 	}
@@ -1560,19 +1757,134 @@ bool TileProcessor::t1_decode() {
 	uint32_t compno;
 	auto tile_comp = tile->comps;
 	auto tccp = m_tcp->tccps;
-	std::vector<decodeBlockInfo*> blocks;
+	// the block list keeps its capacity in the arena, from tile to tile
+	auto arena = WorkerArena::get();
+	auto blocks = arena->get_decode_blocks();
 	auto t1_wrap = std::unique_ptr<Tier1>(new Tier1());
+	bool rc = true;
 	for (compno = 0; compno < tile->numcomps; ++compno) {
-		if (!t1_wrap->prepareDecodeCodeblocks(tile_comp, tccp, &blocks)) {
-			return false;
+		if (!t1_wrap->prepareDecodeCodeblocks(tile_comp, tccp, blocks)) {
+			rc = false;
+			break;
 		}
 		++tile_comp;
 		++tccp;
 	}
 	// !!! assume that code block dimensions do not change over components
-	return t1_wrap->decodeCodeblocks(m_tcp,
+	if (rc)
+		rc = t1_wrap->decodeCodeblocks(m_tcp,
+				(uint16_t) m_tcp->tccps->cblkw,
+				(uint16_t) m_tcp->tccps->cblkh,
+				m_cp->m_coding_param.m_dec.m_t1_schedule, blocks);
+	arena->put_decode_blocks(blocks);
+
+	return rc;
+}
+
+bool TileProcessor::t1_decode_pipelined() {
+	uint32_t numcomps = tile->numcomps;
+	auto arena = WorkerArena::get();
+	auto blocks = arena->get_decode_blocks();
+	auto t1_wrap = std::unique_ptr<Tier1>(new Tier1());
+	for (uint32_t compno = 0; compno < numcomps; ++compno) {
+		if (!t1_wrap->prepareDecodeCodeblocks(tile->comps + compno,
+				m_tcp->tccps + compno, blocks)) {
+			arena->put_decode_blocks(blocks);
+			return false;
+		}
+	}
+
+	struct ComponentState {
+		ComponentState() : numres(0), next_res(0), busy(false), done(false)
+		{}
+		/* number of resolutions to reconstruct */
+		uint32_t numres;
+		/* code blocks still to decode, per resolution */
+		std::unique_ptr<std::atomic<uint32_t>[]> remaining;
+		/* next resolution for the inverse wavelet */
+		std::atomic<uint32_t> next_res;
+		/* set while a worker runs the inverse wavelet of the component */
+		std::atomic<bool> busy;
+		std::atomic<bool> done;
+
+		/* resolution resno can be reconstructed once every code block
+		 * of resolutions 0..resno is decoded */
+		bool ready(uint32_t resno) const {
+			for (uint32_t r = 0; r <= resno; ++r) {
+				if (remaining[r])
+					return false;
+			}
+			return true;
+		}
+	};
+	std::unique_ptr<ComponentState[]> states(new ComponentState[numcomps]);
+	for (uint32_t compno = 0; compno < numcomps; ++compno) {
+		auto st = &states[compno];
+		st->numres = image->comps[compno].resno_decoded + 1;
+		uint32_t len = std::max<uint32_t>(st->numres,
+				tile->comps[compno].minimum_num_resolutions);
+		st->remaining.reset(new std::atomic<uint32_t>[len]);
+		for (uint32_t r = 0; r < len; ++r)
+			st->remaining[r] = 0;
+	}
+	for (auto &block : *blocks)
+		states[block.tilec - tile->comps].remaining[block.resno]++;
+
+	std::atomic<uint32_t> comps_done(0);
+	// MCT needs every component, while DC level shift only needs its own
+	auto finish_component = [this, numcomps, &comps_done](uint32_t compno) {
+		if (!m_tcp->mct)
+			return dc_level_shift_decode(compno);
+		if (++comps_done < numcomps)
+			return true;
+		return mct_dc_level_shift_decode();
+	};
+	// run the inverse wavelet of every resolution of the component that is
+	// ready. Only one worker at a time works on a component: another worker
+	// that finds it busy returns straight away, and the busy worker checks
+	// again for newly decoded resolutions before it lets go.
+	auto advance = [this, &states, &finish_component](uint32_t compno) {
+		auto st = &states[compno];
+		auto tilec = tile->comps + compno;
+		auto qmfbid = m_tcp->tccps[compno].qmfbid;
+		for (;;) {
+			bool expected = false;
+			if (!st->busy.compare_exchange_strong(expected, true))
+				return true;
+			uint32_t resno;
+			while ((resno = st->next_res) < st->numres && st->ready(resno)) {
+				if (!Wavelet::decode_resolution(tilec, resno, qmfbid)) {
+					st->busy = false;
+					return false;
+				}
+				st->next_res = resno + 1;
+			}
+			bool finished = st->next_res == st->numres;
+			st->busy = false;
+			if (finished)
+				return st->done.exchange(true) || finish_component(compno);
+			if (!st->ready(st->next_res))
+				return true;
+		}
+	};
+	auto on_decoded = [this, &states, &advance](decodeBlockInfo *block) {
+		auto compno = (uint32_t) (block->tilec - tile->comps);
+		if (--states[compno].remaining[block->resno] == 0)
+			return advance(compno);
+		return true;
+	};
+
+	// !!! assume that code block dimensions do not change over components
+	bool rc = t1_wrap->decodeCodeblocks(m_tcp,
 			(uint16_t) m_tcp->tccps->cblkw,
-			(uint16_t) m_tcp->tccps->cblkh, &blocks);
+			(uint16_t) m_tcp->tccps->cblkh,
+			m_cp->m_coding_param.m_dec.m_t1_schedule, blocks, true, on_decoded);
+	arena->put_decode_blocks(blocks);
+	// components with no code blocks in their last resolutions
+	for (uint32_t compno = 0; compno < numcomps && rc; ++compno)
+		rc = advance(compno);
+
+	return rc;
 }
 
 bool TileProcessor::dwt_decode() {
@@ -1639,7 +1951,9 @@ bool TileProcessor::mct_decode() {
 			/* nb of components (i.e. size of pData) */
 			tile->numcomps,
 			/* tells if the data is signed */
-			image->comps->sgnd)) {
+			image->comps->sgnd,
+			/* integer samples of the reversible wavelet */
+			m_tcp->tccps->qmfbid == 1)) {
 				grok_free(data);
 				return false;
 			}
@@ -1670,62 +1984,183 @@ bool TileProcessor::mct_decode() {
 	return true;
 }
 
-bool TileProcessor::dc_level_shift_decode() {
+/**
+ * Run fn(begin, len) over the n samples of a tile component, in bands of
+ * consecutive rows that the workers of the pool claim one at a time.
+ * Bands are small enough to stay in cache, and start on a
+ * multiple of 16 samples, so that every sample outside the last partial
+ * vector of the component goes through the SIMD path of the kernels.
+ */
+template<typename F> static void parallel_bands(uint64_t n, F &&fn) {
+	const uint64_t align = 16;
+	const uint64_t band_samples = 1 << 15;
+	uint64_t num_bands = (n + band_samples - 1) / band_samples;
+	if (num_bands < 2 || Scheduler::g_tp->num_threads() == 1) {
+		fn(0, n);
+		return;
+	}
+	static_assert(band_samples % align == 0, "bands must stay aligned");
+	Scheduler::g_tp->parallel_for(num_bands, [n, band_samples, &fn](size_t b) {
+		uint64_t begin = (uint64_t) b * band_samples;
+		fn(begin, std::min<uint64_t>(band_samples, n - begin));
+	});
+}
+
+void TileProcessor::dc_level_shift_range(uint32_t compno, int32_t *min,
+		int32_t *max) {
+	auto img_comp = image->comps + compno;
+
+	if (img_comp->sgnd) {
+		*min = -(1 << (img_comp->prec - 1));
+		*max = (1 << (img_comp->prec - 1)) - 1;
+	} else {
+		*min = 0;
+		*max = (1 << img_comp->prec) - 1;
+	}
+}
+
+bool TileProcessor::mct_dc_level_shift_decode() {
 	uint32_t compno = 0;
-	for (compno = 0; compno < tile->numcomps; compno++) {
-		int32_t min = INT32_MAX, max = INT32_MIN;
-		uint32_t x0 ;
-		uint32_t y0;
-		uint32_t x1;
-		uint32_t y1 ;
-		auto tile_comp = tile->comps + compno;
-		auto tccp = m_tcp->tccps + compno;
-		auto img_comp = image->comps + compno;
-		uint32_t stride = 0;
+	auto tccps = m_tcp->tccps;
+	// the standard RCT/ICT of the first three components is fused with
+	// their DC level shift, unless the shift is left to the output copy
+	if (m_tcp->mct == 1 && tile->numcomps >= 3 && !defer_dc_level_shift
+			&& tccps[1].qmfbid == tccps[0].qmfbid
+			&& tccps[2].qmfbid == tccps[0].qmfbid) {
+		uint64_t samples = tile->comps->buf->reduced_image_dim.area();
+		/* testcase 1336.pdf.asan.47.376 */
+		if ((uint64_t) tile->comps[1].buf->reduced_image_dim.area() < samples
+				|| (uint64_t) tile->comps[2].buf->reduced_image_dim.area()
+						< samples) {
+			GROK_ERROR(
+					"Tiles don't all have the same dimension. Skip the MCT step.");
+			return false;
+		}
+		int32_t shift[3], min[3], max[3];
+		int32_t *chan[3];
+		for (uint32_t i = 0; i < 3; ++i) {
+			shift[i] = tccps[i].m_dc_level_shift;
+			dc_level_shift_range(i, min + i, max + i);
+			chan[i] = tile->comps[i].buf->get_ptr(0, 0, 0, 0);
+		}
+		auto kernel =
+				tccps->qmfbid == 1 ?
+						Kernels::g_kernels->mct_decode_rev_dc_shift :
+						Kernels::g_kernels->mct_decode_irrev_dc_shift;
+		parallel_bands(samples,
+				[kernel, &chan, &shift, &min, &max](uint64_t begin,
+						uint64_t len) {
+					kernel(chan[0] + begin, chan[1] + begin, chan[2] + begin,
+							len, shift, min, max);
+				});
+		compno = 3;
+	} else if (!mct_decode()) {
+		return false;
+	}
+	for (; compno < tile->numcomps; compno++) {
+		if (!dc_level_shift_decode(compno))
+			return false;
+	}
+	return true;
+}
 
-		int32_t *current_ptr = tile_comp->buf->get_ptr( 0, 0, 0, 0);
+bool TileProcessor::dc_level_shift_decode(uint32_t compno) {
+	if (defer_dc_level_shift)
+		return true;
+	auto tile_comp = tile->comps + compno;
 
-		x0 = 0;
-		y0 = 0;
-		x1 = (uint32_t)(tile_comp->buf->reduced_image_dim.width());
-		y1 = (uint32_t)(tile_comp->buf->reduced_image_dim.height());
+	int32_t *current_ptr = tile_comp->buf->get_ptr( 0, 0, 0, 0);
 
-		assert(x1 >= x0);
-		assert(tile_comp->width() >= (x1 - x0));
+	uint64_t x1 = tile_comp->buf->reduced_image_dim.width();
+	uint64_t y1 = tile_comp->buf->reduced_image_dim.height();
 
+	assert(tile_comp->width() >= x1);
 
-		if (img_comp->sgnd) {
-			min = -(1 << (img_comp->prec - 1));
-			max = (1 << (img_comp->prec - 1)) - 1;
-		} else {
-			min = 0;
-			max = (1 << img_comp->prec) - 1;
-		}
+	parallel_bands(x1 * y1, [this, compno, current_ptr](uint64_t begin,
+			uint64_t len) {
+		dc_level_shift_decode(compno, current_ptr + begin,
+				current_ptr + begin, len);
+	});
+	return true;
+}
 
-		if (tccp->qmfbid == 1) {
-			for (uint32_t j = y0; j < y1; ++j) {
-				for (uint32_t i = x0; i < x1; ++i) {
-					*current_ptr = int_clamp(
-							*current_ptr + tccp->m_dc_level_shift, min,
-							max);
-					current_ptr++;
+bool TileProcessor::pack_decoded_tile(grk_image *p_output_image,
+		const int32_t *const *src, uint32_t src_stride, uint32_t x0,
+		uint32_t y0, uint32_t w, uint32_t h) {
+	if (!w || !h)
+		return true;
+	auto format = &m_cp->m_coding_param.m_dec.m_output_format;
+	uint32_t numcomps = image->numcomps;
+	uint32_t comps_per_row = format->interleaved ? numcomps : 1;
+	uint64_t stride = p_output_image->packed_stride;
+	uint64_t plane_len = stride * p_output_image->comps->h;
+	uint8_t *dest = p_output_image->packed_data + y0 * stride
+			+ (uint64_t) x0 * comps_per_row
+					* grk_sample_size(format->sample_type);
+
+	// bands of rows that the workers of the pool claim one at a time. The
+	// rows of every component are level shifted into a scratch buffer,
+	// which stays in cache until it has been packed.
+	const uint64_t band_samples = 1 << 15;
+	uint64_t band_rows = std::max<uint64_t>(1,
+			band_samples / ((uint64_t) w * numcomps));
+	uint64_t num_bands = (h + band_rows - 1) / band_rows;
+	std::atomic<bool> rc(true);
+	auto band = [this, format, src, src_stride, w, h, numcomps, stride,
+				 plane_len, dest, band_rows, &rc](size_t b) {
+		auto arena = WorkerArena::get();
+		auto scratch = (int32_t*) arena->get_buffer(
+				(size_t) w * numcomps * sizeof(int32_t));
+		if (!scratch) {
+			rc = false;
+			return;
+		}
+		std::vector<const int32_t*> rows(numcomps);
+		uint64_t y_end = std::min<uint64_t>(h, (b + 1) * band_rows);
+		for (uint64_t y = b * band_rows; y < y_end; ++y) {
+			for (uint32_t c = 0; c < numcomps; ++c) {
+				rows[c] = src[c] + y * src_stride;
+				if (defer_dc_level_shift) {
+					auto shifted = scratch + (size_t) c * w;
+					dc_level_shift_decode(c, rows[c], shifted, w);
+					rows[c] = shifted;
 				}
-				current_ptr += stride;
 			}
-		} else {
-			for (uint32_t j = y0; j < y1; ++j) {
-				for (uint32_t i = x0; i < x1; ++i) {
-					float value = *((float*) current_ptr);
-					*current_ptr = int_clamp(
-							(int32_t) grok_lrintf(value)
-									+ tccp->m_dc_level_shift, min, max);
-					current_ptr++;
-				}
-				current_ptr += stride;
+			if (format->interleaved) {
+				grk_pack_row(format->sample_type, rows.data(), numcomps,
+						dest + y * stride, w);
+			} else {
+				for (uint32_t c = 0; c < numcomps; ++c)
+					grk_pack_row(format->sample_type, rows.data() + c, 1,
+							dest + c * plane_len + y * stride, w);
 			}
 		}
-	}
-	return true;
+		arena->put_buffer(scratch);
+	};
+	if (num_bands == 1)
+		band(0);
+	else
+		Scheduler::g_tp->parallel_for(num_bands, band);
+	if (!rc)
+		GROK_ERROR("Not enough memory to pack the decoded tile");
+
+	return rc;
+}
+
+void TileProcessor::dc_level_shift_decode(uint32_t compno,
+		const int32_t *src, int32_t *dest, uint64_t n) {
+	auto kernels = Kernels::g_kernels;
+	int32_t min, max;
+	auto tccp = m_tcp->tccps + compno;
+
+	dc_level_shift_range(compno, &min, &max);
+
+	if (tccp->qmfbid == 1)
+		kernels->dc_level_shift_decode_rev(src, dest, n,
+				tccp->m_dc_level_shift, min, max);
+	else
+		kernels->dc_level_shift_decode_irrev(src, dest, n,
+				tccp->m_dc_level_shift, min, max);
 }
 
 /**
@@ -1785,31 +2220,20 @@ uint64_t TileProcessor::get_tile_size(bool reduced) {
 }
 
 bool TileProcessor::dc_level_shift_encode() {
-	uint32_t compno;
-	uint64_t nb_elem, i;
-	int32_t *current_ptr;
-
+	auto kernels = Kernels::g_kernels;
 	auto tile_comp = tile->comps;
 	auto tccp = m_tcp->tccps;
-	auto img_comp = image->comps;
-
-	for (compno = 0; compno < tile->numcomps; compno++) {
-		current_ptr = tile_comp->buf->get_ptr( 0, 0, 0, 0);
-		nb_elem = tile_comp->area();
 
-		if (tccp->qmfbid == 1) {
-			for (i = 0; i < nb_elem; ++i) {
-				*current_ptr -= tccp->m_dc_level_shift;
-				++current_ptr;
-			}
-		} else {
-			for (i = 0; i < nb_elem; ++i) {
-				*current_ptr = (*current_ptr - tccp->m_dc_level_shift)
-						* (1 << 11);
-				++current_ptr;
-			}
-		}
-		++img_comp;
+	for (uint32_t compno = 0; compno < tile->numcomps; compno++) {
+		int32_t *current_ptr = tile_comp->buf->get_ptr( 0, 0, 0, 0);
+		uint64_t nb_elem = tile_comp->area();
+
+		if (tccp->qmfbid == 1)
+			kernels->dc_level_shift_encode_rev(current_ptr, nb_elem,
+					tccp->m_dc_level_shift);
+		else
+			kernels->dc_level_shift_encode_irrev(current_ptr, nb_elem,
+					tccp->m_dc_level_shift);
 		++tccp;
 		++tile_comp;
 	}
@@ -1879,7 +2303,28 @@ bool TileProcessor::dwt_encode() {
 	return rc;
 }
 
-bool TileProcessor::t1_encode() {
+bool TileProcessor::ht_needs_plane_choice() {
+	// a lossless last layer needs every bit plane, so the cleanup pass
+	// keeps to the bit plane above the least significant
+	return m_tcp->isHT && layer_needs_rate_control(m_tcp->numlayers - 1);
+}
+
+void TileProcessor::ht_choose_planes() {
+	for (auto &block : rate_blocks) {
+		auto cblk = block.cblk;
+		uint32_t included = 0;
+		for (uint32_t layno = 0; layno < m_tcp->numlayers; ++layno)
+			included += cblk->layers[layno].numpasses;
+		// the candidates run from the coarsest bit plane down, one per pass;
+		// a block left out of every layer keeps the coarsest
+		if (included)
+			cblk->ht_plane = (uint8_t) (cblk->ht_plane + 1 - included);
+		// the block is coded again, from the missing MSBs of the band
+		cblk->numbps = 0;
+	}
+}
+
+bool TileProcessor::t1_encode(HT_RATE_MODE ht_mode) {
 	const double *l_mct_norms;
 	uint32_t l_mct_numcomps = 0U;
 	auto l_tcp = m_tcp;
@@ -1900,7 +2345,7 @@ bool TileProcessor::t1_encode() {
 	auto t1_wrap = std::unique_ptr<Tier1>(new Tier1());
 
 	return t1_wrap->encodeCodeblocks(l_tcp, tile, l_mct_norms,
-			l_mct_numcomps, needs_rate_control());
+			l_mct_numcomps, needs_rate_control(), ht_mode);
 }
 
 bool TileProcessor::t2_encode(BufferedStream *p_stream,
@@ -1962,7 +2407,7 @@ bool TileProcessor::t2_encode(BufferedStream *p_stream,
 
 	if (!l_t2->encode_packets(m_tileno, tile,
 			m_tcp->numlayers, p_stream, p_data_written, max_dest_size,
-			p_cstr_info, tp_num, tp_pos, cur_pino)) {
+			p_cstr_info, tp_num, tp_pos, cur_pino, packet_lengths)) {
 		delete l_t2;
 		return false;
 	}
@@ -2005,6 +2450,26 @@ bool  TileProcessor::rate_allocate_encode(uint64_t max_dest_size,
 	if (l_cp->m_coding_param.m_enc.m_disto_alloc
 			|| l_cp->m_coding_param.m_enc.m_fixed_quality) {
 		// rate control by rate/distortion or fixed quality
+		rate_blocks.clear();
+		for (uint32_t compno = 0; compno < tile->numcomps; compno++) {
+			auto tilec = tile->comps + compno;
+			for (uint32_t resno = 0; resno < tilec->numresolutions; resno++) {
+				auto res = tilec->resolutions + resno;
+				for (uint32_t bandno = 0; bandno < res->numbands; bandno++) {
+					auto band = res->bands + bandno;
+					for (uint32_t precno = 0; precno < res->pw * res->ph;
+							precno++) {
+						auto prc = band->precincts + precno;
+						for (uint32_t cblkno = 0; cblkno < prc->cw * prc->ch;
+								cblkno++) {
+							rate_blocks.push_back( { compno, resno, bandno,
+									precno, cblkno, band, prc->cblks.enc
+											+ cblkno });
+						}
+					}
+				}
+			}
+		}
 		switch (l_cp->m_coding_param.m_enc.rateControlAlgorithm) {
 		case 0:
 			if (!pcrd_bisect_simple( &l_nb_written, max_dest_size)) {
@@ -2016,6 +2481,11 @@ bool  TileProcessor::rate_allocate_encode(uint64_t max_dest_size,
 				return false;
 			}
 			break;
+		case 2:
+			if (!pcrd_incremental(&l_nb_written, max_dest_size)) {
+				return false;
+			}
+			break;
 		default:
 			if (!pcrd_bisect_feasible(&l_nb_written, max_dest_size)) {
 				return false;
@@ -2035,10 +2505,12 @@ bool  TileProcessor::rate_allocate_encode(uint64_t max_dest_size,
  This method copies a sub-region of this region into p_output_image (which stores data in 32 bit precision)
 
  */
-bool TileProcessor::copy_decoded_tile_to_output_image(uint8_t *p_data,
+bool TileProcessor::copy_decoded_tile_to_output_image(
 		grk_image *p_output_image, bool clearOutputOnInit) {
-	uint32_t i = 0, j = 0, k = 0;
+	uint32_t i = 0, j = 0;
 	auto image_src = image;
+	bool packed = p_output_image->packed_data != nullptr;
+	std::vector<const int32_t*> packed_src(packed ? image_src->numcomps : 0);
 	for (i = 0; i < image_src->numcomps; i++) {
 
 		auto tilec = tile->comps + i;
@@ -2053,7 +2525,7 @@ bool TileProcessor::copy_decoded_tile_to_output_image(uint8_t *p_data,
 		}
 
 		/* Allocate output component buffer if necessary */
-		if (!img_comp_dest->data) {
+		if (!packed && !img_comp_dest->data) {
 			if (!grk_image_single_component_data_alloc(img_comp_dest)) {
 				return false;
 			}
@@ -2063,16 +2535,6 @@ bool TileProcessor::copy_decoded_tile_to_output_image(uint8_t *p_data,
 			}
 		}
 
-		/* Copy info from decoded comp image to output image */
-		img_comp_dest->resno_decoded = img_comp_src->resno_decoded;
-
-		/*-----*/
-		/* Compute the precision of the output buffer */
-		uint32_t size_comp = (img_comp_src->prec + 7) >> 3;
-		if (size_comp == 3) {
-			size_comp = 4;
-		}
-
 		/* Border of the current output component. (x0_dest,y0_dest) corresponds to origin of dest buffer */
 		auto reduce = m_cp->m_coding_param.m_dec.m_reduce;
 		uint32_t x0_dest = uint_ceildivpow2(img_comp_dest->x0,	reduce);
@@ -2176,108 +2638,34 @@ bool TileProcessor::copy_decoded_tile_to_output_image(uint8_t *p_data,
 		/* Compute the input buffer offset */
 		size_t start_offset_src = (size_t) offset_x0_src
 				+ (size_t) offset_y0_src * (size_t) width_src;
-		size_t line_offset_src = (size_t) offset_x1_src
-				+ (size_t) offset_x0_src;
-		size_t end_offset_src = (size_t) offset_y1_src * (size_t) width_src
-				- (size_t) offset_x0_src;
 
 		/* Compute the output buffer offset */
 		size_t start_offset_dest = (size_t) offset_x0_dest
 				+ (size_t) offset_y0_dest * (size_t) img_comp_dest->w;
-		size_t line_offset_dest = (size_t) img_comp_dest->w
-				- (size_t) width_dest;
-
-		/* Move the output buffer index to the first place where we will write*/
-		auto dest_ind = start_offset_dest;
-
-		/* Move to the first place where we will read*/
-		auto src_ind = start_offset_src;
-
-		/*if (i == 0) {
-		 fprintf(stdout, "COMPO[%d]:\n",i);
-		 fprintf(stdout, "SRC: start_x_src=%d, start_y_src=%d, width_src=%d, height_src=%d\n"
-		 "\t tile offset:%d, %d, %d, %d\n"
-		 "\t buffer offset: %d; %d, %d\n",
-		 res->x0, res->y0, width_src, height_src,
-		 offset_x0_src, offset_y0_src, offset_x1_src, offset_y1_src,
-		 start_offset_src, line_offset_src, end_offset_src);
-
-		 fprintf(stdout, "DEST: offset_x0_dest=%d, offset_y0_dest=%d, width_dest=%d, height_dest=%d\n"
-		 "\t start offset: %d, line offset= %d\n",
-		 offset_x0_dest, offset_y0_dest, width_dest, height_dest, start_offset_dest, line_offset_dest);
-		 }*/
-
-		switch (size_comp) {
-		case 1: {
-			int8_t *src_ptr = (int8_t*) p_data;
-			if (img_comp_src->sgnd) {
-				for (j = 0; j < height_dest; ++j) {
-					for (k = 0; k < width_dest; ++k) {
-						img_comp_dest->data[dest_ind++] =
-								(int32_t) src_ptr[src_ind++]; /* Copy only the data needed for the output image */
-					}
-
-					dest_ind += line_offset_dest; /* Move to the next place where we will write */
-					src_ind += line_offset_src; /* Move to the next place where we will read */
-				}
-			} else {
-				for (j = 0; j < height_dest; ++j) {
-					for (k = 0; k < width_dest; ++k) {
-						img_comp_dest->data[dest_ind++] =
-								(int32_t) (src_ptr[src_ind++] & 0xff);
-					}
 
-					dest_ind += line_offset_dest;
-					src_ind += line_offset_src;
-				}
-			}
-			src_ind += end_offset_src; /* Move to the end of this component-part of the input buffer */
-			p_data = (uint8_t*) (src_ptr + src_ind); /* Keep the current position for the next component-part */
+		/* The tile buffer holds the samples of the reduced tile, width_src
+		 * to a row. They go straight to the output image, rather than
+		 * through a buffer in the precision of the image. */
+		const int32_t *src_ptr = tilec->buf->get_ptr(0, 0, 0, 0)
+				+ start_offset_src;
+		/* components of packed output all have the same dimensions, and
+		 * are packed together once the region of the last one is known */
+		if (packed) {
+			packed_src[i] = src_ptr;
+			if (i + 1 < image_src->numcomps)
+				continue;
+			return pack_decoded_tile(p_output_image, packed_src.data(),
+					width_src, offset_x0_dest, offset_y0_dest, width_dest,
+					height_dest);
 		}
-			break;
-		case 2: {
-			int16_t *src_ptr = (int16_t*) p_data;
-
-			if (img_comp_src->sgnd) {
-				for (j = 0; j < height_dest; ++j) {
-					for (k = 0; k < width_dest; ++k) {
-						img_comp_dest->data[dest_ind++] = src_ptr[src_ind++];
-					}
-
-					dest_ind += line_offset_dest;
-					src_ind += line_offset_src;
-				}
-			} else {
-				for (j = 0; j < height_dest; ++j) {
-					for (k = 0; k < width_dest; ++k) {
-						img_comp_dest->data[dest_ind++] = src_ptr[src_ind++]
-								& 0xffff;
-					}
-					dest_ind += line_offset_dest;
-					src_ind += line_offset_src;
-				}
-			}
-			src_ind += end_offset_src;
-			p_data = (uint8_t*) (src_ptr + src_ind);
-		}
-			break;
-		case 4: {
-			auto src_ptr = (int32_t*) p_data;
-
-			for (j = 0; j < height_dest; ++j) {
-				for (k = 0; k < width_dest; ++k) {
-					img_comp_dest->data[dest_ind++] = src_ptr[src_ind++];
-					//memcpy(img_comp_dest->data+dest_ind, src_ptr+src_ind, sizeof(int32_t)*width_dest);
-				}
-
-				dest_ind += line_offset_dest;
-				src_ind += line_offset_src;
-			}
-
-			src_ind += end_offset_src;
-			p_data = (uint8_t*) (src_ptr + src_ind);
-		}
-			break;
+		int32_t *dest_ptr = img_comp_dest->data + start_offset_dest;
+		for (j = 0; j < height_dest; ++j) {
+			if (defer_dc_level_shift)
+				dc_level_shift_decode(i, src_ptr, dest_ptr, width_dest);
+			else
+				memcpy(dest_ptr, src_ptr, width_dest * sizeof(int32_t));
+			src_ptr += width_src;
+			dest_ptr += img_comp_dest->w;
 		}
 	}
 
@@ -2456,6 +2844,7 @@ void grk_tcd_cblk_dec::init() {
 	included = 0;
 #endif
 	numSegmentsAllocated = 0;
+	seg_in_place = false;
 }
 
 void grk_tcd_cblk_dec::cleanup() {
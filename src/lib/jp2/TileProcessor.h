@@ -57,6 +57,7 @@
 #pragma once
 #include "testing.h"
 #include <vector>
+#include <functional>
 
 namespace grk {
 
@@ -68,6 +69,7 @@ struct grk_tcd_seg {
 	void clear() {
 		dataindex = 0;
 		numpasses = 0;
+		real_num_passes = 0;
 		len = 0;
 		maxpasses = 0;
 		numPassesInPacket = 0;
@@ -75,6 +77,7 @@ struct grk_tcd_seg {
 	}
 	uint32_t dataindex;		      // segment data offset in contiguous memory block
 	uint32_t numpasses;		    	// number of passes in segment
+	uint32_t real_num_passes;		// number of passes in segment whose data has been read
 	uint32_t len;               // total length of segment
 	uint32_t maxpasses;			  	// maximum number of passes in segment
 	uint32_t numPassesInPacket;	  // number of passes contributed by current packet
@@ -120,13 +123,31 @@ struct grk_tcd_layer {
 
 const uint8_t cblk_compressed_data_pad_left = 2;
 
+// bytes of tile-part data either side of a code block's data that the
+// HT block decoder may read when it decodes the block in place
+const uint8_t cblk_dec_guard_bytes = 8;
+
+/**
+ * How the HT block coder codes the passes of a code block for rate control
+ */
+enum HT_RATE_MODE {
+	// cleanup pass one bit plane above the least significant, followed by
+	// SigProp and MagRef passes of the least significant bit plane
+	HT_RATE_REFINE_LSB,
+	// cleanup pass at each bit plane in turn, as candidate truncation points
+	HT_RATE_CANDIDATES,
+	// cleanup pass at the bit plane chosen from the candidates, followed by
+	// SigProp and MagRef passes of the bit plane below it
+	HT_RATE_CHOSEN_PLANE
+};
+
 // encoder code block
 struct grk_tcd_cblk_enc {
 	grk_tcd_cblk_enc() :
 			actualData(nullptr), data(nullptr), data_size(0), owns_data(false), layers(
 					nullptr), passes(nullptr), x0(0), y0(0), x1(0), y1(0), numbps(
 					0), numlenbits(0), num_passes_included_in_current_layer(0), num_passes_included_in_previous_layers(
-					0), num_passes_encoded(0),
+					0), num_passes_encoded(0), ht_plane(0),
 #ifdef DEBUG_LOSSLESS_T2
 							included(0),
 							packet_length_info(nullptr),
@@ -149,6 +170,9 @@ struct grk_tcd_cblk_enc {
 	uint32_t num_passes_included_in_current_layer; /* number of passes encoded in current layer */
 	uint32_t num_passes_included_in_previous_layers; /* number of passes in previous layers */
 	uint32_t num_passes_encoded; /* number of passes encoded */
+	// HT cleanup pass bit plane, counted up from the least significant:
+	// the coarsest candidate, and then the plane chosen by rate control
+	uint8_t ht_plane;
 	uint32_t *contextStream;
 #ifdef DEBUG_LOSSLESS_T2
 	uint32_t included;
@@ -171,6 +195,7 @@ struct grk_tcd_cblk_dec {
 														packet_length_info(nullptr),
 #endif
 					numSegmentsAllocated(0),
+					seg_in_place(false),
 					unencoded_data(nullptr){
 	}
 	/**
@@ -188,6 +213,10 @@ struct grk_tcd_cblk_dec {
 	uint32_t numPassesInPacket; /* number of passes added by current packet */
 	uint32_t numSegments; /* number of segment in block*/
 	uint32_t numSegmentsAllocated; // number of segments allocated for segs array
+	// seg_buffers are one contiguous range of a tile part, with
+	// cblk_dec_guard_bytes of the same tile part on either side,
+	// so that the block decoders can read them in place
+	bool seg_in_place;
 #ifdef DEBUG_LOSSLESS_T2
 	uint32_t included;
 	std::vector<grk_packet_length_info>* packet_length_info;
@@ -329,6 +358,19 @@ struct grk_tcd_tile {
 	uint64_t packno; /* packet number */
 };
 
+/**
+ * Code block of a tile, with its position in the tile, for rate control
+ */
+struct grk_rate_block {
+	uint32_t compno;
+	uint32_t resno;
+	uint32_t bandno;
+	uint32_t precno;
+	uint32_t cblkno;
+	grk_tcd_band *band;
+	grk_tcd_cblk_enc *cblk;
+};
+
 /**
  Tile coder/decoder
  */
@@ -339,10 +381,12 @@ struct TileProcessor {
 			  cur_tp_num(0),
 			  cur_totnum_tp(0),
 			  cur_pino(0),
+			  packet_lengths(nullptr),
 			  tile(nullptr),
 			  image(nullptr),
 			  current_plugin_tile(nullptr),
 			  whole_tile_decoding(true),
+			  defer_dc_level_shift(false),
 			  m_cp(nullptr),
 			  m_tcp(nullptr),
 			  m_tileno(0),
@@ -386,6 +430,34 @@ struct TileProcessor {
 			uint64_t *p_data_written, uint64_t len,
 			 grk_codestream_info  *p_cstr_info);
 
+	/**
+	 * Encodes the code blocks of a tile, and allocates them to layers,
+	 * when the first tile part is written. Does nothing for later tile parts.
+	 * @param	tile_no		Index of the tile to encode.
+	 * @param	len			Maximum length of the tile's packets
+	 * @param	p_cstr_info		Codestream information structure
+	 * @return  true if the coding is successful.
+	 */
+	bool encode_code_blocks(uint16_t tile_no, uint64_t len,
+			 grk_codestream_info  *p_cstr_info);
+
+	/**
+	 * Finds the length of each packet of a tile part, once the code
+	 * blocks are encoded, without writing the packets.
+	 * The tile parts must be simulated in the order that they are written.
+	 * @param	pino			packet iterator number of the tile part
+	 * @param	tpnum			tile part number, within pino
+	 * @param	len				Maximum length of the tile's packets
+	 * @param	packet_lengths	the length of each packet is appended to it
+	 * @return  true if the packets fit in len
+	 */
+	bool get_packet_lengths(uint32_t pino, uint32_t tpnum, uint64_t len,
+			std::vector<uint32_t> *packet_lengths);
+
+	bool t2_encode(BufferedStream *p_stream,
+			uint64_t *p_data_written, uint64_t max_dest_size,
+			 grk_codestream_info  *p_cstr_info);
+
 	/**
 	 Decode a tile from a buffer into a raw image
 	 @param src Source buffer
@@ -421,8 +493,14 @@ struct TileProcessor {
 
 	bool needs_rate_control();
 
-	bool copy_decoded_tile_to_output_image(uint8_t *p_data,
-			grk_image *p_output_image, bool clearOutputOnInit);
+	/**
+	 * Copy the decoded tile into the region of the output image that it
+	 * covers, applying the DC level shift if it was deferred. If the
+	 * output image has packed data, the samples are packed as they are
+	 * copied, and no component planes are allocated.
+	 */
+	bool copy_decoded_tile_to_output_image(grk_image *p_output_image,
+			bool clearOutputOnInit);
 
 	void copy_image_to_tile();
 
@@ -437,6 +515,8 @@ struct TileProcessor {
 	uint8_t cur_totnum_tp;
 	/** Current packet iterator number */
 	uint32_t cur_pino;
+	/** if not null, the length that each packet encoded must have */
+	const std::vector<uint32_t> *packet_lengths;
 	/** info on image tile */
 	grk_tcd_tile *tile;
 	/** image header */
@@ -446,6 +526,11 @@ struct TileProcessor {
     /** Only valid for decoding. Whether the whole tile is decoded, or just the region in win_x0/win_y0/win_x1/win_y1 */
     bool   whole_tile_decoding;
 
+    /** Only valid for decoding. Whether decode_tile leaves the DC level shift
+     * to copy_decoded_tile_to_output_image, which applies it as it writes
+     * the tile into the output image */
+    bool   defer_dc_level_shift;
+
 private:
 	/** coding parameters */
 	grk_coding_parameters *m_cp;
@@ -455,6 +540,12 @@ private:
 	uint16_t m_tileno;
 	/** indicate if the tcd is a decoder. */
 	bool m_is_decoder;
+	/**
+	 * code blocks of the tile being encoded, in component, resolution,
+	 * band, precinct and code block order, so that rate control can
+	 * process them concurrently
+	 */
+	std::vector<grk_rate_block> rate_blocks;
 
 	/**
 	 * Initializes tile coding/decoding
@@ -485,11 +576,48 @@ private:
 
 	 bool t1_decode();
 
+	 /**
+	  * Decode the code blocks of the tile, and run the inverse wavelet of
+	  * each resolution as soon as its code blocks are decoded, followed by
+	  * MCT and DC level shift once a component is complete.
+	  * Only valid for whole tile decoding.
+	  */
+	 bool t1_decode_pipelined();
+
 	 bool dwt_decode();
 
 	 bool mct_decode();
 
-	 bool dc_level_shift_decode();
+	 /**
+	  * Inverse MCT and DC level shift of every component. The standard
+	  * RCT/ICT is fused with the level shift, rounding and clamp of the
+	  * first three components, in one pass split into bands of rows
+	  * across the thread pool. Other components get the level shift alone.
+	  */
+	 bool mct_dc_level_shift_decode();
+
+	 /** clamp range of the decoded samples of a component */
+	 void dc_level_shift_range(uint32_t compno, int32_t *min, int32_t *max);
+
+	 bool dc_level_shift_decode(uint32_t compno);
+
+	 /**
+	  * Pack a region of the decoded tile into the packed data of the
+	  * output image, applying the DC level shift if it was deferred
+	  * @param p_output_image	output image
+	  * @param src			first sample of the region, for each component
+	  * @param src_stride		number of samples in a row of the tile buffer
+	  * @param x0			left edge of the region in the output image
+	  * @param y0			top edge of the region in the output image
+	  * @param w			width of the region
+	  * @param h			height of the region
+	  */
+	 bool pack_decoded_tile(grk_image *p_output_image,
+			 const int32_t *const *src, uint32_t src_stride, uint32_t x0,
+			 uint32_t y0, uint32_t w, uint32_t h);
+
+	 void dc_level_shift_decode(uint32_t compno, const int32_t *src,
+			 int32_t *dest, uint64_t n);
 
 	 bool dc_level_shift_encode();
 
@@ -497,17 +625,35 @@ private:
 
 	 bool dwt_encode();
 
-	 bool t1_encode();
+	 bool t1_encode(HT_RATE_MODE ht_mode);
 
-	 bool t2_encode(BufferedStream *p_stream,
-			uint64_t *p_data_written, uint64_t max_dest_size,
-			 grk_codestream_info  *p_cstr_info);
+	 /**
+	  * Rate control of HT code blocks is first run over candidate cleanup
+	  * passes, one per bit plane, when every layer is rate controlled
+	  */
+	 bool ht_needs_plane_choice();
+
+	 /**
+	  * Choose the cleanup pass bit plane of each HT code block,
+	  * from the candidate passes that rate control included in its layers
+	  */
+	 void ht_choose_planes();
 
 	 bool rate_allocate_encode(uint64_t max_dest_size,
 			 grk_codestream_info  *p_cstr_info);
 
 	 bool layer_needs_rate_control(uint32_t layno);
 
+	 /**
+	  * Synchronize the code blocks of the tile with the plugin, serially,
+	  * and, unless the tile is a single lossless layer, run f on the index
+	  * of each rate block, concurrently across code blocks. Then count
+	  * the pixels of the tile and of its components.
+	  * @return maximum squared error of the tile
+	  */
+	 double prepare_rate_blocks(bool single_lossless,
+			 const std::function<void(size_t)> &f);
+
 	 bool make_single_lossless_layer();
 
 	 void makelayer_final(uint32_t layno);
@@ -524,6 +670,9 @@ private:
 	 void makelayer_feasible(uint32_t layno, uint16_t thresh,
 			bool final);
 
+	 bool pcrd_incremental(uint64_t *p_data_written,
+			uint64_t len);
+
 };
 
 }
@@ -378,6 +378,8 @@ static bool j2k_read_header_procedure(grk_j2k *p_j2k, BufferedStream *p_stream)
 		/* Position of the last element if the main header */
 		p_j2k->cstr_index->main_head_end = (uint32_t) p_stream->tell() - 2;
 	}
+	if (p_j2k->m_cp.tl_marker)
+		j2k_build_tile_part_index(p_j2k, (uint64_t)p_stream->tell() - 2);
 
 	/* Next step: read a tile-part header */
 	p_j2k->m_specific_param.m_decoder.m_state = J2K_DEC_STATE_TPHSOT;
@@ -416,6 +418,12 @@ void j2k_setup_decoder(void *j2k_void,  grk_dparameters  *parameters) {
 	if (j2k && parameters) {
 		j2k->m_cp.m_coding_param.m_dec.m_layer = parameters->cp_layer;
 		j2k->m_cp.m_coding_param.m_dec.m_reduce = parameters->cp_reduce;
+		j2k->m_cp.m_coding_param.m_dec.m_max_tiles_in_flight =
+				parameters->max_tiles_in_flight;
+		j2k->m_cp.m_coding_param.m_dec.m_t1_schedule =
+				parameters->t1_schedule;
+		j2k->m_cp.m_coding_param.m_dec.m_disable_pipeline =
+				parameters->disable_pipeline;
 	}
 }
 
@@ -557,8 +565,8 @@ static bool j2k_setup_decoding_validation(grk_j2k *p_j2k) {
 }
 
 
-static bool j2k_need_nb_tile_parts_correction(BufferedStream *p_stream,
-		uint16_t tile_no, bool *p_correction_needed) {
+static bool j2k_need_nb_tile_parts_correction(grk_j2k *p_j2k,
+		BufferedStream *p_stream, uint16_t tile_no, bool *p_correction_needed) {
 	uint8_t l_header_data[10];
 	int64_t l_stream_pos_backup;
 	uint32_t l_current_marker;
@@ -581,6 +589,21 @@ static bool j2k_need_nb_tile_parts_correction(BufferedStream *p_stream,
 		return true;
 	}
 
+	/* with a tile-part index, go straight to the next tile-part of this tile */
+	auto tlm = p_j2k->m_cp.tl_marker;
+	if (tlm && !tlm->tile_part_offsets.empty()) {
+		uint64_t offset;
+		if (!j2k_next_tile_part(p_j2k, tile_no, (uint64_t)l_stream_pos_backup,
+				&offset))
+			return true;
+		if (!p_stream->seek((int64_t)offset)) {
+			if (!p_stream->seek(l_stream_pos_backup)) {
+				return false;
+			}
+			return true;
+		}
+	}
+
 	for (;;) {
 		/* Try to read 2 bytes (the next marker ID) from stream and copy them into the buffer */
 		if (p_stream->read(l_header_data, 2) != 2) {
@@ -811,8 +834,12 @@ bool j2k_read_tile_header(grk_j2k *p_j2k, uint16_t *tile_index,
 			}
 
 			if (p_j2k->m_specific_param.m_decoder.m_skip_data) {
-				// Skip the rest of the tile part header
-				if (!p_stream->skip(
+				// Jump to the next tile-part of the tile we are decoding,
+				// or else skip the rest of the tile part
+				int32_t tile_to_dec = p_j2k->m_specific_param.m_decoder.m_tile_ind_to_dec;
+				if (!(tile_to_dec >= 0 && j2k_seek_tile_part(p_j2k, p_stream,
+						(uint16_t)tile_to_dec, (uint64_t)p_stream->tell()))
+						&& !p_stream->skip(
 						p_j2k->m_specific_param.m_decoder.tile_part_data_length)) {
 					GROK_ERROR( "Stream too short");
 					return false;
@@ -864,7 +891,7 @@ bool j2k_read_tile_header(grk_j2k *p_j2k, uint16_t *tile_index,
 
 				p_j2k->m_specific_param.m_decoder.m_nb_tile_parts_correction_checked =
 						1;
-				if (!j2k_need_nb_tile_parts_correction(p_stream,
+				if (!j2k_need_nb_tile_parts_correction(p_j2k, p_stream,
 						p_j2k->m_current_tile_number, &l_correction_needed)) {
 					GROK_ERROR(
 							"j2k_apply_nb_tile_parts_correction error");
@@ -889,6 +916,13 @@ bool j2k_read_tile_header(grk_j2k *p_j2k, uint16_t *tile_index,
 				}
 			}
 			if (!p_j2k->m_specific_param.m_decoder.ready_to_decode_tile_part_data) {
+				/* when decoding a single tile, jump over the tile-parts of other tiles */
+				if (p_j2k->m_specific_param.m_decoder.m_tile_ind_to_dec >= 0
+						&& p_j2k->m_specific_param.m_decoder.m_state
+								== J2K_DEC_STATE_TPHSOT)
+					j2k_seek_tile_part(p_j2k, p_stream,
+							p_j2k->m_current_tile_number,
+							(uint64_t) p_stream->tell());
 				/* Try to read 2 bytes (the next marker ID) from stream and copy them into the buffer */
 				if (p_stream->read(
 						p_j2k->m_specific_param.m_decoder.m_header_data, 2) != 2) {
@@ -1028,8 +1062,80 @@ bool j2k_read_tile_header(grk_j2k *p_j2k, uint16_t *tile_index,
 	return true;
 }
 
-bool j2k_decode_tile(grk_j2k *p_j2k, uint16_t tile_index, uint8_t *p_data,
-		uint64_t data_size, BufferedStream *p_stream) {
+static bool j2k_end_tile_data(grk_j2k *p_j2k, BufferedStream *p_stream) {
+	p_j2k->m_specific_param.m_decoder.ready_to_decode_tile_part_data = 0;
+	p_j2k->m_specific_param.m_decoder.m_state &= (~(J2K_DEC_STATE_DATA));
+
+	// if there is no EOC marker and there is also no data left, then simply return true
+	if (p_stream->get_number_byte_left() == 0
+			&& p_j2k->m_specific_param.m_decoder.m_state
+					== J2K_DEC_STATE_NEOC) {
+		return true;
+	}
+	// if EOC marker has not been read yet, then try to read the next marker (should be EOC or SOT)
+	if (p_j2k->m_specific_param.m_decoder.m_state != J2K_DEC_STATE_EOC) {
+
+		uint8_t l_data[2];
+		// not enough data for another marker
+		if (p_stream->read(l_data, 2) != 2) {
+			GROK_WARN("j2k_end_tile_data: Not enough data to read another marker. Tile may be truncated.");
+			return true;
+		}
+
+		uint32_t l_current_marker=0;
+		// read marker
+		grok_read_bytes(l_data, &l_current_marker, 2);
+
+		switch(l_current_marker){
+		// we found the EOC marker - set state accordingly and return true;
+		// we can ignore all data after EOC
+		case J2K_MS_EOC:
+			p_j2k->m_current_tile_number = 0;
+			p_j2k->m_specific_param.m_decoder.m_state = J2K_DEC_STATE_EOC;
+			return true;
+			break;
+		// start of another tile
+		case J2K_MS_SOT:
+			return true;
+			break;
+		default:
+			{
+			auto bytesLeft = p_stream->get_number_byte_left();
+			// no bytes left - file ends without EOC marker
+			if (bytesLeft == 0) {
+				p_j2k->m_specific_param.m_decoder.m_state =
+						J2K_DEC_STATE_NEOC;
+				GROK_WARN("Stream does not end with EOC");
+				return true;
+			}
+			GROK_WARN("Decode tile: expected EOC or SOT "
+					"but found unknown \"marker\" %x. \n",
+					l_current_marker);
+			throw DecodeUnknownMarkerAtEndOfTileException();
+			}
+			break;
+		}
+	}
+
+	return true;
+}
+
+static void j2k_copy_resno_decoded(const grk_image *p_tile_image,
+		grk_image *p_output_image) {
+	for (uint32_t compno = 0; compno < p_output_image->numcomps; ++compno)
+		p_output_image->comps[compno].resno_decoded =
+				p_tile_image->comps[compno].resno_decoded;
+}
+
+/**
+ * Decode a tile. If p_data is not null, the samples are copied into it in
+ * the precision of the image. Otherwise, if compose is set, they are
+ * written into the region of the output image that the tile covers, and
+ * if not, the tile buffer is handed over to the output image.
+ */
+static bool j2k_decode_tile(grk_j2k *p_j2k, uint16_t tile_index,
+		uint8_t *p_data, uint64_t data_size, bool compose,
+		BufferedStream *p_stream) {
 	assert(p_stream != nullptr);
 	assert(p_j2k != nullptr);
 
@@ -1044,7 +1150,12 @@ bool j2k_decode_tile(grk_j2k *p_j2k, uint16_t tile_index, uint8_t *p_data,
 		return false;
 	}
 
-	if (!p_j2k->m_tileProcessor->decode_tile(l_tcp->m_tile_data, tile_index)) {
+	auto tileProcessor = p_j2k->m_tileProcessor;
+	// packed samples are written as the tile is copied to the output image
+	bool packed = !p_data && p_j2k->m_output_image
+			&& p_j2k->m_output_image->packed_data;
+	tileProcessor->defer_dc_level_shift = !p_data && (compose || packed);
+	if (!tileProcessor->decode_tile(l_tcp->m_tile_data, tile_index)) {
 		j2k_tcp_destroy(l_tcp);
 		p_j2k->m_specific_param.m_decoder.m_state |= J2K_DEC_STATE_ERR;
 		GROK_ERROR( "Failed to decode.");
@@ -1062,6 +1173,13 @@ bool j2k_decode_tile(grk_j2k *p_j2k, uint16_t tile_index, uint8_t *p_data,
 			if (!p_j2k->m_tileProcessor->update_tile_data(p_data, data_size)) {
 				return false;
 			}
+		} else if (compose || packed) {
+			if (!tileProcessor->copy_decoded_tile_to_output_image(
+					p_j2k->m_output_image, true)) {
+				return false;
+			}
+			j2k_copy_resno_decoded(tileProcessor->image,
+					p_j2k->m_output_image);
 		} else {
 			/* transfer data from tile component to output image */
 			uint32_t compno = 0;
@@ -1084,62 +1202,36 @@ bool j2k_decode_tile(grk_j2k *p_j2k, uint16_t tile_index, uint8_t *p_data,
 		delete l_tcp->m_tile_data;
 		l_tcp->m_tile_data = nullptr;
 
-		p_j2k->m_specific_param.m_decoder.ready_to_decode_tile_part_data = 0;
-		p_j2k->m_specific_param.m_decoder.m_state &= (~(J2K_DEC_STATE_DATA));
+		return j2k_end_tile_data(p_j2k, p_stream);
+	}
 
-		// if there is no EOC marker and there is also no data left, then simply return true
-		if (p_stream->get_number_byte_left() == 0
-				&& p_j2k->m_specific_param.m_decoder.m_state
-						== J2K_DEC_STATE_NEOC) {
-			return true;
-		}
-		// if EOC marker has not been read yet, then try to read the next marker (should be EOC or SOT)
-		if (p_j2k->m_specific_param.m_decoder.m_state != J2K_DEC_STATE_EOC) {
+	return true;
+}
 
-			uint8_t l_data[2];
-			// not enough data for another marker
-			if (p_stream->read(l_data, 2) != 2) {
-				GROK_WARN("j2k_decode_tile: Not enough data to read another marker. Tile may be truncated.");
-				return true;
-			}
+bool j2k_decode_tile(grk_j2k *p_j2k, uint16_t tile_index, uint8_t *p_data,
+		uint64_t data_size, BufferedStream *p_stream) {
+	return j2k_decode_tile(p_j2k, tile_index, p_data, data_size, false,
+			p_stream);
+}
 
-			uint32_t l_current_marker=0;
-			// read marker
-			grok_read_bytes(l_data, &l_current_marker, 2);
+bool j2k_set_output_format(grk_j2k *p_j2k, const grk_output_format *format) {
+	p_j2k->m_cp.m_coding_param.m_dec.m_output_format = *format;
+	return true;
+}
 
-			switch(l_current_marker){
-			// we found the EOC marker - set state accordingly and return true;
-			// we can ignore all data after EOC
-			case J2K_MS_EOC:
-				p_j2k->m_current_tile_number = 0;
-				p_j2k->m_specific_param.m_decoder.m_state = J2K_DEC_STATE_EOC;
-				return true;
-				break;
-			// start of another tile
-			case J2K_MS_SOT:
-				return true;
-				break;
-			default:
-				{
-				auto bytesLeft = p_stream->get_number_byte_left();
-				// no bytes left - file ends without EOC marker
-				if (bytesLeft == 0) {
-					p_j2k->m_specific_param.m_decoder.m_state =
-							J2K_DEC_STATE_NEOC;
-					GROK_WARN("Stream does not end with EOC");
-					return true;
-				}
-				GROK_WARN("Decode tile: expected EOC or SOT "
-						"but found unknown \"marker\" %x. \n",
-						l_current_marker);
-				throw DecodeUnknownMarkerAtEndOfTileException();
-				}
-				break;
-			}
-		}
-	}
+/**
+ * Set up the packed samples of the output image, if the output format
+ * asks for them, so that each tile is packed as it is copied to the
+ * output image
+ */
+static bool j2k_alloc_packed_output(grk_j2k *p_j2k) {
+	auto format = &p_j2k->m_cp.m_coding_param.m_dec.m_output_format;
+	if (format->sample_type == GRK_SAMPLE_INT32)
+		return true;
+	// tiles that are missing from the code stream leave their region at zero
+	bool clear = p_j2k->m_cp.tw * p_j2k->m_cp.th > 1;
 
-	return true;
+	return grk_image_alloc_packed(p_j2k->m_output_image, format, clear);
 }
 
 bool j2k_set_decode_area(grk_j2k *p_j2k, grk_image *p_image, uint32_t start_x,
@@ -1321,26 +1413,203 @@ grk_j2k* j2k_create_decompress(void) {
 }
 
 
-static bool j2k_decode_tiles(grk_j2k *p_j2k, BufferedStream *p_stream) {
+/**
+ * Tile handed off to the thread pool for decoding
+ */
+struct grk_tile_in_flight {
+	grk_tile_in_flight() : tileProcessor(nullptr),
+							image_header(nullptr),
+							tile_no(0)
+	{}
+	~grk_tile_in_flight() {
+		delete tileProcessor;
+		grk_image_destroy(image_header);
+	}
+	TileProcessor *tileProcessor;
+	// private copy of image header, as decoding updates resno_decoded
+	grk_image *image_header;
+	uint16_t tile_no;
+	std::future<bool> result;
+};
+
+static bool j2k_wait_for_tile(grk_j2k *p_j2k, grk_tile_in_flight *tile,
+		uint32_t num_tiles) {
+	bool rc = false;
+	try {
+		rc = tile->result.get();
+	} catch (std::exception &e) {
+		GROK_ERROR("%s", e.what());
+		rc = false;
+	}
+	if (rc) {
+		j2k_copy_resno_decoded(tile->image_header, p_j2k->m_output_image);
+	} else {
+		p_j2k->m_specific_param.m_decoder.m_state |= J2K_DEC_STATE_ERR;
+		GROK_ERROR( "Failed to decode tile %d/%d\n", tile->tile_no + 1,
+				num_tiles);
+	}
+	delete tile;
+
+	return rc;
+}
+
+static bool j2k_decode_tiles_concurrent(grk_j2k *p_j2k, BufferedStream *p_stream,
+		uint32_t max_tiles_in_flight) {
 	bool go_on = true;
+	bool rc = true;
 	uint16_t current_tile_no = 0;
-	uint64_t data_size = 0, max_data_size = 0;
+	uint64_t data_size = 0;
 	uint32_t nb_comps = 0;
-	uint8_t *current_data = nullptr;
-	uint32_t nr_tiles = 0;
 	uint32_t num_tiles_to_decode = p_j2k->m_cp.th * p_j2k->m_cp.tw;
-	bool clearOutputOnInit = false;
-	// if number of tiles is greater than 1, then we need to copy tile data
-	if (num_tiles_to_decode > 1) {
-		current_data = (uint8_t*) grok_malloc(1);
-		if (!current_data) {
-			GROK_ERROR(
-					"Not enough memory to decode tiles");
+	uint32_t num_tiles_decoded = 0;
+	auto output_image = p_j2k->m_output_image;
+	auto tileProcessor = p_j2k->m_tileProcessor;
+	std::deque<grk_tile_in_flight*> in_flight;
+
+	// allocate output components up front, so that tiles
+	// can be copied to the output image concurrently. Packed
+	// output has already been allocated.
+	for (uint32_t compno = 0; compno < output_image->numcomps; ++compno) {
+		auto comp = output_image->comps + compno;
+		if (comp->data || output_image->packed_data
+				|| comp->w * comp->h == 0)
+			continue;
+		if (!grk_image_single_component_data_alloc(comp)) {
+			GROK_ERROR("Not enough memory to decode tiles");
 			return false;
 		}
-		max_data_size = 1;
-		clearOutputOnInit = num_tiles_to_decode > 1;
+		memset(comp->data, 0, (size_t)comp->w * comp->h * sizeof(int32_t));
+	}
+
+	for (uint32_t nr_tiles = 0; nr_tiles < num_tiles_to_decode; nr_tiles++) {
+		auto tile = new grk_tile_in_flight();
+		tile->image_header = grk_image_create0();
+		if (!tile->image_header) {
+			delete tile;
+			rc = false;
+			break;
+		}
+		grk_copy_image_header(p_j2k->m_private_image, tile->image_header);
+		tile->tileProcessor = new TileProcessor(true);
+		if (!tile->tileProcessor->init(tile->image_header, &p_j2k->m_cp)) {
+			delete tile;
+			rc = false;
+			break;
+		}
+		tile->tileProcessor->whole_tile_decoding =
+				tileProcessor->whole_tile_decoding;
+		p_j2k->m_tileProcessor = tile->tileProcessor;
+
+		uint32_t tile_x0, tile_y0, tile_x1, tile_y1;
+		tile_x0 = tile_y0 = tile_x1 = tile_y1 = 0;
+		if (!j2k_read_tile_header(p_j2k, &current_tile_no, &data_size,
+				&tile_x0, &tile_y0, &tile_x1, &tile_y1, &nb_comps,
+				&go_on, p_stream)) {
+			delete tile;
+			rc = false;
+			break;
+		}
+		if (!go_on) {
+			delete tile;
+			break;
+		}
+
+		// take ownership of the tile data, which will be re-read in read_tile_header
+		auto l_tcp = p_j2k->m_cp.tcps + current_tile_no;
+		auto tile_data = l_tcp->m_tile_data;
+		l_tcp->m_tile_data = nullptr;
+		if (!tile_data) {
+			j2k_tcp_destroy(l_tcp);
+			delete tile;
+			rc = false;
+			break;
+		}
+		tile->tile_no = current_tile_no;
+		auto tp = tile->tileProcessor;
+		tile->result = Scheduler::g_tp->enqueue(
+				[tp, tile_data, current_tile_no, output_image] {
+			tp->defer_dc_level_shift = true;
+			bool success = tp->decode_tile(tile_data, current_tile_no);
+			delete tile_data;
+
+			return success
+					&& tp->copy_decoded_tile_to_output_image(output_image, true);
+		});
+		in_flight.push_back(tile);
+
+		try {
+			j2k_end_tile_data(p_j2k, p_stream);
+		} catch (DecodeUnknownMarkerAtEndOfTileException &e) {
+			// only worry about exception if we have more tiles to decode
+			if (nr_tiles < num_tiles_to_decode - 1) {
+				GROK_ERROR("Stream too short, expected SOT");
+				rc = false;
+				break;
+			}
+		}
+
+		if (in_flight.size() == max_tiles_in_flight) {
+			auto oldest = in_flight.front();
+			in_flight.pop_front();
+			if (!j2k_wait_for_tile(p_j2k, oldest, num_tiles_to_decode)) {
+				rc = false;
+				break;
+			}
+			num_tiles_decoded++;
+		}
+
+		if (p_stream->get_number_byte_left() == 0
+				&& p_j2k->m_specific_param.m_decoder.m_state
+						== J2K_DEC_STATE_NEOC)
+			break;
 	}
+	// tiles still in flight reference the coding parameters and
+	// output image, so they must complete even on failure
+	while (!in_flight.empty()) {
+		auto oldest = in_flight.front();
+		in_flight.pop_front();
+		if (j2k_wait_for_tile(p_j2k, oldest, num_tiles_to_decode))
+			num_tiles_decoded++;
+		else
+			rc = false;
+	}
+	p_j2k->m_tileProcessor = tileProcessor;
+	if (!rc)
+		return false;
+
+	if (num_tiles_decoded == 0) {
+		GROK_ERROR( "No tiles were decoded. Exiting");
+		return false;
+	} else if (num_tiles_decoded < num_tiles_to_decode) {
+		GROK_WARN(
+				"Only %d out of %d tiles were decoded\n", num_tiles_decoded,
+				num_tiles_to_decode);
+	}
+	return true;
+}
+
+static bool j2k_decode_tiles(grk_j2k *p_j2k, BufferedStream *p_stream) {
+	bool go_on = true;
+	uint16_t current_tile_no = 0;
+	uint64_t data_size = 0;
+	uint32_t nb_comps = 0;
+	uint32_t nr_tiles = 0;
+	uint32_t num_tiles_to_decode = p_j2k->m_cp.th * p_j2k->m_cp.tw;
+
+	// decode tiles concurrently, unless packet headers are shared
+	// between tiles (PPM) or a plugin is driving the decode
+	uint32_t max_tiles_in_flight =
+			p_j2k->m_cp.m_coding_param.m_dec.m_max_tiles_in_flight;
+	if (!max_tiles_in_flight)
+		max_tiles_in_flight = (uint32_t)Scheduler::g_tp->num_threads();
+	max_tiles_in_flight = std::min<uint32_t>(max_tiles_in_flight,
+			num_tiles_to_decode);
+	if (max_tiles_in_flight > 1 && !p_j2k->m_cp.ppm
+			&& !p_j2k->m_tileProcessor->current_plugin_tile)
+		return j2k_decode_tiles_concurrent(p_j2k, p_stream, max_tiles_in_flight);
+	// if number of tiles is greater than 1, then each tile is written
+	// into its region of the output image
+	bool compose = num_tiles_to_decode > 1;
 	uint32_t num_tiles_decoded = 0;
 
 	for (nr_tiles = 0; nr_tiles < num_tiles_to_decode; nr_tiles++) {
@@ -1349,8 +1618,6 @@ static bool j2k_decode_tiles(grk_j2k *p_j2k, BufferedStream *p_stream) {
 		if (!j2k_read_tile_header(p_j2k, &current_tile_no, &data_size,
 				&tile_x0, &tile_y0, &tile_x1, &tile_y1, &nb_comps,
 				&go_on, p_stream)) {
-			if (current_data)
-				grok_free(current_data);
 			return false;
 		}
 
@@ -1358,25 +1625,9 @@ static bool j2k_decode_tiles(grk_j2k *p_j2k, BufferedStream *p_stream) {
 			break;
 		}
 
-		if (current_data && (data_size > max_data_size)) {
-			uint8_t *new_current_data = (uint8_t*) grok_realloc(
-					current_data, data_size);
-			if (!new_current_data) {
-				grok_free(current_data);
-				GROK_ERROR(
-						"Not enough memory to decode tile %d/%d\n",
-						current_tile_no + 1, num_tiles_to_decode);
-				return false;
-			}
-			current_data = new_current_data;
-			max_data_size = data_size;
-		}
-
 		try {
-			if (!j2k_decode_tile(p_j2k, current_tile_no, current_data,
-					data_size, p_stream)) {
-				if (current_data)
-					grok_free(current_data);
+			if (!j2k_decode_tile(p_j2k, current_tile_no, nullptr, 0, compose,
+					p_stream)) {
 				GROK_ERROR( "Failed to decode tile %d/%d\n",
 						current_tile_no + 1, num_tiles_to_decode);
 				return false;
@@ -1386,8 +1637,6 @@ static bool j2k_decode_tiles(grk_j2k *p_j2k, BufferedStream *p_stream) {
 			if (nr_tiles < num_tiles_to_decode - 1) {
 				GROK_ERROR(
 						"Stream too short, expected SOT");
-				if (current_data)
-					grok_free(current_data);
 				GROK_ERROR( "Failed to decode tile %d/%d\n",
 						current_tile_no + 1, num_tiles_to_decode);
 				return false;
@@ -1395,16 +1644,6 @@ static bool j2k_decode_tiles(grk_j2k *p_j2k, BufferedStream *p_stream) {
 		}
 		//event_msg( EVT_INFO, "Tile %d/%d has been decoded.\n", current_tile_no +1, num_tiles_to_decode);
 
-		/* copy from current data to output image, if necessary */
-		if (current_data) {
-			if (!p_j2k->m_tileProcessor->copy_decoded_tile_to_output_image(
-					current_data, p_j2k->m_output_image, clearOutputOnInit)) {
-				grok_free(current_data);
-				return false;
-			}
-			// event_msg( EVT_INFO, "Image data has been updated with tile %d.\n\n", current_tile_no + 1);
-		}
-
 		num_tiles_decoded++;
 
 		if (p_stream->get_number_byte_left() == 0
@@ -1413,10 +1652,6 @@ static bool j2k_decode_tiles(grk_j2k *p_j2k, BufferedStream *p_stream) {
 			break;
 	}
 
-	if (current_data) {
-		grok_free(current_data);
-	}
-
 	if (num_tiles_decoded == 0) {
 		GROK_ERROR( "No tiles were decoded. Exiting");
 		return false;
@@ -1436,16 +1671,13 @@ static bool j2k_decode_one_tile(grk_j2k *p_j2k, BufferedStream *p_stream) {
 	bool go_on = true;
 	uint16_t current_tile_no;
 	uint32_t tile_no_to_dec;
-	uint64_t data_size = 0, max_data_size = 0;
+	uint64_t data_size = 0;
 	uint32_t tile_x0, tile_y0, tile_x1, tile_y1;
 	uint32_t nb_comps;
-	uint8_t *current_data = nullptr;
 
 	/*Allocate and initialize some elements of codestream index if not already done*/
 	if (!p_j2k->cstr_index->tile_index) {
 		if (!j2k_allocate_tile_element_cstr_index(p_j2k)) {
-			if (current_data)
-				grok_free(current_data);
 			return false;
 		}
 	}
@@ -1455,14 +1687,19 @@ static bool j2k_decode_one_tile(grk_j2k *p_j2k, BufferedStream *p_stream) {
 		if (p_j2k->cstr_index->tile_index->tp_index) {
 			if (!p_j2k->cstr_index->tile_index[tile_no_to_dec].nb_tps) {
 				/* the index for this tile has not been built,
-				 *  so move to the last SOT read */
-				if (!(p_stream->seek(
+				 *  so move to its first tile-part if the TLM markers locate it,
+				 *  or else to the last SOT read */
+				if (j2k_seek_tile_part(p_j2k, p_stream, (uint16_t) tile_no_to_dec,
+						0)) {
+					if (!p_stream->skip(2)) {
+						GROK_ERROR( "Stream too short");
+						return false;
+					}
+				} else if (!(p_stream->seek(
 						p_j2k->m_specific_param.m_decoder.m_last_sot_read_pos
 								+ 2))) {
 					GROK_ERROR(
 							"Problem with seek function");
-					if (current_data)
-						grok_free(current_data);
 					return false;
 				}
 			} else {
@@ -1471,8 +1708,6 @@ static bool j2k_decode_one_tile(grk_j2k *p_j2k, BufferedStream *p_stream) {
 								+ 2))) {
 					GROK_ERROR(
 							"Problem with seek function");
-					if (current_data)
-						grok_free(current_data);
 					return false;
 				}
 			}
@@ -1486,8 +1721,6 @@ static bool j2k_decode_one_tile(grk_j2k *p_j2k, BufferedStream *p_stream) {
 		if (!j2k_read_tile_header(p_j2k, &current_tile_no, &data_size,
 				&tile_x0, &tile_y0, &tile_x1, &tile_y1, &nb_comps,
 				&go_on, p_stream)) {
-			if (current_data)
-				grok_free(current_data);
 			return false;
 		}
 
@@ -1495,26 +1728,9 @@ static bool j2k_decode_one_tile(grk_j2k *p_j2k, BufferedStream *p_stream) {
 			break;
 		}
 
-		if (current_data && data_size > max_data_size) {
-			uint8_t *new_current_data = (uint8_t*) grok_realloc(
-					current_data, data_size);
-			if (!new_current_data) {
-				grok_free(current_data);
-				current_data = nullptr;
-				GROK_ERROR(
-						"Not enough memory to decode tile %d/%d\n",
-						current_tile_no + 1, p_j2k->m_cp.th * p_j2k->m_cp.tw);
-				return false;
-			}
-			current_data = new_current_data;
-			max_data_size = data_size;
-		}
-
 		try {
-			if (!j2k_decode_tile(p_j2k, current_tile_no, current_data,
-					data_size, p_stream)) {
-				if (current_data)
-					grok_free(current_data);
+			if (!j2k_decode_tile(p_j2k, current_tile_no, nullptr, 0, false,
+					p_stream)) {
 				return false;
 			}
 		} catch (DecodeUnknownMarkerAtEndOfTileException &e) {
@@ -1522,20 +1738,11 @@ static bool j2k_decode_one_tile(grk_j2k *p_j2k, BufferedStream *p_stream) {
 		}
 		//event_msg( EVT_INFO, "Tile %d/%d has been decoded.\n", current_tile_no+1, p_j2k->m_cp.th * p_j2k->m_cp.tw);
 
-		if (current_data) {
-			if (!p_j2k->m_tileProcessor->copy_decoded_tile_to_output_image(
-					current_data, p_j2k->m_output_image, false)) {
-				grok_free(current_data);
-				return false;
-			}
-		}
 		//event_msg( EVT_INFO, "Image data has been updated with tile %d.\n\n", current_tile_no+1);
 		if (current_tile_no == tile_no_to_dec) {
 			/* move into the codestream to the first SOT (FIXME or not move?)*/
 			if (!(p_stream->seek(p_j2k->cstr_index->main_head_end + 2))) {
 				GROK_ERROR( "Problem with seek function");
-				if (current_data)
-					grok_free(current_data);
 				return false;
 			}
 			break;
@@ -1546,8 +1753,6 @@ static bool j2k_decode_one_tile(grk_j2k *p_j2k, BufferedStream *p_stream) {
 		}
 
 	}
-	if (current_data)
-		grok_free(current_data);
 	return true;
 }
 
@@ -1574,6 +1779,8 @@ bool j2k_decode(grk_j2k *p_j2k, grk_plugin_tile *tile, BufferedStream *p_stream,
 		return false;
 	}
 	grk_copy_image_header(p_image, p_j2k->m_output_image);
+	if (!j2k_alloc_packed_output(p_j2k))
+		return false;
 
 	/* customization of the decoding */
 	if (!j2k_setup_decoding(p_j2k))
@@ -1679,6 +1886,8 @@ bool j2k_get_tile(grk_j2k *p_j2k, BufferedStream *p_stream, grk_image *p_image,
 		return false;
 	}
 	grk_copy_image_header(p_image, p_j2k->m_output_image);
+	if (!j2k_alloc_packed_output(p_j2k))
+		return false;
 
 	p_j2k->m_specific_param.m_decoder.m_tile_ind_to_dec = (int32_t) tile_index;
 
@@ -1772,6 +1981,8 @@ static void j2k_tcp_destroy(grk_tcp *p_tcp) {
 
 	delete p_tcp->m_tile_data;
 	p_tcp->m_tile_data = nullptr;
+	delete p_tcp->m_packet_lengths;
+	p_tcp->m_packet_lengths = nullptr;
 
 }
 
@@ -2020,6 +2231,12 @@ bool j2k_setup_encoder(grk_j2k *p_j2k,  grk_cparameters  *parameters,
 			& 1u;
 	cp->m_coding_param.m_enc.rateControlAlgorithm =
 			parameters->rateControlAlgorithm;
+	cp->m_coding_param.m_enc.m_max_tiles_in_flight =
+			parameters->max_tiles_in_flight;
+	cp->m_coding_param.m_enc.m_write_plt = parameters->write_plt;
+	// cinema and IMF profiles always have TLM markers
+	cp->m_coding_param.m_enc.m_write_tlm = parameters->write_tlm
+			|| GRK_IS_CINEMA(cp->rsiz) || GRK_IS_IMF(cp->rsiz);
 
 	/* tiles */
 	cp->tdx = parameters->cp_tdx;
@@ -2350,6 +2567,30 @@ bool j2k_encode(grk_j2k *p_j2k, grk_plugin_tile *tile, BufferedStream *p_stream)
 				"allowed by the standard.", nb_tiles,max_num_tiles );
 		return false;
 	}
+	// encode tiles concurrently, unless a plugin is driving the encode
+	uint32_t max_tiles_in_flight =
+			p_j2k->m_cp.m_coding_param.m_enc.m_max_tiles_in_flight;
+	if (!max_tiles_in_flight)
+		max_tiles_in_flight = (uint32_t)Scheduler::g_tp->num_threads();
+	max_tiles_in_flight = std::min<uint32_t>(max_tiles_in_flight, nb_tiles);
+	if (max_tiles_in_flight > 1) {
+		// each tile in flight holds its samples and its code stream buffer
+		auto cp = &p_j2k->m_cp;
+		auto image = p_j2k->m_private_image;
+		uint64_t tile_bytes = j2k_get_max_tile_size(p_j2k) + 1;
+		for (j = 0; j < image->numcomps; ++j) {
+			auto img_comp = image->comps + j;
+			tile_bytes += (uint64_t) ceildiv<uint32_t>(cp->tdx, img_comp->dx)
+					* ceildiv<uint32_t>(cp->tdy, img_comp->dy)
+					* sizeof(int32_t);
+		}
+		max_tiles_in_flight = (uint32_t) std::min<uint64_t>(
+				max_tiles_in_flight,
+				std::max<uint64_t>(max_concurrent_encode_memory / tile_bytes,
+						1));
+	}
+	if (max_tiles_in_flight > 1 && !tile)
+		return j2k_encode_tiles_concurrent(p_j2k, p_stream, max_tiles_in_flight);
 	if (nb_tiles == 1) {
 		transfer_image_to_tile = true;
 #ifdef __SSE__
@@ -2456,10 +2697,8 @@ static bool j2k_pre_write_tile(grk_j2k *p_j2k, uint16_t tile_index) {
 		return false;
 	}
 	//event_msg( EVT_INFO, "tile number %d / %d\n", p_j2k->m_current_tile_number + 1, p_j2k->m_cp.tw * p_j2k->m_cp.th);
-	p_j2k->m_specific_param.m_encoder.m_current_tile_part_number = 0;
 	p_j2k->m_tileProcessor->cur_totnum_tp =
 			p_j2k->m_cp.tcps[tile_index].m_nb_tile_parts;
-	p_j2k->m_specific_param.m_encoder.m_current_poc_tile_part_number = 0;
 
 	/* initialisation before tile encoding  */
 	if (!p_j2k->m_tileProcessor->init_encode_tile(p_j2k->m_current_tile_number)) {
@@ -2470,6 +2709,135 @@ static bool j2k_pre_write_tile(grk_j2k *p_j2k, uint16_t tile_index) {
 }
 
 static bool j2k_post_write_tile(grk_j2k *p_j2k, BufferedStream *p_stream) {
+	grk_tile_writer writer(p_j2k->m_tileProcessor, p_j2k->m_current_tile_number,
+			p_j2k->m_specific_param.m_encoder.m_tlm_sot_offsets_current);
+	if (!j2k_write_tile_parts(p_j2k, &writer, p_stream))
+		return false;
+	p_j2k->m_specific_param.m_encoder.m_tlm_sot_offsets_current =
+			writer.m_tlm_sot_offsets_current;
+	++p_j2k->m_current_tile_number;
+	return true;
+}
+
+/**
+ * Tile handed off to the thread pool for encoding
+ */
+struct grk_encoded_tile {
+	grk_encoded_tile() : stream(nullptr),
+						buffer(nullptr),
+						tile_no(0)
+	{}
+	~grk_encoded_tile() {
+		delete stream;
+		grok_free(buffer);
+	}
+	// memory stream holding the encoded tile parts in buffer
+	BufferedStream *stream;
+	uint8_t *buffer;
+	uint16_t tile_no;
+	std::future<bool> result;
+};
+
+static bool j2k_write_encoded_tile(grk_encoded_tile *tile,
+		BufferedStream *p_stream) {
+	bool rc = false;
+	try {
+		rc = tile->result.get();
+	} catch (std::exception &e) {
+		GROK_ERROR("%s", e.what());
+		rc = false;
+	}
+	if (rc) {
+		auto len = (size_t) tile->stream->tell();
+		rc = p_stream->write_bytes(tile->buffer, len) == len;
+	} else {
+		GROK_ERROR("Failed to encode tile %d\n", tile->tile_no + 1);
+	}
+	delete tile;
+
+	return rc;
+}
+
+static bool j2k_encode_tiles_concurrent(grk_j2k *p_j2k, BufferedStream *p_stream,
+		uint32_t max_tiles_in_flight) {
+	bool rc = true;
+	auto cp = &p_j2k->m_cp;
+	auto image = p_j2k->m_private_image;
+	uint16_t nb_tiles = (uint16_t)(cp->th * cp->tw);
+	// room for the final byte, which a memory stream will not write
+	uint64_t max_tile_size = j2k_get_max_tile_size(p_j2k) + 1;
+	auto tlm_current = p_j2k->m_specific_param.m_encoder.m_tlm_sot_offsets_current;
+	bool use_tlm = cp->m_coding_param.m_enc.m_write_tlm;
+	uint32_t tlm_entry_size = j2k_get_tlm_entry_size(cp);
+	std::deque<grk_encoded_tile*> in_flight;
+
+	for (uint16_t tile_no = 0; tile_no < nb_tiles; ++tile_no) {
+		auto tile = new grk_encoded_tile();
+		tile->tile_no = tile_no;
+		tile->buffer = (uint8_t*) grok_malloc(max_tile_size);
+		if (!tile->buffer) {
+			GROK_ERROR("Not enough memory to encode tile %d", tile_no + 1);
+			delete tile;
+			rc = false;
+			break;
+		}
+		tile->stream = (BufferedStream*) create_mem_stream(tile->buffer,
+				max_tile_size, false, false);
+		auto stream = tile->stream;
+		// each tile writes its tile part lengths into its own slots in the TLM buffer
+		auto tlm = tlm_current;
+		if (use_tlm)
+			tlm_current += tlm_entry_size * cp->tcps[tile_no].m_nb_tile_parts;
+		tile->result = Scheduler::g_tp->enqueue(
+				[p_j2k, cp, image, tile_no, tlm, stream] {
+			std::unique_ptr<TileProcessor> tp(new TileProcessor(false));
+			if (!tp->init(image, cp))
+				return false;
+			tp->cur_totnum_tp = cp->tcps[tile_no].m_nb_tile_parts;
+			if (!tp->init_encode_tile(tile_no))
+				return false;
+			for (uint32_t j = 0; j < image->numcomps; ++j) {
+				if (!tp->tile->comps[j].buf->alloc_component_data_encode()) {
+					GROK_ERROR("Error allocating tile component data.");
+					return false;
+				}
+			}
+			tp->copy_image_to_tile();
+			grk_tile_writer writer(tp.get(), tile_no, tlm);
+			return j2k_write_tile_parts(p_j2k, &writer, stream);
+		});
+		in_flight.push_back(tile);
+
+		if (in_flight.size() == max_tiles_in_flight) {
+			auto oldest = in_flight.front();
+			in_flight.pop_front();
+			if (!j2k_write_encoded_tile(oldest, p_stream)) {
+				rc = false;
+				break;
+			}
+		}
+	}
+	// tiles still in flight reference the coding parameters and
+	// image, so they must complete even on failure
+	while (!in_flight.empty()) {
+		auto oldest = in_flight.front();
+		in_flight.pop_front();
+		if (rc) {
+			rc = j2k_write_encoded_tile(oldest, p_stream);
+		} else {
+			oldest->result.wait();
+			delete oldest;
+		}
+	}
+	if (!rc)
+		return false;
+	p_j2k->m_specific_param.m_encoder.m_tlm_sot_offsets_current = tlm_current;
+	p_j2k->m_current_tile_number = nb_tiles;
+
+	return true;
+}
+
+static uint64_t j2k_get_max_tile_size(grk_j2k *p_j2k) {
 	auto cp = &(p_j2k->m_cp);
 	auto image = p_j2k->m_private_image;
 	auto img_comp = image->comps;
@@ -2492,19 +2860,23 @@ static bool j2k_post_write_tile(grk_j2k *p_j2k, BufferedStream *p_stream) {
 	if (tile_size < 256 * image->numcomps)
 		tile_size = 256 * image->numcomps;
 
-	uint64_t available_data = tile_size;
+	return tile_size;
+}
+
+static bool j2k_write_tile_parts(grk_j2k *p_j2k, grk_tile_writer *p_writer,
+		BufferedStream *p_stream) {
+	uint64_t available_data = j2k_get_max_tile_size(p_j2k);
 	uint64_t nb_bytes_written=0;
-	if (!j2k_write_first_tile_part(p_j2k, &nb_bytes_written, available_data,
-			p_stream)) {
+	if (!j2k_write_first_tile_part(p_j2k, p_writer, &nb_bytes_written,
+			available_data, p_stream)) {
 		return false;
 	}
 	available_data -= nb_bytes_written;
 	nb_bytes_written = 0;
-	if (!j2k_write_all_tile_parts(p_j2k, &nb_bytes_written, available_data,
-			p_stream)) {
+	if (!j2k_write_all_tile_parts(p_j2k, p_writer, &nb_bytes_written,
+			available_data, p_stream)) {
 		return false;
 	}
-	++p_j2k->m_current_tile_number;
 	return true;
 }
 
@@ -2512,7 +2884,7 @@ static bool j2k_setup_end_compress(grk_j2k *p_j2k) {
 	assert(p_j2k != nullptr);
 
 	p_j2k->m_procedure_list->push_back((j2k_procedure) j2k_write_eoc);
-	if (GRK_IS_CINEMA(p_j2k->m_cp.rsiz) || GRK_IS_IMF(p_j2k->m_cp.rsiz))
+	if (p_j2k->m_cp.m_coding_param.m_enc.m_write_tlm)
 		p_j2k->m_procedure_list->push_back((j2k_procedure) j2k_write_updated_tlm);
 	p_j2k->m_procedure_list->push_back((j2k_procedure) j2k_write_epc);
 	p_j2k->m_procedure_list->push_back((j2k_procedure) j2k_end_encoding);
@@ -2621,12 +2993,10 @@ static bool j2k_setup_header_writing(grk_j2k *p_j2k) {
 	p_j2k->m_procedure_list->push_back((j2k_procedure) j2k_write_all_qcc);
 
 
-	if (GRK_IS_CINEMA(p_j2k->m_cp.rsiz)  || GRK_IS_IMF(p_j2k->m_cp.rsiz)) {
+	if (p_j2k->m_cp.m_coding_param.m_enc.m_write_tlm)
 		p_j2k->m_procedure_list->push_back((j2k_procedure) j2k_write_tlm);
-		if (p_j2k->m_cp.rsiz == GRK_PROFILE_CINEMA_4K) {
-			p_j2k->m_procedure_list->push_back((j2k_procedure) j2k_write_poc);
-		}
-	}
+	if (p_j2k->m_cp.rsiz == GRK_PROFILE_CINEMA_4K)
+		p_j2k->m_procedure_list->push_back((j2k_procedure) j2k_write_poc);
 	p_j2k->m_procedure_list->push_back((j2k_procedure) j2k_write_regions);
 	p_j2k->m_procedure_list->push_back((j2k_procedure) j2k_write_com);
 	//begin custom procedures
@@ -2645,24 +3015,25 @@ static bool j2k_setup_header_writing(grk_j2k *p_j2k) {
 	return true;
 }
 
-static bool j2k_write_first_tile_part(grk_j2k *p_j2k, uint64_t *p_data_written,
-		uint64_t total_data_size, BufferedStream *p_stream) {
+static bool j2k_write_first_tile_part(grk_j2k *p_j2k, grk_tile_writer *p_writer,
+		uint64_t *p_data_written, uint64_t total_data_size,
+		BufferedStream *p_stream) {
 	uint64_t l_nb_bytes_written = 0;
 	uint64_t l_current_nb_bytes_written;
-	auto l_tcd = p_j2k->m_tileProcessor;
+	auto l_tcd = p_writer->tileProcessor;
 	auto l_cp = &(p_j2k->m_cp);
 
 	l_tcd->cur_pino = 0;
 
 	/*Get number of tile parts*/
-	p_j2k->m_specific_param.m_encoder.m_current_poc_tile_part_number = 0;
+	p_writer->m_current_poc_tile_part_number = 0;
 
 	/* INDEX >> */
 	/* << INDEX */
 
 	l_current_nb_bytes_written = 0;
 	uint64_t psot_location = 0;
-	if (!j2k_write_sot(p_j2k, p_stream, &psot_location,
+	if (!j2k_write_sot(p_j2k, p_writer, p_stream, &psot_location,
 			&l_current_nb_bytes_written)) {
 		return false;
 	}
@@ -2670,9 +3041,9 @@ static bool j2k_write_first_tile_part(grk_j2k *p_j2k, uint64_t *p_data_written,
 	total_data_size -= l_current_nb_bytes_written;
 
 	if (!GRK_IS_CINEMA(l_cp->rsiz)) {
-		if (l_cp->tcps[p_j2k->m_current_tile_number].numpocs) {
+		if (l_cp->tcps[p_writer->tile_no].numpocs) {
 			l_current_nb_bytes_written = 0;
-			if (!j2k_write_poc_in_memory(p_j2k, p_stream,
+			if (!j2k_write_poc_in_memory(p_j2k, p_writer->tile_no, p_stream,
 					&l_current_nb_bytes_written))
 				return false;
 			l_nb_bytes_written += l_current_nb_bytes_written;
@@ -2681,7 +3052,7 @@ static bool j2k_write_first_tile_part(grk_j2k *p_j2k, uint64_t *p_data_written,
 	}
 
 	l_current_nb_bytes_written = 0;
-	if (!j2k_write_sod(p_j2k, l_tcd, &l_current_nb_bytes_written,
+	if (!j2k_write_sod(p_j2k, p_writer, &l_current_nb_bytes_written,
 			total_data_size, p_stream)) {
 		return false;
 	}
@@ -2697,14 +3068,15 @@ static bool j2k_write_first_tile_part(grk_j2k *p_j2k, uint64_t *p_data_written,
 		return false;
 	}
 	p_stream->seek(currentLocation);
-	if (GRK_IS_CINEMA(l_cp->rsiz)  || GRK_IS_IMF(l_cp->rsiz) ) {
-		j2k_update_tlm(p_j2k, (uint32_t) l_nb_bytes_written);
+	if (l_cp->m_coding_param.m_enc.m_write_tlm) {
+		j2k_update_tlm(l_cp, p_writer, (uint32_t) l_nb_bytes_written);
 	}
 	return true;
 }
 
-static bool j2k_write_all_tile_parts(grk_j2k *p_j2k, uint64_t *p_data_written,
-		uint64_t total_data_size, BufferedStream *p_stream) {
+static bool j2k_write_all_tile_parts(grk_j2k *p_j2k, grk_tile_writer *p_writer,
+		uint64_t *p_data_written, uint64_t total_data_size,
+		BufferedStream *p_stream) {
 	uint8_t tilepartno = 0;
 	uint64_t l_nb_bytes_written = 0;
 	uint64_t l_current_nb_bytes_written;
@@ -2712,29 +3084,29 @@ static bool j2k_write_all_tile_parts(grk_j2k *p_j2k, uint64_t *p_data_written,
 	uint32_t tot_num_tp;
 	uint32_t pino;
 
-	auto l_tcd = p_j2k->m_tileProcessor;
+	auto l_tcd = p_writer->tileProcessor;
 	auto l_cp = &(p_j2k->m_cp);
-	auto l_tcp = l_cp->tcps + p_j2k->m_current_tile_number;
+	auto l_tcp = l_cp->tcps + p_writer->tile_no;
 
 	/*Get number of tile parts*/
-	tot_num_tp = j2k_get_num_tp(l_cp, 0, p_j2k->m_current_tile_number);
+	tot_num_tp = j2k_get_num_tp(l_cp, 0, p_writer->tile_no);
   if (tot_num_tp > 255) {
     GROK_ERROR(
         "Tile %d contains more than 255 tile parts, which is not permitted by the JPEG 2000 standard.\n",
-        p_j2k->m_current_tile_number);
+        p_writer->tile_no);
     return false;
   }
 
 	/* start writing remaining tile parts */
-	++p_j2k->m_specific_param.m_encoder.m_current_tile_part_number;
+	++p_writer->m_current_tile_part_number;
 	for (tilepartno = 1; tilepartno < tot_num_tp; ++tilepartno) {
-		p_j2k->m_specific_param.m_encoder.m_current_poc_tile_part_number =
+		p_writer->m_current_poc_tile_part_number =
 				tilepartno;
 		l_current_nb_bytes_written = 0;
 		l_part_tile_size = 0;
 
 		uint64_t psot_location = 0;
-		if (!j2k_write_sot(p_j2k, p_stream, &psot_location,
+		if (!j2k_write_sot(p_j2k, p_writer, p_stream, &psot_location,
 				&l_current_nb_bytes_written)) {
 			return false;
 		}
@@ -2743,7 +3115,7 @@ static bool j2k_write_all_tile_parts(grk_j2k *p_j2k, uint64_t *p_data_written,
 		l_part_tile_size += (uint32_t) l_current_nb_bytes_written;
 
 		l_current_nb_bytes_written = 0;
-		if (!j2k_write_sod(p_j2k, l_tcd, &l_current_nb_bytes_written,
+		if (!j2k_write_sod(p_j2k, p_writer, &l_current_nb_bytes_written,
 				total_data_size, p_stream)) {
 			return false;
 		}
@@ -2759,32 +3131,32 @@ static bool j2k_write_all_tile_parts(grk_j2k *p_j2k, uint64_t *p_data_written,
 			return false;
 		}
 		p_stream->seek(currentLocation);
-		if (GRK_IS_CINEMA(l_cp->rsiz)  || GRK_IS_IMF(l_cp->rsiz)) {
-			j2k_update_tlm(p_j2k, l_part_tile_size);
+		if (l_cp->m_coding_param.m_enc.m_write_tlm) {
+			j2k_update_tlm(l_cp, p_writer, l_part_tile_size);
 		}
 
-		++p_j2k->m_specific_param.m_encoder.m_current_tile_part_number;
+		++p_writer->m_current_tile_part_number;
 	}
 
 	for (pino = 1; pino <= l_tcp->numpocs; ++pino) {
 		l_tcd->cur_pino = pino;
 
 		/*Get number of tile parts*/
-		tot_num_tp = j2k_get_num_tp(l_cp, pino, p_j2k->m_current_tile_number);
+		tot_num_tp = j2k_get_num_tp(l_cp, pino, p_writer->tile_no);
 	  if (tot_num_tp > 255) {
 	    GROK_ERROR(
 	        "Tile %d contains more than 255 tile parts, which is not permitted by the JPEG 2000 standard.\n",
-	        p_j2k->m_current_tile_number);
+	        p_writer->tile_no);
 	    return false;
 	  }
 
 		for (tilepartno = 0; tilepartno < tot_num_tp; ++tilepartno) {
-			p_j2k->m_specific_param.m_encoder.m_current_poc_tile_part_number =
+			p_writer->m_current_poc_tile_part_number =
 					tilepartno;
 			l_current_nb_bytes_written = 0;
 			l_part_tile_size = 0;
 			uint64_t psot_location = 0;
-			if (!j2k_write_sot(p_j2k, p_stream, &psot_location,
+			if (!j2k_write_sot(p_j2k, p_writer, p_stream, &psot_location,
 					&l_current_nb_bytes_written)) {
 				return false;
 			}
@@ -2794,7 +3166,7 @@ static bool j2k_write_all_tile_parts(grk_j2k *p_j2k, uint64_t *p_data_written,
 			l_part_tile_size += (uint32_t) l_current_nb_bytes_written;
 
 			l_current_nb_bytes_written = 0;
-			if (!j2k_write_sod(p_j2k, l_tcd, &l_current_nb_bytes_written,
+			if (!j2k_write_sod(p_j2k, p_writer, &l_current_nb_bytes_written,
 					total_data_size, p_stream)) {
 				return false;
 			}
@@ -2812,10 +3184,10 @@ static bool j2k_write_all_tile_parts(grk_j2k *p_j2k, uint64_t *p_data_written,
 			}
 			p_stream->seek(currentLocation);
 
-			if (GRK_IS_CINEMA(l_cp->rsiz) || GRK_IS_IMF(l_cp->rsiz)) {
-				j2k_update_tlm(p_j2k, l_part_tile_size);
+			if (l_cp->m_coding_param.m_enc.m_write_tlm) {
+				j2k_update_tlm(l_cp, p_writer, l_part_tile_size);
 			}
-			++p_j2k->m_specific_param.m_encoder.m_current_tile_part_number;
+			++p_writer->m_current_tile_part_number;
 		}
 	}
 	*p_data_written = l_nb_bytes_written;
@@ -2829,17 +3201,27 @@ static bool j2k_write_updated_tlm(grk_j2k *p_j2k, BufferedStream *p_stream) {
 	assert(p_j2k != nullptr);
 	assert(p_stream != nullptr);
 
-	l_tlm_size = 5 * p_j2k->m_specific_param.m_encoder.m_total_tile_parts;
-	l_tlm_position = 6 + p_j2k->m_specific_param.m_encoder.m_tlm_start;
+	uint32_t l_entry_size = j2k_get_tlm_entry_size(&p_j2k->m_cp);
+	uint32_t l_entries_per_marker = (UINT16_MAX - 4) / l_entry_size;
+	uint32_t l_remaining = p_j2k->m_specific_param.m_encoder.m_total_tile_parts;
+	auto l_entries = p_j2k->m_specific_param.m_encoder.m_tlm_sot_offsets_buffer;
+	l_tlm_position = p_j2k->m_specific_param.m_encoder.m_tlm_start;
 	l_current_position = p_stream->tell();
 
-	if (!p_stream->seek(l_tlm_position)) {
-		return false;
-	}
-	if (p_stream->write_bytes(
-			p_j2k->m_specific_param.m_encoder.m_tlm_sot_offsets_buffer,
-			l_tlm_size) != l_tlm_size) {
-		return false;
+	while (l_remaining) {
+		uint32_t l_nb_entries = std::min<uint32_t>(l_remaining,
+				l_entries_per_marker);
+		l_tlm_size = l_nb_entries * l_entry_size;
+		/* skip TLM, Ltlm, Ztlm and Stlm */
+		if (!p_stream->seek(l_tlm_position + 6)) {
+			return false;
+		}
+		if (p_stream->write_bytes(l_entries, l_tlm_size) != l_tlm_size) {
+			return false;
+		}
+		l_entries += l_tlm_size;
+		l_tlm_position += 6 + l_tlm_size;
+		l_remaining -= l_nb_entries;
 	}
 	if (!p_stream->seek(l_current_position)) {
 		return false;
@@ -3141,8 +3523,8 @@ static bool j2k_update_rates(grk_j2k *p_j2k, BufferedStream *p_stream) {
 
 	for (i = 0; i < l_cp->th; ++i) {
 		for (j = 0; j < l_cp->tw; ++j) {
-			double l_offset = (double) (*l_tp_stride_func)(l_tcp)
-					/ l_tcp->numlayers;
+			// a layer may end after every tile part header
+			double l_offset = (double) (*l_tp_stride_func)(l_tcp);
 
 			/* 4 borders of the tile rescale on the image if necessary */
 			uint32_t l_x0 = std::max<uint32_t>((l_cp->tx0 + j * l_cp->tdx),
@@ -3216,10 +3598,10 @@ static bool j2k_update_rates(grk_j2k *p_j2k, BufferedStream *p_stream) {
 		}
 	}
 
-	if (GRK_IS_CINEMA(l_cp->rsiz) || GRK_IS_IMF(l_cp->rsiz)) {
+	if (l_cp->m_coding_param.m_enc.m_write_tlm) {
 		p_j2k->m_specific_param.m_encoder.m_tlm_sot_offsets_buffer =
 				(uint8_t*) grok_malloc(
-						5
+						j2k_get_tlm_entry_size(l_cp)
 								* p_j2k->m_specific_param.m_encoder.m_total_tile_parts);
 		if (!p_j2k->m_specific_param.m_encoder.m_tlm_sot_offsets_buffer) {
 			return false;
@@ -3369,37 +3751,51 @@ template<typename S, typename D> void j2k_write(const void *p_src_data,
 	}
 }
 
+/* MCT record data is stored big endian, as written by j2k_write */
+template<typename S, typename D> void j2k_read(const void *p_src_data,
+		void *p_dest_data, uint32_t nb_elem) {
+	const uint8_t *l_src_data = (const uint8_t*) p_src_data;
+	D *l_dest_data = (D*) p_dest_data;
+	uint32_t i;
+	S l_temp;
+	for (i = 0; i < nb_elem; ++i) {
+		grok_read<S>(l_src_data, &l_temp, sizeof(S));
+		l_src_data += sizeof(S);
+		*(l_dest_data++) = (D) l_temp;
+	}
+}
+
 static void j2k_read_int16_to_float(const void *p_src_data, void *p_dest_data,
 		uint32_t nb_elem) {
-	j2k_write<int16_t, float>(p_src_data, p_dest_data, nb_elem);
+	j2k_read<int16_t, float>(p_src_data, p_dest_data, nb_elem);
 }
 static void j2k_read_int32_to_float(const void *p_src_data, void *p_dest_data,
 		uint32_t nb_elem) {
-	j2k_write<int32_t, float>(p_src_data, p_dest_data, nb_elem);
+	j2k_read<int32_t, float>(p_src_data, p_dest_data, nb_elem);
 }
 static void j2k_read_float32_to_float(const void *p_src_data, void *p_dest_data,
 		uint32_t nb_elem) {
-	j2k_write<float, float>(p_src_data, p_dest_data, nb_elem);
+	j2k_read<float, float>(p_src_data, p_dest_data, nb_elem);
 }
 static void j2k_read_float64_to_float(const void *p_src_data, void *p_dest_data,
 		uint32_t nb_elem) {
-	j2k_write<double, float>(p_src_data, p_dest_data, nb_elem);
+	j2k_read<double, float>(p_src_data, p_dest_data, nb_elem);
 }
 static void j2k_read_int16_to_int32(const void *p_src_data, void *p_dest_data,
 		uint32_t nb_elem) {
-	j2k_write<int16_t, int32_t>(p_src_data, p_dest_data, nb_elem);
+	j2k_read<int16_t, int32_t>(p_src_data, p_dest_data, nb_elem);
 }
 static void j2k_read_int32_to_int32(const void *p_src_data, void *p_dest_data,
 		uint32_t nb_elem) {
-	j2k_write<int32_t, int32_t>(p_src_data, p_dest_data, nb_elem);
+	j2k_read<int32_t, int32_t>(p_src_data, p_dest_data, nb_elem);
 }
 static void j2k_read_float32_to_int32(const void *p_src_data, void *p_dest_data,
 		uint32_t nb_elem) {
-	j2k_write<float, int32_t>(p_src_data, p_dest_data, nb_elem);
+	j2k_read<float, int32_t>(p_src_data, p_dest_data, nb_elem);
 }
 static void j2k_read_float64_to_int32(const void *p_src_data, void *p_dest_data,
 		uint32_t nb_elem) {
-	j2k_write<double, int32_t>(p_src_data, p_dest_data, nb_elem);
+	j2k_read<double, int32_t>(p_src_data, p_dest_data, nb_elem);
 }
 static void j2k_write_float_to_int16(const void *p_src_data, void *p_dest_data,
 		uint32_t nb_elem) {
@@ -4183,7 +4579,10 @@ static bool j2k_read_cod(grk_j2k *p_j2k, uint8_t *p_header_data,
 
 	grok_read_bytes(p_header_data, &l_tcp->mct, 1); /* SGcod (C) */
 	++p_header_data;
-	if (l_tcp->mct > 1 )
+	// array based transform (MCC/MCO markers) needs the Part 2 MCT extension
+	bool custom_mct = (l_cp->rsiz & (GRK_PROFILE_PART2 | GRK_EXTENSION_MCT))
+			== (GRK_PROFILE_PART2 | GRK_EXTENSION_MCT);
+	if (l_tcp->mct > (custom_mct ? 2 : 1))
 	{
 		GROK_ERROR("Invalid MCT value : %d. Should be either 0 or 1", l_tcp->mct);
 		return false;
@@ -4538,11 +4937,12 @@ static bool j2k_write_poc(grk_j2k *p_j2k, BufferedStream *p_stream) {
 	assert(p_stream != nullptr);
 
 	uint64_t data_written = 0;
-	return j2k_write_poc_in_memory(p_j2k, p_stream, &data_written);
+	return j2k_write_poc_in_memory(p_j2k, p_j2k->m_current_tile_number,
+			p_stream, &data_written);
 }
 
-static bool j2k_write_poc_in_memory(grk_j2k *p_j2k, BufferedStream *p_stream,
-		uint64_t *p_data_written) {
+static bool j2k_write_poc_in_memory(grk_j2k *p_j2k, uint16_t tile_no,
+		BufferedStream *p_stream, uint64_t *p_data_written) {
 	
 	uint32_t i;
 	uint32_t l_nb_comp;
@@ -4552,7 +4952,7 @@ static bool j2k_write_poc_in_memory(grk_j2k *p_j2k, BufferedStream *p_stream,
 	assert(p_j2k != nullptr);
 	
 
-	auto l_tcp = &p_j2k->m_cp.tcps[p_j2k->m_current_tile_number];
+	auto l_tcp = &p_j2k->m_cp.tcps[tile_no];
 	auto l_tccp = &l_tcp->tccps[0];
 	auto l_image = p_j2k->m_private_image;
 	l_nb_comp = l_image->numcomps;
@@ -4679,6 +5079,9 @@ static uint64_t j2k_get_specific_header_sizes(grk_j2k *p_j2k) {
 
 	l_nb_bytes += j2k_get_max_poc_size(p_j2k);
 
+	if (p_j2k->m_cp.m_coding_param.m_enc.m_write_plt)
+		l_nb_bytes += j2k_get_max_plt_size(p_j2k);
+
 	/*** DEVELOPER CORNER, Add room for your headers ***/
 
 	return l_nb_bytes;
@@ -4843,9 +5246,9 @@ static bool j2k_read_tlm(grk_j2k *p_j2k, uint8_t *p_header_data,
   if (!p_j2k->m_cp.tl_marker)
       p_j2k->m_cp.tl_marker = new grk_tl_marker();
 
-	uint8_t num_tp = (uint8_t)(header_size / l_quotient);
+	uint32_t num_tp = header_size / l_quotient;
 	uint32_t l_Ttlm_i=0, l_Ptlm_i=0;
-	for (uint8_t i = 0; i < num_tp; ++i) {
+	for (uint32_t i = 0; i < num_tp; ++i) {
 		if (L_iT) {
 			grok_read_bytes(p_header_data, &l_Ttlm_i, L_iT);
 			p_header_data += L_iT;
@@ -4866,6 +5269,67 @@ static bool j2k_read_tlm(grk_j2k *p_j2k, uint8_t *p_header_data,
 	return true;
 }
 
+static void j2k_build_tile_part_index(grk_j2k *p_j2k, uint64_t first_sot) {
+	auto tlm = p_j2k->m_cp.tl_marker;
+	uint32_t num_tiles = p_j2k->m_cp.tw * p_j2k->m_cp.th;
+
+	tlm->tile_part_offsets.clear();
+	tlm->tile_part_offsets.resize(num_tiles);
+	uint64_t pos = first_sot;
+	uint32_t tile_part = 0;
+	for (auto &pair : tlm->tile_part_lengths) {
+		for (auto &info : pair.second) {
+			// without tile numbers, there is one tile-part per tile, in tile order
+			uint32_t tile_no = info.has_tile_number ? info.tile_number : tile_part;
+			if (tile_no >= num_tiles || info.length < 12) {
+				GROK_WARN("TLM marker is inconsistent with the image: "
+						"tile-parts will be located by reading their headers");
+				tlm->tile_part_offsets.clear();
+				return;
+			}
+			tlm->tile_part_offsets[tile_no].push_back(pos);
+			pos += info.length;
+			++tile_part;
+		}
+	}
+}
+
+static bool j2k_next_tile_part(grk_j2k *p_j2k, uint16_t tile_no, uint64_t pos,
+		uint64_t *p_offset) {
+	auto tlm = p_j2k->m_cp.tl_marker;
+	if (!tlm || tile_no >= tlm->tile_part_offsets.size())
+		return false;
+	auto &offsets = tlm->tile_part_offsets[tile_no];
+	auto it = std::lower_bound(offsets.begin(), offsets.end(), pos);
+	if (it == offsets.end())
+		return false;
+	*p_offset = *it;
+
+	return true;
+}
+
+static bool j2k_seek_tile_part(grk_j2k *p_j2k, BufferedStream *p_stream,
+		uint16_t tile_no, uint64_t pos) {
+	uint64_t offset;
+	if (!p_stream->has_seek() || !j2k_next_tile_part(p_j2k, tile_no, pos, &offset))
+		return false;
+	auto current = p_stream->tell();
+	uint8_t data[2];
+	uint32_t marker = 0;
+	if (p_stream->seek((int64_t)offset) && p_stream->read(data, 2) == 2) {
+		grok_read_bytes(data, &marker, 2);
+		if (marker == J2K_MS_SOT && p_stream->seek((int64_t)offset))
+			return true;
+	}
+	GROK_WARN("TLM marker does not locate tile-part of tile %d: "
+			"tile-parts will be located by reading their headers", tile_no);
+	p_j2k->m_cp.tl_marker->tile_part_offsets.clear();
+	if (!p_stream->seek(current))
+		GROK_ERROR("Problem with seek function");
+
+	return false;
+}
+
 /**
  * Reads a PLM marker (Packet length, main header marker)
  *
@@ -4934,7 +5398,6 @@ static bool j2k_read_plm(grk_j2k *p_j2k, uint8_t *p_header_data,
  */
 static bool j2k_read_plt(grk_j2k *p_j2k, uint8_t *p_header_data,
 		uint16_t header_size) {
-	(void) p_j2k;
 	assert(p_header_data != nullptr);
 	assert(p_j2k != nullptr);
 	
@@ -4950,6 +5413,9 @@ static bool j2k_read_plt(grk_j2k *p_j2k, uint8_t *p_header_data,
 	++p_header_data;
 	--header_size;
 
+	auto l_tcp = p_j2k->get_current_decode_tcp();
+	if (!l_tcp->m_packet_lengths)
+		l_tcp->m_packet_lengths = new std::vector<uint32_t>();
 	uint32_t l_tmp;
 	uint32_t l_packet_len = 0;
 	for (uint32_t i = 0; i < header_size; ++i) {
@@ -4962,6 +5428,7 @@ static bool j2k_read_plt(grk_j2k *p_j2k, uint8_t *p_header_data,
 			l_packet_len <<= 7;
 		} else {
 			/* store packet length and proceed to next packet */
+			l_tcp->m_packet_lengths->push_back(l_packet_len);
 			l_packet_len = 0;
 		}
 	}
@@ -5329,46 +5796,171 @@ static bool j2k_merge_ppt(grk_tcp *p_tcp) {
 	return true;
 }
 
+static uint64_t j2k_get_max_plt_size(grk_j2k *p_j2k) {
+	auto cp = &p_j2k->m_cp;
+	auto image = p_j2k->m_private_image;
+	/* every tile is encoded with the same coding parameters */
+	auto tcp = cp->tcps;
+	uint64_t l_nb_packets = 0;
+
+	for (uint32_t compno = 0; compno < image->numcomps; ++compno) {
+		auto tccp = tcp->tccps + compno;
+		auto img_comp = image->comps + compno;
+		uint64_t tcw = ceildiv<uint32_t>(cp->tdx, img_comp->dx) + 1;
+		uint64_t tch = ceildiv<uint32_t>(cp->tdy, img_comp->dy) + 1;
+		for (uint32_t resno = 0; resno < tccp->numresolutions; ++resno) {
+			uint32_t level = tccp->numresolutions - 1 - resno;
+			uint64_t rw = ceildiv<uint64_t>(tcw, (uint64_t) 1 << level) + 1;
+			uint64_t rh = ceildiv<uint64_t>(tch, (uint64_t) 1 << level) + 1;
+			l_nb_packets += (ceildiv<uint64_t>(rw,
+					(uint64_t) 1 << tccp->prcw[resno]) + 1)
+					* (ceildiv<uint64_t>(rh, (uint64_t) 1 << tccp->prch[resno]) + 1);
+		}
+	}
+	l_nb_packets *= tcp->numlayers;
+
+	/* at most five bytes per packet length, and five bytes
+	 * for PLT, Lplt and Zplt in each marker segment */
+	uint64_t l_iplt_bytes = 5 * l_nb_packets;
+	return l_iplt_bytes + 5 * ceildiv<uint64_t>(l_iplt_bytes, UINT16_MAX - 3);
+}
+
+static uint32_t j2k_get_tlm_entry_size(grk_coding_parameters *cp) {
+	return (cp->tw * cp->th > 256) ? 6 : 5;
+}
+
 static bool j2k_write_tlm(grk_j2k *p_j2k, BufferedStream *p_stream) {
 	assert(p_j2k != nullptr);
 	assert(p_stream != nullptr);
 
-	uint32_t l_tlm_size =
-			6 + (5 * p_j2k->m_specific_param.m_encoder.m_total_tile_parts);
+	uint32_t l_entry_size = j2k_get_tlm_entry_size(&p_j2k->m_cp);
+	uint32_t l_entries_per_marker = (UINT16_MAX - 4) / l_entry_size;
+	uint32_t l_remaining = p_j2k->m_specific_param.m_encoder.m_total_tile_parts;
+	if (ceildiv<uint32_t>(l_remaining, l_entries_per_marker) > 256) {
+		GROK_ERROR("Too many tile parts (%d) for TLM markers", l_remaining);
+		return false;
+	}
 
 	/* change the way data is written to avoid seeking if possible */
 	/* TODO */
 	p_j2k->m_specific_param.m_encoder.m_tlm_start = p_stream->tell();
 
-	/* TLM */
-	if (!p_stream->write_short(J2K_MS_TLM)) {
-		return false;
-	}
+	/* the tile part lengths may need more than one marker segment */
+	uint32_t l_Ztlm = 0;
+	do {
+		uint32_t l_nb_entries = std::min<uint32_t>(l_remaining,
+				l_entries_per_marker);
+		/* TLM */
+		if (!p_stream->write_short(J2K_MS_TLM)) {
+			return false;
+		}
 
-	/* Lpoc */
-	if (!p_stream->write_short((uint16_t) (l_tlm_size - 2))) {
-		return false;
-	}
+		/* Ltlm */
+		if (!p_stream->write_short((uint16_t) (4 + l_nb_entries * l_entry_size))) {
+			return false;
+		}
 
-	/* Ztlm=0*/
-	if (!p_stream->write_byte(0)) {
-		return false;
-	}
+		/* Ztlm */
+		if (!p_stream->write_byte((uint8_t) l_Ztlm++)) {
+			return false;
+		}
 
-	/* Stlm ST=1(8bits-255 tiles max),SP=1(Ptlm=32bits) */
-	if (!p_stream->write_byte(0x50)) {
-		return false;
+		/* Stlm ST=1 (8 bit Ttlm) or ST=2 (16 bit Ttlm), SP=1 (Ptlm=32bits) */
+		if (!p_stream->write_byte(l_entry_size == 5 ? 0x50 : 0x60)) {
+			return false;
+		}
+		/* the entries are written by j2k_write_updated_tlm */
+		if (!p_stream->skip(l_nb_entries * l_entry_size)) {
+			return false;
+		}
+		l_remaining -= l_nb_entries;
+	} while (l_remaining);
+
+	return true;
+}
+
+static bool j2k_get_packet_lengths(grk_j2k *p_j2k, grk_tile_writer *p_writer,
+		uint64_t max_len) {
+	auto l_cp = &(p_j2k->m_cp);
+	auto l_tcp = l_cp->tcps + p_writer->tile_no;
+	auto l_tcd = p_writer->tileProcessor;
+
+	/* tile parts in the order that j2k_write_tile_parts writes them */
+	p_writer->m_packet_lengths.clear();
+	for (uint32_t pino = 0; pino <= l_tcp->numpocs; ++pino) {
+		uint32_t tot_num_tp = j2k_get_num_tp(l_cp, pino, p_writer->tile_no);
+		for (uint32_t tilepartno = 0; tilepartno < tot_num_tp;
+				++tilepartno) {
+			p_writer->m_packet_lengths.emplace_back();
+			auto &lengths = p_writer->m_packet_lengths.back();
+			if (!l_tcd->get_packet_lengths(pino, tilepartno, max_len,
+					&lengths))
+				return false;
+			for (auto len : lengths)
+				max_len -= len;
+		}
 	}
-	/* do nothing on the 5 * l_j2k->m_specific_param.m_encoder.m_total_tile_parts remaining data */
-	if (!p_stream->skip(
-			(5 * p_j2k->m_specific_param.m_encoder.m_total_tile_parts))) {
-		return false;
+
+	return true;
+}
+
+static bool j2k_write_plt(const std::vector<uint32_t> &packet_lengths,
+		BufferedStream *p_stream, uint64_t *p_data_written) {
+	/* Lplt, Zplt and Iplt must fit in 65535 bytes */
+	const size_t l_max_iplt = UINT16_MAX - 3;
+	std::vector<uint8_t> l_iplt;
+	uint32_t l_Zplt = 0;
+
+	*p_data_written = 0;
+	auto it = packet_lengths.begin();
+	while (it != packet_lengths.end()) {
+		l_iplt.clear();
+		for (; it != packet_lengths.end(); ++it) {
+			/* seven bits per byte, most significant first, with the
+			 * high bit set on every byte but the last */
+			uint8_t l_bytes[5];
+			uint32_t l_nb_bytes = 0;
+			uint32_t l_len = *it;
+			do {
+				l_bytes[l_nb_bytes++] = (uint8_t) (l_len & 0x7f);
+				l_len >>= 7;
+			} while (l_len);
+			/* a packet length never straddles two marker segments */
+			if (l_iplt.size() + l_nb_bytes > l_max_iplt)
+				break;
+			while (l_nb_bytes--)
+				l_iplt.push_back(
+						(uint8_t) (l_bytes[l_nb_bytes] | (l_nb_bytes ? 0x80 : 0)));
+		}
+		if (l_Zplt > 255) {
+			GROK_ERROR("Too many packets in tile part for PLT markers");
+			return false;
+		}
+		/* PLT */
+		if (!p_stream->write_short(J2K_MS_PLT)) {
+			return false;
+		}
+		/* Lplt */
+		if (!p_stream->write_short((uint16_t) (3 + l_iplt.size()))) {
+			return false;
+		}
+		/* Zplt */
+		if (!p_stream->write_byte((uint8_t) l_Zplt++)) {
+			return false;
+		}
+		/* Iplt */
+		if (p_stream->write_bytes(l_iplt.data(), l_iplt.size())
+				!= l_iplt.size()) {
+			return false;
+		}
+		*p_data_written += 5 + l_iplt.size();
 	}
 	return true;
 }
 
-static bool j2k_write_sot(grk_j2k *p_j2k, BufferedStream *p_stream,
-		uint64_t *psot_location, uint64_t *p_data_written) {
+static bool j2k_write_sot(grk_j2k *p_j2k, grk_tile_writer *p_writer,
+		BufferedStream *p_stream, uint64_t *psot_location,
+		uint64_t *p_data_written) {
 	assert(p_j2k != nullptr);
 
 	/* SOT */
@@ -5382,7 +5974,7 @@ static bool j2k_write_sot(grk_j2k *p_j2k, BufferedStream *p_stream,
 	}
 
 	/* Isot */
-	if (!p_stream->write_short((uint16_t) p_j2k->m_current_tile_number)) {
+	if (!p_stream->write_short(p_writer->tile_no)) {
 		return false;
 	}
 
@@ -5393,14 +5985,13 @@ static bool j2k_write_sot(grk_j2k *p_j2k, BufferedStream *p_stream,
 	}
 
 	/* TPsot */
-	if (!p_stream->write_byte(
-			p_j2k->m_specific_param.m_encoder.m_current_tile_part_number)) {
+	if (!p_stream->write_byte(p_writer->m_current_tile_part_number)) {
 		return false;
 	}
 
 	/* TNsot */
 	if (!p_stream->write_byte(
-			p_j2k->m_cp.tcps[p_j2k->m_current_tile_number].m_nb_tile_parts)) {
+			p_j2k->m_cp.tcps[p_writer->tile_no].m_nb_tile_parts)) {
 		return false;
 	}
 
@@ -5483,6 +6074,11 @@ static bool j2k_read_sot(grk_j2k *p_j2k, uint8_t *p_header_data,
 		return false;
 	}
 	++l_tcp->m_current_tile_part_number;
+	/* packet lengths are collected again from the PLT markers of every tile-part */
+	if (l_current_part == 0) {
+		delete l_tcp->m_packet_lengths;
+		l_tcp->m_packet_lengths = nullptr;
+	}
 	/* look for the tile in the list of already processed tile (in parts). */
 	/* Optimization possible here with a more complex data structure and with the removing of tiles */
 	/* since the time taken by this function can only grow at the time */
@@ -5671,45 +6267,92 @@ static bool j2k_read_sot(grk_j2k *p_j2k, uint8_t *p_header_data,
 	return true;
 }
 
-static bool j2k_write_sod(grk_j2k *p_j2k, TileProcessor *p_tile_coder,
+static bool j2k_write_sod(grk_j2k *p_j2k, grk_tile_writer *p_writer,
 		uint64_t *p_data_written, uint64_t total_data_size,
 		BufferedStream *p_stream) {
+	(void) p_j2k;
 	 grk_codestream_info  *l_cstr_info = nullptr;
 	uint64_t l_remaining_data;
 
 	assert(p_j2k != nullptr);
 	assert(p_stream != nullptr);
 
-	/* SOD */
-	if (!p_stream->write_short(J2K_MS_SOD)) {
-		return false;
-	}
-
-	*p_data_written = 2;
-
 	/* make room for the EOF marker */
 	l_remaining_data = total_data_size - 4;
 
 	/* update tile coder */
-	p_tile_coder->tp_num =
-			p_j2k->m_specific_param.m_encoder.m_current_poc_tile_part_number;
-	p_tile_coder->cur_tp_num =
-			p_j2k->m_specific_param.m_encoder.m_current_tile_part_number;
+	auto p_tile_coder = p_writer->tileProcessor;
+	p_tile_coder->tp_num = p_writer->m_current_poc_tile_part_number;
+	p_tile_coder->cur_tp_num = p_writer->m_current_tile_part_number;
 
 	/* set packno to zero when writing the first tile part */
-	if (p_j2k->m_specific_param.m_encoder.m_current_tile_part_number == 0) {
+	if (p_writer->m_current_tile_part_number == 0) {
 		p_tile_coder->tile->packno = 0;
 		if (l_cstr_info) {
 			l_cstr_info->packno = 0;
 		}
 	}
-	if (!p_tile_coder->encode_tile(p_j2k->m_current_tile_number, p_stream,
-			p_data_written, l_remaining_data, l_cstr_info)) {
+	if (!p_j2k->m_cp.m_coding_param.m_enc.m_write_plt) {
+		/* SOD */
+		if (!p_stream->write_short(J2K_MS_SOD)) {
+			return false;
+		}
+
+		*p_data_written = 2;
+		if (!p_tile_coder->encode_tile(p_writer->tile_no, p_stream,
+				p_data_written, l_remaining_data, l_cstr_info)) {
+			GROK_ERROR( "Cannot encode tile");
+			return false;
+		}
+		return true;
+	}
+
+	/* The PLT markers precede SOD, so once the code blocks are encoded,
+	 * the length of each packet of the tile is found by simulating
+	 * the packets of every tile part. The packets are then written
+	 * after the markers, and must have the simulated lengths */
+	uint64_t l_max_plt_size = j2k_get_max_plt_size(p_j2k);
+	if (l_remaining_data <= l_max_plt_size + 2) {
+		GROK_ERROR( "Not enough space for PLT markers in tile %d",
+				p_writer->tile_no);
+		return false;
+	}
+	uint64_t l_max_packet_data = l_remaining_data - l_max_plt_size - 2;
+	if (!p_tile_coder->encode_code_blocks(p_writer->tile_no,
+			l_max_packet_data, l_cstr_info)) {
 		GROK_ERROR( "Cannot encode tile");
 		return false;
 	}
+	if (p_writer->m_current_tile_part_number == 0
+			&& !j2k_get_packet_lengths(p_j2k, p_writer, l_max_packet_data)) {
+		GROK_ERROR( "Cannot find the packet lengths of tile %d",
+				p_writer->tile_no);
+		return false;
+	}
+	if (p_writer->m_current_tile_part_number
+			>= p_writer->m_packet_lengths.size()) {
+		GROK_ERROR( "Tile part %d of tile %d was not expected",
+				p_writer->m_current_tile_part_number, p_writer->tile_no);
+		return false;
+	}
+	auto &l_packet_lengths =
+			p_writer->m_packet_lengths[p_writer->m_current_tile_part_number];
+	uint64_t l_plt_bytes = 0;
+	if (!j2k_write_plt(l_packet_lengths, p_stream, &l_plt_bytes))
+		return false;
+	/* SOD */
+	if (!p_stream->write_short(J2K_MS_SOD))
+		return false;
+	*p_data_written = l_plt_bytes + 2;
 
-	return true;
+	p_tile_coder->packet_lengths = &l_packet_lengths;
+	bool rc = p_tile_coder->t2_encode(p_stream, p_data_written,
+			l_max_packet_data, l_cstr_info);
+	p_tile_coder->packet_lengths = nullptr;
+	if (!rc)
+		GROK_ERROR( "Cannot encode tile");
+
+	return rc;
 }
 
 static bool j2k_read_sod(grk_j2k *p_j2k, BufferedStream *p_stream) {
@@ -7486,6 +8129,7 @@ grk_tcp::grk_tcp() :
 				m_current_tile_part_number(-1),
 				m_nb_tile_parts(0),
 				m_tile_data(nullptr),
+				m_packet_lengths(nullptr),
 				mct_norms(nullptr),
 				m_mct_decoding_matrix(nullptr),
 				m_mct_coding_matrix(nullptr),
@@ -82,6 +82,9 @@ const uint32_t max_num_tile_parts = max_num_tiles * max_num_tile_parts_per_tile;
 
 // limits in Grok library
 const uint64_t max_tile_area = 67108864000;
+// memory that tiles encoding concurrently may hold, for their samples
+// and code stream buffers
+const uint64_t max_concurrent_encode_memory = (uint64_t)1 << 30;
 const uint32_t max_supported_precision = 16; // maximum supported precision for Grok library
 const uint32_t default_numbers_segments = 10;
 const uint32_t default_header_size = 1000;
@@ -297,6 +300,8 @@ struct grk_tcp {
 	uint8_t m_nb_tile_parts;
 
 	ChunkBuffer *m_tile_data;
+	/** lengths of the packets of the tile, in codestream order, read from PLT markers */
+	std::vector<uint32_t> *m_packet_lengths;
 
 	/** encoding norms */
 	double *mct_norms;
@@ -343,8 +348,14 @@ struct grk_encoding_param {
 	uint32_t m_fixed_quality :1;
 	/** Enabling Tile part generation*/
 	uint32_t m_tp_on :1;
+	/** write PLT markers in tile part headers */
+	uint32_t m_write_plt :1;
+	/** write TLM markers in the main header */
+	uint32_t m_write_tlm :1;
 	/* rate control algorithm */
 	uint32_t rateControlAlgorithm;
+	/** maximum number of tiles encoded concurrently; if == 0, use number of threads */
+	uint32_t m_max_tiles_in_flight;
 };
 
 struct grk_decoding_param {
@@ -352,6 +363,14 @@ struct grk_decoding_param {
 	uint32_t m_reduce;
 	/** if != 0, then only the first "layer" layers are decoded; if == 0 or not used, all the quality layers are decoded */
 	uint32_t m_layer;
+	/** maximum number of tiles decoded concurrently; if == 0, use number of threads */
+	uint32_t m_max_tiles_in_flight;
+	/** order in which the code blocks of a tile are decoded */
+	GRK_T1_SCHEDULE m_t1_schedule;
+	/** if true, the inverse wavelet waits until every code block of the tile is decoded */
+	bool m_disable_pipeline;
+	/** sample type and layout of the decoded image */
+	grk_output_format m_output_format;
 };
 
 struct grk_tl_info {
@@ -374,6 +393,10 @@ typedef std::vector<grk_tl_info> TL_INFO_VEC;
 typedef std::map<uint8_t, TL_INFO_VEC> TL_MAP;
 struct grk_tl_marker {
     TL_MAP tile_part_lengths;
+    /** codestream position of the SOT marker of every tile-part, per tile,
+     *  built from tile_part_lengths once the main header has been read.
+     *  Empty if the TLM markers do not describe every tile-part */
+    std::vector< std::vector<uint64_t> > tile_part_offsets;
 };
 
 struct grk_pl_info {
@@ -501,14 +524,6 @@ struct grk_j2k_dec {
 };
 
 struct grk_j2k_enc {
-	/** Tile part number, regardless of poc, for each new poc, tp is reset to 1*/
-	uint8_t m_current_poc_tile_part_number; /* tp_num */
-
-	/** Tile part number currently coding, taking into account POC.
-	 *  m_current_tile_part_number holds the total number of tile parts
-	 *   while encoding the last tile part.*/
-	uint8_t m_current_tile_part_number; /*cur_tp_num */
-
 	/**
 	 locate the start position of the TLM marker
 	 after encoding the tilepart, a jump (in j2k_write_sod) is done
@@ -534,6 +549,41 @@ struct grk_j2k;
 typedef bool (*j2k_procedure)(grk_j2k *j2k, BufferedStream*);
 
 struct TileProcessor;
+
+/**
+ * State for writing the tile parts of a single tile. Each tile
+ * has its own writer, so that tiles can be encoded concurrently.
+ */
+struct grk_tile_writer {
+	grk_tile_writer(TileProcessor *tp, uint16_t tile_no,
+			uint8_t *tlm_sot_offsets) :
+			tileProcessor(tp),
+			tile_no(tile_no),
+			m_current_poc_tile_part_number(0),
+			m_current_tile_part_number(0),
+			m_tlm_sot_offsets_current(tlm_sot_offsets) {
+	}
+	TileProcessor *tileProcessor;
+	uint16_t tile_no;
+
+	/** Tile part number, regardless of poc, for each new poc, tp is reset to 1*/
+	uint8_t m_current_poc_tile_part_number; /* tp_num */
+
+	/** Tile part number currently coding, taking into account POC.
+	 *  m_current_tile_part_number holds the total number of tile parts
+	 *   while encoding the last tile part.*/
+	uint8_t m_current_tile_part_number; /*cur_tp_num */
+
+	/**
+	 * Offset in the tlm buffer of this tile's first remaining tile part
+	 */
+	uint8_t *m_tlm_sot_offsets_current;
+
+	/**
+	 * Length of each packet of each tile part, when PLT markers are written
+	 */
+	std::vector<std::vector<uint32_t>> m_packet_lengths;
+};
 /**
  JPEG-2000 codestream reader/writer
  */
@@ -684,6 +734,16 @@ bool j2k_read_tile_header(grk_j2k *p_j2k, uint16_t *tile_index,
 bool j2k_set_decode_area(grk_j2k *p_j2k, grk_image *p_image, uint32_t start_x,
 		uint32_t start_y, uint32_t end_x, uint32_t end_y);
 
+/**
+ * Sets the sample type and layout of the decoded image.
+ *
+ * @param	p_j2k		the jpeg2000 codec.
+ * @param	format		sample type and layout
+ *
+ * @return	true		if the format could be set.
+ */
+bool j2k_set_output_format(grk_j2k *p_j2k, const grk_output_format *format);
+
 /**
  * Creates a J2K decompression structure.
  *
@@ -300,7 +300,22 @@ static bool j2k_write_SQcd_SQcc(grk_j2k *p_j2k, uint16_t tile_no,
 /**
  * Updates the Tile Length Marker.
  */
-static void j2k_update_tlm(grk_j2k *p_j2k, uint32_t tile_part_size);
+static void j2k_update_tlm(grk_coding_parameters *cp,
+		grk_tile_writer *p_writer, uint32_t tile_part_size);
+
+/**
+ * Gets the number of bytes of each tile part entry in the TLM markers:
+ * an 8 bit tile index when there are at most 256 tiles, otherwise
+ * a 16 bit tile index, followed by a 32 bit tile part length.
+ */
+static uint32_t j2k_get_tlm_entry_size(grk_coding_parameters *cp);
+
+/**
+ * Gets an upper bound on the size of the PLT markers of a tile part.
+ *
+ * @param       p_j2k   J2K codec.
+ */
+static uint64_t j2k_get_max_plt_size(grk_j2k *p_j2k);
 
 /**
  * Reads a SQcd or SQcc element, i.e. the quantization values of a band in the QCD or QCC.
@@ -328,21 +343,106 @@ static void j2k_copy_tile_component_parameters(grk_j2k *p_j2k);
  */
 static bool j2k_decode_tiles(grk_j2k *p_j2k, BufferedStream *p_stream);
 
+/**
+ * Reads the tiles, keeping up to max_tiles_in_flight tiles decoding concurrently
+ * on the thread pool. Tile headers and tile data are still read sequentially.
+ *
+ * @param               p_j2k                   the J2k codec.
+ * @param               p_stream                the stream to read from.
+ * @param               max_tiles_in_flight     maximum number of tiles decoded at once
+ */
+static bool j2k_decode_tiles_concurrent(grk_j2k *p_j2k, BufferedStream *p_stream,
+		uint32_t max_tiles_in_flight);
+
+/**
+ * Copies the number of decoded resolutions from a decoded tile's image header
+ * to the output image.
+ *
+ * @param               p_tile_image            the tile image header.
+ * @param               p_output_image          the output image.
+ */
+static void j2k_copy_resno_decoded(const grk_image *p_tile_image,
+		grk_image *p_output_image);
+
+struct grk_tile_in_flight;
+
+/**
+ * Waits for a concurrently decoded tile to complete, and releases it.
+ *
+ * @param               p_j2k                   the J2k codec.
+ * @param               tile                    the tile in flight.
+ * @param               num_tiles               total number of tiles.
+ */
+static bool j2k_wait_for_tile(grk_j2k *p_j2k, grk_tile_in_flight *tile,
+		uint32_t num_tiles);
+
+/**
+ * Resets the decoder state once the data of the current tile has been consumed,
+ * and reads the next marker, which should be EOC or SOT
+ *
+ * @param               p_j2k                   the J2k codec.
+ * @param               p_stream                the stream to read from.
+ */
+static bool j2k_end_tile_data(grk_j2k *p_j2k, BufferedStream *p_stream);
+
 static bool j2k_pre_write_tile(grk_j2k *p_j2k, uint16_t tile_index);
 
 static bool j2k_post_write_tile(grk_j2k *p_j2k, BufferedStream *p_stream);
 
+/**
+ * Gets the size of the buffer reserved for the encoded tile parts of a tile.
+ *
+ * @param       p_j2k          J2K codec.
+ */
+static uint64_t j2k_get_max_tile_size(grk_j2k *p_j2k);
+
+/**
+ * Encodes a tile and writes all of its tile parts.
+ *
+ * @param       p_j2k          J2K codec.
+ * @param       p_writer       the tile writer.
+ * @param       p_stream       the stream to write data to.
+ */
+static bool j2k_write_tile_parts(grk_j2k *p_j2k, grk_tile_writer *p_writer,
+		BufferedStream *p_stream);
+
+/**
+ * Encodes the tiles, keeping up to max_tiles_in_flight tiles encoding concurrently
+ * on the thread pool. Each tile is encoded into its own memory buffer, and the buffers
+ * are written to the stream in tile order.
+ *
+ * @param       p_j2k                   J2K codec.
+ * @param       p_stream                the stream to write data to.
+ * @param       max_tiles_in_flight     maximum number of tiles encoded at once
+ */
+static bool j2k_encode_tiles_concurrent(grk_j2k *p_j2k, BufferedStream *p_stream,
+		uint32_t max_tiles_in_flight);
+
+struct grk_encoded_tile;
+
+/**
+ * Waits for a concurrently encoded tile to complete, writes it to the stream,
+ * and releases it.
+ *
+ * @param       tile           the tile in flight.
+ * @param       p_stream       the stream to write data to.
+ */
+static bool j2k_write_encoded_tile(grk_encoded_tile *tile,
+		BufferedStream *p_stream);
+
 /**
  * Sets up the procedures to do on writing header.
  * Developers wanting to extend the library can add their own writing procedures.
  */
 static bool j2k_setup_header_writing(grk_j2k *p_j2k);
 
-static bool j2k_write_first_tile_part(grk_j2k *p_j2k, uint64_t *p_data_written,
-		uint64_t total_data_size, BufferedStream *p_stream);
+static bool j2k_write_first_tile_part(grk_j2k *p_j2k, grk_tile_writer *p_writer,
+		uint64_t *p_data_written, uint64_t total_data_size,
+		BufferedStream *p_stream);
 
-static bool j2k_write_all_tile_parts(grk_j2k *p_j2k, uint64_t *p_data_written,
-		uint64_t total_data_size, BufferedStream *p_stream);
+static bool j2k_write_all_tile_parts(grk_j2k *p_j2k, grk_tile_writer *p_writer,
+		uint64_t *p_data_written, uint64_t total_data_size,
+		BufferedStream *p_stream);
 
 /**
  * Gets the offset of the header.
@@ -589,12 +689,13 @@ static bool j2k_write_poc(grk_j2k *p_j2k, BufferedStream *p_stream);
  * Writes the POC marker (Progression Order Change)
  *
  * @param       p_j2k          J2K codec.
+ * @param       tile_no        the tile to write the POC for.
  * @param       p_stream       the stream to write data to.
  * @param       p_data_written number of bytes written
 
  */
-static bool j2k_write_poc_in_memory(grk_j2k *p_j2k, BufferedStream *p_stream,
-		uint64_t *p_data_written);
+static bool j2k_write_poc_in_memory(grk_j2k *p_j2k, uint16_t tile_no,
+		BufferedStream *p_stream, uint64_t *p_data_written);
 /**
  * Gets the maximum size taken by the writing of a POC.
  */
@@ -644,6 +745,44 @@ static bool j2k_read_crg(grk_j2k *p_j2k, uint8_t *p_header_data,
 static bool j2k_read_tlm(grk_j2k *p_j2k, uint8_t *p_header_data,
 		uint16_t header_size);
 
+/**
+ * Builds the position of every tile-part in the codestream from the
+ * tile-part lengths read from the TLM markers.
+ *
+ * @param       p_j2k                   the jpeg2000 codec.
+ * @param       first_sot               position of the first SOT marker.
+ */
+static void j2k_build_tile_part_index(grk_j2k *p_j2k, uint64_t first_sot);
+
+/**
+ * Gets the position of the next tile-part of a tile, from the tile-part
+ * index built from the TLM markers.
+ *
+ * @param       p_j2k                   the jpeg2000 codec.
+ * @param       tile_no                 tile number.
+ * @param       pos                     the tile-part must start at or after this position.
+ * @param       p_offset                position of the SOT marker of the tile-part.
+ *
+ * @return true if the index holds such a tile-part.
+ */
+static bool j2k_next_tile_part(grk_j2k *p_j2k, uint16_t tile_no, uint64_t pos,
+		uint64_t *p_offset);
+
+/**
+ * Moves the stream to the SOT marker of the next tile-part of a tile, when
+ * the TLM markers locate it. If the stream does not hold a SOT marker there,
+ * the index is dropped and the stream stays where it was.
+ *
+ * @param       p_j2k                   the jpeg2000 codec.
+ * @param       p_stream                the stream to read data from.
+ * @param       tile_no                 tile number.
+ * @param       pos                     the tile-part must start at or after this position.
+ *
+ * @return true if the stream is positioned on the SOT marker of the tile-part.
+ */
+static bool j2k_seek_tile_part(grk_j2k *p_j2k, BufferedStream *p_stream,
+		uint16_t tile_no, uint64_t pos);
+
 /**
  * Writes the updated tlm.
  *
@@ -722,17 +861,41 @@ static bool j2k_merge_ppt(grk_tcp *p_tcp);
  */
 static bool j2k_write_tlm(grk_j2k *p_j2k, BufferedStream *p_stream);
 
+/**
+ * Finds the length of each packet of each tile part of a tile,
+ * once its code blocks are encoded
+ *
+ * @param       p_j2k           J2K codec.
+ * @param       p_writer        the tile writer, which keeps the lengths
+ * @param       max_len         the length available for the packets
+ */
+static bool j2k_get_packet_lengths(grk_j2k *p_j2k, grk_tile_writer *p_writer,
+		uint64_t max_len);
+
+/**
+ * Writes the PLT markers (Packet Lengths, tile-part header)
+ *
+ * @param       packet_lengths  lengths of the packets of the tile part
+ * @param       p_stream        the stream to write data to.
+ * @param       p_data_written  number of bytes written
+
+ */
+static bool j2k_write_plt(const std::vector<uint32_t> &packet_lengths,
+		BufferedStream *p_stream, uint64_t *p_data_written);
+
 /**
  * Writes the SOT marker (Start of tile-part)
  *
  * @param       p_j2k            J2K codec.
+ * @param       p_writer         the tile writer.
  * @param       p_stream         the stream to write data to.
  * @param       psot_location    PSOT location
  * @param       p_data_written   number of bytes written
 
  */
-static bool j2k_write_sot(grk_j2k *p_j2k, BufferedStream *p_stream,
-		uint64_t *psot_location, uint64_t *p_data_written);
+static bool j2k_write_sot(grk_j2k *p_j2k, grk_tile_writer *p_writer,
+		BufferedStream *p_stream, uint64_t *psot_location,
+		uint64_t *p_data_written);
 
 /**
  * Reads values from a SOT marker (Start of tile-part)
@@ -764,13 +927,13 @@ static bool j2k_read_sot(grk_j2k *p_j2k, uint8_t *p_header_data,
  * Writes the SOD marker (Start of data)
  *
  * @param       p_j2k               J2K codec.
- * @param       p_tile_coder        tile coder
+ * @param       p_writer            the tile writer.
  * @param       p_data_written      number of bytes written
  * @param       total_data_size   total data size
  * @param       p_stream            the stream to write data to.
 
  */
-static bool j2k_write_sod(grk_j2k *p_j2k, TileProcessor *p_tile_coder,
+static bool j2k_write_sod(grk_j2k *p_j2k, grk_tile_writer *p_writer,
 		uint64_t *p_data_written, uint64_t total_data_size,
 		BufferedStream *p_stream);
 
@@ -783,18 +946,17 @@ static bool j2k_write_sod(grk_j2k *p_j2k, TileProcessor *p_tile_coder,
  */
 static bool j2k_read_sod(grk_j2k *p_j2k, BufferedStream *p_stream);
 
-static void j2k_update_tlm(grk_j2k *p_j2k, uint32_t tile_part_size) {
-	/* PSOT */
-	grok_write_bytes(
-			p_j2k->m_specific_param.m_encoder.m_tlm_sot_offsets_current,
-			p_j2k->m_current_tile_number, 1);
-	++p_j2k->m_specific_param.m_encoder.m_tlm_sot_offsets_current;
+static void j2k_update_tlm(grk_coding_parameters *cp,
+		grk_tile_writer *p_writer, uint32_t tile_part_size) {
+	/* Ttlm */
+	uint32_t tile_index_size = j2k_get_tlm_entry_size(cp) - 4;
+	grok_write_bytes(p_writer->m_tlm_sot_offsets_current, p_writer->tile_no,
+			tile_index_size);
+	p_writer->m_tlm_sot_offsets_current += tile_index_size;
 
 	/* PSOT */
-	grok_write_bytes(
-			p_j2k->m_specific_param.m_encoder.m_tlm_sot_offsets_current,
-			tile_part_size, 4);
-	p_j2k->m_specific_param.m_encoder.m_tlm_sot_offsets_current += 4;
+	grok_write_bytes(p_writer->m_tlm_sot_offsets_current, tile_part_size, 4);
+	p_writer->m_tlm_sot_offsets_current += 4;
 }
 
 /**
@@ -1085,6 +1247,7 @@ static float j2k_get_default_stride(grk_tcp *p_tcp);
 /**
  * Checks for invalid number of tile-parts in SOT marker (TPsot==TNsot). See issue 254.
  *
+ * @param       p_j2k               the jpeg2000 codec.
  * @param       p_stream            the stream to read data from.
  * @param       tile_no             tile number we're looking for.
  * @param       p_correction_needed output value. if true, non conformant codestream needs TNsot correction.
@@ -1092,6 +1255,6 @@ static float j2k_get_default_stride(grk_tcp *p_tcp);
  *
  * @return true if the function was successful, false else.
  */
-static bool j2k_need_nb_tile_parts_correction(BufferedStream *p_stream,
-		uint16_t tile_no, bool *p_correction_needed);
+static bool j2k_need_nb_tile_parts_correction(grk_j2k *p_j2k,
+		BufferedStream *p_stream, uint16_t tile_no, bool *p_correction_needed);
 }
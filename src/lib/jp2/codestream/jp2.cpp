@@ -1858,11 +1858,32 @@ static bool jp2_read_colr(grk_jp2 *jp2, uint8_t *p_colr_header_data,
 	return true;
 }
 
+/**
+ * Palettes and channel definitions are applied to the int32_t component
+ * planes once the code stream is decoded, so the samples can only be
+ * packed after them. Otherwise, the code stream decoder packs them.
+ *
+ * @return true if the samples are to be packed after decoding
+ */
+static bool jp2_setup_output_format(grk_jp2 *jp2) {
+	auto color = &jp2->color;
+	bool pack_after = jp2->output_format.sample_type != GRK_SAMPLE_INT32
+			&& ((color->jp2_pclr && color->jp2_pclr->cmap) || color->jp2_cdef);
+	grk_output_format planes;
+	memset(&planes, 0, sizeof(planes));
+	j2k_set_output_format(jp2->j2k,
+			pack_after ? &planes : &jp2->output_format);
+
+	return pack_after;
+}
+
 bool jp2_decode(grk_jp2 *jp2, grk_plugin_tile *tile, BufferedStream *p_stream,
 		grk_image *p_image) {
 	if (!p_image)
 		return false;
 
+	bool pack_after = jp2_setup_output_format(jp2);
+
 	/* J2K decoding */
 	if (!j2k_decode(jp2->j2k, tile, p_stream, p_image)) {
 		GROK_ERROR(
@@ -1926,6 +1947,9 @@ bool jp2_decode(grk_jp2 *jp2, grk_plugin_tile *tile, BufferedStream *p_stream,
 		jp2_apply_cdef(p_image, &(jp2->color));
 	}
 
+	if (pack_after && !grk_image_pack(p_image, &jp2->output_format))
+		return false;
+
 	// retrieve icc profile
 	if (jp2->color.icc_profile_buf) {
 		p_image->icc_profile_buf = jp2->color.icc_profile_buf;
@@ -3227,6 +3251,11 @@ bool jp2_set_decode_area(grk_jp2 *p_jp2, grk_image *p_image, uint32_t start_x,
 			end_x, end_y);
 }
 
+bool jp2_set_output_format(grk_jp2 *p_jp2, const grk_output_format *format) {
+	p_jp2->output_format = *format;
+	return true;
+}
+
 bool jp2_get_tile(grk_jp2 *p_jp2, BufferedStream *p_stream, grk_image *p_image, uint16_t tile_index) {
 	if (!p_image)
 		return false;
@@ -3234,6 +3263,7 @@ bool jp2_get_tile(grk_jp2 *p_jp2, BufferedStream *p_stream, grk_image *p_image,
 	GROK_WARN(
 			"JP2 box which are after the codestream will not be read by this function.");
 
+	bool pack_after = jp2_setup_output_format(p_jp2);
 	if (!j2k_get_tile(p_jp2->j2k, p_stream, p_image, tile_index)) {
 		GROK_ERROR(
 				"Failed to decode the codestream in the JP2 file");
@@ -3273,6 +3303,9 @@ bool jp2_get_tile(grk_jp2 *p_jp2, BufferedStream *p_stream, grk_image *p_image,
 		jp2_apply_cdef(p_image, &(p_jp2->color));
 	}
 
+	if (pack_after && !grk_image_pack(p_image, &p_jp2->output_format))
+		return false;
+
 	if (p_jp2->color.icc_profile_buf) {
 		p_image->icc_profile_buf = p_jp2->color.icc_profile_buf;
 		p_image->icc_profile_len = p_jp2->color.icc_profile_len;
@@ -208,6 +208,9 @@ struct grk_jp2 {
 	grk_jp2_buffer xml;
 	grk_jp2_uuid uuids[JP2_MAX_NUM_UUIDS];
 	uint32_t numUuids;
+
+	/* sample type and layout of the decoded image */
+	grk_output_format output_format;
 };
 
 /**
@@ -392,6 +395,16 @@ void jp2_destroy(grk_jp2 *jp2);
 bool jp2_set_decode_area(grk_jp2 *p_jp2, grk_image *p_image, uint32_t start_x,
 		uint32_t start_y, uint32_t end_x, uint32_t end_y);
 
+/**
+ * Sets the sample type and layout of the decoded image.
+ *
+ * @param  p_jp2      the jpeg2000 codec.
+ * @param  format     sample type and layout
+ *
+ * @return  true      if the format could be set.
+ */
+bool jp2_set_output_format(grk_jp2 *p_jp2, const grk_output_format *format);
+
 /**
  *
  */
@@ -115,6 +115,10 @@ struct grk_codec_private {
 					grk_image *p_image,
 					uint16_t tile_index);
 
+			/** Set output format function handler */
+			bool (*set_output_format)(void *p_codec,
+					const grk_output_format *format);
+
 		} m_decompression;
 
 		/**
@@ -152,10 +156,30 @@ struct grk_codec_private {
 
 
 ThreadPool* Scheduler::g_tp = nullptr;
+std::vector<WorkerArena*> Scheduler::g_arenas;
 
 static bool is_plugin_initialized = false;
+static void grk_deinitialize_thread_pool(void) {
+	delete Scheduler::g_tp;
+	Scheduler::g_tp = nullptr;
+	// workers have been joined, so no arena is still in use
+	for (auto arena : Scheduler::g_arenas)
+		delete arena;
+	Scheduler::g_arenas.clear();
+}
+
 bool GRK_CALLCONV grk_initialize(const char *plugin_path, uint32_t numthreads) {
-	Scheduler::g_tp = new ThreadPool(numthreads ? numthreads : hardware_concurrency());
+	if (!numthreads)
+		numthreads = hardware_concurrency();
+	// initializing again keeps the thread pool, unless its size changes
+	if (Scheduler::g_tp && Scheduler::g_tp->num_threads() != numthreads)
+		grk_deinitialize_thread_pool();
+	if (!Scheduler::g_tp) {
+		Scheduler::g_tp = new ThreadPool(numthreads);
+		for (size_t i = 0; i < Scheduler::g_tp->num_threads(); ++i)
+			Scheduler::g_arenas.push_back(new WorkerArena());
+	}
+	Kernels::init();
 	if (!is_plugin_initialized) {
 		grok_plugin_load_info info;
 		info.plugin_path = plugin_path;
@@ -166,8 +190,7 @@ bool GRK_CALLCONV grk_initialize(const char *plugin_path, uint32_t numthreads) {
 
 GRK_API void GRK_CALLCONV grk_deinitialize() {
 	grok_plugin_cleanup();
-	delete Scheduler::g_tp;
-	Scheduler::g_tp = nullptr;
+	grk_deinitialize_thread_pool();
 }
 
 /* ---------------------------------------------------------------------- */
@@ -296,6 +319,9 @@ const char* GRK_CALLCONV grk_version(void) {
 		l_codec->m_codec_data.m_decompression.get_decoded_tile = (bool (*)(
 				void *p_codec, BufferedStream *p_cio, grk_image *p_image, uint16_t tile_index)) j2k_get_tile;
 
+		l_codec->m_codec_data.m_decompression.set_output_format = (bool (*)(
+				void*, const grk_output_format*)) j2k_set_output_format;
+
 		l_codec->m_codec = j2k_create_decompress();
 
 		if (!l_codec->m_codec) {
@@ -332,6 +358,8 @@ const char* GRK_CALLCONV grk_version(void) {
 
 		l_codec->m_codec_data.m_decompression.get_decoded_tile = (bool (*)(
 				void *p_codec, BufferedStream *p_cio, grk_image *p_image, uint16_t tile_index)) jp2_get_tile;
+		l_codec->m_codec_data.m_decompression.set_output_format = (bool (*)(
+				void*, const grk_output_format*)) jp2_set_output_format;
 		l_codec->m_codec = jp2_create(true);
 		if (!l_codec->m_codec) {
 			grok_free(l_codec);
@@ -411,6 +439,29 @@ bool GRK_CALLCONV grk_set_decode_area( grk_codec  *p_codec,
 	}
 	return false;
 }
+bool GRK_CALLCONV grk_set_output_format( grk_codec  *p_codec,
+		GRK_SAMPLE_TYPE sample_type, bool interleaved, uint64_t stride,
+		uint8_t *buffer, uint64_t buffer_len) {
+	if (p_codec) {
+		grk_codec_private *l_codec = (grk_codec_private*) p_codec;
+		if (!l_codec->is_decompressor) {
+			return false;
+		}
+		if (sample_type > GRK_SAMPLE_FLOAT32) {
+			GROK_ERROR("Unknown output sample type %d", sample_type);
+			return false;
+		}
+		grk_output_format format;
+		format.sample_type = sample_type;
+		format.interleaved = interleaved;
+		format.stride = stride;
+		format.buffer = buffer;
+		format.buffer_len = buffer_len;
+		return l_codec->m_codec_data.m_decompression.set_output_format(
+				l_codec->m_codec, &format);
+	}
+	return false;
+}
 bool GRK_CALLCONV grk_read_tile_header( grk_codec  *p_codec,
 		 uint16_t *tile_index, uint64_t *data_size,
 		uint32_t *p_tile_x0, uint32_t *p_tile_y0, uint32_t *p_tile_x1,
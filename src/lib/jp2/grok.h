@@ -320,6 +320,25 @@ typedef enum _GRK_CODEC_FORMAT {
 	GRK_CODEC_JP2 = 2 			/**< JP2 file format : read/write */
 } GRK_CODEC_FORMAT;
 
+/**
+ * Order in which the code blocks of a tile are handed to the
+ * tier-1 decoder threads
+ */
+typedef enum _GRK_T1_SCHEDULE {
+	GRK_T1_SCHEDULE_COST = 0, 		/**< largest estimated decode cost first */
+	GRK_T1_SCHEDULE_CODESTREAM = 1 	/**< component-resolution-band-precinct order */
+} GRK_T1_SCHEDULE;
+
+/**
+ * Type of the samples delivered by the decoder
+ */
+typedef enum _GRK_SAMPLE_TYPE {
+	GRK_SAMPLE_INT32 = 0,	/**< one int32_t plane per component, in grk_image_comp::data */
+	GRK_SAMPLE_UINT8 = 1,	/**< 8 bits per sample, in grk_image::packed_data */
+	GRK_SAMPLE_UINT16 = 2,	/**< 16 bits per sample, in grk_image::packed_data */
+	GRK_SAMPLE_FLOAT32 = 3	/**< float per sample, in grk_image::packed_data */
+} GRK_SAMPLE_TYPE;
+
 #define  GRK_NUM_COMMENTS_SUPPORTED 256
 #define GRK_MAX_COMMENT_LENGTH (UINT16_MAX-2)
 
@@ -512,7 +531,8 @@ typedef struct _grk_cparameters {
 	bool write_display_resolution;
 	double display_resolution[2];
 
-	// 0: bisect with all truncation points,  1: bisect with only feasible truncation points
+	// 0: bisect with all truncation points,  1: bisect with only feasible truncation points,
+	// 2: feasible truncation points, with estimated packet header sizes verified by T2
 	uint32_t rateControlAlgorithm;
 	uint32_t numThreads;
 	int32_t deviceId;
@@ -520,6 +540,17 @@ typedef struct _grk_cparameters {
 	uint32_t kernelBuildOptions;
 	uint32_t repeats;
 	bool verbose;
+	/**
+	 Set the maximum number of tiles that are encoded concurrently.
+	 Bounds the memory used by in-flight tiles when encoding multi-tile images.
+	 if == 0 or not used, the number of threads in the library thread pool is used;
+	 if == 1, tiles are encoded one at a time
+	 */
+	uint32_t max_tiles_in_flight;
+	/** Write PLT markers (packet lengths) in the header of each tile part */
+	bool write_plt;
+	/** Write TLM markers (tile part lengths) in the main header */
+	bool write_tlm;
 }  grk_cparameters; 
 
 /**
@@ -685,6 +716,29 @@ typedef struct _grk_dparameters {
 	/** Nb of tile to decode */
 	uint32_t nb_tile_to_decode;
 	uint32_t flags;
+	/**
+	 Set the maximum number of tiles that are decoded concurrently.
+	 Bounds the memory used by in-flight tiles when decoding multi-tile images.
+	 if == 0 or not used, the number of threads in the library thread pool is used;
+	 if == 1, tiles are decoded one at a time
+	 */
+	uint32_t max_tiles_in_flight;
+	/**
+	 Order in which the code blocks of a tile are decoded.
+	 Decoding the most expensive blocks first stops a single large block,
+	 picked up last, from keeping one thread busy while the others idle.
+	 Default: GRK_T1_SCHEDULE_COST
+	 */
+	GRK_T1_SCHEDULE t1_schedule;
+	/**
+	 Decode each tile in separate stages: every code block first, then
+	 the inverse wavelet, then MCT and DC level shift.
+	 By default, the inverse wavelet of a resolution starts as soon as the
+	 code blocks of that resolution and the lower ones are decoded, while
+	 code blocks of higher resolutions are still being decoded.
+	 This only applies when the whole tile is decoded.
+	 */
+	bool disable_pipeline;
 }  grk_dparameters; 
 
 typedef enum grk_prec_mode {
@@ -745,6 +799,8 @@ typedef struct _grk_decompress_params {
 	uint32_t repeats;
 	bool verbose;
 	uint32_t numThreads;
+	/* decode RAW/RAWL output straight to packed samples, when possible */
+	bool packed_raw;
 } grk_decompress_parameters;
 
 typedef void * grk_codec; 
@@ -868,6 +924,14 @@ typedef struct _grk_image {
 	size_t iptc_len;
 	uint8_t *xmp_buf;
 	size_t xmp_len;
+	/** decoded samples, in the type and layout set by
+	 *  grk_set_output_format. Planar output holds the plane of each
+	 *  component in turn, each plane being comps[0].h rows */
+	uint8_t *packed_data;
+	/** distance in bytes between the starts of two rows of packed_data */
+	uint64_t packed_stride;
+	/** if true, then image will manage packed_data, otherwise up to caller */
+	bool owns_packed_data;
 } grk_image;
 
 /**
@@ -1232,7 +1296,13 @@ typedef struct _grk_plugin_tile {
 
 // version
 GRK_API const char* GRK_CALLCONV grk_version(void);
-//initialize library
+/**
+ Initialize library. Calling it again keeps the library thread pool,
+ unless numthreads asks for a different number of threads.
+ @param plugin_path	path to plugin, or nullptr
+ @param numthreads	number of threads in the library thread pool,
+ 					or 0 for the number of hardware threads
+ */
 GRK_API bool GRK_CALLCONV grk_initialize(const char *plugin_path,
 		uint32_t numthreads);
 //deinitialize library
@@ -1484,6 +1554,35 @@ GRK_API bool GRK_CALLCONV grk_set_decode_area( grk_codec  *p_codec,
 		grk_image *p_image, uint32_t start_x, uint32_t start_y,
 		uint32_t end_x, uint32_t end_y);
 
+/**
+ * Sets the type and layout of the decoded samples. This function should be
+ * called after grk_setup_decoder and before grk_decode or
+ * grk_get_decoded_tile.
+ *
+ * For any type other than GRK_SAMPLE_INT32, the decoder writes the samples
+ * of all components to grk_image::packed_data, rather than to int32_t
+ * component planes. All components must have the same dimensions, and, for
+ * GRK_SAMPLE_UINT8 and GRK_SAMPLE_UINT16, a precision of no more than 8 or
+ * 16 bits. Signed samples are stored in two's complement, as with
+ * grk_decode_tile_data.
+ *
+ * @param	p_codec			the jpeg2000 codec.
+ * @param	sample_type		type of the decoded samples. Default: GRK_SAMPLE_INT32
+ * @param	interleaved		store the components of each pixel next to each other
+ * 							(RGBRGB...), rather than one plane per component
+ * @param	stride			distance in bytes between the starts of two rows;
+ * 							if == 0, rows follow each other with no padding
+ * @param	buffer			buffer of buffer_len bytes for the samples, which remains
+ * 							owned by the caller. if == nullptr, the library allocates
+ * 							the buffer, and grk_image_destroy frees it
+ * @param	buffer_len		length of buffer
+ *
+ * @return	true			if the format could be set.
+ */
+GRK_API bool GRK_CALLCONV grk_set_output_format( grk_codec  *p_codec,
+		GRK_SAMPLE_TYPE sample_type, bool interleaved, uint64_t stride,
+		uint8_t *buffer, uint64_t buffer_len);
+
 
 /**
  * Decode an image from a JPEG-2000 codestream
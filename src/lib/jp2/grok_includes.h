@@ -81,6 +81,7 @@
 #include <sstream>
 #include <iostream>
 #include <vector>
+#include <deque>
 
 /* Avoid compile-time warning because parameter is not used */
 #define ARG_NOT_USED(x) (void)(x)
@@ -185,6 +186,8 @@ static inline long grok_lrintf(float f) {
 #define GRK_UNUSED(x) (void)x
 
 #include "ThreadPool.h"
+#include "kernels.h"
+#include "WorkerArena.h"
 #include "mem_stream.h"
 #include "grok_malloc.h"
 #include "logger.h"
@@ -103,6 +103,8 @@ void GRK_CALLCONV grk_image_destroy(grk_image *image) {
 			grk_buffer_delete(image->xmp_buf);
 			image->xmp_buf = nullptr;
 		}
+		if (image->packed_data && image->owns_packed_data)
+			grk::grok_aligned_free(image->packed_data);
 		grk::grok_free(image);
 	}
 }
@@ -267,6 +269,154 @@ void transfer_image_data(grk_image *src, grk_image *dest) {
 		dest_comp->owns_data = src_comp->owns_data;
 		src_comp->data = nullptr;
 	}
+	if (dest->packed_data && dest->owns_packed_data)
+		grok_aligned_free(dest->packed_data);
+	dest->packed_data = src->packed_data;
+	dest->packed_stride = src->packed_stride;
+	dest->owns_packed_data = src->owns_packed_data;
+	src->packed_data = nullptr;
+}
+
+uint32_t grk_sample_size(GRK_SAMPLE_TYPE sample_type) {
+	switch (sample_type) {
+	case GRK_SAMPLE_UINT8:
+		return 1;
+	case GRK_SAMPLE_UINT16:
+		return 2;
+	default:
+		return 4;
+	}
+}
+
+bool grk_image_alloc_packed(grk_image *image, const grk_output_format *format,
+		bool clear) {
+	if (!image->numcomps || !image->comps)
+		return false;
+	uint32_t sample_bytes = grk_sample_size(format->sample_type);
+	uint32_t numcomps = image->numcomps;
+	auto comp0 = image->comps;
+	for (uint32_t compno = 0; compno < numcomps; ++compno) {
+		auto comp = image->comps + compno;
+		if (comp->w != comp0->w || comp->h != comp0->h
+				|| comp->dx != comp0->dx || comp->dy != comp0->dy) {
+			GROK_ERROR("Packed output needs components of equal dimensions: "
+					"component %d is %dx%d rather than %dx%d", compno,
+					comp->w, comp->h, comp0->w, comp0->h);
+			return false;
+		}
+		if (format->sample_type != GRK_SAMPLE_FLOAT32
+				&& comp->prec > sample_bytes * 8) {
+			GROK_ERROR("Component %d precision %d does not fit in "
+					"%d bit packed samples", compno, comp->prec,
+					sample_bytes * 8);
+			return false;
+		}
+	}
+	uint32_t comps_per_row = format->interleaved ? numcomps : 1;
+	uint64_t row_len = (uint64_t) comp0->w * comps_per_row * sample_bytes;
+	uint64_t stride = format->stride ? format->stride : row_len;
+	if (stride < row_len) {
+		GROK_ERROR("Packed output stride %" PRIu64 " is less than "
+				"the row length %" PRIu64, stride, row_len);
+		return false;
+	}
+	uint64_t num_rows = (uint64_t) comp0->h * (numcomps / comps_per_row);
+	if (!num_rows)
+		return false;
+	// the last row needs no padding, and any bytes that follow the
+	// rows in the caller's buffer are left alone
+	uint64_t len = stride * (num_rows - 1) + row_len;
+	uint8_t *dest = format->buffer;
+	if (dest) {
+		if (format->buffer_len < len) {
+			GROK_ERROR("Packed output buffer of %" PRIu64 " bytes is smaller "
+					"than the %" PRIu64 " bytes of the image",
+					format->buffer_len, len);
+			return false;
+		}
+	} else {
+		dest = (uint8_t*) grok_aligned_malloc(len);
+		if (!dest) {
+			GROK_ERROR("Not enough memory for packed output");
+			return false;
+		}
+	}
+	if (clear) {
+		for (uint64_t row = 0; row < num_rows; ++row)
+			memset(dest + row * stride, 0, row_len);
+	}
+	if (image->packed_data && image->owns_packed_data)
+		grok_aligned_free(image->packed_data);
+	image->packed_data = dest;
+	image->packed_stride = stride;
+	image->owns_packed_data = !format->buffer;
+
+	return true;
+}
+
+void grk_pack_row(GRK_SAMPLE_TYPE sample_type, const int32_t *const *src,
+		uint32_t numcomps, uint8_t *dest, uint64_t n) {
+	auto kernels = Kernels::g_kernels;
+	switch (sample_type) {
+	case GRK_SAMPLE_UINT8:
+		kernels->pack_u8(src, numcomps, dest, n);
+		break;
+	case GRK_SAMPLE_UINT16:
+		kernels->pack_u16(src, numcomps, (uint16_t*) dest, n);
+		break;
+	default:
+		kernels->pack_f32(src, numcomps, (float*) dest, n);
+		break;
+	}
+}
+
+bool grk_image_pack(grk_image *image, const grk_output_format *format) {
+	if (format->sample_type == GRK_SAMPLE_INT32)
+		return true;
+	if (!image->numcomps || !image->comps)
+		return false;
+	for (uint32_t compno = 0; compno < image->numcomps; ++compno) {
+		if (!image->comps[compno].data) {
+			GROK_ERROR("Component %d has no data to pack", compno);
+			return false;
+		}
+	}
+	if (!grk_image_alloc_packed(image, format, false))
+		return false;
+
+	// one band of rows per thread
+	uint32_t numcomps = image->numcomps;
+	uint32_t w = image->comps->w;
+	uint32_t h = image->comps->h;
+	uint32_t comps_per_row = format->interleaved ? numcomps : 1;
+	uint64_t num_rows = (uint64_t) h * (numcomps / comps_per_row);
+	uint64_t num_bands = std::min<uint64_t>(Scheduler::g_tp->num_threads(),
+			num_rows);
+	auto sample_type = format->sample_type;
+	auto dest = image->packed_data;
+	auto stride = image->packed_stride;
+	Scheduler::g_tp->parallel_for(num_bands,
+			[=](size_t band) {
+		const int32_t *src[4];
+		std::vector<const int32_t*> src_vec;
+		auto rows = src;
+		if (comps_per_row > 4) {
+			src_vec.resize(comps_per_row);
+			rows = src_vec.data();
+		}
+		uint64_t row_end = num_rows * (band + 1) / num_bands;
+		for (uint64_t row = num_rows * band / num_bands; row < row_end; ++row) {
+			uint64_t y = row % h;
+			uint32_t first_comp = (uint32_t) (row / h);
+			for (uint32_t c = 0; c < comps_per_row; ++c)
+				rows[c] = image->comps[first_comp + c].data + y * w;
+			grk_pack_row(sample_type, rows, comps_per_row,
+					dest + row * stride, w);
+		}
+	});
+	grk_image_all_components_data_free(image);
+
+	return true;
 }
 
 }
@@ -84,10 +84,59 @@ bool update_image_dimensions(grk_image* p_image, uint32_t reduce);
 
 /**
  Transfer data from src to dest for each component, and null out src data.
+ Packed data, if any, is transferred as well.
  Assumption:  src and dest have the same number of components
  */
 void transfer_image_data(grk_image *src, grk_image *dest);
 
+/**
+ * Sample type and layout of decoded images, from grk_set_output_format.
+ * All zero is the default: int32_t planes.
+ */
+struct grk_output_format {
+	GRK_SAMPLE_TYPE sample_type;
+	bool interleaved;
+	uint64_t stride;
+	uint8_t *buffer;
+	uint64_t buffer_len;
+};
+
+/**
+ Size in bytes of a packed sample of the given type
+ */
+uint32_t grk_sample_size(GRK_SAMPLE_TYPE sample_type);
+
+/**
+ Set up the packed_data of an image for the sample type and layout of
+ format, in the caller's buffer of format or in a buffer that the image
+ owns. The components must already have their decoded dimensions.
+ @param image	image
+ @param format	sample type and layout
+ @param clear	if true, set every sample to zero
+ @return false if the components cannot be packed in this format, or if
+ there is not enough memory
+ */
+bool grk_image_alloc_packed(grk_image *image, const grk_output_format *format,
+		bool clear);
+
+/**
+ Pack n samples of each of numcomps rows into dest, in the given sample
+ type, interleaving the rows when numcomps > 1
+ */
+void grk_pack_row(GRK_SAMPLE_TYPE sample_type, const int32_t *const *src,
+		uint32_t numcomps, uint8_t *dest, uint64_t n);
+
+/**
+ Pack the int32_t component planes of an image into packed_data, in the
+ sample type and layout of format, and release the planes that the image
+ owns. Does nothing for GRK_SAMPLE_INT32.
+
+ The decoder packs samples as it writes them to the output image; this
+ pass is only needed once the planes have been changed after decoding,
+ as with JP2 palettes and channel definitions.
+ */
+bool grk_image_pack(grk_image *image, const grk_output_format *format);
+
 /*@}*/
 
 }
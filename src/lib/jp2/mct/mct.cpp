@@ -55,8 +55,6 @@
  * POSSIBILITY OF SUCH DAMAGE.
  */
 
-#include "CPUArch.h"
-#include "simd.h"
 #include "grok_includes.h"
 
 namespace grk {
@@ -79,60 +77,37 @@ const double* mct::get_norms_irrev() {
 }
 
 
+/**
+ * Run a three component kernel over n samples, with one chunk of samples
+ * per thread. Chunks start on a multiple of 16 samples, so that each chunk
+ * keeps the alignment that the widest kernels rely on.
+ */
+template<typename T> static void mct_parallel(
+		void (*kernel)(T*, T*, T*, uint64_t),
+		T *chan0, T *chan1, T *chan2, uint64_t n){
+	const uint64_t align = 16;
+	size_t num_threads = Scheduler::g_tp->num_threads();
+	uint64_t chunkSize = n / num_threads;
+	chunkSize = (chunkSize/align) * align;
+	uint64_t i = 0;
+	if (chunkSize > align) {
+		Scheduler::g_tp->parallel_for(num_threads,
+				[kernel, chunkSize, chan0, chan1, chan2](size_t index) {
+			uint64_t begin = (uint64_t)index * chunkSize;
+			kernel(chan0 + begin, chan1 + begin, chan2 + begin, chunkSize);
+		});
+		i = chunkSize * num_threads;
+	}
+	if (i < n)
+		kernel(chan0 + i, chan1 + i, chan2 + i, n - i);
+}
+
 /* <summary> */
 /* Forward reversible MCT. */
 /* </summary> */
 void mct::encode_rev(int32_t *restrict chan0, int32_t *restrict chan1,
 		int32_t *restrict chan2, uint64_t n) {
-	size_t i = 0;
-
-#if (defined(__SSE2__) || defined(__AVX2__))
-    size_t chunkSize = n / Scheduler::g_tp->num_threads();
-    //ensure it is divisible by VREG_INT_COUNT
-    chunkSize = (chunkSize/VREG_INT_COUNT) * VREG_INT_COUNT;
-	if (chunkSize > VREG_INT_COUNT) {
-	    std::vector< std::future<int> > results;
-	    for(uint64_t i = 0; i < Scheduler::g_tp->num_threads(); ++i) {
-	    	uint64_t index = i;
-	        results.emplace_back(
-	            Scheduler::g_tp->enqueue([index, chunkSize, chan0,chan1,chan2] {
-	        		uint64_t begin = (uint64_t)index * chunkSize;
-					for (auto j = begin; j < begin+chunkSize; j+=VREG_INT_COUNT ){
-						VREG y, u, v;
-						VREG r = LOAD((const VREG*) &chan0[j]);
-						VREG g = LOAD((const VREG*) &chan1[j]);
-						VREG b = LOAD((const VREG*) &chan2[j]);
-						y = ADD(g, g);
-						y = ADD(y, b);
-						y = ADD(y, r);
-						y = SAR(y, 2);
-						u = SUB(b, g);
-						v = SUB(r, g);
-						STORE((VREG*) &chan0[j], y);
-						STORE((VREG*) &chan1[j], u);
-						STORE((VREG*) &chan2[j], v);
-					}
-	                return 0;
-	            })
-	        );
-	    }
-	    for(auto && result: results){
-	        result.get();
-	    }
-		i = chunkSize * Scheduler::g_tp->num_threads();
-	}
-#endif
-	for (; i < n; ++i) {
-		int32_t r = chan0[i];
-		int32_t g = chan1[i];
-		int32_t b = chan2[i];
-		int32_t y = (r + (g * 2) + b) >> 2;
-		int32_t u = b - g;
-		int32_t v = r - g;
-		chan0[i] = y;
-		chan1[i] = u;
-		chan2[i] = v;
-	}
+	mct_parallel(Kernels::g_kernels->mct_encode_rev, chan0, chan1, chan2, n);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -142,52 +117,7 @@ void mct::encode_rev(int32_t *restrict chan0, int32_t *restrict chan1,
 /* </summary> */
 void mct::decode_rev(int32_t *restrict chan0, int32_t *restrict chan1,
 		int32_t *restrict chan2, uint64_t n) {
-	size_t i = 0;
-#if (defined(__SSE2__) || defined(__AVX2__))
-    size_t chunkSize = n / Scheduler::g_tp->num_threads();
-    //ensure it is divisible by VREG_INT_COUNT
-    chunkSize = (chunkSize/VREG_INT_COUNT) * VREG_INT_COUNT;
-	if (chunkSize > VREG_INT_COUNT) {
-	    std::vector< std::future<int> > results;
-	    for(uint64_t i = 0; i < Scheduler::g_tp->num_threads(); ++i) {
-	    	uint64_t index = i;
-	        results.emplace_back(
-	            Scheduler::g_tp->enqueue([index, chunkSize,chan0,chan1,chan2] {
-					uint64_t begin = (uint64_t)index * chunkSize;
-					for (auto j = begin; j < begin+chunkSize; j+=VREG_INT_COUNT ){
-						VREG r, g, b;
-						VREG y = LOAD((const VREG*) &(chan0[j]));
-						VREG u = LOAD((const VREG*) &(chan1[j]));
-						VREG v = LOAD((const VREG*) &(chan2[j]));
-						g = y;
-						g = SUB(g, SAR(ADD(u, v), 2));
-						r = ADD(v, g);
-						b = ADD(u, g);
-						STORE((VREG*) &(chan0[j]), r);
-						STORE((VREG*) &(chan1[j]), g);
-						STORE((VREG*) &(chan2[j]), b);
-					}
-					return 0;
-	            })
-	        );
-	    }
-	    for(auto && result: results){
-	        result.get();
-	    }
-		i = chunkSize * Scheduler::g_tp->num_threads();
-	}
-#endif
-	for (; i < n; ++i) {
-		int32_t y = chan0[i];
-		int32_t u = chan1[i];
-		int32_t v = chan2[i];
-		int32_t g = y - ((u + v) >> 2);
-		int32_t r = v + g;
-		int32_t b = u + g;
-		chan0[i] = r;
-		chan1[i] = g;
-		chan2[i] = b;
-	}
+	mct_parallel(Kernels::g_kernels->mct_decode_rev, chan0, chan1, chan2, n);
 }
 /* <summary> */
 /* Forward irreversible MCT. */
@@ -197,153 +127,7 @@ void mct::encode_irrev( int32_t* restrict chan0,
 						int32_t* restrict chan2,
 						uint64_t n)
 {
-    size_t i = 0;
-#ifdef __SSE4_1__
-    const __m128i ry = _mm_set1_epi32(2449);
-    const __m128i gy = _mm_set1_epi32(4809);
-    const __m128i by = _mm_set1_epi32(934);
-    const __m128i ru = _mm_set1_epi32(1382);
-    const __m128i gu = _mm_set1_epi32(2714);
-    const __m128i gv = _mm_set1_epi32(3430);
-    const __m128i bv = _mm_set1_epi32(666);
-    const __m128i mulround = _mm_shuffle_epi32(_mm_cvtsi32_si128(4096), _MM_SHUFFLE(1, 0, 1, 0));
-
-    size_t chunkSize = n / Scheduler::g_tp->num_threads();
-    //ensure it is divisible by 4
-    chunkSize = (chunkSize/4) * 4;
-	if (chunkSize > 4) {
-
-		std::vector< std::future<int> > results;
-		for(size_t k = 0; k < Scheduler::g_tp->num_threads(); ++k) {
-			uint64_t index = k;
-			results.emplace_back(
-				Scheduler::g_tp->enqueue([index, chunkSize, chan0,chan1,chan2,
-											 ry,gy,by,ru,gu,gv,bv,
-											 mulround] {
-
-				uint64_t begin = (uint64_t)index * chunkSize;
-				for (auto j = begin; j < begin+chunkSize; j+=4 ){
-					__m128i lo, hi;
-					__m128i y, u, v;
-					__m128i r = _mm_load_si128((const __m128i *)&(chan0[j]));
-					__m128i g = _mm_load_si128((const __m128i *)&(chan1[j]));
-					__m128i b = _mm_load_si128((const __m128i *)&(chan2[j]));
-
-					lo = r;
-					hi = _mm_shuffle_epi32(r, _MM_SHUFFLE(3, 3, 1, 1));
-					lo = _mm_mul_epi32(lo, ry);
-					hi = _mm_mul_epi32(hi, ry);
-					lo = _mm_add_epi64(lo, mulround);
-					hi = _mm_add_epi64(hi, mulround);
-					lo = _mm_srli_epi64(lo, 13);
-					hi = _mm_slli_epi64(hi, 32-13);
-					y = _mm_blend_epi16(lo, hi, 0xCC);
-
-					lo = g;
-					hi = _mm_shuffle_epi32(g, _MM_SHUFFLE(3, 3, 1, 1));
-					lo = _mm_mul_epi32(lo, gy);
-					hi = _mm_mul_epi32(hi, gy);
-					lo = _mm_add_epi64(lo, mulround);
-					hi = _mm_add_epi64(hi, mulround);
-					lo = _mm_srli_epi64(lo, 13);
-					hi = _mm_slli_epi64(hi, 32-13);
-					y = _mm_add_epi32(y, _mm_blend_epi16(lo, hi, 0xCC));
-
-					lo = b;
-					hi = _mm_shuffle_epi32(b, _MM_SHUFFLE(3, 3, 1, 1));
-					lo = _mm_mul_epi32(lo, by);
-					hi = _mm_mul_epi32(hi, by);
-					lo = _mm_add_epi64(lo, mulround);
-					hi = _mm_add_epi64(hi, mulround);
-					lo = _mm_srli_epi64(lo, 13);
-					hi = _mm_slli_epi64(hi, 32-13);
-					y = _mm_add_epi32(y, _mm_blend_epi16(lo, hi, 0xCC));
-					_mm_store_si128((__m128i *)&(chan0[j]), y);
-
-					lo = _mm_cvtepi32_epi64(_mm_shuffle_epi32(b, _MM_SHUFFLE(3, 2, 2, 0)));
-					hi = _mm_cvtepi32_epi64(_mm_shuffle_epi32(b, _MM_SHUFFLE(3, 2, 3, 1)));
-					lo = _mm_slli_epi64(lo, 12);
-					hi = _mm_slli_epi64(hi, 12);
-					lo = _mm_add_epi64(lo, mulround);
-					hi = _mm_add_epi64(hi, mulround);
-					lo = _mm_srli_epi64(lo, 13);
-					hi = _mm_slli_epi64(hi, 32-13);
-					u = _mm_blend_epi16(lo, hi, 0xCC);
-
-					lo = r;
-					hi = _mm_shuffle_epi32(r, _MM_SHUFFLE(3, 3, 1, 1));
-					lo = _mm_mul_epi32(lo, ru);
-					hi = _mm_mul_epi32(hi, ru);
-					lo = _mm_add_epi64(lo, mulround);
-					hi = _mm_add_epi64(hi, mulround);
-					lo = _mm_srli_epi64(lo, 13);
-					hi = _mm_slli_epi64(hi, 32-13);
-					u = _mm_sub_epi32(u, _mm_blend_epi16(lo, hi, 0xCC));
-
-					lo = g;
-					hi = _mm_shuffle_epi32(g, _MM_SHUFFLE(3, 3, 1, 1));
-					lo = _mm_mul_epi32(lo, gu);
-					hi = _mm_mul_epi32(hi, gu);
-					lo = _mm_add_epi64(lo, mulround);
-					hi = _mm_add_epi64(hi, mulround);
-					lo = _mm_srli_epi64(lo, 13);
-					hi = _mm_slli_epi64(hi, 32-13);
-					u = _mm_sub_epi32(u, _mm_blend_epi16(lo, hi, 0xCC));
-					_mm_store_si128((__m128i *)&(chan1[j]), u);
-
-					lo = _mm_cvtepi32_epi64(_mm_shuffle_epi32(r, _MM_SHUFFLE(3, 2, 2, 0)));
-					hi = _mm_cvtepi32_epi64(_mm_shuffle_epi32(r, _MM_SHUFFLE(3, 2, 3, 1)));
-					lo = _mm_slli_epi64(lo, 12);
-					hi = _mm_slli_epi64(hi, 12);
-					lo = _mm_add_epi64(lo, mulround);
-					hi = _mm_add_epi64(hi, mulround);
-					lo = _mm_srli_epi64(lo, 13);
-					hi = _mm_slli_epi64(hi, 32-13);
-					v = _mm_blend_epi16(lo, hi, 0xCC);
-
-					lo = g;
-					hi = _mm_shuffle_epi32(g, _MM_SHUFFLE(3, 3, 1, 1));
-					lo = _mm_mul_epi32(lo, gv);
-					hi = _mm_mul_epi32(hi, gv);
-					lo = _mm_add_epi64(lo, mulround);
-					hi = _mm_add_epi64(hi, mulround);
-					lo = _mm_srli_epi64(lo, 13);
-					hi = _mm_slli_epi64(hi, 32-13);
-					v = _mm_sub_epi32(v, _mm_blend_epi16(lo, hi, 0xCC));
-
-					lo = b;
-					hi = _mm_shuffle_epi32(b, _MM_SHUFFLE(3, 3, 1, 1));
-					lo = _mm_mul_epi32(lo, bv);
-					hi = _mm_mul_epi32(hi, bv);
-					lo = _mm_add_epi64(lo, mulround);
-					hi = _mm_add_epi64(hi, mulround);
-					lo = _mm_srli_epi64(lo, 13);
-					hi = _mm_slli_epi64(hi, 32-13);
-					v = _mm_sub_epi32(v, _mm_blend_epi16(lo, hi, 0xCC));
-					_mm_store_si128((__m128i *)&(chan2[j]), v);
-
-				}
-				return 0;
-				})
-			);
-		}
-		for(auto && result: results){
-			result.get();
-		}
-		i = Scheduler::g_tp->num_threads() * chunkSize;
-	}
-#endif
-    for(; i < n; ++i) {
-        int32_t r = chan0[i];
-        int32_t g = chan1[i];
-        int32_t b = chan2[i];
-        int32_t y =  int_fix_mul(r, 2449) + int_fix_mul(g, 4809) + int_fix_mul(b, 934);
-        int32_t u = -int_fix_mul(r, 1382) - int_fix_mul(g, 2714) + int_fix_mul(b, 4096);
-        int32_t v =  int_fix_mul(r, 4096) - int_fix_mul(g, 3430) - int_fix_mul(b, 666);
-        chan0[i] = y;
-        chan1[i] = u;
-        chan2[i] = v;
-    }
+	mct_parallel(Kernels::g_kernels->mct_encode_irrev, chan0, chan1, chan2, n);
 }
 
 /* <summary> */
@@ -351,57 +135,7 @@ void mct::encode_irrev( int32_t* restrict chan0,
 /* </summary> */
 void mct::decode_irrev(float *restrict c0, float *restrict c1, float *restrict c2,
 		uint64_t n) {
-	uint64_t i = 0;
-#if (defined(__SSE2__) || defined(__AVX2__))
-	size_t chunkSize = n / Scheduler::g_tp->num_threads();
-	//ensure it is divisible by VREG_INT_COUNT
-	chunkSize = (chunkSize/VREG_INT_COUNT) * VREG_INT_COUNT;
-	if (chunkSize > VREG_INT_COUNT) {
-		std::vector< std::future<int> > results;
-		for(uint64_t i = 0; i < Scheduler::g_tp->num_threads(); ++i) {
-			uint64_t index = i;
-			results.emplace_back(
-				Scheduler::g_tp->enqueue([index, chunkSize, c0,c1,c2] {
-				const VREGF vrv = SETF(1.402f);
-				const VREGF vgu = SETF(0.34413f);
-				const VREGF vgv = SETF(0.71414f);
-				const VREGF vbu = SETF(1.772f);
-				uint64_t begin = (uint64_t)index * chunkSize;
-				for (auto j = begin; j < begin+chunkSize; j +=VREG_INT_COUNT){
-					VREGF vy, vu, vv;
-					VREGF vr, vg, vb;
-
-					vy = LOADF(c0 + j);
-					vu = LOADF(c1 + j);
-					vv = LOADF(c2 + j);
-					vr = ADDF(vy, MULF(vv, vrv));
-					vg = SUBF(SUBF(vy, MULF(vu, vgu)),MULF(vv, vgv));
-					vb = ADDF(vy, MULF(vu, vbu));
-					STOREF(c0 + j, vr);
-					STOREF(c1 + j, vg);
-					STOREF(c2 + j, vb);
-				}
-				return 0;
-				})
-			);
-		}
-		for(auto && result: results){
-			result.get();
-		}
-		i = chunkSize * Scheduler::g_tp->num_threads();
-	}
-#endif
-	for (; i < n; ++i) {
-		float y = c0[i];
-		float u = c1[i];
-		float v = c2[i];
-		float r = y + (v * 1.402f);
-		float g = y - (u * 0.34413f) - (v * (0.71414f));
-		float b = y + (u * 1.772f);
-		c0[i] = r;
-		c1[i] = g;
-		c2[i] = b;
-	}
+	mct_parallel(Kernels::g_kernels->mct_decode_irrev, c0, c1, c2, n);
 }
 
 //////////////////////////////////////////////////////////////////////////////
@@ -426,88 +160,92 @@ void mct::calculate_norms(double *pNorms, uint32_t pNbComps, float *pMatrix) {
 	}
 }
 
+/**
+ * Run a custom MCT kernel over n samples of each component, in bands of
+ * samples that the workers of the pool claim one at a time. Each band is
+ * transformed in blocks of custom_block samples, whose inputs for all of
+ * the components fit in a scratch buffer leased from the worker's arena.
+ */
+template<typename T> static bool mct_custom_parallel(
+		void (*kernel)(const T*, uint32_t, T* const*, uint64_t, uint32_t, T*),
+		const T *matrix, uint32_t numcomps, T *const *chan, uint64_t n) {
+	const uint32_t custom_block = 64;
+	const uint64_t custom_band = 4096;
+	uint64_t num_bands = (n + custom_band - 1) / custom_band;
+	std::atomic<bool> rc(true);
+	auto band = [kernel, matrix, numcomps, chan, n, custom_block,
+				 custom_band, &rc](size_t b) {
+		auto arena = WorkerArena::get();
+		auto scratch = (T*) arena->get_buffer(
+				(size_t) numcomps * custom_block * sizeof(T));
+		if (!scratch) {
+			rc = false;
+			return;
+		}
+		uint64_t end = std::min<uint64_t>(n, (b + 1) * custom_band);
+		for (uint64_t i = (uint64_t) b * custom_band; i < end;
+				i += custom_block)
+			kernel(matrix, numcomps, chan, i,
+					(uint32_t) std::min<uint64_t>(custom_block, end - i),
+					scratch);
+		arena->put_buffer(scratch);
+	};
+	if (num_bands == 1)
+		band(0);
+	else if (num_bands > 1)
+		Scheduler::g_tp->parallel_for(num_bands, band);
+	if (!rc)
+		GROK_ERROR("Not enough memory for custom MCT");
+
+	return rc;
+}
+
+/**
+ * Convert a float matrix to the 13 bit fixed point of int_fix_mul
+ */
+static int32_t* mct_fix_matrix(const float *matrix, uint32_t numcomps) {
+	uint32_t nb_coeffs = numcomps * numcomps;
+	auto fix_matrix = (int32_t*) grok_malloc(nb_coeffs * sizeof(int32_t));
+	if (!fix_matrix)
+		return nullptr;
+	for (uint32_t i = 0; i < nb_coeffs; ++i)
+		fix_matrix[i] = (int32_t) (matrix[i] * (float) (1 << 13));
+
+	return fix_matrix;
+}
+
 bool mct::encode_custom(uint8_t *pCodingdata, uint64_t n, uint8_t **pData,
 		uint32_t pNbComp, uint32_t isSigned) {
-	float *lMct = (float*) pCodingdata;
-	uint64_t i;
-	uint32_t j;
-	uint32_t k;
-	uint32_t lNbMatCoeff = pNbComp * pNbComp;
-	int32_t *lCurrentData = nullptr;
-	int32_t *lCurrentMatrix = nullptr;
-	int32_t **lData = (int32_t**) pData;
-	uint32_t lMultiplicator = 1 << 13;
-	int32_t *lMctPtr;
-
 	ARG_NOT_USED(isSigned);
 
-	lCurrentData = (int32_t*) grok_malloc(
-			(pNbComp + lNbMatCoeff) * sizeof(int32_t));
-	if (!lCurrentData) {
+	auto matrix = mct_fix_matrix((float*) pCodingdata, pNbComp);
+	if (!matrix)
 		return false;
-	}
-
-	lCurrentMatrix = lCurrentData + pNbComp;
-
-	for (i = 0; i < lNbMatCoeff; ++i) {
-		lCurrentMatrix[i] = (int32_t) (*(lMct++) * (float) lMultiplicator);
-	}
-
-	for (i = 0; i < n; ++i) {
-		lMctPtr = lCurrentMatrix;
-		for (j = 0; j < pNbComp; ++j) {
-			lCurrentData[j] = (*(lData[j]));
-		}
-
-		for (j = 0; j < pNbComp; ++j) {
-			*(lData[j]) = 0;
-			for (k = 0; k < pNbComp; ++k) {
-				*(lData[j]) += int_fix_mul(*lMctPtr, lCurrentData[k]);
-				++lMctPtr;
-			}
-
-			++lData[j];
-		}
-	}
-	grok_free(lCurrentData);
+	bool rc = mct_custom_parallel(Kernels::g_kernels->mct_custom_int,
+			(const int32_t*) matrix, pNbComp, (int32_t**) pData, n);
+	grok_free(matrix);
 
-	return true;
+	return rc;
 }
 
 bool mct::decode_custom(uint8_t *pDecodingData, uint64_t n, uint8_t **pData,
-		uint32_t pNbComp, uint32_t isSigned) {
-	float *lMct;
-	uint64_t i;
-	uint32_t j;
-	uint32_t k;
-
-	float *lCurrentData = nullptr;
-	float *lCurrentResult = nullptr;
-	float **lData = (float**) pData;
-
+		uint32_t pNbComp, uint32_t isSigned, bool reversible) {
 	ARG_NOT_USED(isSigned);
 
-	lCurrentData = (float*) grok_malloc(2 * pNbComp * sizeof(float));
-	if (!lCurrentData) {
-		return false;
+	// reversible tiles hold integer samples: the matrix is applied in
+	// fixed point, as the encoder does
+	if (reversible) {
+		auto matrix = mct_fix_matrix((float*) pDecodingData, pNbComp);
+		if (!matrix)
+			return false;
+		bool rc = mct_custom_parallel(Kernels::g_kernels->mct_custom_int,
+				(const int32_t*) matrix, pNbComp, (int32_t**) pData, n);
+		grok_free(matrix);
+		return rc;
 	}
-	lCurrentResult = lCurrentData + pNbComp;
 
-	for (i = 0; i < n; ++i) {
-		lMct = (float*) pDecodingData;
-		for (j = 0; j < pNbComp; ++j) {
-			lCurrentData[j] = (float) (*(lData[j]));
-		}
-		for (j = 0; j < pNbComp; ++j) {
-			lCurrentResult[j] = 0;
-			for (k = 0; k < pNbComp; ++k) {
-				lCurrentResult[j] += *(lMct++) * lCurrentData[k];
-			}
-			*(lData[j]++) = (float) (lCurrentResult[j]);
-		}
-	}
-	grok_free(lCurrentData);
-	return true;
+	return mct_custom_parallel(Kernels::g_kernels->mct_custom_float,
+			(const float*) pDecodingData, pNbComp, (float**) pData, n);
 }
 
 }
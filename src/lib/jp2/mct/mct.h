@@ -122,7 +122,8 @@ public:
 	static const double* get_norms_irrev(void);
 
 	/**
-	 FIXME DOC
+	 Apply a custom (array based) multi-component transform to integer
+	 samples, with the matrix in 13 bit fixed point. Runs on the thread pool.
 	 @param p_coding_data    MCT data
 	 @param n                size of components
 	 @param p_data           components
@@ -133,16 +134,19 @@ public:
 	static bool encode_custom(uint8_t *p_coding_data, uint64_t n, uint8_t **p_data,
 			uint32_t nb_comp, uint32_t is_signed);
 	/**
-	 FIXME DOC
+	 Apply an inverse custom (array based) multi-component transform.
+	 Runs on the thread pool.
 	 @param pDecodingData    MCT data
 	 @param n                size of components
 	 @param pData            components
 	 @param pNbComp          nb of components (i.e. size of p_data)
 	 @param isSigned         tells if the data is signed
+	 @param reversible       true for the integer samples of the reversible
+	                         wavelet, false for float samples
 	 @return false if function encounter a problem, true otherwise
 	 */
 	static bool decode_custom(uint8_t *pDecodingData, uint64_t n, uint8_t **pData,
-			uint32_t pNbComp, uint32_t isSigned);
+			uint32_t pNbComp, uint32_t isSigned, bool reversible);
 	/**
 	 FIXME DOC
 	 @param pNorms           MCT data
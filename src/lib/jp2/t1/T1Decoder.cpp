@@ -15,72 +15,112 @@
  *
  */
 #include "grok_includes.h"
-#include "T1Factory.h"
+#include "T1Interface.h"
 #include "T1Decoder.h"
+#include "T1Stats.h"
+#include <chrono>
 #include <atomic>
+#include <algorithm>
 
 namespace grk {
 
 T1Decoder::T1Decoder(grk_tcp *tcp,
 					uint16_t blockw,
-					uint16_t blockh) :
+					uint16_t blockh,
+					GRK_T1_SCHEDULE schedule) :
+		tcp(tcp),
 		codeblock_width((uint16_t) (blockw ? (uint32_t) 1 << blockw : 0)),
 		codeblock_height((uint16_t) (blockh ? (uint32_t) 1 << blockh : 0)),
-		decodeBlocks(nullptr){
-	for (auto i = 0U; i < Scheduler::g_tp->num_threads(); ++i) {
-		threadStructs.push_back(
-				T1Factory::get_t1(false, tcp, codeblock_width,
-						codeblock_height));
-	}
+		schedule(schedule){
 }
 
-T1Decoder::~T1Decoder() {
-	for (auto &t : threadStructs) {
-		delete t;
-	}
+/**
+ * Estimated decode cost of a code block, from what tier-2 has read:
+ * every coding pass scans the samples of the block, and every
+ * compressed byte goes through the MQ or HT decoder
+ */
+static uint64_t decode_cost(decodeBlockInfo *block) {
+	auto cblk = block->cblk;
+	uint64_t passes = 0;
+	for (uint32_t i = 0; i < cblk->numSegments; ++i)
+		passes += cblk->segs[i].real_num_passes;
+	uint64_t area = (uint64_t) (cblk->x1 - cblk->x0)
+			* (uint64_t) (cblk->y1 - cblk->y0);
+
+	return (passes * area) / 4 + (uint64_t) cblk->seg_buffers.get_len() * 8;
 }
 
-bool T1Decoder::decode(std::vector<decodeBlockInfo*> *blocks) {
+bool T1Decoder::decode(std::vector<decodeBlockInfo> *blocks,
+		bool by_resolution,
+		const std::function<bool(decodeBlockInfo*)> &on_decoded) {
 	if (!blocks || !blocks->size())
 		return true;;
-	auto maxBlocks = blocks->size();
-	decodeBlocks = new decodeBlockInfo*[maxBlocks];
-	for (uint64_t i = 0; i < maxBlocks; ++i) {
-		decodeBlocks[i] = blocks->operator[](i);
-	}
-	std::atomic<int> blockCount(-1);
 	success = true;
-    std::vector< std::future<int> > results;
-    for(size_t i = 0; i < Scheduler::g_tp->num_threads(); ++i) {
-        results.emplace_back(
-            Scheduler::g_tp->enqueue([this, maxBlocks, &blockCount] {
-                auto threadnum =  Scheduler::g_tp->thread_number(std::this_thread::get_id());
-                while (true) {
-                	uint64_t index = ++blockCount;
-                	if (index >= maxBlocks)
-                		break;
-					decodeBlockInfo *block = decodeBlocks[index];
-					if (!success){
-						delete block;
-						return 0;
-					}
-					auto impl = threadStructs[threadnum];
-					if (!impl->decode(block)) {
-						success = false;
-						delete block;
-						return 0;
-					}
-					impl->postDecode(block);
-					delete block;
-                }
-                return 0;
-            })
-        );
-    }
-    for(auto && result: results){
-        result.get();
-    }
-	delete[] decodeBlocks;
+	auto num_blocks = blocks->size();
+	// order in which blocks are handed out: lowest resolution first if
+	// requested, then most expensive first, so that the last blocks to be
+	// picked up are short ones
+	struct BlockOrder {
+		uint32_t resno;
+		uint64_t cost;
+		size_t index;
+	};
+	std::vector<BlockOrder> order;
+	if (schedule == GRK_T1_SCHEDULE_COST || by_resolution) {
+		order.reserve(num_blocks);
+		for (size_t i = 0; i < num_blocks; ++i) {
+			auto block = &blocks->operator[](i);
+			order.push_back( { by_resolution ? block->resno : 0,
+					schedule == GRK_T1_SCHEDULE_COST ? decode_cost(block) : 0, i });
+		}
+		std::sort(order.begin(), order.end(),
+				[](const BlockOrder &a, const BlockOrder &b) {
+			if (a.resno != b.resno)
+				return a.resno < b.resno;
+			if (a.cost != b.cost)
+				return a.cost > b.cost;
+			return a.index < b.index;
+		});
+	}
+	auto num_threads = Scheduler::g_tp->num_threads();
+	std::vector<T1WorkerAccumulator> accumulators(num_threads);
+	Scheduler::g_tp->parallel_for(num_blocks,
+			t1_grain(num_blocks, num_threads),
+			[this, blocks, &order, &on_decoded, &accumulators](size_t index) {
+		if (!success)
+			return;
+		if (!order.empty())
+			index = order[index].index;
+		decodeBlockInfo *block = &blocks->operator[](index);
+#ifdef GRK_T1_STATS
+		auto start = std::chrono::high_resolution_clock::now();
+#endif
+		// coders are owned by the worker's arena, and reused across tiles
+		auto arena = WorkerArena::get();
+		auto impl = arena->get_t1(false, tcp, codeblock_width,
+				codeblock_height);
+		if (!impl->decode(block))
+			success = false;
+		else
+			impl->postDecode(block);
+		arena->put_t1(impl);
+		if (success && on_decoded && !on_decoded(block))
+			success = false;
+#ifdef GRK_T1_STATS
+		auto &acc = accumulators[(size_t)Scheduler::g_tp->thread_number()];
+		std::chrono::duration<double> elapsed =
+				std::chrono::high_resolution_clock::now() - start;
+		acc.seconds += elapsed.count();
+		acc.blocks++;
+		for (uint32_t i = 0; i < block->cblk->numSegments; ++i)
+			acc.passes += block->cblk->segs[i].real_num_passes;
+#else
+		GRK_UNUSED(accumulators);
+#endif
+	});
+#ifdef GRK_T1_STATS
+	t1_log_stats("decode", tcp->isHT, accumulators);
+#endif
 	return success;
 }
 
@@ -19,24 +19,31 @@
 #include <string>
 #include <vector>
 #include <thread>
+#include <functional>
 
 namespace grk {
 
 struct decodeBlockInfo;
-class T1Interface;
 
 class T1Decoder {
 public:
-	T1Decoder(grk_tcp *tcp, uint16_t blockw, uint16_t blockh);
-	~T1Decoder();
-	bool decode(std::vector<decodeBlockInfo*> *blocks);
+	T1Decoder(grk_tcp *tcp, uint16_t blockw, uint16_t blockh,
+			GRK_T1_SCHEDULE schedule);
+	/**
+	 * Decode code blocks
+	 * @param blocks		blocks to decode
+	 * @param by_resolution	if true, hand out the blocks of lower resolutions first
+	 * @param on_decoded	if set, called on the decoding thread after each
+	 * 						block is decoded; returning false stops the decode
+	 */
+	bool decode(std::vector<decodeBlockInfo> *blocks, bool by_resolution,
+			const std::function<bool(decodeBlockInfo*)> &on_decoded);
 
 private:
+	grk_tcp *tcp;
 	uint16_t codeblock_width, codeblock_height;  //nominal dimensions of block
-	std::vector<T1Interface*> threadStructs;
+	GRK_T1_SCHEDULE schedule;
 	std::atomic_bool success;
-
-	decodeBlockInfo** decodeBlocks;
 };
 
 }
@@ -16,71 +16,64 @@
  */
 
 #include "grok_includes.h"
-#include "T1Factory.h"
+#include "T1Interface.h"
 #include "T1Encoder.h"
+#include "T1Stats.h"
+#include <chrono>
 
 namespace grk {
 
 T1Encoder::T1Encoder(grk_tcp *tcp, grk_tcd_tile *tile, uint16_t encodeMaxCblkW,
 		uint16_t encodeMaxCblkH, bool needsRateControl) :
+		tcp(tcp),
 		tile(tile),
+		maxCblkW(encodeMaxCblkW),
+		maxCblkH(encodeMaxCblkH),
 		needsRateControl(needsRateControl),
-		encodeBlocks(nullptr),
-		blockCount(-1)
+		encodeBlocks(nullptr)
 {
-	for (auto i = 0U; i < Scheduler::g_tp->num_threads(); ++i) {
-		threadStructs.push_back(
-				T1Factory::get_t1(true, tcp, encodeMaxCblkW, encodeMaxCblkH));
-	}
-}
-T1Encoder::~T1Encoder() {
-	for (auto &t : threadStructs) {
-		delete t;
-	}
 }
-bool T1Encoder::encode(size_t threadId, uint64_t maxBlocks) {
-	auto impl = threadStructs[threadId];
-	uint64_t index = ++blockCount;
-	if (index >= maxBlocks)
-		return false;
-	encodeBlockInfo *block = encodeBlocks[index];
+void T1Encoder::encode(T1WorkerAccumulator &acc, uint64_t index) {
+	encodeBlockInfo *block = &encodeBlocks->operator[](index);
+#ifdef GRK_T1_STATS
+	auto start = std::chrono::high_resolution_clock::now();
+#endif
+	// coders are owned by the worker's arena, and reused across tiles
+	auto arena = WorkerArena::get();
+	auto impl = arena->get_t1(true, tcp, maxCblkW, maxCblkH);
 	uint32_t max = 0;
 	impl->preEncode(block, tile, max);
 	auto dist = impl->encode(block, tile, max, needsRateControl);
-	if (needsRateControl) {
-		std::unique_lock<std::mutex> lk(distortion_mutex);
-		tile->distotile += dist;
-	}
-	delete block;
-	return true;
-
+	arena->put_t1(impl);
+	acc.distortion += dist;
+#ifdef GRK_T1_STATS
+	std::chrono::duration<double> elapsed =
+			std::chrono::high_resolution_clock::now() - start;
+	acc.seconds += elapsed.count();
+	acc.blocks++;
+	acc.passes += block->cblk->num_passes_encoded;
+#endif
 }
-bool T1Encoder::encode(std::vector<encodeBlockInfo*> *blocks) {
+bool T1Encoder::encode(std::vector<encodeBlockInfo> *blocks) {
 	if (!blocks || blocks->size() == 0)
 		return true;
 
-	auto maxBlocks = blocks->size();
-	encodeBlocks = new encodeBlockInfo*[maxBlocks];
-	for (uint64_t i = 0; i < maxBlocks; ++i) {
-		encodeBlocks[i] = blocks->operator[](i);
+	encodeBlocks = blocks;
+	auto num_threads = Scheduler::g_tp->num_threads();
+	std::vector<T1WorkerAccumulator> accumulators(num_threads);
+	Scheduler::g_tp->parallel_for(blocks->size(),
+			t1_grain(blocks->size(), num_threads),
+			[this, &accumulators](size_t index) {
+		encode(accumulators[(size_t)Scheduler::g_tp->thread_number()], index);
+	});
+	encodeBlocks = nullptr;
+	if (needsRateControl) {
+		for (auto &acc : accumulators)
+			tile->distotile += acc.distortion;
 	}
-	blocks->clear();
-    std::vector< std::future<int> > results;
-    for(size_t i = 0; i < Scheduler::g_tp->num_threads(); ++i) {
-          results.emplace_back(
-            Scheduler::g_tp->enqueue([this, maxBlocks] {
-                auto threadnum =  Scheduler::g_tp->thread_number(std::this_thread::get_id());
-                while(encode(threadnum, maxBlocks)){
-
-                }
-                return 0;
-            })
-        );
-    }
-    for(auto && result: results){
-        result.get();
-    }
-	delete[] encodeBlocks;
+#ifdef GRK_T1_STATS
+	t1_log_stats("encode", tcp->isHT, accumulators);
+#endif
 	return true;
 }
 
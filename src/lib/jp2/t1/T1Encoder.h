@@ -21,23 +21,23 @@
 
 namespace grk {
 
+struct T1WorkerAccumulator;
+
 class T1Encoder {
 public:
 	T1Encoder(grk_tcp *tcp, grk_tcd_tile *tile, uint16_t encodeMaxCblkW,
 			uint16_t encodeMaxCblkH, bool needsRateControl);
-	~T1Encoder();
-	bool encode(std::vector<encodeBlockInfo*> *blocks);
+	bool encode(std::vector<encodeBlockInfo> *blocks);
 
 private:
-	bool encode(size_t threadId, uint64_t maxBlocks);
+	void encode(T1WorkerAccumulator &acc, uint64_t index);
 
+	grk_tcp *tcp;
 	grk_tcd_tile *tile;
-	std::vector<T1Interface*> threadStructs;
-	mutable std::mutex distortion_mutex;
+	uint16_t maxCblkW;
+	uint16_t maxCblkH;
 	bool needsRateControl;
-	mutable std::mutex block_mutex;
-	encodeBlockInfo** encodeBlocks;
-	std::atomic<int64_t> blockCount;
+	std::vector<encodeBlockInfo> *encodeBlocks;
 
 };
 
@@ -72,7 +72,8 @@ struct encodeBlockInfo {
 		unencodedData(nullptr),
 #endif
 					mct_numcomps(0),
-					k_msbs(0)
+					k_msbs(0),
+					ht_rate_mode(HT_RATE_REFINE_LSB)
 	{
 	}
 	int32_t *tiledp;
@@ -95,6 +96,7 @@ struct encodeBlockInfo {
 #endif
 	uint32_t mct_numcomps;
 	uint8_t k_msbs;
+	HT_RATE_MODE ht_rate_mode;
 };
 
 class T1Interface {
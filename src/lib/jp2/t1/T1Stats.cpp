@@ -0,0 +1,48 @@
+/*
+ *    Copyright (C) 2016-2020 Grok Image Compression Inc.
+ *
+ *    This source code is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This source code is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "grok_includes.h"
+#include "T1Stats.h"
+
+namespace grk {
+
+void t1_log_stats(const char *label, bool isHT,
+		const std::vector<T1WorkerAccumulator> &accumulators) {
+	uint64_t blocks = 0;
+	double seconds = 0;
+	double max_seconds = 0;
+	for (auto &acc : accumulators) {
+		blocks += acc.blocks;
+		seconds += acc.seconds;
+		max_seconds = std::max<double>(max_seconds, acc.seconds);
+	}
+	if (!blocks)
+		return;
+	GROK_INFO("T1 %s (%s): %llu blocks", label, isHT ? "HT" : "Part-1",
+			(unsigned long long) blocks);
+	for (size_t i = 0; i < accumulators.size(); ++i) {
+		auto &acc = accumulators[i];
+		GROK_INFO("  thread %3u: %8llu blocks %10llu passes %10.3f ms",
+				(uint32_t) i, (unsigned long long) acc.blocks,
+				(unsigned long long) acc.passes, acc.seconds * 1000);
+	}
+	double mean = seconds / (double) accumulators.size();
+	if (mean > 0)
+		GROK_INFO("  busiest thread: %.2f x mean", max_seconds / mean);
+}
+
+}
@@ -0,0 +1,71 @@
+/*
+ *    Copyright (C) 2016-2020 Grok Image Compression Inc.
+ *
+ *    This source code is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This source code is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <algorithm>
+
+namespace grk {
+
+/**
+ * Tier-1 totals of one worker, for the code blocks of one tile.
+ *
+ * T1Encoder and T1Decoder keep one accumulator per worker of the pool,
+ * and reduce them once every block is done, instead of updating shared
+ * state after each block.
+ */
+struct T1WorkerAccumulator {
+	T1WorkerAccumulator() : distortion(0),
+							blocks(0),
+							passes(0),
+							seconds(0)
+	{}
+	/** decrease in distortion of the encoded blocks */
+	double distortion;
+
+	/* statistics: only collected when built with GRK_T1_STATS */
+	uint64_t blocks;
+	uint64_t passes;
+	double seconds;
+
+	// keep the totals of different workers on different cache lines
+	char pad[64];
+};
+
+/**
+ * Number of code blocks that a worker claims at a time: large enough
+ * that workers rarely meet on the shared counter, small enough that the
+ * last blocks of a tile still spread over all workers
+ */
+inline size_t t1_grain(size_t num_blocks, size_t num_threads) {
+	return std::max<size_t>(1, num_blocks / (num_threads * 16));
+}
+
+/**
+ * Log block count, pass count and time of each worker, and how far the
+ * busiest worker is above the average
+ * @param label		"encode" or "decode"
+ * @param isHT		true if the blocks were coded with HT
+ * @param accumulators	one accumulator per worker
+ */
+void t1_log_stats(const char *label, bool isHT,
+		const std::vector<T1WorkerAccumulator> &accumulators);
+
+}
@@ -25,11 +25,14 @@ bool Tier1::encodeCodeblocks(grk_tcp *tcp,
 							grk_tcd_tile *tile,
 							const double *mct_norms,
 							uint32_t mct_numcomps,
-							bool doRateControl) {
+							bool doRateControl,
+							HT_RATE_MODE htRateMode) {
 
 	uint32_t compno, resno, bandno, precno;
 	tile->distotile = 0;
-	std::vector<encodeBlockInfo*> blocks;
+	// the block list keeps its capacity in the arena, from tile to tile
+	auto arena = WorkerArena::get();
+	auto blocks = arena->get_encode_blocks();
 	uint16_t maxCblkW = 0;
 	uint16_t maxCblkH = 0;
 
@@ -67,7 +70,8 @@ bool Tier1::encodeCodeblocks(grk_tcp *tcp,
 								(uint16_t) (1 << tccp->cblkw));
 						maxCblkH = std::max<int16_t>(maxCblkH,
 								(uint16_t) (1 << tccp->cblkh));
-						auto block = new encodeBlockInfo();
+						blocks->emplace_back();
+						auto block = &blocks->back();
 						block->compno = compno;
 						block->bandno = band->bandno;
 						block->cblk = cblk;
@@ -84,8 +88,7 @@ bool Tier1::encodeCodeblocks(grk_tcp *tcp,
 						block->tiledp = tilec->buf->get_ptr( resno,
 								bandno, (uint32_t) x, (uint32_t) y);
 						block->k_msbs = (uint8_t)(band->numbps - cblk->numbps);
-						blocks.push_back(block);
-
+						block->ht_rate_mode = htRateMode;
 					}
 				}
 			}
@@ -93,11 +96,14 @@ bool Tier1::encodeCodeblocks(grk_tcp *tcp,
 	}
 
 	T1Encoder encoder(tcp, tile, maxCblkW, maxCblkH, doRateControl);
-	return encoder.encode(&blocks);
+	bool rc = encoder.encode(blocks);
+	arena->put_encode_blocks(blocks);
+
+	return rc;
 }
 
 bool Tier1::prepareDecodeCodeblocks(TileComponent *tilec, grk_tccp *tccp,
-		std::vector<decodeBlockInfo*> *blocks) {
+		std::vector<decodeBlockInfo> *blocks) {
 	uint32_t resno, bandno, precno;
 	if (!tilec->buf->alloc_component_data_decode()) {
 		GROK_ERROR( "Not enough memory for tile data");
@@ -148,7 +154,8 @@ bool Tier1::prepareDecodeCodeblocks(TileComponent *tilec, grk_tccp *tccp,
 						y += pres->y1 - pres->y0;
 					}
 
-					auto block = new decodeBlockInfo();
+					blocks->emplace_back();
+					auto block = &blocks->back();
 					block->bandno = band->bandno;
 					block->cblk = cblk;
 					block->cblk_sty = tccp->cblk_sty;
@@ -162,8 +169,6 @@ bool Tier1::prepareDecodeCodeblocks(TileComponent *tilec, grk_tccp *tccp,
 					block->tiledp = tilec->buf->get_ptr( resno, bandno,
 							(uint32_t) x, (uint32_t) y);
 					block->k_msbs = (uint8_t)(band->numbps - cblk->numbps);
-					blocks->push_back(block);
-
 				}
 			}
 		}
@@ -173,9 +178,12 @@ bool Tier1::prepareDecodeCodeblocks(TileComponent *tilec, grk_tccp *tccp,
 
 bool Tier1::decodeCodeblocks(grk_tcp *tcp,
 		                    uint16_t blockw, uint16_t blockh,
-		                    std::vector<decodeBlockInfo*> *blocks) {
-	T1Decoder decoder(tcp, blockw, blockh);
-	return decoder.decode(blocks);
+		                    GRK_T1_SCHEDULE schedule,
+		                    std::vector<decodeBlockInfo> *blocks,
+		                    bool by_resolution,
+		                    const std::function<bool(decodeBlockInfo*)> &on_decoded) {
+	T1Decoder decoder(tcp, blockw, blockh, schedule);
+	return decoder.decode(blocks, by_resolution, on_decoded);
 }
 
 }
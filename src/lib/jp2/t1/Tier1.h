@@ -19,6 +19,7 @@
 
 #include "grok_includes.h"
 #include <vector>
+#include <functional>
 #include "T1Interface.h"
 
 namespace grk {
@@ -29,15 +30,19 @@ public:
 	bool encodeCodeblocks(	grk_tcp *tcp,
 							grk_tcd_tile *tile,
 							const double *mct_norms,
-			uint32_t mct_numcomps, bool doRateControl);
+			uint32_t mct_numcomps, bool doRateControl,
+			HT_RATE_MODE htRateMode);
 
 	bool prepareDecodeCodeblocks(TileComponent *tilec, grk_tccp *tccp,
-			std::vector<decodeBlockInfo*> *blocks);
+			std::vector<decodeBlockInfo> *blocks);
 
 	bool decodeCodeblocks(	grk_tcp *tcp,
 							uint16_t blockw,
 							uint16_t blockh,
-							std::vector<decodeBlockInfo*> *blocks);
+							GRK_T1_SCHEDULE schedule,
+							std::vector<decodeBlockInfo> *blocks,
+							bool by_resolution = false,
+							const std::function<bool(decodeBlockInfo*)> &on_decoded = nullptr);
 
 };
 
@@ -17,7 +17,6 @@
 #ifdef _MSC_VER
 #include <intrin.h>
 #endif
-#include "ojph_block_decoder.h"
 #include "ojph_block_encoder.h"
 #include "ojph_mem.h"
 using namespace ojph;
@@ -27,6 +26,7 @@ using namespace ojph::local;
 #include "T1HT.h"
 #include "testing.h"
 #include "grok_malloc.h"
+#include "dwt_utils.h"
 #include <algorithm>
 using namespace std;
 
@@ -34,14 +34,191 @@ using namespace std;
 namespace grk {
 namespace t1_ht {
 
+// sample is significant in the cleanup pass
+const uint8_t HT_SIG = 1;
+// sample becomes significant in the SigProp pass
+const uint8_t HT_NEW_SIG = 2;
+// the block decoder's stream readers load whole aligned words, which can
+// reach a few bytes either side of the code block data
+const uint32_t HT_CODED_PAD = cblk_dec_guard_bytes;
+
+/**
+ * Writes the SigProp pass, forwards from the start of the refinement
+ * segment. Bits are packed from the least significant end of each byte,
+ * and a byte that follows 0xFF carries only 7 bits.
+ */
+struct SigPropWriter {
+	SigPropWriter(uint8_t *buf) :
+			buf(buf), pos(0), tmp(0), used_bits(0), max_bits(8) {
+	}
+	void put(uint32_t bit) {
+		tmp |= bit << used_bits;
+		if (++used_bits == max_bits) {
+			buf[pos++] = (uint8_t) tmp;
+			max_bits = (tmp == 0xFF) ? 7 : 8;
+			tmp = 0;
+			used_bits = 0;
+		}
+	}
+	uint32_t flush(void) {
+		if (used_bits)
+			buf[pos++] = (uint8_t) tmp;
+		// MagRef bytes that follow must not complete a marker code
+		if (pos && buf[pos - 1] == 0xFF)
+			buf[pos++] = 0;
+		return pos;
+	}
+	uint8_t *buf;
+	uint32_t pos;
+	uint32_t tmp;
+	uint32_t used_bits;
+	uint32_t max_bits;
+};
+
+/**
+ * Writes the MagRef pass, which the decoder reads backwards from the end of
+ * the refinement segment: bytes are written in reading order, and reversed
+ * when they are copied out. After a byte above 0x8F, a byte whose 7 least
+ * significant bits are set carries only those 7 bits.
+ */
+struct MagRefWriter {
+	MagRefWriter(uint8_t *buf) :
+			buf(buf), pos(0), tmp(0), used_bits(0), last_above_8F(true) {
+	}
+	void put(uint32_t bit) {
+		tmp |= bit << used_bits;
+		++used_bits;
+		if ((used_bits == 7 && last_above_8F && tmp == 0x7F)
+				|| used_bits == 8)
+			emit();
+	}
+	uint32_t flush(void) {
+		if (used_bits)
+			emit();
+		return pos;
+	}
+	void emit(void) {
+		buf[pos++] = (uint8_t) tmp;
+		last_above_8F = tmp > 0x8F;
+		tmp = 0;
+		used_bits = 0;
+	}
+	uint8_t *buf;
+	uint32_t pos;
+	uint32_t tmp;
+	uint32_t used_bits;
+	bool last_above_8F;
+};
+
+/**
+ * Quantizes the tile samples of a code block to the sign-magnitude form
+ * that the HT block encoder codes
+ */
+struct HTQuantizer {
+	HTQuantizer(encodeBlockInfo *block, grk_tcd_tile *tile, uint16_t w,
+			uint16_t h) :
+			src(block->tiledp),
+			stride((tile->comps + block->compno)->width()),
+			w(w),
+			h(h),
+			reversible(block->qmfbid == 1),
+			shift(0),
+			scale(0) {
+		if (reversible) {
+			shift = 31U - (block->k_msbs + 1U);
+		} else {
+			// scaling by a power of two is exact, so this rounds the
+			// same as multiplying by inv_step_ht and the power in turn
+			int32_t s = 31 - (block->k_msbs + 1) - 11;
+			scale = block->inv_step_ht * (float) (1 << s);
+		}
+	}
+	/**
+	 * Quantize num_rows rows of the code block, starting at row y0,
+	 * to dest, w samples per row
+	 */
+	void quantize(uint32_t y0, uint32_t num_rows, int32_t *dest) const {
+		auto kernels = Kernels::g_kernels;
+		for (uint32_t y = y0; y < y0 + num_rows; ++y, dest += w) {
+			auto row = src + (size_t) y * stride;
+			if (reversible)
+				kernels->quantize_ht_rev(row, dest, w, shift);
+			else
+				kernels->quantize_ht_irrev(row, dest, w, scale);
+		}
+	}
+	/**
+	 * ojph::local::row_source callback
+	 */
+	static void get_rows(const void *ctx, int y, ojph::si32 *line, int width) {
+		auto quant = (const HTQuantizer*) ctx;
+		assert(width == quant->w);
+		GRK_UNUSED(width);
+		quant->quantize((uint32_t) y,
+				std::min<uint32_t>(2U, quant->h - (uint32_t) y), line);
+	}
+
+	const int32_t *src;
+	uint32_t stride;
+	uint16_t w;
+	uint16_t h;
+	bool reversible;
+	uint32_t shift;
+	float scale;
+};
+
+/**
+ * Weight of squared quantization steps in the distortion of the tile
+ */
+static double ht_distortion_weight(encodeBlockInfo *block, grk_tcd_tile *tile) {
+	double w1 = 1;
+	if (block->mct_norms && (block->compno < block->mct_numcomps))
+		w1 = block->mct_norms[block->compno];
+	uint32_t level = (tile->comps + block->compno)->numresolutions - 1
+			- block->resno;
+	double w2 =
+			(block->qmfbid == 1) ?
+					dwt_utils::getnorm(level, block->bandno) :
+					dwt_utils::getnorm_real(level, block->bandno);
+	double w = w1 * w2 * block->stepsize;
+
+	return w * w;
+}
+
+/**
+ * Value that the decoder reconstructs for quantization index q, in
+ * quantization steps, when the bit planes below plane are not coded.
+ * The decoder reconstructs at the middle of the quantization interval,
+ * except for the least significant bit plane of the reversible
+ * transform, which is exact.
+ */
+static inline double ht_reconstruct(uint32_t q, uint32_t plane,
+		double offset) {
+	uint32_t coded = q >> plane;
+	if (!coded)
+		return 0;
+	if (!plane)
+		return q + offset;
+	return (double) (coded << plane) + (double) (1U << (plane - 1));
+}
+
+/**
+ * Decrease in squared error when sample x is reconstructed as r, not 0
+ */
+static inline double ht_gain(double x, double r) {
+	return r * (2 * x - r);
+}
+
 T1HT::T1HT(bool isEncoder,
 			grk_tcp *tcp,
 			uint16_t maxCblkW,
 			uint16_t maxCblkH) :
 				coded_data_size(isEncoder ? 0 : (uint32_t)(maxCblkW*maxCblkH* sizeof(int32_t))),
-				coded_data(isEncoder ? nullptr : new uint8_t[coded_data_size]),
+				coded_data(isEncoder ? nullptr : new uint8_t[coded_data_size + 2 * HT_CODED_PAD]),
 				unencoded_data_size(maxCblkW*maxCblkH),
 				unencoded_data(new int32_t[unencoded_data_size]),
+				refine_state(isEncoder ? new uint8_t[unencoded_data_size] : nullptr),
+				refine_data(isEncoder ? new uint8_t[2 * unencoded_data_size + 16] : nullptr),
 				allocator( new mem_fixed_allocator),
 				elastic_alloc(new mem_elastic_allocator(1048576))
 {
@@ -51,6 +228,8 @@ T1HT::T1HT(bool isEncoder,
 T1HT::~T1HT() {
    delete[] coded_data;
    delete[] unencoded_data;
+   delete[] refine_state;
+   delete[] refine_data;
    delete allocator;
    delete elastic_alloc;
 }
@@ -59,80 +238,268 @@ void T1HT::preEncode(encodeBlockInfo *block, grk_tcd_tile *tile,
 	(void)block;
 	(void)tile;
 
-	auto cblk = block->cblk;
-	auto w = cblk->x1 - cblk->x0;
-	auto h = cblk->y1 - cblk->y0;
-	uint32_t tile_width = (tile->comps + block->compno)->width();
-	auto tileLineAdvance = tile_width - w;
-	uint32_t tileIndex = 0;
-	uint32_t cblk_index = 0;
+	// the samples are quantized by encode, once it knows whether rate
+	// control needs all of them at once. The block encoder has no use
+	// for the maximum.
 	maximum = 0;
+}
+double T1HT::encode_candidates(encodeBlockInfo *block, grk_tcd_tile *tile,
+		uint16_t w, uint16_t h) {
+	auto cblk = block->cblk;
+	// bit plane of the least significant bit of the quantization index
+	uint32_t shift = 30U - block->k_msbs;
+	double scale = 1.0 / (double) (1U << shift);
+	double offset = (block->qmfbid == 1) ? 0 : 0.5;
+	uint32_t num_samples = (uint32_t) w * h;
 
-	//convert to sign-magnitude
-	if (block->qmfbid == 1) {
-		int32_t shift = 31 - (block->k_msbs + 1);
-		for (auto j = 0U; j < h; ++j) {
-			for (auto i = 0U; i < w; ++i) {
-				int32_t temp = block->tiledp[tileIndex];
-		        int32_t val = temp >= 0 ? temp : -temp;
-		        int32_t sign = temp >= 0 ? 0 : 0x80000000;
-		        int32_t res = sign | (val << shift);
-		        unencoded_data[cblk_index] = res;
-				maximum = max(maximum, (uint32_t)res);
-				tileIndex++;
-				cblk_index++;
+	uint32_t all = 0;
+	for (uint32_t i = 0; i < num_samples; ++i)
+		all |= ((uint32_t) unencoded_data[i] & 0x7FFFFFFF) >> shift;
+	cblk->num_passes_encoded = 0;
+	cblk->numbps = 1;
+	cblk->ht_plane = 0;
+	if (!all)
+		return 0;
+	uint32_t max_plane = std::min<uint32_t>(uint_floorlog2(all),
+			block->k_msbs - 1U);
+
+	double distortion[32] = { };
+	for (uint32_t i = 0; i < num_samples; ++i) {
+		uint32_t mag = (uint32_t) unencoded_data[i] & 0x7FFFFFFF;
+		uint32_t q = mag >> shift;
+		double x = mag * scale;
+		for (uint32_t plane = 0; plane <= max_plane && (q >> plane); ++plane)
+			distortion[plane] += ht_gain(x, ht_reconstruct(q, plane, offset));
+	}
+
+	double weight = ht_distortion_weight(block, tile);
+	uint32_t rate = 0;
+	double cumulative = 0;
+	for (uint32_t passno = 0; passno <= max_plane; ++passno) {
+		uint32_t plane = max_plane - passno;
+		coded_lists *next_coded = nullptr;
+		int pass_length[2] = { 0, 0 };
+		elastic_alloc->restart();
+		ojph_encode_codeblock(unencoded_data, block->k_msbs - plane, 1, w, h,
+				w, pass_length, elastic_alloc, next_coded, nullptr);
+		// rate and distortion may not decrease from one candidate to the next
+		uint32_t prev_rate = rate;
+		rate = std::max<uint32_t>(rate, (uint32_t) pass_length[0]);
+		cumulative = std::max<double>(cumulative, distortion[plane] * weight);
+		auto pass = cblk->passes + passno;
+		pass->len = (uint16_t) (rate - prev_rate);
+		pass->rate = (uint16_t) rate;
+		pass->distortiondec = cumulative;
+		// the candidates of a layer are signalled as a single codeword
+		// segment, as is the cleanup pass that replaces them
+		pass->term = 0;
+	}
+	cblk->num_passes_encoded = max_plane + 1;
+	cblk->numbps = max_plane + 1;
+	cblk->ht_plane = (uint8_t) max_plane;
+
+	return distortion[0] * weight;
+}
+
+uint32_t T1HT::encode_refinement(encodeBlockInfo *block, uint32_t plane,
+		uint16_t w, uint16_t h, uint32_t *lengths) {
+	// bit of the refined bit plane: the cleanup pass codes the bits above it
+	uint32_t shift = 30U - block->k_msbs + plane;
+	uint32_t num_samples = (uint32_t) w * h;
+	for (uint32_t i = 0; i < num_samples; ++i)
+		refine_state[i] =
+				((unencoded_data[i] & 0x7FFFFFFF) >> (shift + 1)) ? HT_SIG : 0;
+
+	// the passes visit stripes of 4 rows, column by column
+	MagRefWriter mrp(refine_data + unencoded_data_size + 8);
+	for (uint32_t y0 = 0; y0 < h; y0 += 4) {
+		uint32_t y1 = std::min<uint32_t>(y0 + 4, h);
+		for (uint32_t x = 0; x < w; ++x) {
+			for (uint32_t y = y0; y < y1; ++y) {
+				uint32_t index = y * w + x;
+				if (refine_state[index] & HT_SIG)
+					mrp.put(((uint32_t)unencoded_data[index] >> shift) & 1);
 			}
-			tileIndex += tileLineAdvance;
 		}
-	} else {
-		for (auto j = 0U; j < h; ++j) {
-			int32_t shift = 31 - (block->k_msbs + 1) - 11;
-			for (auto i = 0U; i < w; ++i) {
-				int32_t temp = block->tiledp[tileIndex];
-				int32_t t = (int32_t)((float)temp * block->inv_step_ht * (1<<shift));
-				int32_t val = t >= 0 ? t : -t;
-				maximum = max((uint32_t)val, maximum);
-				int32_t sign = t >= 0 ? 0 : 0x80000000;
-				int32_t res = sign | val;
-				unencoded_data[cblk_index] = res;
-				tileIndex++;
-				cblk_index++;
+	}
+
+	// SigProp visits the samples next to a significant sample, where
+	// samples that become significant earlier in the pass count as well.
+	// Signs follow the significance of each group of 4 columns.
+	SigPropWriter spp(refine_data);
+	uint32_t lost = 0;
+	for (uint32_t y0 = 0; y0 < h; y0 += 4) {
+		uint32_t y1 = std::min<uint32_t>(y0 + 4, h);
+		for (uint32_t x0 = 0; x0 < w; x0 += 4) {
+			uint32_t x1 = std::min<uint32_t>(x0 + 4, w);
+			for (uint32_t x = x0; x < x1; ++x) {
+				for (uint32_t y = y0; y < y1; ++y) {
+					uint32_t index = y * w + x;
+					if (refine_state[index])
+						continue;
+					uint32_t bit = ((uint32_t)unencoded_data[index] >> shift) & 1;
+					bool neighbour = false;
+					for (uint32_t ny = (y ? y - 1 : y);
+							ny <= std::min<uint32_t>(y + 1, h - 1U) && !neighbour; ++ny) {
+						for (uint32_t nx = (x ? x - 1 : x);
+								nx <= std::min<uint32_t>(x + 1, w - 1U); ++nx) {
+							if (refine_state[ny * w + nx]) {
+								neighbour = true;
+								break;
+							}
+						}
+					}
+					if (!neighbour) {
+						lost += bit;
+						continue;
+					}
+					spp.put(bit);
+					if (bit)
+						refine_state[index] = HT_NEW_SIG;
+				}
+			}
+			for (uint32_t x = x0; x < x1; ++x) {
+				for (uint32_t y = y0; y < y1; ++y) {
+					uint32_t index = y * w + x;
+					if (refine_state[index] & HT_NEW_SIG)
+						spp.put((uint32_t)unencoded_data[index] >> 31);
+				}
 			}
-			tileIndex += tileLineAdvance;
 		}
 	}
+	lengths[0] = spp.flush();
+	lengths[1] = mrp.flush();
+
+	return lost;
+}
+
+double T1HT::get_distortion(encodeBlockInfo *block, uint32_t num_samples,
+		uint32_t plane, bool refine, double *distortion) {
+	// bit plane of the least significant bit of the quantization index
+	uint32_t shift = 30U - block->k_msbs;
+	double scale = 1.0 / (double) (1U << shift);
+	double offset = (block->qmfbid == 1) ? 0 : 0.5;
+	double all_planes = 0;
+	distortion[0] = distortion[1] = distortion[2] = 0;
+	for (uint32_t i = 0; i < num_samples; ++i) {
+		uint32_t mag = (uint32_t) unencoded_data[i] & 0x7FFFFFFF;
+		uint32_t q = mag >> shift;
+		if (!q)
+			continue;
+		double x = mag * scale;
+		all_planes += ht_gain(x, ht_reconstruct(q, 0, offset));
+		if (!refine) {
+			distortion[0] += ht_gain(x, ht_reconstruct(q, plane, offset));
+		} else if (refine_state[i] & HT_SIG) {
+			double cleanup = ht_gain(x, ht_reconstruct(q, plane, offset));
+			distortion[0] += cleanup;
+			distortion[2] += ht_gain(x, ht_reconstruct(q, plane - 1, offset))
+					- cleanup;
+		} else if (refine_state[i] & HT_NEW_SIG) {
+			distortion[1] += ht_gain(x, ht_reconstruct(q, plane - 1, offset));
+		}
+	}
+
+	return all_planes;
 }
+
 double T1HT::encode(encodeBlockInfo *block, grk_tcd_tile *tile, uint32_t maximum,
 		bool doRateControl) {
-	(void)doRateControl;
-	(void)tile;
+	(void)maximum;
 
 	 coded_lists *next_coded = nullptr;
 	 int pass_length[2] = {0,0};
-	int32_t shift = 31 - (block->k_msbs + 1);
+	 // the previous block's output has already been copied out
+	 elastic_alloc->restart();
 	auto cblk = block->cblk;
-	cblk->numbps = 0;
-	//if (maximum >= (uint32_t)1<<(31 - (block->k_msbs+1)))
-	{
-		uint16_t w =  (uint16_t)(cblk->x1 - cblk->x0);
-		uint16_t h =  (uint16_t)(cblk->y1 - cblk->y0);
-
-		 ojph_encode_codeblock(unencoded_data, block->k_msbs,1,
-								   w, h, w,
-								   pass_length,
-								   elastic_alloc,
-								   next_coded);
-
-		 cblk->num_passes_encoded = 1;
-		 cblk->passes[0].len = (uint16_t)pass_length[0];
-		 cblk->passes[0].rate = (uint16_t)pass_length[0];
-		 uint32_t abs_max = (maximum & 0x7FFFFFFF) >> shift;
-		 cblk->numbps = 1;
-		 assert(cblk->data);
-		 memcpy(cblk->data, next_coded->buf, pass_length[0]);
-	}
-
-  return 0;
+	uint16_t w =  (uint16_t)(cblk->x1 - cblk->x0);
+	uint16_t h =  (uint16_t)(cblk->y1 - cblk->y0);
+
+	// Rate control revisits the quantized samples, so they are stored
+	// in unencoded_data. Otherwise, the block encoder quantizes the tile
+	// samples two rows at a time, as it codes them.
+	HTQuantizer quant(block, tile, w, h);
+	ojph::local::row_source rows = { HTQuantizer::get_rows, &quant };
+	if (doRateControl) {
+		quant.quantize(0, h, unencoded_data);
+		if (block->ht_rate_mode == HT_RATE_CANDIDATES)
+			return encode_candidates(block, tile, w, h);
+	}
+
+	// With rate control, the cleanup pass stops at a bit plane above the
+	// least significant, and the SigProp and MagRef passes code the bit
+	// plane below it, so that the block can be truncated after any of
+	// the three passes.
+	uint32_t refine_lengths[2] = {0,0};
+	uint32_t plane = 0;
+	if (doRateControl && block->ht_rate_mode == HT_RATE_CHOSEN_PLANE
+			&& cblk->ht_plane) {
+		// samples that the refinement passes cannot code are left out,
+		// as are the bit planes below
+		plane = cblk->ht_plane;
+		encode_refinement(block, plane - 1, w, h, refine_lengths);
+	} else if (doRateControl && block->k_msbs >= 2) {
+		// A sample that the refinement passes cannot code would be missing
+		// from every layer, and from the distortion that rate control sees,
+		// so such blocks keep a single cleanup pass, which codes every sample.
+		// Otherwise, the passes end at the same samples as a single
+		// cleanup pass of the least significant bit plane.
+		if (!encode_refinement(block, 0, w, h, refine_lengths))
+			plane = 1;
+	}
+	bool refine = plane != 0;
+
+	ojph_encode_codeblock(unencoded_data, block->k_msbs - plane, 1,
+							w, h, w,
+							pass_length,
+							elastic_alloc,
+							next_coded,
+							doRateControl ? nullptr : &rows);
+
+	uint32_t cleanup_length = (uint32_t)pass_length[0];
+	uint32_t length = cleanup_length + refine_lengths[0] + refine_lengths[1];
+	assert(cblk->data);
+	assert(!refine || length <= cblk->data_size);
+	memcpy(cblk->data, next_coded->buf, cleanup_length);
+	if (refine) {
+		memcpy(cblk->data + cleanup_length, refine_data, refine_lengths[0]);
+		auto mrp = refine_data + unencoded_data_size + 8;
+		auto dest = cblk->data + length;
+		for (uint32_t i = 0; i < refine_lengths[1]; ++i)
+			*--dest = mrp[i];
+	}
+
+	double distortion[3] = {0,0,0};
+	double all_planes = 0;
+	if (doRateControl) {
+		double weight = ht_distortion_weight(block, tile);
+		all_planes = weight
+				* get_distortion(block, (uint32_t) w * h, plane, refine,
+						distortion);
+		for (uint32_t i = 0; i < 3; ++i)
+			distortion[i] *= weight;
+	}
+
+	// the cleanup pass is a codeword segment of its own, and the
+	// refinement passes share the next one
+	cblk->num_passes_encoded = refine ? 3 : 1;
+	cblk->numbps = plane + 1;
+	uint32_t pass_lengths[3] = {cleanup_length, refine_lengths[0], refine_lengths[1]};
+	uint32_t rate = 0;
+	double cumulative = 0;
+	for (uint32_t i = 0; i < cblk->num_passes_encoded; ++i) {
+		auto pass = cblk->passes + i;
+		rate += pass_lengths[i];
+		cumulative += distortion[i];
+		pass->len = (uint16_t)pass_lengths[i];
+		pass->rate = (uint16_t)rate;
+		pass->distortiondec = cumulative;
+		pass->term = (i != 1);
+	}
+
+	// the distortion of the tile is that of every bit plane, whichever
+	// the passes stop at
+	return all_planes;
 }
 bool T1HT::decode(decodeBlockInfo *block) {
 	auto cblk = block->cblk;
@@ -141,31 +508,50 @@ bool T1HT::decode(decodeBlockInfo *block) {
 
 	auto min_buf_vec = &cblk->seg_buffers;
 	uint16_t total_seg_len = (uint16_t) (min_buf_vec->get_len());
-	if (coded_data_size < total_seg_len) {
-		delete[] coded_data;
-		coded_data = new uint8_t[total_seg_len];
-		coded_data_size = total_seg_len;
-	}
+	// the decoder only reads the coded data, so segments that follow on
+	// from each other in the tile part are decoded where they are
+	uint8_t *data = nullptr;
 	size_t offset = 0;
-	// note: min_buf_vec only contains segments of non-zero length
-	for (int32_t i = 0; i < min_buf_vec->size(); ++i) {
-		grk_buf *seg = (grk_buf*) min_buf_vec->get(i);
-		memcpy(coded_data + offset, seg->buf, seg->len);
-		offset += seg->len;
+	if (cblk->seg_in_place) {
+		data = ((grk_buf*) min_buf_vec->get(0))->buf;
+		for (int32_t i = 0; i < min_buf_vec->size(); ++i)
+			offset += ((grk_buf*) min_buf_vec->get(i))->len;
+	} else {
+		if (coded_data_size < total_seg_len) {
+			delete[] coded_data;
+			coded_data = new uint8_t[total_seg_len + 2 * HT_CODED_PAD];
+			coded_data_size = total_seg_len;
+		}
+		data = coded_data + HT_CODED_PAD;
+		// note: min_buf_vec only contains segments of non-zero length
+		for (int32_t i = 0; i < min_buf_vec->size(); ++i) {
+			grk_buf *seg = (grk_buf*) min_buf_vec->get(i);
+			memcpy(data + offset, seg->buf, seg->len);
+			offset += seg->len;
+		}
 	}
 
+	// the cleanup pass is in the first segment, and the SigProp and
+	// MagRef passes are in the second
 	size_t num_passes = 0;
 	for (uint32_t i = 0; i < cblk->numSegments; ++i){
 		auto sgrk = cblk->segs + i;
-		num_passes += sgrk->numpasses;
+		num_passes += sgrk->real_num_passes;
 	}
+	num_passes = std::min<size_t>(num_passes, 3);
+	size_t cleanup_length = offset;
+	if (num_passes > 1)
+		cleanup_length = std::min<size_t>(cblk->segs[0].len, offset);
+	if (cleanup_length < 2)
+		num_passes = 0;
 
    if (num_passes)
-	   ojph_decode_codeblock(coded_data, unencoded_data,
+	   Kernels::g_kernels->decode_ht_codeblock(data,
+									   unencoded_data,
 									   block->k_msbs,
 									   (int)num_passes,
-									   (int)offset,
-									   0,
+									   (int)cleanup_length,
+									   (int)(offset - cleanup_length),
 									   cblk->x1 - cblk->x0,
 									   cblk->y1 - cblk->y0,
 									   cblk->x1 - cblk->x0);
@@ -177,6 +563,9 @@ bool T1HT::decode(decodeBlockInfo *block) {
 
 void T1HT::postDecode(decodeBlockInfo *block) {
 	auto cblk = block->cblk;
+	// a block that is not in the decoded layers keeps the zeros of the tile
+	if (!cblk->seg_buffers.get_len())
+		return;
 	uint16_t w =  (uint16_t)(cblk->x1 - cblk->x0);
 	uint16_t h =  (uint16_t)(cblk->y1 - cblk->y0);
 
@@ -204,7 +593,9 @@ void T1HT::postDecode(decodeBlockInfo *block) {
 */
 	uint32_t tile_width = block->tilec->width();
 	if (block->qmfbid == 1) {
-		int32_t shift = 31 - (block->k_msbs + 1);
+		// the least significant bit plane is one below the cleanup pass
+		// when the block has refinement passes
+		int32_t shift = 31 - (block->k_msbs + (int32_t)cblk->numbps);
 		int32_t *restrict tile_data = block->tiledp;
 		for (auto j = 0U; j < h; ++j) {
 			int32_t *restrict tile_row_data = tile_data;
@@ -44,10 +44,51 @@ public:
 	void postDecode(decodeBlockInfo *block);
 
 private:
+	/**
+	 * Code a cleanup pass at each bit plane, from the most significant
+	 * bit plane of the block down to the least significant, as candidate
+	 * passes for rate control to choose from. Only their lengths and
+	 * distortions are kept.
+	 *
+	 * @return decrease in distortion of the tile, when every bit plane
+	 * is coded
+	 */
+	double encode_candidates(encodeBlockInfo *block, grk_tcd_tile *tile,
+			uint16_t w, uint16_t h);
+	/**
+	 * Code the SigProp and MagRef passes of a bit plane,
+	 * for a cleanup pass that codes the bit planes above it.
+	 *
+	 * @param block		code block
+	 * @param plane		refined bit plane, counted up from the least significant
+	 * @param w			code block width
+	 * @param h			code block height
+	 * @param lengths	returns the SigProp and MagRef lengths in bytes
+	 *
+	 * @return number of samples that the passes could not code, because they
+	 * become significant in the refined bit plane without
+	 * any significant neighbour
+	 */
+	uint32_t encode_refinement(encodeBlockInfo *block, uint32_t plane,
+			uint16_t w, uint16_t h, uint32_t *lengths);
+	/**
+	 * Decrease in distortion, in squared quantization steps, of each pass:
+	 * of the single cleanup pass at bit plane, or of the cleanup pass and
+	 * the SigProp and MagRef passes coded by encode_refinement
+	 *
+	 * @return decrease in distortion when every bit plane is coded
+	 */
+	double get_distortion(encodeBlockInfo *block, uint32_t num_samples,
+			uint32_t plane, bool refine, double *distortion);
+
 	uint32_t coded_data_size;
 	uint8_t *coded_data;
 	uint32_t unencoded_data_size;
 	int32_t *unencoded_data;
+	// significance of each sample in the cleanup and SigProp passes
+	uint8_t *refine_state;
+	// SigProp bytes, followed by MagRef bytes in the order they are written
+	uint8_t *refine_data;
 
     mem_fixed_allocator *allocator;
     mem_elastic_allocator *elastic_alloc;
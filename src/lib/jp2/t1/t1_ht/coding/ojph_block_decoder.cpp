@@ -39,6 +39,7 @@
 #include <cassert>
 #include <cstring>
 #include "ojph_block_decoder.h"
+#include "ojph_block_decoder_streams.h"
 #include "ojph_arch.h"
 #include "ojph_message.h"
 
@@ -52,256 +53,8 @@ namespace ojph {
     //VLC
     // index: 7 bits for codeword + 3 bits for context
     // table 0 is for the initial line of quads
-    static ui16 vlc_tbl0[1024] = { 0 };
-    static ui16 vlc_tbl1[1024] = { 0 };
-
-    /////////////////////////////////////////////////////////////////////////
-    //
-    /////////////////////////////////////////////////////////////////////////
-    struct mel_struct {
-      //storage
-      ui8* data; //pointer to where to read data
-      ui64 tmp;  //temporary buffer of read data
-      int bits;  //number of bits stored in tmp
-      int size;
-      bool unstuff;  //true if the next bit needs to be unstuffed
-                     //state if mel decoder
-      int k;     //state
-
-      //queue of decoded runs
-      int num_runs;
-      ui64 runs;
-    };
-
-    /////////////////////////////////////////////////////////////////////////
-    static inline
-    void mel_read(mel_struct *melp)
-    {
-      if (melp->bits > 32)
-        return;
-      ui32 val;
-      val = *(ui32*)melp->data;
-
-      int bits = 32 - melp->unstuff;
-
-      ui32 t = (melp->size > 0) ? (val & 0xFF) : 0xFF;
-      if (melp->size == 1) t |= 0xF;
-      melp->data += melp->size-- > 0;
-      bool unstuff = ((val & 0xFF) == 0xFF);
-
-      bits -= unstuff;
-      t = t << (8 - unstuff);
-
-      t |= (melp->size > 0) ? ((val>>8) & 0xFF) : 0xFF;
-      if (melp->size == 1) t |= 0xF;
-      melp->data += melp->size-- > 0;
-      unstuff = (((val >> 8) & 0xFF) == 0xFF);
-
-      bits -= unstuff;
-      t = t << (8 - unstuff);
-
-      t |= (melp->size > 0) ? ((val>>16) & 0xFF) : 0xFF;
-      if (melp->size == 1) t |= 0xF;
-      melp->data += melp->size-- > 0;
-      unstuff = (((val >> 16) & 0xFF) == 0xFF);
-
-      bits -= unstuff;
-      t = t << (8 - unstuff);
-
-      t |= (melp->size > 0) ? ((val>>24) & 0xFF) : 0xFF;
-      if (melp->size == 1) t |= 0xF;
-      melp->data += melp->size-- > 0;
-      melp->unstuff = (((val >> 24) & 0xFF) == 0xFF);
-
-      melp->tmp |= ((ui64)t) << (64 - bits - melp->bits);
-      melp->bits += bits;
-    }
-
-    /////////////////////////////////////////////////////////////////////////
-    static inline
-    void mel_decode(mel_struct *melp)
-    {
-      static const int mel_exp[13] = { //MEL exponent
-        0, 0, 0, 1, 1, 1, 2, 2, 2, 3, 3, 4, 5
-      };
-
-      if (melp->bits < 6)
-        mel_read(melp);
-
-      while (melp->bits >= 6 && melp->num_runs < 8)
-      {
-        int eval = mel_exp[melp->k];
-        int run = 0;
-        if (melp->tmp & (1ull<<63)) //MSB is set
-        { //one is found
-          run = 1 << eval;
-          run--;
-          melp->k = melp->k + 1 < 12 ? melp->k + 1 : 12;
-          melp->tmp <<= 1;
-          melp->bits -= 1;
-          run = run << 1; //not terminating in one
-        }
-        else
-        { //0 is found
-          run = (melp->tmp >> (63 - eval)) & ((1 << eval) - 1);
-          //run = bit_reverse[run] >> (5 - eval);
-          melp->k = melp->k - 1 > 0 ? melp->k - 1 : 0;
-          melp->tmp <<= eval + 1;
-          melp->bits -= eval + 1;
-          run = (run << 1) + 1; //terminating with one
-        }
-        eval = melp->num_runs * 7;
-        melp->runs &= ~((ui64)0x3F << eval);
-        melp->runs |= ((ui64)run) << eval;
-        melp->num_runs++; //increment count
-      }
-    }
-
-    /////////////////////////////////////////////////////////////////////////
-    static inline
-    void mel_init(mel_struct *melp, ui8*bbuf, int lcup, int scup)
-    {
-      melp->data = bbuf + lcup - scup;
-      melp->bits = 0;
-      melp->tmp = 0;
-      melp->unstuff = false;
-      melp->size = scup - 1;
-      melp->k = 0;
-      melp->num_runs = 0;
-      melp->runs = 0;
-
-      //These few lines take care of the case where data is not at a multiple
-      // of 4 boundary.  It reads at 1,2,3 up to 4 bytes from the mel stream
-      int num = 4 - (intptr_t(melp->data) & 0x3);
-      for (int i = 0; i < num; ++i) {
-        assert(melp->unstuff == false || melp->data[0] <= 0x8F);
-        ui64 d = (melp->size > 0) ? *melp->data : 0xFF;
-        if (melp->size == 1) d |= 0xF;
-        melp->data += melp->size-- > 0;
-        int d_bits = 8 - melp->unstuff;
-        melp->tmp = (melp->tmp << d_bits) | d;
-        melp->bits += d_bits;
-        melp->unstuff = ((d & 0xFF) == 0xFF);
-      }
-      melp->tmp <<= (64 - melp->bits); //push up
-    }
-
-    /////////////////////////////////////////////////////////////////////////
-    static inline
-    int mel_get_run(mel_struct *melp)
-    {
-      if (melp->num_runs == 0)
-        mel_decode(melp);
-
-      int t = melp->runs & 0x7F;
-      melp->runs >>= 7;
-      melp->num_runs--;
-      return t;
-    }
-
-    /////////////////////////////////////////////////////////////////////////
-    //
-    /////////////////////////////////////////////////////////////////////////
-    struct rev_struct {
-      //storage
-      ui8* data;     //pointer to where to read data
-      ui64 tmp;		   //temporary buffer of read data
-      int bits;      //number of bits stored in tmp
-      int size;
-      bool unstuff;  //true if a bit needs to be unstuffed
-    };
-
-    /////////////////////////////////////////////////////////////////////////
-    inline void rev_read(rev_struct *vlcp)
-    {
-      //process 4 bytes at a time
-      if (vlcp->bits > 32)
-        return;
-      ui32 val;
-      val = *(ui32*)vlcp->data;
-      vlcp->data -= 4;
-
-      //accumulate in int and then push into the registers
-      ui32 tmp = val >> 24;
-      int bits;
-      bits = 8 - ((vlcp->unstuff && (((val >> 24) & 0x7F) == 0x7F)) ? 1 : 0);
-      bool unstuff = (val >> 24) > 0x8F;
-
-      tmp |= ((val >> 16) & 0xFF) << bits;
-      bits += 8 - ((unstuff && (((val >> 16) & 0x7F) == 0x7F)) ? 1 : 0);
-      unstuff = ((val >> 16) & 0xFF) > 0x8F;
-
-      tmp |= ((val >> 8) & 0xFF) << bits;
-      bits += 8 - ((unstuff && (((val >> 8) & 0x7F) == 0x7F)) ? 1 : 0);
-      unstuff = ((val >> 8) & 0xFF) > 0x8F;
-
-      tmp |= (val & 0xFF) << bits;
-      bits += 8 - ((unstuff && ((val & 0x7F) == 0x7F)) ? 1 : 0);
-      unstuff = (val & 0xFF) > 0x8F;
-
-      vlcp->tmp |= (ui64)tmp << vlcp->bits;
-      vlcp->bits += bits;
-      vlcp->unstuff = unstuff;
-
-      vlcp->size -= 4;
-      //because we read ahead of time, we might in fact exceed vlc size,
-      // but data should not be used if the codeblock is properly generated
-      //The mel code can in fact occupy zero length, if it has a small number
-      // of bits and these bits overlap with the VLC code
-      if (vlcp->size < -8) //8 is based on the fact that we may read 64 bits
-        OJPH_ERROR(0x00010001, "Error in reading VLC data");
-    }
-
-    /////////////////////////////////////////////////////////////////////////
-    inline void rev_init(rev_struct *vlcp, ui8* data, int lcup, int scup)
-    {
-      //first byte has only the upper 4 bits
-      vlcp->data = data + lcup - 2;
-
-      //size can not be larger than this, in fact it should be smaller
-      vlcp->size = scup - 2;
-
-      int d = *vlcp->data--;
-      vlcp->tmp = d >> 4; //both initialize and set
-      vlcp->bits = 4 - ((vlcp->tmp & 7) == 7);
-      vlcp->unstuff = (d | 0xF) > 0x8F;
-
-      //These few lines take care of the case where data is not at a multiple
-      // of 4 boundary.  It reads at 1,2,3 up to 4 bytes from the vlc stream
-      int num = 1 + (intptr_t(vlcp->data) & 0x3);
-      int tnum = num < vlcp->size ? num : vlcp->size;
-      for (int i = 0; i < tnum; ++i) {
-        ui64 d;
-        d = *vlcp->data--;
-        int d_bits = 8 - ((vlcp->unstuff && ((d & 0x7F) == 0x7F)) ? 1 : 0);
-        vlcp->tmp |= d << vlcp->bits;
-        vlcp->bits += d_bits;
-        vlcp->unstuff = d > 0x8F;
-      }
-      vlcp->data -= 3; //make ready to read a 32 bits
-      rev_read(vlcp);
-    }
-
-    /////////////////////////////////////////////////////////////////////////
-    inline ui32 rev_fetch(rev_struct *vlcp)
-    {
-      if (vlcp->bits < 32)
-      {
-        rev_read(vlcp);
-        if (vlcp->bits < 32)
-          rev_read(vlcp);
-      }
-      return (ui32)vlcp->tmp;
-    }
-
-    /////////////////////////////////////////////////////////////////////////
-    inline ui32 rev_advance(rev_struct *vlcp, int num_bits)
-    {
-      assert(num_bits <= vlcp->bits);
-      vlcp->tmp >>= num_bits;
-      vlcp->bits -= num_bits;
-      return (ui32)vlcp->tmp;
-    }
+    ui16 vlc_tbl0[1024] = { 0 };
+    ui16 vlc_tbl1[1024] = { 0 };
 
     /////////////////////////////////////////////////////////////////////////
     inline void rev_read_mrp(rev_struct *mrp)
@@ -430,171 +183,6 @@ namespace ojph {
       return true;
     }
 
-    /////////////////////////////////////////////////////////////////////////
-    inline int decode_init_uvlc(ui32 vlc, ui32 mode, int *u)
-    {
-      //table stores possible decoding three bits from vlc
-      // there are 8 entries for xx1, x10, 100, 000
-      // 2 bits for prefix length
-      // 3 bits for suffix length
-      // 3 bits for prefix value
-      static const ui8 dec[8] = {
-        3 | (5 << 2) | (5 << 5), //000 == 000
-        1 | (0 << 2) | (1 << 5), //001 == xx1
-        2 | (0 << 2) | (2 << 5), //010 == x10
-        1 | (0 << 2) | (1 << 5), //011 == xx1
-        3 | (1 << 2) | (3 << 5), //100 == 100
-        1 | (0 << 2) | (1 << 5), //101 == xx1
-        2 | (0 << 2) | (2 << 5), //110 == x10
-        1 | (0 << 2) | (1 << 5)  //111 == xx1
-      };
-
-      int consumed_bits = 0;
-      if (mode == 0)
-      {
-        u[0] = u[1] = 1; //Kappa is 1 for initial line
-      }
-      else if (mode <= 2)
-      {
-        int d = dec[vlc & 0x7];
-        vlc >>= d & 0x3;
-        consumed_bits += d & 0x3;
-
-        int suffix_len = ((d >> 2) & 0x7);
-        consumed_bits += suffix_len;
-
-        d = (d >> 5) + (vlc & ((1 << suffix_len) - 1));
-        u[0] = (mode == 1) ? d + 1 : 1; //Kappa is 1 for initial line
-        u[1] = (mode == 1) ? 1 : d + 1; //Kappa is 1 for initial line
-      }
-      else if (mode == 3)
-      {
-        int d1 = dec[vlc & 0x7];
-        vlc >>= d1 & 0x3;
-        consumed_bits += d1 & 0x3;
-
-        if ((d1 & 0x3) > 2)
-        {
-          //u_{q_2} prefix
-          u[1] = (vlc & 1) + 1 + 1; //Kappa is 1 for initial line
-          ++consumed_bits;
-          vlc >>= 1;
-
-          int suffix_len = ((d1 >> 2) & 0x7);
-          consumed_bits += suffix_len;
-          d1 = (d1 >> 5) + (vlc & ((1 << suffix_len) - 1));
-          u[0] = d1 + 1; //Kappa is 1 for initial line
-        }
-        else
-        {
-          int d2 = dec[vlc & 0x7];
-          vlc >>= d2 & 0x3;
-          consumed_bits += d2 & 0x3;
-
-          int suffix_len = ((d1 >> 2) & 0x7);
-          consumed_bits += suffix_len;
-
-          d1 = (d1 >> 5) + (vlc & ((1 << suffix_len) - 1));
-          u[0] = d1 + 1; //Kappa is 1 for initial line
-          vlc >>= suffix_len;
-
-          suffix_len = ((d2 >> 2) & 0x7);
-          consumed_bits += suffix_len;
-
-          d2 = (d2 >> 5) + (vlc & ((1 << suffix_len) - 1));
-          u[1] = d2 + 1; //Kappa is 1 for initial line
-        }
-      }
-      else if (mode == 4)
-      {
-        int d1 = dec[vlc & 0x7];
-        vlc >>= d1 & 0x3;
-        consumed_bits += d1 & 0x3;
-
-        int d2 = dec[vlc & 0x7];
-        vlc >>= d2 & 0x3;
-        consumed_bits += d2 & 0x3;
-
-        int suffix_len = ((d1 >> 2) & 0x7);
-        consumed_bits += suffix_len;
-
-        d1 = (d1 >> 5) + (vlc & ((1 << suffix_len) - 1));
-        u[0] = d1 + 3; //Kappa is 1 for initial line
-        vlc >>= suffix_len;
-
-        suffix_len = ((d2 >> 2) & 0x7);
-        consumed_bits += suffix_len;
-
-        d2 = (d2 >> 5) + (vlc & ((1 << suffix_len) - 1));
-        u[1] = d2 + 3; //Kappa is 1 for initial line
-      }
-      return consumed_bits;
-    }
-
-    /////////////////////////////////////////////////////////////////////////
-    inline int decode_noninit_uvlc(ui32 vlc, ui32 mode, int *u)
-    {
-      //table stores possible decoding three bits from vlc
-      // there are 8 entries for xx1, x10, 100, 000
-      // 2 bits for prefix length
-      // 3 bits for suffix length
-      // 3 bits for prefix value
-      static const ui8 dec[8] = {
-        3 | (5 << 2) | (5 << 5), //000 == 000
-        1 | (0 << 2) | (1 << 5), //001 == xx1
-        2 | (0 << 2) | (2 << 5), //010 == x10
-        1 | (0 << 2) | (1 << 5), //011 == xx1
-        3 | (1 << 2) | (3 << 5), //100 == 100
-        1 | (0 << 2) | (1 << 5), //101 == xx1
-        2 | (0 << 2) | (2 << 5), //110 == x10
-        1 | (0 << 2) | (1 << 5)  //111 == xx1
-      };
-
-      int consumed_bits = 0;
-      if (mode == 0)
-      {
-        u[0] = u[1] = 1; //for kappa
-      }
-      else if (mode <= 2)
-      {
-        int d = dec[vlc & 0x7];
-        vlc >>= d & 0x3;
-        consumed_bits += d & 0x3;
-
-        int suffix_len = ((d >> 2) & 0x7);
-        consumed_bits += suffix_len;
-
-        d = (d >> 5) + (vlc & ((1 << suffix_len) - 1));
-        u[0] = (mode == 1) ? d + 1 : 1; //for kappa
-        u[1] = (mode == 1) ? 1 : d + 1; //for kappa
-      }
-      else if (mode == 3)
-      {
-        int d1 = dec[vlc & 0x7];
-        vlc >>= d1 & 0x3;
-        consumed_bits += d1 & 0x3;
-
-        int d2 = dec[vlc & 0x7];
-        vlc >>= d2 & 0x3;
-        consumed_bits += d2 & 0x3;
-
-        int suffix_len = ((d1 >> 2) & 0x7);
-        consumed_bits += suffix_len;
-
-        d1 = (d1 >> 5) + (vlc & ((1 << suffix_len) - 1));
-        u[0] = d1 + 1;  //for kappa
-        vlc >>= suffix_len;
-
-        suffix_len = ((d2 >> 2) & 0x7);
-        consumed_bits += suffix_len;
-
-        d2 = (d2 >> 5) + (vlc & ((1 << suffix_len) - 1));
-        u[1] = d2 + 1;  //for kappa
-      }
-      return consumed_bits;
-    }
-
-
     /////////////////////////////////////////////////////////////////////////
     static bool vlc_tables_initialized = vlc_init_tables();
 
@@ -676,7 +264,12 @@ namespace ojph {
     ui32 frwd_fetch(frwd_struct *msp)
     {
       if (msp->bits < 32)
+      {
         frwd_read<X>(msp);
+        //unstuffed bytes give fewer than 32 bits, so one read may not do
+        if (msp->bits < 32)
+          frwd_read<X>(msp);
+      }
       return (ui32)msp->tmp;
     }
 
@@ -690,12 +283,12 @@ namespace ojph {
                                int width, int height, int stride)
     {
       //sigma: each ui32 contains flags for 32 locations, stripe high;
-      // that is, 4 rows by 8 columns.  For 1024 columns, we need 32 integers.
+      // that is, 4 rows by 8 columns.  For 1024 columns, we need 128 integers.
       // Here, we need these arrays to be used interchangeably
       //One extra for simple implementation
-      ui32 sigma1[33] = { 0 }, sigma2[33] = { 0 };
+      ui32 sigma1[129] = { 0 }, sigma2[129] = { 0 };
       //mbr: arranges similar to sigma.
-      ui32 mbr1[33] = { 0 }, mbr2[33] = { 0 };
+      ui32 mbr1[129] = { 0 }, mbr2[129] = { 0 };
       //a pointer to sigma
       ui32* sip = sigma1;
       //pointers to arrays to be used interchangeably
@@ -1321,7 +914,7 @@ namespace ojph {
             for (int i = 0; i < width;
                  i += 8, cur_sig++, cur_mbr++, nxt_sig++, nxt_mbr++)
             {
-              int mbr = *cur_mbr;
+              ui32 mbr = *cur_mbr;
               ui32 new_sig = 0;
               if (mbr)
               {
@@ -1333,7 +926,7 @@ namespace ojph {
                   si32 *dp = decoded_data + (y - 8) * stride;
                   dp += i + n;
 
-                  ui32 col_mask = 0xF << (4 * n);
+                  ui32 col_mask = 0xFu << (4 * n);
 
                   ui32 inv_sig = ~cur_sig[0];
 
@@ -1344,14 +937,14 @@ namespace ojph {
                       continue;
 
                     //scan 4 mbr
-                    int sample_mask = 0x11111111 & col_mask;
+                    ui32 sample_mask = 0x11111111 & col_mask;
                     if (mbr & sample_mask)
                     {
                       assert(dp[0] == 0);
                       if (cwd & 1)
                       {
                         new_sig |= sample_mask;
-                        ui32 t = 0x32 << (j * 4);
+                        ui32 t = 0x32u << (j * 4);
                         mbr |= t & inv_sig;
                       }
                       cwd >>= 1; ++cnt;
@@ -1364,7 +957,7 @@ namespace ojph {
                       if (cwd & 1)
                       {
                         new_sig |= sample_mask;
-                        ui32 t = 0x74 << (j * 4);
+                        ui32 t = 0x74u << (j * 4);
                         mbr |= t & inv_sig;
                       }
                       cwd >>= 1; ++cnt;
@@ -1377,7 +970,7 @@ namespace ojph {
                       if (cwd & 1)
                       {
                         new_sig |= sample_mask;
-                        ui32 t = 0xE8 << (j * 4);
+                        ui32 t = 0xE8u << (j * 4);
                         mbr |= t & inv_sig;
                       }
                       cwd >>= 1; ++cnt;
@@ -1390,7 +983,7 @@ namespace ojph {
                       if (cwd & 1)
                       {
                         new_sig |= sample_mask;
-                        ui32 t = 0xC0 << (j * 4);
+                        ui32 t = 0xC0u << (j * 4);
                         mbr |= t & inv_sig;
                       }
                       cwd >>= 1; ++cnt;
@@ -1398,11 +991,11 @@ namespace ojph {
                   }
 
                   //signs here
-                  if (new_sig & (0xFFFF << (4 * n)))
+                  if (new_sig & (0xFFFFu << (4 * n)))
                   {
                     si32 *dp = decoded_data + (y - 8) * stride;
                     dp += i + n;
-                    ui32 col_mask = 0xF << (4 * n);
+                    ui32 col_mask = 0xFu << (4 * n);
 
                     for (int j = n; j < end; ++j, ++dp, col_mask <<= 4)
                     {
@@ -1410,7 +1003,7 @@ namespace ojph {
                         continue;
 
                       //scan 4 signs
-                      int sample_mask = 0x11111111 & col_mask;
+                      ui32 sample_mask = 0x11111111 & col_mask;
                       if (new_sig & sample_mask)
                       {
                         assert(dp[0] == 0);
@@ -1577,7 +1170,7 @@ namespace ojph {
         {
           ui32 *cur_sig, *cur_mbr, *nxt_sig, *nxt_mbr;
 
-          int pattern = 0xFFFFFFFF;
+          ui32 pattern = 0xFFFFFFFF;
           if (height - y == 3)
             pattern = 0x77777777;
           else if (height - y == 2)
@@ -1616,7 +1209,7 @@ namespace ojph {
           for (int i = 0; i < width; i += 8,
                cur_sig++, cur_mbr++, nxt_sig++, nxt_mbr++)
           {
-            int mbr = *cur_mbr & pattern;
+            ui32 mbr = *cur_mbr & pattern;
             ui32 new_sig = 0;
             if (mbr)
             {
@@ -1628,7 +1221,7 @@ namespace ojph {
                 si32 *dp = decoded_data + y * stride;
                 dp += i + n;
 
-                ui32 col_mask = 0xF << (4 * n);
+                ui32 col_mask = 0xFu << (4 * n);
 
                 ui32 inv_sig = ~cur_sig[0] & pattern;
 
@@ -1639,14 +1232,14 @@ namespace ojph {
                     continue;
 
                   //scan 4 mbr
-                  int sample_mask = 0x11111111 & col_mask;
+                  ui32 sample_mask = 0x11111111 & col_mask;
                   if (mbr & sample_mask)
                   {
                     assert(dp[0] == 0);
                     if (cwd & 1)
                     {
                       new_sig |= sample_mask;
-                      ui32 t = 0x32 << (j * 4);
+                      ui32 t = 0x32u << (j * 4);
                       mbr |= t & inv_sig;
                     }
                     cwd >>= 1; ++cnt;
@@ -1659,7 +1252,7 @@ namespace ojph {
                     if (cwd & 1)
                     {
                       new_sig |= sample_mask;
-                      ui32 t = 0x74 << (j * 4);
+                      ui32 t = 0x74u << (j * 4);
                       mbr |= t & inv_sig;
                     }
                     cwd >>= 1; ++cnt;
@@ -1672,7 +1265,7 @@ namespace ojph {
                     if (cwd & 1)
                     {
                       new_sig |= sample_mask;
-                      ui32 t = 0xE8 << (j * 4);
+                      ui32 t = 0xE8u << (j * 4);
                       mbr |= t & inv_sig;
                     }
                     cwd >>= 1; ++cnt;
@@ -1685,7 +1278,7 @@ namespace ojph {
                     if (cwd & 1)
                     {
                       new_sig |= sample_mask;
-                      ui32 t = 0xC0 << (j * 4);
+                      ui32 t = 0xC0u << (j * 4);
                       mbr |= t & inv_sig;
                     }
                     cwd >>= 1; ++cnt;
@@ -1693,11 +1286,11 @@ namespace ojph {
                 }
 
                 //signs here
-                if (new_sig & (0xFFFF << (4 * n)))
+                if (new_sig & (0xFFFFu << (4 * n)))
                 {
                   si32 *dp = decoded_data + y * stride;
                   dp += i + n;
-                  ui32 col_mask = 0xF << (4 * n);
+                  ui32 col_mask = 0xFu << (4 * n);
 
                   for (int j = n; j < end; ++j, ++dp, col_mask <<= 4)
                   {
@@ -1705,7 +1298,7 @@ namespace ojph {
                       continue;
 
                     //scan 4 signs
-                    int sample_mask = 0x11111111 & col_mask;
+                    ui32 sample_mask = 0x11111111 & col_mask;
                     if (new_sig & sample_mask)
                     {
                       assert(dp[0] == 0);
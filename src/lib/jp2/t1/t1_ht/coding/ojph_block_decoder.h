@@ -44,6 +44,13 @@
 namespace ojph {
   namespace local {
 
+    //////////////////////////////////////////////////////////////////////////
+    //VLC tables, shared with the block decoders built for each instruction
+    // set: index is 7 bits for codeword + 3 bits for context,
+    // table 0 is for the initial line of quads
+    extern ui16 vlc_tbl0[1024];
+    extern ui16 vlc_tbl1[1024];
+
     //////////////////////////////////////////////////////////////////////////
     //decodes the cleanup pass, significance propagation pass,
     // and magnitude refinement pass
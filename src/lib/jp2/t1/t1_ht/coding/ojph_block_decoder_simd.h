@@ -0,0 +1,799 @@
+/*
+ *    Copyright (C) 2016-2020 Grok Image Compression Inc.
+ *
+ *    This source code is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This source code is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ *    This source code incorporates work covered by the following copyright and
+ *    permission notice:
+ *
+ * This software is released under the 2-Clause BSD license, included
+ * below.
+ *
+ * Copyright (c) 2019, Aous Naman
+ * Copyright (c) 2019, Kakadu Software Pty Ltd, Australia
+ * Copyright (c) 2019, The University of New South Wales, Australia
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * HT block decoder for SSE4.1 and AVX2, included by the kernel tables
+ * that are built for those instruction sets (see kernels_impl.h).
+ *
+ * The output is bit identical to ojph_decode_codeblock. The differences
+ * are in how the work is organised:
+ *
+ * 1. The MagSgn, SigProp and MagRef streams are unstuffed up front into
+ *    plain bit arrays, so that any sample's bits can be read at a known
+ *    bit offset instead of through a stateful reader.
+ * 2. Each line of quads is decoded in two steps. The first runs the
+ *    serial VLC, MEL and u decoding for the whole line and stores the
+ *    quad information and exponent bound U of every quad. The second
+ *    decodes the four MagSgn samples of each quad together: the sample
+ *    lengths m_n, their offsets (a prefix sum) and the sample values are
+ *    computed in vector registers, and two quads are written out as two
+ *    rows of four samples.
+ * 3. The SigProp and MagRef passes visit the samples of a stripe with bit
+ *    scans over the significance words, rather than testing all 32
+ *    positions of each word.
+ *
+ * Only static functions may be used here: see kernels_impl.h.
+ */
+
+#ifndef OJPH_BLOCK_DECODER_SIMD_H
+#define OJPH_BLOCK_DECODER_SIMD_H
+
+#include <cstring>
+#include <smmintrin.h>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+#include "ojph_block_decoder.h"
+#include "ojph_block_decoder_streams.h"
+
+namespace ojph {
+  namespace local {
+    namespace {
+
+    /////////////////////////////////////////////////////////////////////////
+    // unstuffed streams
+    /////////////////////////////////////////////////////////////////////////
+
+    // largest code block, in samples
+    const int HT_MAX_SAMPLES = 4096;
+    // a valid MagSgn stream holds at most 32 bits per sample
+    const int HT_MS_BYTES = HT_MAX_SAMPLES * 4;
+    // SigProp: one membership and one sign bit per sample at most
+    const int HT_SPP_BYTES = HT_MAX_SAMPLES / 4;
+    // MagRef: one bit per sample at most
+    const int HT_MRP_BYTES = HT_MAX_SAMPLES / 8;
+    // bytes after the end of an unstuffed stream, see bits_at
+    const int HT_PAD_BYTES = 16;
+
+    struct unstuffed {
+      ui8 *data;
+      // bit positions from here on read as the stream's fill bits
+      ui32 limit;
+    };
+
+    /////////////////////////////////////////////////////////////////////////
+    // 32 bits of an unstuffed stream, starting at bit pos
+    static inline ui32 bits_at(const unstuffed *s, ui32 pos)
+    {
+      pos = pos < s->limit ? pos : s->limit;
+      ui64 val;
+      memcpy(&val, s->data + (pos >> 3), sizeof(val));
+      return (ui32)(val >> (pos & 7));
+    }
+
+    /////////////////////////////////////////////////////////////////////////
+    static inline void unstuff_flush(ui64 &acc, int &bits, ui8 *out, int &n)
+    {
+      if (bits >= 32) {
+        ui32 t = (ui32)acc;
+        memcpy(out + n, &t, sizeof(t));
+        n += 4;
+        acc >>= 32;
+        bits -= 32;
+      }
+    }
+
+    /////////////////////////////////////////////////////////////////////////
+    static inline void unstuff_end(ui64 acc, int bits, ui8 fill, ui8 *out,
+                                   int n, unstuffed *s)
+    {
+      if (fill)
+        acc |= ~(ui64)0 << bits;
+      memcpy(out + n, &acc, sizeof(acc));
+      memset(out + n + 8, fill, HT_PAD_BYTES - 8);
+      s->data = out;
+      s->limit = (ui32)(n + 8) << 3;
+    }
+
+    /////////////////////////////////////////////////////////////////////////
+    // Unstuff a forward stream (MagSgn with X = 0xFF, SigProp with X = 0)
+    // into out, which has room for cap + HT_PAD_BYTES bytes. A byte that
+    // follows 0xFF carries 7 bits, and bytes past the end read as X;
+    // the bits are accumulated exactly as frwd_read does.
+    template<int X>
+    static void unstuff_frwd(const ui8 *data, int size, ui8 *out, int cap,
+                             unstuffed *s)
+    {
+      ui64 acc = 0;
+      int bits = 0, n = 0, i = 0;
+      bool unstuff = false;
+      while (i < size && n < cap)
+      {
+        if (!unstuff && i + 4 <= size)
+        {
+          //four bytes at once if none of them is 0xFF
+          ui32 val;
+          memcpy(&val, data + i, sizeof(val));
+          ui32 inv = ~val;
+          if (((inv - 0x01010101u) & ~inv & 0x80808080u) == 0)
+          {
+            acc |= (ui64)val << bits;
+            bits += 32;
+            i += 4;
+            unstuff_flush(acc, bits, out, n);
+            continue;
+          }
+        }
+        ui32 d = data[i++];
+        acc |= (ui64)d << bits;
+        bits += 8 - unstuff;
+        unstuff = d == 0xFF;
+        unstuff_flush(acc, bits, out, n);
+      }
+      unstuff_end(acc, bits, (ui8)X, out, n, s);
+    }
+
+    /////////////////////////////////////////////////////////////////////////
+    // Unstuff the MagRef stream, which is read backwards from the end of
+    // the refinement segment, as rev_read_mrp does. Bytes past the end
+    // read as 0
+    static void unstuff_mrp(const ui8 *data, int size, ui8 *out, int cap,
+                            unstuffed *s)
+    {
+      ui64 acc = 0;
+      int bits = 0, n = 0;
+      bool unstuff = true;
+      for (int i = 1; i <= size && n < cap; ++i)
+      {
+        ui32 d = data[size - i];
+        acc |= (ui64)d << bits;
+        bits += 8 - ((unstuff && ((d & 0x7F) == 0x7F)) ? 1 : 0);
+        unstuff = d > 0x8F;
+        unstuff_flush(acc, bits, out, n);
+      }
+      unstuff_end(acc, bits, 0, out, n, s);
+    }
+
+    /////////////////////////////////////////////////////////////////////////
+    // MagSgn
+    /////////////////////////////////////////////////////////////////////////
+
+    // 32 bits of the MagSgn stream at each of the four bit positions
+    static inline __m128i read_quad(const unstuffed *ms, __m128i pos)
+    {
+      pos = _mm_min_epu32(pos, _mm_set1_epi32((int)ms->limit));
+#if defined(__AVX2__)
+      __m256i w = _mm256_i32gather_epi64((const long long*)ms->data,
+                                         _mm_srli_epi32(pos, 3), 1);
+      w = _mm256_srlv_epi64(w, _mm256_cvtepu32_epi64(
+        _mm_and_si128(pos, _mm_set1_epi32(7))));
+      w = _mm256_permutevar8x32_epi32(w,
+        _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6));
+      return _mm256_castsi256_si128(w);
+#else
+      return _mm_setr_epi32((int)bits_at(ms, (ui32)_mm_extract_epi32(pos, 0)),
+                            (int)bits_at(ms, (ui32)_mm_extract_epi32(pos, 1)),
+                            (int)bits_at(ms, (ui32)_mm_extract_epi32(pos, 2)),
+                            (int)bits_at(ms, (ui32)_mm_extract_epi32(pos, 3)));
+#endif
+    }
+
+    /////////////////////////////////////////////////////////////////////////
+    // 1 << m on each lane, for 0 <= m <= 31
+    static inline __m128i pow2(__m128i m)
+    {
+#if defined(__AVX2__)
+      return _mm_sllv_epi32(_mm_set1_epi32(1), m);
+#else
+      //build the float 2^m; 2^31 converts to 0x80000000, which is 1 << 31
+      __m128i e = _mm_slli_epi32(_mm_add_epi32(m, _mm_set1_epi32(127)), 23);
+      return _mm_cvttps_epi32(_mm_castsi128_ps(e));
+#endif
+    }
+
+    /////////////////////////////////////////////////////////////////////////
+    // Decode the four samples of a quad, in the order top-left,
+    // bottom-left, top-right, bottom-right, from the MagSgn bits at pos,
+    // and advance pos. v_n receives the magnitudes with the centre of bin
+    // bit, from which the exponents of the line state are derived.
+    static inline __m128i decode_quad(ui32 qinf, int U_q, const unstuffed *ms,
+                                      ui32 &pos, __m128i shift, __m128i &v_n)
+    {
+      const __m128i one = _mm_set1_epi32(1);
+      const __m128i rho_bits = _mm_setr_epi32(0x10, 0x20, 0x40, 0x80);
+      const __m128i e1_bits = _mm_setr_epi32(0x100, 0x200, 0x400, 0x800);
+      const __m128i ek_bits = _mm_setr_epi32(0x1000, 0x2000, 0x4000, 0x8000);
+
+      __m128i q = _mm_set1_epi32((int)qinf);
+      __m128i sig = _mm_cmpeq_epi32(_mm_and_si128(q, rho_bits), rho_bits);
+      __m128i e_1 = _mm_cmpeq_epi32(_mm_and_si128(q, e1_bits), e1_bits);
+      __m128i e_k = _mm_cmpeq_epi32(_mm_and_si128(q, ek_bits), ek_bits);
+
+      //m_n = U_q - e_k for significant samples, and 0 for the others
+      __m128i m_n = _mm_and_si128(sig, _mm_add_epi32(_mm_set1_epi32(U_q), e_k));
+
+      //each sample starts where the previous ones end
+      __m128i inc = _mm_add_epi32(m_n, _mm_slli_si128(m_n, 4));
+      inc = _mm_add_epi32(inc, _mm_slli_si128(inc, 8));
+      __m128i start = _mm_add_epi32(_mm_set1_epi32((int)pos),
+                                    _mm_sub_epi32(inc, m_n));
+      pos += (ui32)_mm_extract_epi32(inc, 3);
+      __m128i ms_val = read_quad(ms, start);
+
+      //v_n = ms_val[m_n-1:0] | e_1 << m_n | 1; the lsb is the sign
+      __m128i bit_m = pow2(m_n);
+      v_n = _mm_and_si128(ms_val, _mm_sub_epi32(bit_m, one));
+      v_n = _mm_or_si128(v_n, _mm_and_si128(e_1, bit_m));
+      v_n = _mm_or_si128(v_n, one);
+
+      __m128i val = _mm_slli_epi32(ms_val, 31);
+      val = _mm_or_si128(val, _mm_sll_epi32(_mm_add_epi32(v_n,
+        _mm_set1_epi32(2)), shift));
+      return _mm_and_si128(val, sig);
+    }
+
+    /////////////////////////////////////////////////////////////////////////
+    // line state of one quad: the bottom-left sample is merged into the
+    // state of the previous quad's bottom-right sample, and the
+    // bottom-right sample starts the state of the next one
+    static inline void update_line_state(ui32 qinf, __m128i v_n, ui8 *lsp,
+                                         ui8 &carry)
+    {
+      ui8 ls = carry;
+      if (qinf & 0x20)
+      {
+        int t = ls & 0x7F;
+        int e = 32 - (int)count_leading_zeros((ui32)_mm_extract_epi32(v_n, 1));
+        ls = (ui8)(0x80 | (t > e ? t : e));
+      }
+      *lsp = ls;
+      carry = 0;
+      if (qinf & 0x80)
+        carry = (ui8)(0x80 | (32 -
+          (int)count_leading_zeros((ui32)_mm_extract_epi32(v_n, 3))));
+    }
+
+    /////////////////////////////////////////////////////////////////////////
+    // Decode the MagSgn samples of a line of quads, write rows y and y + 1
+    // of the code block, and build the line state for the next line
+    static inline void decode_quad_line(const ui16 *qinf, const ui8 *U_q,
+                                        const unstuffed *ms, ui32 &pos,
+                                        int p, si32 *sp, int stride,
+                                        int width, bool two_rows, ui8 *lsp)
+    {
+      const __m128i shift = _mm_cvtsi32_si128(p - 1);
+      ui8 carry = 0;
+      int q = 0;
+      for (int x = 0; x < width; x += 4, q += 2)
+      {
+        __m128i v0 = _mm_setzero_si128(), v1 = _mm_setzero_si128();
+        __m128i s0 = _mm_setzero_si128(), s1 = _mm_setzero_si128();
+        if (qinf[q] & 0xF0)
+          s0 = decode_quad(qinf[q], U_q[q], ms, pos, shift, v0);
+        update_line_state(qinf[q], v0, lsp + q, carry);
+        if (qinf[q + 1] & 0xF0)
+          s1 = decode_quad(qinf[q + 1], U_q[q + 1], ms, pos, shift, v1);
+        update_line_state(qinf[q + 1], v1, lsp + q + 1, carry);
+
+        //the left columns of the two quads are in lanes 0 and 2
+        __m128i top = _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(s0),
+          _mm_castsi128_ps(s1), _MM_SHUFFLE(2, 0, 2, 0)));
+        __m128i bottom = _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(s0),
+          _mm_castsi128_ps(s1), _MM_SHUFFLE(3, 1, 3, 1)));
+        if (x + 4 <= width)
+        {
+          _mm_storeu_si128((__m128i*)(sp + x), top);
+          if (two_rows)
+            _mm_storeu_si128((__m128i*)(sp + stride + x), bottom);
+        }
+        else
+        {
+          si32 t[8];
+          _mm_storeu_si128((__m128i*)t, top);
+          _mm_storeu_si128((__m128i*)(t + 4), bottom);
+          for (int i = 0; i < width - x; ++i)
+          {
+            sp[x + i] = t[i];
+            if (two_rows)
+              sp[stride + x + i] = t[4 + i];
+          }
+        }
+      }
+      lsp[q] = carry;
+    }
+
+    /////////////////////////////////////////////////////////////////////////
+    // SigProp and MagRef
+    /////////////////////////////////////////////////////////////////////////
+
+    /////////////////////////////////////////////////////////////////////////
+    // MagRef pass of one stripe: one bit for each sample that is
+    // significant in the cleanup pass, in stripe scan order
+    static void decode_magref_stripe(si32 *dpp, const ui32 *cur_sig,
+                                     int width, int stride, int p,
+                                     const unstuffed *mrp, ui32 &pos)
+    {
+      ui32 half = 1u << (p - 2);
+      for (int i = 0; i < width; i += 8)
+      {
+        ui32 sig = *cur_sig++;
+        if (!sig)
+          continue;
+        ui32 cwd = bits_at(mrp, pos);
+        pos += population_count(sig);
+        si32 *dp = dpp + i;
+        for (ui32 s = sig; s; s &= s - 1)
+        {
+          ui32 k = count_trailing_zeros(s);
+          si32 *d = dp + (k >> 2) + (int)(k & 3) * stride;
+          assert(d[0] != 0);
+          *d ^= (si32)((1 - (cwd & 1)) << (p - 1));
+          *d |= (si32)half;
+          cwd >>= 1;
+        }
+      }
+    }
+
+    /////////////////////////////////////////////////////////////////////////
+    // mbr of a stripe from its own significance: the neighbours of the
+    // significant samples, less the significant samples themselves
+    static void stripe_mbr(ui32 *mbr, const ui32 *sig, int width)
+    {
+      //integrate horizontally
+      ui32 prev = 0;
+      for (int i = 0; i < width; i += 8, mbr++, sig++)
+      {
+        mbr[0] = sig[0];
+        mbr[0] |= prev >> 28;    //for first column, left neighbors
+        mbr[0] |= sig[0] << 4;   //left neighbors
+        mbr[0] |= sig[0] >> 4;   //left neighbors
+        mbr[0] |= sig[1] << 28;  //for last column, right neighbors
+        prev = sig[0];
+
+        //integrate vertically
+        ui32 t = mbr[0], z = mbr[0];
+        z |= (t & 0x77777777) << 1; //above neighbors
+        z |= (t & 0xEEEEEEEE) >> 1; //below neighbors
+        mbr[0] = z & ~sig[0]; //remove already significance samples
+      }
+    }
+
+    /////////////////////////////////////////////////////////////////////////
+    // add the neighbours in the first row of the next stripe to mbr
+    static void stripe_mbr_next(ui32 *cur_mbr, const ui32 *cur_sig,
+                                const ui32 *nxt_sig, int width)
+    {
+      ui32 prev = 0;
+      for (int i = 0; i < width; i += 8, cur_mbr++, cur_sig++, nxt_sig++)
+      {
+        ui32 t = nxt_sig[0];
+        t |= prev >> 28;        //for first column, left neighbors
+        t |= nxt_sig[0] << 4;   //left neighbors
+        t |= nxt_sig[0] >> 4;   //left neighbors
+        t |= nxt_sig[1] << 28;  //for last column, right neighbors
+        prev = nxt_sig[0];
+
+        cur_mbr[0] |= (t & 0x11111111) << 3;
+        cur_mbr[0] &= ~cur_sig[0]; //remove already significance samples
+      }
+    }
+
+    /////////////////////////////////////////////////////////////////////////
+    // SigProp pass of one stripe. pattern masks out the rows of a stripe
+    // that are past the bottom of the code block
+    static void decode_sigprop_stripe(si32 *dpp, const ui32 *cur_sig,
+                                      ui32 *cur_mbr, const ui32 *nxt_sig,
+                                      ui32 *nxt_mbr, ui32 pattern, int width,
+                                      int stride, int p,
+                                      const unstuffed *spp, ui32 &pos)
+    {
+      //samples that may become members once a sample in the same column
+      // becomes significant: the samples below, and those of the next
+      // column in the rows above, alongside and below
+      static const ui32 nbrs[4] = { 0x32, 0x74, 0xE8, 0xC0 };
+      si32 val = 3 << (p - 2);
+      for (int i = 0; i < width; i += 8, cur_sig++, cur_mbr++, nxt_sig++,
+           nxt_mbr++)
+      {
+        ui32 mbr = *cur_mbr & pattern;
+        ui32 new_sig = 0;
+        if (mbr)
+        {
+          ui32 inv_sig = ~cur_sig[0] & pattern;
+          int cols = width - i < 8 ? width - i : 8;
+          for (int n = 0; n < 8 && n < cols; n += 4)
+          {
+            int end = n + 4 < cols ? n + 4 : cols;
+            ui32 group = (0xFFFFFFFFu >> (32 - 4 * (end - n))) << (4 * n);
+            ui32 cwd = bits_at(spp, pos);
+            ui32 cnt = 0;
+
+            //members, in scan order; a sample that becomes significant
+            // adds the following samples around it
+            ui32 todo = mbr & group;
+            while (todo)
+            {
+              ui32 k = count_trailing_zeros(todo);
+              ui32 bit = 1u << k;
+              if (cwd & 1)
+              {
+                new_sig |= bit;
+                mbr |= (nbrs[k & 3] << (k & ~3u)) & inv_sig;
+              }
+              cwd >>= 1; ++cnt;
+              todo = mbr & group & ~(bit | (bit - 1));
+            }
+
+            //signs
+            for (ui32 s = new_sig & group; s; s &= s - 1)
+            {
+              ui32 k = count_trailing_zeros(s);
+              si32 *d = dpp + i + (k >> 2) + (int)(k & 3) * stride;
+              assert(d[0] == 0);
+              *d |= (si32)((cwd & 1) << 31) | val;
+              cwd >>= 1; ++cnt;
+            }
+            pos += cnt;
+
+            //update next stripe
+            if (n == 4)
+            {
+              //horizontally
+              ui32 t = new_sig >> 28;
+              t |= ((t & 0xE) >> 1) | ((t & 7) << 1);
+              cur_mbr[1] |= t & ~cur_sig[1];
+            }
+          }
+        }
+        //vertically
+        new_sig |= cur_sig[0];
+        ui32 u = (new_sig & 0x88888888) >> 3;
+        ui32 t = u | (u << 4) | (u >> 4);
+        if (i > 0)
+          nxt_mbr[-1] |= (u << 28) & ~nxt_sig[-1];
+        nxt_mbr[0] |= t & ~nxt_sig[0];
+        nxt_mbr[1] |= (u >> 28) & ~nxt_sig[1];
+      }
+    }
+
+    /////////////////////////////////////////////////////////////////////////
+    // decoder
+    /////////////////////////////////////////////////////////////////////////
+    static void decode_codeblock_simd(ui8* coded_data, si32* decoded_data,
+                                      int missing_msbs, int num_passes,
+                                      int lengths1, int lengths2,
+                                      int width, int height, int stride)
+    {
+      //sigma: each ui32 contains flags for 32 locations, stripe high;
+      // that is, 4 rows by 8 columns.  For 1024 columns, we need 128 integers.
+      //One extra for simple implementation
+      ui32 sigma1[129] = { 0 }, sigma2[129] = { 0 };
+      //mbr: arranges similar to sigma.
+      ui32 mbr1[129] = { 0 }, mbr2[129] = { 0 };
+
+      int p = 30 - missing_msbs; // Bit-plane index for cleanup pass
+
+      // read scup and fix the bytes there
+      int lcup, scup;
+      lcup = lengths1;
+      scup = (((int)coded_data[lcup-1]) << 4) + (coded_data[lcup-2] & 0xF);
+      if (scup > lcup) //something is wrong
+        return;
+
+      mel_struct mel;
+      mel_init(&mel, coded_data, lcup, scup);
+      rev_struct vlc;
+      rev_init(&vlc, coded_data, lcup, scup);
+
+      ui8 ms_buf[HT_MS_BYTES + HT_PAD_BYTES];
+      unstuffed magsgn;
+      unstuff_frwd<0xFF>(coded_data, lcup - scup, ms_buf, HT_MS_BYTES,
+                         &magsgn);
+      ui32 ms_pos = 0;
+      ui8 spp_buf[HT_SPP_BYTES + HT_PAD_BYTES];
+      unstuffed sigprop;
+      ui32 spp_pos = 0;
+      if (num_passes > 1)
+        unstuff_frwd<0>(coded_data + lengths1, lengths2, spp_buf,
+                        HT_SPP_BYTES, &sigprop);
+      ui8 mrp_buf[HT_MRP_BYTES + HT_PAD_BYTES];
+      unstuffed magref;
+      ui32 mrp_pos = 0;
+      if (num_passes > 2)
+        unstuff_mrp(coded_data + lengths1, lengths2, mrp_buf, HT_MRP_BYTES,
+                    &magref);
+
+      //quad information and U_q of one line of quads, with room for a
+      // missing second quad of the last pair
+      ui16 qinf[514];
+      ui8 U_q[514];
+      //line states of the previous and current lines of quads: one byte
+      // per quad; the upper bit is the significance of the quad's bottom
+      // left sample or of the previous quad's bottom right sample, and the
+      // lower bits hold the largest exponent E of the two, plus 2
+      ui8 line_state[2][514];
+      ui8 *prev_ls = line_state[0], *cur_ls = line_state[1];
+
+      //initial line of quads
+      ///////////////////////
+      int run = mel_get_run(&mel);
+      ui32 c_p = 0;
+      for (int x = 0, q = 0; x < width; x += 4, q += 2)
+      {
+        //first quad
+        ui32 vlc_val = rev_fetch(&vlc);
+        ui32 qinf0 = vlc_tbl0[(c_p << 7) | (vlc_val & 0x7F)];
+        if (c_p == 0) //zero context
+        {
+          run -= 2;
+          qinf0 = (run == -1) ? qinf0 : 0;
+          if (run < 0) //either -1 or -2, get
+            run = mel_get_run(&mel);
+        }
+        //prepare context for the next quad
+        c_p = ((qinf0 & 0x10) >> 4) | ((qinf0 & 0xE0) >> 5);
+        //remove data from vlc stream
+        vlc_val = rev_advance(&vlc, qinf0 & 0x7);
+
+        //second quad
+        ui32 qinf1 = 0;
+        if (x + 2 < width)
+        {
+          qinf1 = vlc_tbl0[(c_p << 7) | (vlc_val & 0x7F)];
+          if (c_p == 0) //zero context
+          {
+            run -= 2;
+            qinf1 = (run == -1) ? qinf1 : 0;
+            if (run < 0) //either -1 or -2, get
+              run = mel_get_run(&mel);
+          }
+          //prepare context for the next quad
+          c_p = ((qinf1 & 0x10) >> 4) | ((qinf1 & 0xE0) >> 5);
+          //remove data from vlc stream
+          vlc_val = rev_advance(&vlc, qinf1 & 0x7);
+        }
+
+        //update sigma
+        sigma1[x >> 3] |= ((((qinf0 & 0x30) >> 4) | ((qinf0 & 0xC0) >> 2))
+          | (((qinf1 & 0x30) | ((qinf1 & 0xC0) << 2)) << 4)) << ((x & 4) << 2);
+
+        //retrieve u
+        int U_p[2];
+        int uvlc_mode = ((qinf0 & 0x8) >> 3) | ((qinf1 & 0x8) >> 2);
+        if (uvlc_mode == 3)
+        {
+          run -= 2;
+          uvlc_mode += (run == -1) ? 1 : 0;
+          if (run < 0) //either -1 or -2, get
+            run = mel_get_run(&mel);
+        }
+        int consumed_bits = decode_init_uvlc(vlc_val, uvlc_mode, U_p);
+        rev_advance(&vlc, consumed_bits);
+
+        qinf[q] = (ui16)qinf0;
+        qinf[q + 1] = (ui16)qinf1;
+        U_q[q] = (ui8)U_p[0];
+        U_q[q + 1] = (ui8)U_p[1];
+      }
+      decode_quad_line(qinf, U_q, &magsgn, ms_pos, p, decoded_data, stride,
+                       width, height > 1, cur_ls);
+
+      //non-initial lines
+      ///////////////////
+      for (int y = 2; y < height; /*done at the end of loop*/)
+      {
+        ui8 *t = prev_ls; prev_ls = cur_ls; cur_ls = t;
+        ui32 *sip = y & 0x4 ? sigma2 : sigma1;
+        int sip_shift = y & 0x2;
+
+        c_p = 0;
+        for (int x = 0, q = 0; x < width; x += 4, q += 2)
+        {
+          //first quad
+          c_p |= (prev_ls[q] >> 7);
+          c_p |= (prev_ls[q + 1] >> 5) & 0x4;
+          ui32 vlc_val = rev_fetch(&vlc);
+          ui32 qinf0 = vlc_tbl1[(c_p << 7) | (vlc_val & 0x7F)];
+          if (c_p == 0) //zero context
+          {
+            run -= 2;
+            qinf0 = (run == -1) ? qinf0 : 0;
+            if (run < 0) //either -1 or -2, get
+              run = mel_get_run(&mel);
+          }
+          //prepare context for the next quad
+          c_p = ((qinf0 & 0x40) >> 5) | ((qinf0 & 0x80) >> 6);
+          //remove data from vlc stream
+          vlc_val = rev_advance(&vlc, qinf0 & 0x7);
+
+          //second quad
+          ui32 qinf1 = 0;
+          if (x + 2 < width)
+          {
+            c_p |= (prev_ls[q + 1] >> 7);
+            c_p |= (prev_ls[q + 2] >> 5) & 0x4;
+            qinf1 = vlc_tbl1[(c_p << 7) | (vlc_val & 0x7F)];
+            if (c_p == 0) //zero context
+            {
+              run -= 2;
+              qinf1 = (run == -1) ? qinf1 : 0;
+              if (run < 0) //either -1 or -2, get
+                run = mel_get_run(&mel);
+            }
+            //prepare context for the next quad
+            c_p = ((qinf1 & 0x40) >> 5) | ((qinf1 & 0x80) >> 6);
+            //remove data from vlc stream
+            vlc_val = rev_advance(&vlc, qinf1 & 0x7);
+          }
+
+          //update sigma
+          sip[x >> 3] |= ((((qinf0 & 0x30) >> 4) | ((qinf0 & 0xC0) >> 2))
+            | (((qinf1 & 0x30) | ((qinf1 & 0xC0) << 2)) << 4))
+            << (((x & 4) << 2) + sip_shift);
+
+          //retrieve u
+          int U_p[2];
+          int uvlc_mode = ((qinf0 & 0x8) >> 3) | ((qinf1 & 0x8) >> 2);
+          int consumed_bits = decode_noninit_uvlc(vlc_val, uvlc_mode, U_p);
+          rev_advance(&vlc, consumed_bits);
+
+          //calculate kappa and add it to U_p
+          if ((qinf0 & 0xF0) & ((qinf0 & 0xF0) - 1))
+          {
+            int E = (prev_ls[q] & 0x7F);
+            E = E > (prev_ls[q + 1] & 0x7F) ? E : (prev_ls[q + 1] & 0x7F);
+            E -= 2;
+            U_p[0] += E > 0 ? E : 0;
+          }
+
+          if ((qinf1 & 0xF0) & ((qinf1 & 0xF0) - 1))
+          {
+            int E = (prev_ls[q + 1] & 0x7F);
+            E = E > (prev_ls[q + 2] & 0x7F) ? E : (prev_ls[q + 2] & 0x7F);
+            E -= 2;
+            U_p[1] += E > 0 ? E : 0;
+          }
+
+          qinf[q] = (ui16)qinf0;
+          qinf[q + 1] = (ui16)qinf1;
+          U_q[q] = (ui8)U_p[0];
+          U_q[q + 1] = (ui8)U_p[1];
+        }
+        decode_quad_line(qinf, U_q, &magsgn, ms_pos, p,
+                         decoded_data + y * stride, stride, width,
+                         y < height - 1, cur_ls);
+
+        y += 2;
+        if (num_passes > 1 && (y & 3) == 0) {
+
+          if (num_passes > 2) //do magref
+            decode_magref_stripe(decoded_data + (y - 4) * stride,
+                                 y & 0x4 ? sigma1 : sigma2, width, stride, p,
+                                 &magref, mrp_pos);
+
+          if (y >= 4) //generate mbr of first stripe
+            stripe_mbr(y & 0x4 ? mbr1 : mbr2, y & 0x4 ? sigma1 : sigma2,
+                       width);
+
+          if (y >= 8) //wait until 8 rows has been processed
+          {
+            ui32 *cur_sig = y & 0x4 ? sigma2 : sigma1;
+            ui32 *cur_mbr = y & 0x4 ? mbr2 : mbr1;
+            ui32 *nxt_sig = y & 0x4 ? sigma1 : sigma2;
+            ui32 *nxt_mbr = y & 0x4 ? mbr1 : mbr2;
+
+            //add membership from the next stripe, obtained above
+            stripe_mbr_next(cur_mbr, cur_sig, nxt_sig, width);
+
+            //find new locations and get signs
+            decode_sigprop_stripe(decoded_data + (y - 8) * stride, cur_sig,
+                                  cur_mbr, nxt_sig, nxt_mbr, 0xFFFFFFFF,
+                                  width, stride, p, &sigprop, spp_pos);
+
+            //clear current sigma
+            //mbr need not be cleared because it is overwritten
+            memset(cur_sig, 0, ((width + 7) >> 3) << 2);
+          }
+        }
+      }
+
+      //terminating
+      if (num_passes > 1) {
+        if (num_passes > 2 && ((height & 3) == 1 || (height & 3) == 2))
+        {//do magref
+          decode_magref_stripe(decoded_data + (height & 0xFFFFFFFC) * stride,
+                               height & 0x4 ? sigma2 : sigma1, //reversed
+                               width, stride, p, &magref, mrp_pos);
+        }
+
+        //do the last incomplete stripe
+        // for cases of (height & 3) == 0 and 3
+        // the should have been processed previously
+        if ((height & 3) == 1 || (height & 3) == 2)
+        {
+          //generate mbr of first stripe
+          stripe_mbr(height & 0x4 ? mbr2 : mbr1,
+                     height & 0x4 ? sigma2 : sigma1, width);
+        }
+
+        int st = height;
+        st -= height > 6 ? (((height + 1) & 3) + 3) : height;
+        for (int y = st; y < height; y += 4)
+        {
+          ui32 pattern = 0xFFFFFFFF;
+          if (height - y == 3)
+            pattern = 0x77777777;
+          else if (height - y == 2)
+            pattern = 0x33333333;
+          else if (height - y == 1)
+            pattern = 0x11111111;
+
+          ui32 *cur_sig = y & 0x4 ? sigma2 : sigma1;
+          ui32 *cur_mbr = y & 0x4 ? mbr2 : mbr1;
+          ui32 *nxt_sig = y & 0x4 ? sigma1 : sigma2;
+          ui32 *nxt_mbr = y & 0x4 ? mbr1 : mbr2;
+
+          //add membership from the next stripe, obtained above
+          if (height - y > 4)
+            stripe_mbr_next(cur_mbr, cur_sig, nxt_sig, width);
+
+          //find new locations and get signs
+          decode_sigprop_stripe(decoded_data + y * stride, cur_sig, cur_mbr,
+                                nxt_sig, nxt_mbr, pattern, width, stride, p,
+                                &sigprop, spp_pos);
+        }
+      }
+    }
+
+    }
+  }
+}
+
+#endif // !OJPH_BLOCK_DECODER_SIMD_H
@@ -0,0 +1,470 @@
+//***************************************************************************/
+// This software is released under the 2-Clause BSD license, included
+// below.
+//
+// Copyright (c) 2019, Aous Naman 
+// Copyright (c) 2019, Kakadu Software Pty Ltd, Australia
+// Copyright (c) 2019, The University of New South Wales, Australia
+// 
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+// 
+// 1. Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+// 
+// 2. Redistributions in binary form must reproduce the above copyright
+// notice, this list of conditions and the following disclaimer in the
+// documentation and/or other materials provided with the distribution.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+// IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+// TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+// PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+// TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+// PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+// LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//***************************************************************************/
+// This file is part of the OpenJPH software implementation.
+// File: ojph_block_decoder_streams.h
+// Author: Aous Naman
+// Date: 28 August 2019
+//***************************************************************************/
+
+// MEL and VLC readers of the cleanup pass, shared by the block decoders
+// built for each instruction set. Everything here has internal linkage,
+// so that code compiled with one set of instruction set flags is never
+// picked by the linker for callers built with another.
+
+#ifndef OJPH_BLOCK_DECODER_STREAMS_H
+#define OJPH_BLOCK_DECODER_STREAMS_H
+
+#include <cassert>
+#include "ojph_defs.h"
+#include "ojph_arch.h"
+#include "ojph_message.h"
+
+namespace ojph {
+  namespace local {
+
+    /////////////////////////////////////////////////////////////////////////
+    //
+    /////////////////////////////////////////////////////////////////////////
+    struct mel_struct {
+      //storage
+      ui8* data; //pointer to where to read data
+      ui64 tmp;  //temporary buffer of read data
+      int bits;  //number of bits stored in tmp
+      int size;
+      bool unstuff;  //true if the next bit needs to be unstuffed
+                     //state if mel decoder
+      int k;     //state
+
+      //queue of decoded runs
+      int num_runs;
+      ui64 runs;
+    };
+
+    /////////////////////////////////////////////////////////////////////////
+    static inline
+    void mel_read(mel_struct *melp)
+    {
+      if (melp->bits > 32)
+        return;
+      ui32 val;
+      val = *(ui32*)melp->data;
+
+      int bits = 32 - melp->unstuff;
+
+      ui32 t = (melp->size > 0) ? (val & 0xFF) : 0xFF;
+      if (melp->size == 1) t |= 0xF;
+      melp->data += melp->size-- > 0;
+      bool unstuff = ((val & 0xFF) == 0xFF);
+
+      bits -= unstuff;
+      t = t << (8 - unstuff);
+
+      t |= (melp->size > 0) ? ((val>>8) & 0xFF) : 0xFF;
+      if (melp->size == 1) t |= 0xF;
+      melp->data += melp->size-- > 0;
+      unstuff = (((val >> 8) & 0xFF) == 0xFF);
+
+      bits -= unstuff;
+      t = t << (8 - unstuff);
+
+      t |= (melp->size > 0) ? ((val>>16) & 0xFF) : 0xFF;
+      if (melp->size == 1) t |= 0xF;
+      melp->data += melp->size-- > 0;
+      unstuff = (((val >> 16) & 0xFF) == 0xFF);
+
+      bits -= unstuff;
+      t = t << (8 - unstuff);
+
+      t |= (melp->size > 0) ? ((val>>24) & 0xFF) : 0xFF;
+      if (melp->size == 1) t |= 0xF;
+      melp->data += melp->size-- > 0;
+      melp->unstuff = (((val >> 24) & 0xFF) == 0xFF);
+
+      melp->tmp |= ((ui64)t) << (64 - bits - melp->bits);
+      melp->bits += bits;
+    }
+
+    /////////////////////////////////////////////////////////////////////////
+    static inline
+    void mel_decode(mel_struct *melp)
+    {
+      static const int mel_exp[13] = { //MEL exponent
+        0, 0, 0, 1, 1, 1, 2, 2, 2, 3, 3, 4, 5
+      };
+
+      if (melp->bits < 6)
+        mel_read(melp);
+
+      while (melp->bits >= 6 && melp->num_runs < 8)
+      {
+        int eval = mel_exp[melp->k];
+        int run = 0;
+        if (melp->tmp & (1ull<<63)) //MSB is set
+        { //one is found
+          run = 1 << eval;
+          run--;
+          melp->k = melp->k + 1 < 12 ? melp->k + 1 : 12;
+          melp->tmp <<= 1;
+          melp->bits -= 1;
+          run = run << 1; //not terminating in one
+        }
+        else
+        { //0 is found
+          run = (int)((melp->tmp >> (63 - eval)) & ((1u << eval) - 1));
+          //run = bit_reverse[run] >> (5 - eval);
+          melp->k = melp->k - 1 > 0 ? melp->k - 1 : 0;
+          melp->tmp <<= eval + 1;
+          melp->bits -= eval + 1;
+          run = (run << 1) + 1; //terminating with one
+        }
+        eval = melp->num_runs * 7;
+        melp->runs &= ~((ui64)0x3F << eval);
+        melp->runs |= ((ui64)run) << eval;
+        melp->num_runs++; //increment count
+      }
+    }
+
+    /////////////////////////////////////////////////////////////////////////
+    static inline
+    void mel_init(mel_struct *melp, ui8*bbuf, int lcup, int scup)
+    {
+      melp->data = bbuf + lcup - scup;
+      melp->bits = 0;
+      melp->tmp = 0;
+      melp->unstuff = false;
+      melp->size = scup - 1;
+      melp->k = 0;
+      melp->num_runs = 0;
+      melp->runs = 0;
+
+      //These few lines take care of the case where data is not at a multiple
+      // of 4 boundary.  It reads at 1,2,3 up to 4 bytes from the mel stream
+      int num = 4 - (intptr_t(melp->data) & 0x3);
+      for (int i = 0; i < num; ++i) {
+        assert(melp->unstuff == false || melp->data[0] <= 0x8F);
+        ui64 d = (melp->size > 0) ? *melp->data : 0xFF;
+        if (melp->size == 1) d |= 0xF;
+        melp->data += melp->size-- > 0;
+        int d_bits = 8 - melp->unstuff;
+        melp->tmp = (melp->tmp << d_bits) | d;
+        melp->bits += d_bits;
+        melp->unstuff = ((d & 0xFF) == 0xFF);
+      }
+      melp->tmp <<= (64 - melp->bits); //push up
+    }
+
+    /////////////////////////////////////////////////////////////////////////
+    static inline
+    int mel_get_run(mel_struct *melp)
+    {
+      if (melp->num_runs == 0)
+        mel_decode(melp);
+
+      int t = melp->runs & 0x7F;
+      melp->runs >>= 7;
+      melp->num_runs--;
+      return t;
+    }
+
+    /////////////////////////////////////////////////////////////////////////
+    //
+    /////////////////////////////////////////////////////////////////////////
+    struct rev_struct {
+      //storage
+      ui8* data;     //pointer to where to read data
+      ui64 tmp;		   //temporary buffer of read data
+      int bits;      //number of bits stored in tmp
+      int size;
+      bool unstuff;  //true if a bit needs to be unstuffed
+    };
+
+    /////////////////////////////////////////////////////////////////////////
+    static inline void rev_read(rev_struct *vlcp)
+    {
+      //process 4 bytes at a time
+      if (vlcp->bits > 32)
+        return;
+      ui32 val;
+      val = *(ui32*)vlcp->data;
+      vlcp->data -= 4;
+
+      //accumulate in int and then push into the registers
+      ui32 tmp = val >> 24;
+      int bits;
+      bits = 8 - ((vlcp->unstuff && (((val >> 24) & 0x7F) == 0x7F)) ? 1 : 0);
+      bool unstuff = (val >> 24) > 0x8F;
+
+      tmp |= ((val >> 16) & 0xFF) << bits;
+      bits += 8 - ((unstuff && (((val >> 16) & 0x7F) == 0x7F)) ? 1 : 0);
+      unstuff = ((val >> 16) & 0xFF) > 0x8F;
+
+      tmp |= ((val >> 8) & 0xFF) << bits;
+      bits += 8 - ((unstuff && (((val >> 8) & 0x7F) == 0x7F)) ? 1 : 0);
+      unstuff = ((val >> 8) & 0xFF) > 0x8F;
+
+      tmp |= (val & 0xFF) << bits;
+      bits += 8 - ((unstuff && ((val & 0x7F) == 0x7F)) ? 1 : 0);
+      unstuff = (val & 0xFF) > 0x8F;
+
+      vlcp->tmp |= (ui64)tmp << vlcp->bits;
+      vlcp->bits += bits;
+      vlcp->unstuff = unstuff;
+
+      vlcp->size -= 4;
+      //because we read ahead of time, we might in fact exceed vlc size,
+      // but data should not be used if the codeblock is properly generated
+      //The mel code can in fact occupy zero length, if it has a small number
+      // of bits and these bits overlap with the VLC code
+      if (vlcp->size < -8) //8 is based on the fact that we may read 64 bits
+        OJPH_ERROR(0x00010001, "Error in reading VLC data");
+    }
+
+    /////////////////////////////////////////////////////////////////////////
+    static inline void rev_init(rev_struct *vlcp, ui8* data, int lcup, int scup)
+    {
+      //first byte has only the upper 4 bits
+      vlcp->data = data + lcup - 2;
+
+      //size can not be larger than this, in fact it should be smaller
+      vlcp->size = scup - 2;
+
+      int d = *vlcp->data--;
+      vlcp->tmp = d >> 4; //both initialize and set
+      vlcp->bits = 4 - ((vlcp->tmp & 7) == 7);
+      vlcp->unstuff = (d | 0xF) > 0x8F;
+
+      //These few lines take care of the case where data is not at a multiple
+      // of 4 boundary.  It reads at 1,2,3 up to 4 bytes from the vlc stream
+      int num = 1 + (intptr_t(vlcp->data) & 0x3);
+      int tnum = num < vlcp->size ? num : vlcp->size;
+      for (int i = 0; i < tnum; ++i) {
+        ui64 d;
+        d = *vlcp->data--;
+        int d_bits = 8 - ((vlcp->unstuff && ((d & 0x7F) == 0x7F)) ? 1 : 0);
+        vlcp->tmp |= d << vlcp->bits;
+        vlcp->bits += d_bits;
+        vlcp->unstuff = d > 0x8F;
+      }
+      vlcp->data -= 3; //make ready to read a 32 bits
+      rev_read(vlcp);
+    }
+
+    /////////////////////////////////////////////////////////////////////////
+    static inline ui32 rev_fetch(rev_struct *vlcp)
+    {
+      if (vlcp->bits < 32)
+      {
+        rev_read(vlcp);
+        if (vlcp->bits < 32)
+          rev_read(vlcp);
+      }
+      return (ui32)vlcp->tmp;
+    }
+
+    /////////////////////////////////////////////////////////////////////////
+    static inline ui32 rev_advance(rev_struct *vlcp, int num_bits)
+    {
+      assert(num_bits <= vlcp->bits);
+      vlcp->tmp >>= num_bits;
+      vlcp->bits -= num_bits;
+      return (ui32)vlcp->tmp;
+    }
+
+    /////////////////////////////////////////////////////////////////////////
+    static inline int decode_init_uvlc(ui32 vlc, ui32 mode, int *u)
+    {
+      //table stores possible decoding three bits from vlc
+      // there are 8 entries for xx1, x10, 100, 000
+      // 2 bits for prefix length
+      // 3 bits for suffix length
+      // 3 bits for prefix value
+      static const ui8 dec[8] = {
+        3 | (5 << 2) | (5 << 5), //000 == 000
+        1 | (0 << 2) | (1 << 5), //001 == xx1
+        2 | (0 << 2) | (2 << 5), //010 == x10
+        1 | (0 << 2) | (1 << 5), //011 == xx1
+        3 | (1 << 2) | (3 << 5), //100 == 100
+        1 | (0 << 2) | (1 << 5), //101 == xx1
+        2 | (0 << 2) | (2 << 5), //110 == x10
+        1 | (0 << 2) | (1 << 5)  //111 == xx1
+      };
+
+      int consumed_bits = 0;
+      if (mode == 0)
+      {
+        u[0] = u[1] = 1; //Kappa is 1 for initial line
+      }
+      else if (mode <= 2)
+      {
+        int d = dec[vlc & 0x7];
+        vlc >>= d & 0x3;
+        consumed_bits += d & 0x3;
+
+        int suffix_len = ((d >> 2) & 0x7);
+        consumed_bits += suffix_len;
+
+        d = (d >> 5) + (vlc & ((1 << suffix_len) - 1));
+        u[0] = (mode == 1) ? d + 1 : 1; //Kappa is 1 for initial line
+        u[1] = (mode == 1) ? 1 : d + 1; //Kappa is 1 for initial line
+      }
+      else if (mode == 3)
+      {
+        int d1 = dec[vlc & 0x7];
+        vlc >>= d1 & 0x3;
+        consumed_bits += d1 & 0x3;
+
+        if ((d1 & 0x3) > 2)
+        {
+          //u_{q_2} prefix
+          u[1] = (vlc & 1) + 1 + 1; //Kappa is 1 for initial line
+          ++consumed_bits;
+          vlc >>= 1;
+
+          int suffix_len = ((d1 >> 2) & 0x7);
+          consumed_bits += suffix_len;
+          d1 = (d1 >> 5) + (vlc & ((1 << suffix_len) - 1));
+          u[0] = d1 + 1; //Kappa is 1 for initial line
+        }
+        else
+        {
+          int d2 = dec[vlc & 0x7];
+          vlc >>= d2 & 0x3;
+          consumed_bits += d2 & 0x3;
+
+          int suffix_len = ((d1 >> 2) & 0x7);
+          consumed_bits += suffix_len;
+
+          d1 = (d1 >> 5) + (vlc & ((1 << suffix_len) - 1));
+          u[0] = d1 + 1; //Kappa is 1 for initial line
+          vlc >>= suffix_len;
+
+          suffix_len = ((d2 >> 2) & 0x7);
+          consumed_bits += suffix_len;
+
+          d2 = (d2 >> 5) + (vlc & ((1 << suffix_len) - 1));
+          u[1] = d2 + 1; //Kappa is 1 for initial line
+        }
+      }
+      else if (mode == 4)
+      {
+        int d1 = dec[vlc & 0x7];
+        vlc >>= d1 & 0x3;
+        consumed_bits += d1 & 0x3;
+
+        int d2 = dec[vlc & 0x7];
+        vlc >>= d2 & 0x3;
+        consumed_bits += d2 & 0x3;
+
+        int suffix_len = ((d1 >> 2) & 0x7);
+        consumed_bits += suffix_len;
+
+        d1 = (d1 >> 5) + (vlc & ((1 << suffix_len) - 1));
+        u[0] = d1 + 3; //Kappa is 1 for initial line
+        vlc >>= suffix_len;
+
+        suffix_len = ((d2 >> 2) & 0x7);
+        consumed_bits += suffix_len;
+
+        d2 = (d2 >> 5) + (vlc & ((1 << suffix_len) - 1));
+        u[1] = d2 + 3; //Kappa is 1 for initial line
+      }
+      return consumed_bits;
+    }
+
+    /////////////////////////////////////////////////////////////////////////
+    static inline int decode_noninit_uvlc(ui32 vlc, ui32 mode, int *u)
+    {
+      //table stores possible decoding three bits from vlc
+      // there are 8 entries for xx1, x10, 100, 000
+      // 2 bits for prefix length
+      // 3 bits for suffix length
+      // 3 bits for prefix value
+      static const ui8 dec[8] = {
+        3 | (5 << 2) | (5 << 5), //000 == 000
+        1 | (0 << 2) | (1 << 5), //001 == xx1
+        2 | (0 << 2) | (2 << 5), //010 == x10
+        1 | (0 << 2) | (1 << 5), //011 == xx1
+        3 | (1 << 2) | (3 << 5), //100 == 100
+        1 | (0 << 2) | (1 << 5), //101 == xx1
+        2 | (0 << 2) | (2 << 5), //110 == x10
+        1 | (0 << 2) | (1 << 5)  //111 == xx1
+      };
+
+      int consumed_bits = 0;
+      if (mode == 0)
+      {
+        u[0] = u[1] = 1; //for kappa
+      }
+      else if (mode <= 2)
+      {
+        int d = dec[vlc & 0x7];
+        vlc >>= d & 0x3;
+        consumed_bits += d & 0x3;
+
+        int suffix_len = ((d >> 2) & 0x7);
+        consumed_bits += suffix_len;
+
+        d = (d >> 5) + (vlc & ((1 << suffix_len) - 1));
+        u[0] = (mode == 1) ? d + 1 : 1; //for kappa
+        u[1] = (mode == 1) ? 1 : d + 1; //for kappa
+      }
+      else if (mode == 3)
+      {
+        int d1 = dec[vlc & 0x7];
+        vlc >>= d1 & 0x3;
+        consumed_bits += d1 & 0x3;
+
+        int d2 = dec[vlc & 0x7];
+        vlc >>= d2 & 0x3;
+        consumed_bits += d2 & 0x3;
+
+        int suffix_len = ((d1 >> 2) & 0x7);
+        consumed_bits += suffix_len;
+
+        d1 = (d1 >> 5) + (vlc & ((1 << suffix_len) - 1));
+        u[0] = d1 + 1;  //for kappa
+        vlc >>= suffix_len;
+
+        suffix_len = ((d2 >> 2) & 0x7);
+        consumed_bits += suffix_len;
+
+        d2 = (d2 >> 5) + (vlc & ((1 << suffix_len) - 1));
+        u[1] = d2 + 1;  //for kappa
+      }
+      return consumed_bits;
+    }
+
+
+  }
+}
+
+#endif // !OJPH_BLOCK_DECODER_STREAMS_H
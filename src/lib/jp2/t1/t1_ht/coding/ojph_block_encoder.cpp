@@ -466,9 +466,19 @@ namespace ojph {
                                int width, int height, int stride,
                                int* lengths,
                                ojph::mem_elastic_allocator *elastic,
-                               ojph::coded_lists *& coded)
+                               ojph::coded_lists *& coded,
+                               const row_source *rows)
     {
       assert(num_passes == 1);
+      assert(width <= 1024);
+      //two rows of samples, when they come from rows
+      si32 line[2 * 1024];
+      if (rows)
+      {
+        rows->get_rows(rows->ctx, 0, line, width);
+        buf = line;
+        stride = width;
+      }
       const int ms_size = 16384;         //more than enough
       ui8 ms_buf[ms_size];
       const int mel_vlc_size = 3072;     //more than enough
@@ -723,7 +733,13 @@ namespace ojph {
         c_q0 = lcxp[0] + (lcxp[1] << 2);
         lcxp[0] = 0;
 
-        sp = buf + y * stride;
+        if (rows)
+        {
+          rows->get_rows(rows->ctx, y, line, width);
+          sp = line;
+        }
+        else
+          sp = buf + y * stride;
         for (int x = 0; x < width; x += 4)
         {
           //prepare two quads
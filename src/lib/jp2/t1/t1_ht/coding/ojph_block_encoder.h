@@ -51,11 +51,24 @@ namespace ojph {
   namespace local {
 
     //////////////////////////////////////////////////////////////////////////
+    //supplies the samples of a code block two rows at a time, just before
+    // the encoder codes them, so that they need not be stored in full
+    struct row_source
+    {
+      //write rows y and y + 1 of the code block to line, the second row
+      // width samples after the first; y + 1 may be past the last row
+      void (*get_rows)(const void *ctx, int y, si32 *line, int width);
+      const void *ctx;
+    };
+
+    //////////////////////////////////////////////////////////////////////////
+    //the samples come from buf, or from rows when it is not null
     void
       ojph_encode_codeblock(si32* buf, int missing_msbs, int num_passes,
                             int width, int height, int stride,
                             int* lengths, ojph::mem_elastic_allocator *elastic,
-                            ojph::coded_lists *& coded);
+                            ojph::coded_lists *& coded,
+                            const row_source *rows = nullptr);
   }
 }
 
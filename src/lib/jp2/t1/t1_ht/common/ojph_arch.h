@@ -117,7 +117,7 @@ namespace ojph {
   #ifdef OJPH_COMPILER_MSVC
     unsigned long result = 0;
     _BitScanForward(&result, val);
-    return (ui32)(31 ^ result);
+    return (ui32)result;
   #elif (defined OJPH_COMPILER_GNUC)
     return __builtin_ctz(val);
   #else
@@ -196,6 +196,11 @@ namespace ojph {
 
     void get_buffer(int needed_bytes, coded_lists*& p);
 
+    // invalidate all buffers handed out so far, and keep the first
+    // store for reuse instead of growing for as long as the allocator
+    // lives
+    void restart();
+
   private:
     struct stores_list
     {
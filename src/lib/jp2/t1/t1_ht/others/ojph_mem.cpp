@@ -118,4 +118,21 @@ namespace ojph {
     cur_store->data += extended_bytes;
   }
 
+  ////////////////////////////////////////////////////////////////////////////
+  void mem_elastic_allocator::restart()
+  {
+    if (store == NULL)
+      return;
+
+    stores_list* t = store->next_store;
+    while (t) {
+      stores_list* next = t->next_store;
+      free(t);
+      t = next;
+    }
+    int bytes = (int)(store->data - (char*)store) + store->available;
+    cur_store = store = new (store) stores_list(bytes);
+    total_allocated = bytes;
+  }
+
 }
@@ -141,25 +141,32 @@ bool T1Part1::decode(decodeBlockInfo *block) {
 		return true;
 
 	auto min_buf_vec = &cblk->seg_buffers;
-	uint16_t total_seg_len = (uint16_t) (min_buf_vec->get_len() + GRK_FAKE_MARKER_BYTES);
-	if (t1->cblkdatabuffersize < total_seg_len) {
-		uint8_t *new_block = (uint8_t*) grok_realloc(t1->cblkdatabuffer,
-				total_seg_len);
-		if (!new_block)
-			return false;
-		t1->cblkdatabuffer = new_block;
-		t1->cblkdatabuffersize = total_seg_len;
-	}
-	size_t offset = 0;
-	// note: min_buf_vec only contains segments of non-zero length
-	for (int32_t i = 0; i < min_buf_vec->size(); ++i) {
-		grk_buf *seg = (grk_buf*) min_buf_vec->get(i);
-		memcpy(t1->cblkdatabuffer + offset, seg->buf, seg->len);
-		offset += seg->len;
-	}
+	uint16_t total_seg_len = (uint16_t) min_buf_vec->get_len();
 	tcd_seg_data_chunk_t chunk;
-	chunk.len = t1->cblkdatabuffersize;
-	chunk.data = t1->cblkdatabuffer;
+	// the MQ decoder only reads the coded data, so segments that follow on
+	// from each other in the tile part are decoded where they are
+	if (cblk->seg_in_place) {
+		chunk.len = total_seg_len;
+		chunk.data = ((grk_buf*) min_buf_vec->get(0))->buf;
+	} else {
+		if (t1->cblkdatabuffersize < total_seg_len) {
+			uint8_t *new_block = (uint8_t*) grok_realloc(t1->cblkdatabuffer,
+					total_seg_len);
+			if (!new_block)
+				return false;
+			t1->cblkdatabuffer = new_block;
+			t1->cblkdatabuffersize = total_seg_len;
+		}
+		size_t offset = 0;
+		// note: min_buf_vec only contains segments of non-zero length
+		for (int32_t i = 0; i < min_buf_vec->size(); ++i) {
+			grk_buf *seg = (grk_buf*) min_buf_vec->get(i);
+			memcpy(t1->cblkdatabuffer + offset, seg->buf, seg->len);
+			offset += seg->len;
+		}
+		chunk.len = t1->cblkdatabuffersize;
+		chunk.data = t1->cblkdatabuffer;
+	}
 
 	tcd_cblk_dec_t cblkopj;
 	memset(&cblkopj, 0, sizeof(tcd_cblk_dec_t));
@@ -178,7 +185,7 @@ bool T1Part1::decode(decodeBlockInfo *block) {
 		memset(sopj, 0, sizeof(tcd_seg_t));
 		auto sgrk = cblk->segs + i;
 		sopj->len = sgrk->len;
-		sopj->real_num_passes = sgrk->numpasses;
+		sopj->real_num_passes = sgrk->real_num_passes;
 	}
 	cblkopj.segs = segs;
 	// subtract roishift as it was added when packet was parsed
@@ -61,9 +61,6 @@
 namespace grk {
 
 static void mqc_byteout(mqc_t *mqc);
-static void mqc_renorme(mqc_t *mqc);
-static void mqc_codemps(mqc_t *mqc);
-static void mqc_codelps(mqc_t *mqc);
 static void mqc_setbits(mqc_t *mqc);
 static const mqc_state_t mqc_states[47 * 2] = {
     {0x5601, 0, &mqc_states[2], &mqc_states[3]},
@@ -163,76 +160,7 @@ static const mqc_state_t mqc_states[47 * 2] = {
 };
 static void mqc_byteout(mqc_t *mqc)
 {
-    /* bp is initialized to start - 1 in mqc_init_enc() */
-    /* but this is safe, see tcd_code_block_enc_allocate_data() */
-    assert(mqc->bp >= mqc->start - 1);
-    if (*mqc->bp == 0xff) {
-        mqc->bp++;
-        *mqc->bp = (uint8_t)(mqc->c >> 20);
-        mqc->c &= 0xfffff;
-        mqc->ct = 7;
-    } else {
-        if ((mqc->c & 0x8000000) == 0) {
-            mqc->bp++;
-            *mqc->bp = (uint8_t)(mqc->c >> 19);
-            mqc->c &= 0x7ffff;
-            mqc->ct = 8;
-        } else {
-            (*mqc->bp)++;
-            if (*mqc->bp == 0xff) {
-                mqc->c &= 0x7ffffff;
-                mqc->bp++;
-                *mqc->bp = (uint8_t)(mqc->c >> 20);
-                mqc->c &= 0xfffff;
-                mqc->ct = 7;
-            } else {
-                mqc->bp++;
-                *mqc->bp = (uint8_t)(mqc->c >> 19);
-                mqc->c &= 0x7ffff;
-                mqc->ct = 8;
-            }
-        }
-    }
-}
-
-static void mqc_renorme(mqc_t *mqc)
-{
-    do {
-        mqc->a <<= 1;
-        mqc->c <<= 1;
-        mqc->ct--;
-        if (mqc->ct == 0) {
-            mqc_byteout(mqc);
-        }
-    } while ((mqc->a & 0x8000) == 0);
-}
-
-static void mqc_codemps(mqc_t *mqc)
-{
-    mqc->a -= (*mqc->curctx)->qeval;
-    if ((mqc->a & 0x8000) == 0) {
-        if (mqc->a < (*mqc->curctx)->qeval) {
-            mqc->a = (*mqc->curctx)->qeval;
-        } else {
-            mqc->c += (*mqc->curctx)->qeval;
-        }
-        *mqc->curctx = (*mqc->curctx)->nmps;
-        mqc_renorme(mqc);
-    } else {
-        mqc->c += (*mqc->curctx)->qeval;
-    }
-}
-
-static void mqc_codelps(mqc_t *mqc)
-{
-    mqc->a -= (*mqc->curctx)->qeval;
-    if (mqc->a < (*mqc->curctx)->qeval) {
-        mqc->c += (*mqc->curctx)->qeval;
-    } else {
-        mqc->a = (*mqc->curctx)->qeval;
-    }
-    *mqc->curctx = (*mqc->curctx)->nlps;
-    mqc_renorme(mqc);
+    mqc_byteout_macro(mqc, mqc->c, mqc->ct);
 }
 
 static void mqc_setbits(mqc_t *mqc)
@@ -277,11 +205,7 @@ void mqc_init_enc(mqc_t *mqc, uint8_t *bp)
 
 void mqc_encode(mqc_t *mqc, uint32_t d)
 {
-    if ((*mqc->curctx)->mps == d) {
-        mqc_codemps(mqc);
-    } else {
-        mqc_codelps(mqc);
-    }
+    mqc_encode_macro(mqc, mqc->curctx, mqc->a, mqc->c, mqc->ct, d);
 }
 
 void mqc_flush(mqc_t *mqc)
@@ -301,8 +225,6 @@ void mqc_flush(mqc_t *mqc)
     }
 }
 
-#define BYPASS_CT_INIT  0xDEADBEEF
-
 void mqc_bypass_init_enc(mqc_t *mqc)
 {
     /* This function is normally called after at least one mqc_flush() */
@@ -323,21 +245,7 @@ void mqc_bypass_init_enc(mqc_t *mqc)
 
 void mqc_bypass_enc(mqc_t *mqc, uint32_t d)
 {
-    if (mqc->ct == BYPASS_CT_INIT) {
-        mqc->ct = 8;
-    }
-    mqc->ct--;
-    mqc->c = mqc->c + (d << mqc->ct);
-    if (mqc->ct == 0) {
-        *mqc->bp = (uint8_t)mqc->c;
-        mqc->ct = 8;
-        /* If the previous byte was 0xff, make sure that the next msb is 0 */
-        if (*mqc->bp == 0xff) {
-            mqc->ct = 7;
-        }
-        mqc->bp++;
-        mqc->c = 0;
-    }
+    mqc_bypass_enc_macro(mqc, mqc->c, mqc->ct, d);
 }
 
 uint32_t mqc_bypass_get_extra_bytes(mqc_t *mqc, bool erterm)
@@ -439,32 +347,23 @@ void mqc_segmark_enc(mqc_t *mqc)
 
 static void mqc_init_dec_common(mqc_t *mqc,
                                     uint8_t *bp,
-                                    uint32_t len,
-                                    uint32_t extra_writable_bytes)
+                                    uint32_t len)
 {
-    (void)extra_writable_bytes;
-
-    assert(extra_writable_bytes >= GRK_FAKE_MARKER_BYTES);
+    /* No artificial 0xFF 0xFF marker is written after the data: the */
+    /* bytein routines compare bp with end instead, so that code blocks */
+    /* can be decoded in place in a tile part that other threads read */
     mqc->start = bp;
     mqc->end = bp + len;
-    /* Insert an artificial 0xFF 0xFF marker at end of the code block */
-    /* data so that the bytein routines stop on it. This saves us comparing */
-    /* the bp and end pointers */
-    /* But before inserting it, backup th bytes we will overwrite */
-    memcpy(mqc->backup, mqc->end, GRK_FAKE_MARKER_BYTES);
-    mqc->end[0] = 0xFF;
-    mqc->end[1] = 0xFF;
     mqc->bp = bp;
 }
-void mqc_init_dec(mqc_t *mqc, uint8_t *bp, uint32_t len,
-                      uint32_t extra_writable_bytes)
+void mqc_init_dec(mqc_t *mqc, uint8_t *bp, uint32_t len)
 {
     /* Implements ISO 15444-1 C.3.5 Initialization of the decoder (INITDEC) */
     /* Note: alternate "J.1 - Initialization of the software-conventions */
     /* decoder" has been tried, but does */
     /* not bring any improvement. */
     /* See https://github.com/uclouvain/openjpeg/issues/921 */
-    mqc_init_dec_common(mqc, bp, len, extra_writable_bytes);
+    mqc_init_dec_common(mqc, bp, len);
     mqc_setcurctx(mqc, 0);
     mqc->end_of_byte_stream_counter = 0;
     if (len == 0) {
@@ -479,20 +378,13 @@ void mqc_init_dec(mqc_t *mqc, uint8_t *bp, uint32_t len,
     mqc->a = 0x8000;
 }
 
-void mqc_raw_init_dec(mqc_t *mqc, uint8_t *bp, uint32_t len,
-                          uint32_t extra_writable_bytes)
+void mqc_raw_init_dec(mqc_t *mqc, uint8_t *bp, uint32_t len)
 {
-    mqc_init_dec_common(mqc, bp, len, extra_writable_bytes);
+    mqc_init_dec_common(mqc, bp, len);
     mqc->c = 0;
     mqc->ct = 0;
 }
 
-void opq_mqc_finish_dec(mqc_t *mqc)
-{
-    /* Restore the bytes overwritten by mqc_init_dec_common() */
-    memcpy(mqc->end, mqc->backup, GRK_FAKE_MARKER_BYTES);
-}
-
 void mqc_resetstates(mqc_t *mqc)
 {
     uint32_t i;
@@ -92,8 +92,6 @@ typedef struct mqc {
     const mqc_state_t **curctx;
     /* lut_ctxno_zc shifted by (1 << 9) * bandno */
     const uint8_t* lut_ctxno_zc_orient;
-    /** Original value of the 2 bytes at end[0] and end[1] */
-    uint8_t backup[GRK_FAKE_MARKER_BYTES];
 } mqc_t;
 
 #include "mqc_inl.h"
@@ -117,54 +115,25 @@ void mqc_segmark_enc(mqc_t *mqc);
 /**
 Initialize the decoder for MQ decoding.
 
-mqc_finish_dec() must be absolutely called after finishing the decoding
-passes, so as to restore the bytes temporarily overwritten.
+The decoder only reads the buffer: past its end, it reads 0xFF bytes,
+as if the data were followed by a 0xFF 0xFF marker. So the buffer may
+be shared with other threads, and may be read-only.
 
 @param mqc MQC handle
 @param bp Pointer to the start of the buffer from which the bytes will be read
-          Note that OPJ_COMMON_CBLK_DATA_EXTRA bytes at the end of the buffer
-          will be temporarily overwritten with an artificial 0xFF 0xFF marker.
-          (they will be backuped in the mqc structure to be restored later)
-          So bp must be at least len + OPJ_COMMON_CBLK_DATA_EXTRA large, and
-          writable.
 @param len Length of the input buffer
-@param extra_writable_bytes Indicate how many bytes after len are writable.
-                            This is to indicate your consent that bp must be
-                            large enough.
 */
-void mqc_init_dec(mqc_t *mqc, uint8_t *bp, uint32_t len,
-                      uint32_t extra_writable_bytes);
+void mqc_init_dec(mqc_t *mqc, uint8_t *bp, uint32_t len);
 
 /**
 Initialize the decoder for RAW decoding.
 
-mqc_finish_dec() must be absolutely called after finishing the decoding
-passes, so as to restore the bytes temporarily overwritten.
+As with mqc_init_dec(), the buffer is only read.
 
 @param mqc MQC handle
 @param bp Pointer to the start of the buffer from which the bytes will be read
-          Note that OPJ_COMMON_CBLK_DATA_EXTRA bytes at the end of the buffer
-          will be temporarily overwritten with an artificial 0xFF 0xFF marker.
-          (they will be backuped in the mqc structure to be restored later)
-          So bp must be at least len + OPJ_COMMON_CBLK_DATA_EXTRA large, and
-          writable.
 @param len Length of the input buffer
-@param extra_writable_bytes Indicate how many bytes after len are writable.
-                            This is to indicate your consent that bp must be
-                            large enough.
 */
-void mqc_raw_init_dec(mqc_t *mqc, uint8_t *bp, uint32_t len,
-                          uint32_t extra_writable_bytes);
-
-
-/**
-Terminate RAW/MQC decoding
-
-This restores the bytes temporarily overwritten by mqc_init_dec()/
-mqc_raw_init_dec()
-
-@param mqc MQC handle
-*/
-void opq_mqc_finish_dec(mqc_t *mqc);
+void mqc_raw_init_dec(mqc_t *mqc, uint8_t *bp, uint32_t len);
 
 }
@@ -93,19 +93,20 @@ static INLINE uint32_t mqc_raw_decode(mqc_t *mqc)
 {
     uint32_t d;
     if (mqc->ct == 0) {
-        /* Given mqc_raw_init_dec() we know that at some point we will */
-        /* have a 0xFF 0xFF artificial marker */
+        /* Past the end of the data, read 0xFF bytes, as if there were */
+        /* a 0xFF 0xFF marker */
+        uint32_t l_c = mqc->bp < mqc->end ? *mqc->bp : 0xff;
         if (mqc->c == 0xff) {
-            if (*mqc->bp  > 0x8f) {
+            if (l_c > 0x8f) {
                 mqc->c = 0xff;
                 mqc->ct = 8;
             } else {
-                mqc->c = *mqc->bp;
+                mqc->c = l_c;
                 mqc->bp ++;
                 mqc->ct = 7;
             }
         } else {
-            mqc->c = *mqc->bp;
+            mqc->c = l_c;
             mqc->bp ++;
             mqc->ct = 8;
         }
@@ -119,11 +120,17 @@ static INLINE uint32_t mqc_raw_decode(mqc_t *mqc)
 
 #define mqc_bytein_macro(mqc, c, ct) \
 { \
-        uint32_t l_c;  \
-        /* Given mqc_init_dec() we know that at some point we will */ \
-        /* have a 0xFF 0xFF artificial marker */ \
-        l_c = *(mqc->bp + 1); \
-        if (*mqc->bp == 0xff) { \
+        uint32_t l_b, l_c;  \
+        /* Past the end of the data, read 0xFF bytes, as if there were */ \
+        /* a 0xFF 0xFF marker */ \
+        if (mqc->bp + 1 < mqc->end) { \
+            l_b = *mqc->bp; \
+            l_c = *(mqc->bp + 1); \
+        } else { \
+            l_b = mqc->bp < mqc->end ? *mqc->bp : 0xff; \
+            l_c = 0xff; \
+        } \
+        if (l_b == 0xff) { \
             if (l_c > 0x8f) { \
                 c += 0xff00; \
                 ct = 8; \
@@ -174,6 +181,146 @@ static INLINE uint32_t mqc_raw_decode(mqc_t *mqc)
     } \
 }
 
+/**
+Number of bits that a renormalization of the encoder shifts out of a,
+that is the number of leading zeros of the 16 bit register a (0 < a < 0x8000)
+*/
+static INLINE uint32_t mqc_renorme_shift(uint32_t a)
+{
+#if defined(__GNUC__)
+    return (uint32_t)__builtin_clz(a) - 16U;
+#else
+    uint32_t n = 0;
+    while ((a & 0x8000) == 0) {
+        a <<= 1;
+        n++;
+    }
+    return n;
+#endif
+}
+
+/* For internal use of mqc_renorme_macro(): output a byte, with bit stuffing */
+/* after a 0xff byte. bp is initialized to start - 1 in mqc_init_enc(), but */
+/* this is safe, see tcd_code_block_enc_allocate_data() */
+#define mqc_byteout_macro(mqc, c, ct) \
+{ \
+    assert((mqc)->bp >= (mqc)->start - 1); \
+    if (*(mqc)->bp == 0xff) { \
+        (mqc)->bp++; \
+        *(mqc)->bp = (uint8_t)(c >> 20); \
+        c &= 0xfffff; \
+        ct = 7; \
+    } else { \
+        if ((c & 0x8000000) == 0) { \
+            (mqc)->bp++; \
+            *(mqc)->bp = (uint8_t)(c >> 19); \
+            c &= 0x7ffff; \
+            ct = 8; \
+        } else { \
+            (*(mqc)->bp)++; \
+            if (*(mqc)->bp == 0xff) { \
+                c &= 0x7ffffff; \
+                (mqc)->bp++; \
+                *(mqc)->bp = (uint8_t)(c >> 20); \
+                c &= 0xfffff; \
+                ct = 7; \
+            } else { \
+                (mqc)->bp++; \
+                *(mqc)->bp = (uint8_t)(c >> 19); \
+                c &= 0x7ffff; \
+                ct = 8; \
+            } \
+        } \
+    } \
+}
+
+/* For internal use of mqc_encode_macro(). Rather than shifting a and c */
+/* one bit at a time, shift them by all the bits left before the next byte */
+/* out, or by all the bits a needs, which gives the same register state */
+#define mqc_renorme_macro(mqc, a, c, ct) \
+{ \
+    uint32_t ns = mqc_renorme_shift(a); \
+    while (ns >= ct) { \
+        a <<= ct; \
+        c <<= ct; \
+        ns -= ct; \
+        mqc_byteout_macro(mqc, c, ct); \
+    } \
+    a <<= ns; \
+    c <<= ns; \
+    ct -= ns; \
+}
+
+/* For internal use of mqc_encode_macro() */
+#define mqc_codemps_macro(mqc, curctx, a, c, ct) \
+{ \
+    a -= (*curctx)->qeval; \
+    if ((a & 0x8000) == 0) { \
+        if (a < (*curctx)->qeval) { \
+            a = (*curctx)->qeval; \
+        } else { \
+            c += (*curctx)->qeval; \
+        } \
+        *curctx = (*curctx)->nmps; \
+        mqc_renorme_macro(mqc, a, c, ct); \
+    } else { \
+        c += (*curctx)->qeval; \
+    } \
+}
+
+/* For internal use of mqc_encode_macro() */
+#define mqc_codelps_macro(mqc, curctx, a, c, ct) \
+{ \
+    a -= (*curctx)->qeval; \
+    if (a < (*curctx)->qeval) { \
+        c += (*curctx)->qeval; \
+    } else { \
+        a = (*curctx)->qeval; \
+    } \
+    *curctx = (*curctx)->nlps; \
+    mqc_renorme_macro(mqc, a, c, ct); \
+}
+
+/**
+Encode a symbol with the coder state held in the caller's a, c, ct and
+curctx, which the T1 coding passes keep in registers from one symbol to
+the next (see DOWNLOAD_MQC_VARIABLES)
+*/
+#define mqc_encode_macro(mqc, curctx, a, c, ct, d) \
+{ \
+    if ((*curctx)->mps == (d)) { \
+        mqc_codemps_macro(mqc, curctx, a, c, ct); \
+    } else { \
+        mqc_codelps_macro(mqc, curctx, a, c, ct); \
+    } \
+}
+
+/* ct value that tells mqc_bypass_enc_macro() it has not been called */
+/* since mqc_bypass_init_enc() */
+#define BYPASS_CT_INIT  0xDEADBEEF
+
+/**
+Encode a symbol in bypass (raw) mode, with the c and ct of the caller
+*/
+#define mqc_bypass_enc_macro(mqc, c, ct, d) \
+{ \
+    if (ct == BYPASS_CT_INIT) { \
+        ct = 8; \
+    } \
+    ct--; \
+    c = c + ((d) << ct); \
+    if (ct == 0) { \
+        *(mqc)->bp = (uint8_t)c; \
+        ct = 8; \
+        /* If the previous byte was 0xff, make sure that the next msb is 0 */ \
+        if (*(mqc)->bp == 0xff) { \
+            ct = 7; \
+        } \
+        (mqc)->bp++; \
+        c = 0; \
+    } \
+}
+
 #define DOWNLOAD_MQC_VARIABLES(mqc, curctx, c, a, ct) \
          const mqc_state_t **curctx = mqc->curctx; \
          uint32_t c = mqc->c; \
@@ -220,52 +220,43 @@ static INLINE void t1_update_flags(opj_flag_t *flagsp, uint32_t ci,
 	t1_update_flags_macro(*flagsp, flagsp, ci, s, stride, vsc);
 }
 
-static INLINE void t1_enc_sigpass_step(t1_t *t1, opj_flag_t *flagsp,
-		int32_t *datap, int32_t bpno, int32_t one, int32_t *nmsedec,
-		uint8_t type, uint32_t ci, uint32_t vsc) {
-	uint32_t v;
-
-	mqc_t *mqc = &(t1->mqc); /* MQC component */
-
-	uint32_t const flags = *flagsp;
-
-	if ((flags & ((T1_SIGMA_THIS | T1_PI_THIS) << (ci * 3U))) == 0U
-			&& (flags & (T1_SIGMA_NEIGHBOURS << (ci * 3U))) != 0U) {
-		uint32_t ctxt1 = t1_getctxno_zc(mqc, flags >> (ci * 3U));
-		v = (opj_int_abs(*datap) & one) ? 1 : 0;
-#ifdef DEBUG_ENC_SIG
-        fprintf(stderr, "   ctxt1=%d\n", ctxt1);
-#endif
-		mqc_setcurctx(mqc, ctxt1);
-		if (type == T1_TYPE_RAW) { /* BYPASS/LAZY MODE */
-			mqc_bypass_enc(mqc, v);
-		} else {
-			mqc_encode(mqc, v);
-		}
-		if (v) {
-			uint32_t lu = t1_getctxtno_sc_or_spb_index(*flagsp,
-					flagsp[-1], flagsp[1], ci);
-			uint32_t ctxt2 = t1_getctxno_sc(lu);
-			v = *datap < 0 ? 1U : 0U;
-			*nmsedec += t1_getnmsedec_sig((uint32_t) opj_int_abs(*datap),
-					(uint32_t) bpno);
-#ifdef DEBUG_ENC_SIG
-            fprintf(stderr, "   ctxt2=%d\n", ctxt2);
-#endif
-			mqc_setcurctx(mqc, ctxt2);
-			if (type == T1_TYPE_RAW) { /* BYPASS/LAZY MODE */
-				mqc_bypass_enc(mqc, v);
-			} else {
-				uint32_t spb = t1_getspb(lu);
-#ifdef DEBUG_ENC_SIG
-                fprintf(stderr, "   spb=%d\n", spb);
-#endif
-				mqc_encode(mqc, v ^ spb);
-			}
-			t1_update_flags(flagsp, ci, v, t1->w + 2, vsc);
-		}
-		*flagsp |= T1_PI_THIS << (ci * 3U);
-	}
+/**
+ Encode one sample of the significance propagation pass, with the MQ coder
+ state held in the caller's curctx, a, c and ct
+ */
+#define t1_enc_sigpass_step_macro(mqc, curctx, a, c, ct, flagsp, datap, \
+                                  bpno, one, nmsedec, type, ci, vsc) \
+{ \
+	uint32_t v; \
+	uint32_t const flags = *flagsp; \
+	if ((flags & ((T1_SIGMA_THIS | T1_PI_THIS) << ((ci) * 3U))) == 0U \
+			&& (flags & (T1_SIGMA_NEIGHBOURS << ((ci) * 3U))) != 0U) { \
+		uint32_t ctxt1 = t1_getctxno_zc(mqc, flags >> ((ci) * 3U)); \
+		v = (opj_int_abs(*(datap)) & one) ? 1 : 0; \
+		t1_setcurctx(curctx, ctxt1); \
+		if (type == T1_TYPE_RAW) { /* BYPASS/LAZY MODE */ \
+			mqc_bypass_enc_macro(mqc, c, ct, v); \
+		} else { \
+			mqc_encode_macro(mqc, curctx, a, c, ct, v); \
+		} \
+		if (v) { \
+			uint32_t lu = t1_getctxtno_sc_or_spb_index(*flagsp, \
+					flagsp[-1], flagsp[1], ci); \
+			uint32_t ctxt2 = t1_getctxno_sc(lu); \
+			v = *(datap) < 0 ? 1U : 0U; \
+			nmsedec += t1_getnmsedec_sig((uint32_t) opj_int_abs(*(datap)), \
+					(uint32_t) bpno); \
+			t1_setcurctx(curctx, ctxt2); \
+			if (type == T1_TYPE_RAW) { /* BYPASS/LAZY MODE */ \
+				mqc_bypass_enc_macro(mqc, c, ct, v); \
+			} else { \
+				uint32_t spb = t1_getspb(lu); \
+				mqc_encode_macro(mqc, curctx, a, c, ct, v ^ spb); \
+			} \
+			t1_update_flags(flagsp, ci, v, t1->w + 2, vsc); \
+		} \
+		*flagsp |= T1_PI_THIS << ((ci) * 3U); \
+	} \
 }
 
 static INLINE void t1_dec_sigpass_step_raw(t1_t *t1, opj_flag_t *flagsp,
@@ -328,8 +319,10 @@ static void t1_enc_sigpass(t1_t *t1, int32_t bpno, int32_t *nmsedec,
 	int32_t const one = 1 << (bpno + T1_NMSEDEC_FRACBITS);
 	opj_flag_t *f = &T1_FLAGS(0, 0);
 	uint32_t const extra = 2;
+	int32_t pass_nmsedec = 0;
+	mqc_t *mqc = &(t1->mqc); /* MQC component */
+	DOWNLOAD_MQC_VARIABLES(mqc, curctx, c, a, ct);
 
-	*nmsedec = 0;
 #ifdef DEBUG_ENC_SIG
     fprintf(stderr, "enc_sigpass: bpno=%d\n", bpno);
 #endif
@@ -346,18 +339,18 @@ static void t1_enc_sigpass(t1_t *t1, int32_t bpno, int32_t *nmsedec,
 				f++;
 				continue;
 			}
-			t1_enc_sigpass_step(t1, f,
+			t1_enc_sigpass_step_macro(mqc, curctx, a, c, ct, f,
 					&t1->data[((k + 0) * t1->data_stride) + i], bpno, one,
-					nmsedec, type, 0, cblksty & J2K_CCP_CBLKSTY_VSC);
-			t1_enc_sigpass_step(t1, f,
+					pass_nmsedec, type, 0U, cblksty & J2K_CCP_CBLKSTY_VSC);
+			t1_enc_sigpass_step_macro(mqc, curctx, a, c, ct, f,
 					&t1->data[((k + 1) * t1->data_stride) + i], bpno, one,
-					nmsedec, type, 1, 0);
-			t1_enc_sigpass_step(t1, f,
+					pass_nmsedec, type, 1U, 0U);
+			t1_enc_sigpass_step_macro(mqc, curctx, a, c, ct, f,
 					&t1->data[((k + 2) * t1->data_stride) + i], bpno, one,
-					nmsedec, type, 2, 0);
-			t1_enc_sigpass_step(t1, f,
+					pass_nmsedec, type, 2U, 0U);
+			t1_enc_sigpass_step_macro(mqc, curctx, a, c, ct, f,
 					&t1->data[((k + 3) * t1->data_stride) + i], bpno, one,
-					nmsedec, type, 3, 0);
+					pass_nmsedec, type, 3U, 0U);
 			++f;
 		}
 		f += extra;
@@ -378,14 +371,16 @@ static void t1_enc_sigpass(t1_t *t1, int32_t bpno, int32_t *nmsedec,
 				continue;
 			}
 			for (j = k; j < t1->h; ++j) {
-				t1_enc_sigpass_step(t1, f,
+				t1_enc_sigpass_step_macro(mqc, curctx, a, c, ct, f,
 						&t1->data[(j * t1->data_stride) + i], bpno, one,
-						nmsedec, type, j - k,
+						pass_nmsedec, type, j - k,
 						(j == k && (cblksty & J2K_CCP_CBLKSTY_VSC) != 0));
 			}
 			++f;
 		}
 	}
+	UPLOAD_MQC_VARIABLES(mqc, curctx, c, a, ct);
+	*nmsedec = pass_nmsedec;
 }
 
 static void t1_dec_sigpass_raw(t1_t *t1, int32_t bpno,
@@ -510,31 +505,28 @@ static void t1_dec_sigpass_mqc(t1_t *t1, int32_t bpno,
 	}
 }
 
-static INLINE void t1_enc_refpass_step(t1_t *t1, opj_flag_t *flagsp,
-		int32_t *datap, int32_t bpno, int32_t one, int32_t *nmsedec,
-		uint8_t type, uint32_t ci) {
-	uint32_t v;
-
-	mqc_t *mqc = &(t1->mqc); /* MQC component */
-
-	uint32_t const shift_flags = (*flagsp >> (ci * 3U));
-
-	if ((shift_flags & (T1_SIGMA_THIS | T1_PI_THIS)) == T1_SIGMA_THIS) {
-		uint32_t ctxt = t1_getctxno_mag(shift_flags);
-		*nmsedec += t1_getnmsedec_ref((uint32_t) opj_int_abs(*datap),
-				(uint32_t) bpno);
-		v = (opj_int_abs(*datap) & one) ? 1 : 0;
-#ifdef DEBUG_ENC_REF
-        fprintf(stderr, "  ctxt=%d\n", ctxt);
-#endif
-		mqc_setcurctx(mqc, ctxt);
-		if (type == T1_TYPE_RAW) { /* BYPASS/LAZY MODE */
-			mqc_bypass_enc(mqc, v);
-		} else {
-			mqc_encode(mqc, v);
-		}
-		*flagsp |= T1_MU_THIS << (ci * 3U);
-	}
+/**
+ Encode one sample of the magnitude refinement pass, with the MQ coder
+ state held in the caller's curctx, a, c and ct
+ */
+#define t1_enc_refpass_step_macro(mqc, curctx, a, c, ct, flagsp, datap, \
+                                  bpno, one, nmsedec, type, ci) \
+{ \
+	uint32_t v; \
+	uint32_t const shift_flags = (*flagsp >> ((ci) * 3U)); \
+	if ((shift_flags & (T1_SIGMA_THIS | T1_PI_THIS)) == T1_SIGMA_THIS) { \
+		uint32_t ctxt = t1_getctxno_mag(shift_flags); \
+		nmsedec += t1_getnmsedec_ref((uint32_t) opj_int_abs(*(datap)), \
+				(uint32_t) bpno); \
+		v = (opj_int_abs(*(datap)) & one) ? 1 : 0; \
+		t1_setcurctx(curctx, ctxt); \
+		if (type == T1_TYPE_RAW) { /* BYPASS/LAZY MODE */ \
+			mqc_bypass_enc_macro(mqc, c, ct, v); \
+		} else { \
+			mqc_encode_macro(mqc, curctx, a, c, ct, v); \
+		} \
+		*flagsp |= T1_MU_THIS << ((ci) * 3U); \
+	} \
 }
 
 static INLINE void t1_dec_refpass_step_raw(t1_t *t1, opj_flag_t *flagsp,
@@ -579,8 +571,10 @@ static void t1_enc_refpass(t1_t *t1, int32_t bpno, int32_t *nmsedec,
 	const int32_t one = 1 << (bpno + T1_NMSEDEC_FRACBITS);
 	opj_flag_t *f = &T1_FLAGS(0, 0);
 	const uint32_t extra = 2U;
+	int32_t pass_nmsedec = 0;
+	mqc_t *mqc = &(t1->mqc); /* MQC component */
+	DOWNLOAD_MQC_VARIABLES(mqc, curctx, c, a, ct);
 
-	*nmsedec = 0;
 #ifdef DEBUG_ENC_REF
     fprintf(stderr, "enc_refpass: bpno=%d\n", bpno);
 #endif
@@ -605,18 +599,18 @@ static void t1_enc_refpass(t1_t *t1, int32_t bpno, int32_t *nmsedec,
 				continue;
 			}
 
-			t1_enc_refpass_step(t1, f,
+			t1_enc_refpass_step_macro(mqc, curctx, a, c, ct, f,
 					&t1->data[((k + 0) * t1->data_stride) + i], bpno, one,
-					nmsedec, type, 0);
-			t1_enc_refpass_step(t1, f,
+					pass_nmsedec, type, 0U);
+			t1_enc_refpass_step_macro(mqc, curctx, a, c, ct, f,
 					&t1->data[((k + 1) * t1->data_stride) + i], bpno, one,
-					nmsedec, type, 1);
-			t1_enc_refpass_step(t1, f,
+					pass_nmsedec, type, 1U);
+			t1_enc_refpass_step_macro(mqc, curctx, a, c, ct, f,
 					&t1->data[((k + 2) * t1->data_stride) + i], bpno, one,
-					nmsedec, type, 2);
-			t1_enc_refpass_step(t1, f,
+					pass_nmsedec, type, 2U);
+			t1_enc_refpass_step_macro(mqc, curctx, a, c, ct, f,
 					&t1->data[((k + 3) * t1->data_stride) + i], bpno, one,
-					nmsedec, type, 3);
+					pass_nmsedec, type, 3U);
 			++f;
 		}
 		f += extra;
@@ -638,13 +632,15 @@ static void t1_enc_refpass(t1_t *t1, int32_t bpno, int32_t *nmsedec,
 				continue;
 			}
 			for (j = k; j < t1->h; ++j) {
-				t1_enc_refpass_step(t1, f,
+				t1_enc_refpass_step_macro(mqc, curctx, a, c, ct, f,
 						&t1->data[(j * t1->data_stride) + i], bpno, one,
-						nmsedec, type, j - k);
+						pass_nmsedec, type, j - k);
 			}
 			++f;
 		}
 	}
+	UPLOAD_MQC_VARIABLES(mqc, curctx, c, a, ct);
+	*nmsedec = pass_nmsedec;
 }
 
 static void t1_dec_refpass_raw(t1_t *t1, int32_t bpno) {
@@ -737,75 +733,57 @@ static void t1_dec_refpass_mqc(t1_t *t1, int32_t bpno) {
 	}
 }
 
-static void t1_enc_clnpass_step(t1_t *t1, opj_flag_t *flagsp,
-		int32_t *datap, int32_t bpno, int32_t one, int32_t *nmsedec,
-		uint32_t agg, uint32_t runlen, uint32_t lim, uint32_t cblksty) {
-	uint32_t v;
-	uint32_t ci;
-	mqc_t *mqc = &(t1->mqc); /* MQC component */
-
-	const uint32_t check = (T1_SIGMA_4 | T1_SIGMA_7 | T1_SIGMA_10
-			| T1_SIGMA_13 |
-			T1_PI_0 | T1_PI_1 | T1_PI_2 | T1_PI_3);
-
-	if ((*flagsp & check) == check) {
-		if (runlen == 0) {
-			*flagsp &= ~(T1_PI_0 | T1_PI_1 | T1_PI_2 | T1_PI_3);
-		} else if (runlen == 1) {
-			*flagsp &= ~(T1_PI_1 | T1_PI_2 | T1_PI_3);
-		} else if (runlen == 2) {
-			*flagsp &= ~(T1_PI_2 | T1_PI_3);
-		} else if (runlen == 3) {
-			*flagsp &= ~(T1_PI_3);
-		}
-		return;
-	}
-
-	for (ci = runlen; ci < lim; ++ci) {
-		uint32_t vsc;
-		opj_flag_t flags;
-		uint32_t ctxt1;
-
-		flags = *flagsp;
-
-		if ((agg != 0) && (ci == runlen)) {
-			goto LABEL_PARTIAL;
-		}
-
-		if (!(flags & ((T1_SIGMA_THIS | T1_PI_THIS) << (ci * 3U)))) {
-			ctxt1 = t1_getctxno_zc(mqc, flags >> (ci * 3U));
-#ifdef DEBUG_ENC_CLN
-            printf("   ctxt1=%d\n", ctxt1);
-#endif
-			mqc_setcurctx(mqc, ctxt1);
-			v = (opj_int_abs(*datap) & one) ? 1 : 0;
-			mqc_encode(mqc, v);
-			if (v) {
-				uint32_t ctxt2, spb;
-				uint32_t lu;
-				LABEL_PARTIAL: lu = t1_getctxtno_sc_or_spb_index(*flagsp,
-						flagsp[-1], flagsp[1], ci);
-				*nmsedec += t1_getnmsedec_sig(
-						(uint32_t) opj_int_abs(*datap), (uint32_t) bpno);
-				ctxt2 = t1_getctxno_sc(lu);
-#ifdef DEBUG_ENC_CLN
-                printf("   ctxt2=%d\n", ctxt2);
-#endif
-				mqc_setcurctx(mqc, ctxt2);
-
-				v = *datap < 0 ? 1U : 0U;
-				spb = t1_getspb(lu);
-#ifdef DEBUG_ENC_CLN
-                printf("   spb=%d\n", spb);
-#endif
-				mqc_encode(mqc, v ^ spb);
-				vsc = ((cblksty & J2K_CCP_CBLKSTY_VSC) && (ci == 0)) ? 1 : 0;
-				t1_update_flags(flagsp, ci, v, t1->w + 2U, vsc);
-			}
-		}
-		*flagsp &= ~(T1_PI_THIS << (3U * ci));
-		datap += t1->data_stride;
-	}
+/**
+ Encode a column of the cleanup pass from row runlen to row lim, with the
+ MQ coder state held in the caller's curctx, a, c and ct. When agg is set,
+ the run length coding has already told that row runlen is significant.
+ datap is advanced from row to row.
+ */
+#define t1_enc_clnpass_step_macro(mqc, curctx, a, c, ct, flagsp, datap, \
+                                  bpno, one, nmsedec, agg, runlen, lim, \
+                                  cblksty) \
+{ \
+	const uint32_t check = (T1_SIGMA_4 | T1_SIGMA_7 | T1_SIGMA_10 \
+			| T1_SIGMA_13 | T1_PI_0 | T1_PI_1 | T1_PI_2 | T1_PI_3); \
+	if ((*flagsp & check) == check) { \
+		if (runlen == 0) { \
+			*flagsp &= ~(T1_PI_0 | T1_PI_1 | T1_PI_2 | T1_PI_3); \
+		} else if (runlen == 1) { \
+			*flagsp &= ~(T1_PI_1 | T1_PI_2 | T1_PI_3); \
+		} else if (runlen == 2) { \
+			*flagsp &= ~(T1_PI_2 | T1_PI_3); \
+		} else if (runlen == 3) { \
+			*flagsp &= ~(T1_PI_3); \
+		} \
+	} else { \
+		for (uint32_t ci = runlen; ci < lim; ++ci) { \
+			bool partial = (agg != 0) && (ci == runlen); \
+			if (partial \
+					|| !(*flagsp & ((T1_SIGMA_THIS | T1_PI_THIS) << (ci * 3U)))) { \
+				uint32_t v = 1; \
+				if (!partial) { \
+					uint32_t ctxt1 = t1_getctxno_zc(mqc, *flagsp >> (ci * 3U)); \
+					t1_setcurctx(curctx, ctxt1); \
+					v = (opj_int_abs(*datap) & one) ? 1 : 0; \
+					mqc_encode_macro(mqc, curctx, a, c, ct, v); \
+				} \
+				if (v) { \
+					uint32_t lu = t1_getctxtno_sc_or_spb_index(*flagsp, \
+							flagsp[-1], flagsp[1], ci); \
+					uint32_t spb = t1_getspb(lu); \
+					nmsedec += t1_getnmsedec_sig( \
+							(uint32_t) opj_int_abs(*datap), (uint32_t) bpno); \
+					t1_setcurctx(curctx, t1_getctxno_sc(lu)); \
+					v = *datap < 0 ? 1U : 0U; \
+					mqc_encode_macro(mqc, curctx, a, c, ct, v ^ spb); \
+					t1_update_flags(flagsp, ci, v, t1->w + 2U, \
+							((cblksty & J2K_CCP_CBLKSTY_VSC) && (ci == 0)) ? 1 : 0); \
+				} \
+			} \
+			*flagsp &= ~(T1_PI_THIS << (3U * ci)); \
+			datap += t1->data_stride; \
+		} \
+	} \
 }
 
 #define t1_dec_clnpass_step_macro(check_flags, partial, \
@@ -851,10 +829,10 @@ static void t1_enc_clnpass(t1_t *t1, int32_t bpno, int32_t *nmsedec,
 	uint32_t i, k;
 	const int32_t one = 1 << (bpno + T1_NMSEDEC_FRACBITS);
 	uint32_t agg, runlen;
-
+	int32_t pass_nmsedec = 0;
 	mqc_t *mqc = &(t1->mqc); /* MQC component */
+	DOWNLOAD_MQC_VARIABLES(mqc, curctx, c, a, ct);
 
-	*nmsedec = 0;
 #ifdef DEBUG_ENC_CLN
     printf("enc_clnpass: bpno=%d\n", bpno);
 #endif
@@ -863,10 +841,12 @@ static void t1_enc_clnpass(t1_t *t1, int32_t bpno, int32_t *nmsedec,
         printf(" k=%d\n", k);
 #endif
 		for (i = 0; i < t1->w; ++i) {
+			opj_flag_t *f = &T1_FLAGS(i, k);
+			int32_t *datap;
 #ifdef DEBUG_ENC_CLN
             printf("  i=%d\n", i);
 #endif
-			agg = !(T1_FLAGS(i, k));
+			agg = !(*f);
 #ifdef DEBUG_ENC_CLN
             printf("   agg=%d\n", agg);
 #endif
@@ -878,20 +858,20 @@ static void t1_enc_clnpass(t1_t *t1, int32_t bpno, int32_t *nmsedec,
 						break;
 					}
 				}
-				mqc_setcurctx(mqc, T1_CTXNO_AGG);
-				mqc_encode(mqc, runlen != 4);
+				t1_setcurctx(curctx, T1_CTXNO_AGG);
+				mqc_encode_macro(mqc, curctx, a, c, ct, runlen != 4);
 				if (runlen == 4) {
 					continue;
 				}
-				mqc_setcurctx(mqc, T1_CTXNO_UNI);
-				mqc_encode(mqc, runlen >> 1);
-				mqc_encode(mqc, runlen & 1);
+				t1_setcurctx(curctx, T1_CTXNO_UNI);
+				mqc_encode_macro(mqc, curctx, a, c, ct, runlen >> 1);
+				mqc_encode_macro(mqc, curctx, a, c, ct, runlen & 1);
 			} else {
 				runlen = 0;
 			}
-			t1_enc_clnpass_step(t1, &T1_FLAGS(i, k),
-					&t1->data[((k + runlen) * t1->data_stride) + i], bpno, one,
-					nmsedec, agg, runlen, 4U, cblksty);
+			datap = &t1->data[((k + runlen) * t1->data_stride) + i];
+			t1_enc_clnpass_step_macro(mqc, curctx, a, c, ct, f, datap,
+					bpno, one, pass_nmsedec, agg, runlen, 4U, cblksty);
 		}
 	}
 	if (k < t1->h) {
@@ -901,15 +881,20 @@ static void t1_enc_clnpass(t1_t *t1, int32_t bpno, int32_t *nmsedec,
         printf(" k=%d\n", k);
 #endif
 		for (i = 0; i < t1->w; ++i) {
+			opj_flag_t *f = &T1_FLAGS(i, k);
+			int32_t *datap;
 #ifdef DEBUG_ENC_CLN
             printf("  i=%d\n", i);
             printf("   agg=%d\n", agg);
 #endif
-			t1_enc_clnpass_step(t1, &T1_FLAGS(i, k),
-					&t1->data[((k + runlen) * t1->data_stride) + i], bpno, one,
-					nmsedec, agg, runlen, t1->h - k, cblksty);
+			datap = &t1->data[((k + runlen) * t1->data_stride) + i];
+			t1_enc_clnpass_step_macro(mqc, curctx, a, c, ct, f, datap,
+					bpno, one, pass_nmsedec, agg, runlen, t1->h - k,
+					cblksty);
 		}
 	}
+	UPLOAD_MQC_VARIABLES(mqc, curctx, c, a, ct);
+	*nmsedec = pass_nmsedec;
 }
 
 #define t1_dec_clnpass_internal(t1, bpno, vsc, w, h, flags_stride) \
@@ -1326,11 +1311,9 @@ bool t1_decode_cblk(t1_t *t1, tcd_cblk_dec_t *cblk,
 				T1_TYPE_RAW : T1_TYPE_MQ;
 
 		if (type == T1_TYPE_RAW) {
-			mqc_raw_init_dec(mqc, cblkdata + cblkdataindex, seg->len,
-			GRK_FAKE_MARKER_BYTES);
+			mqc_raw_init_dec(mqc, cblkdata + cblkdataindex, seg->len);
 		} else {
-			mqc_init_dec(mqc, cblkdata + cblkdataindex, seg->len,
-			GRK_FAKE_MARKER_BYTES);
+			mqc_init_dec(mqc, cblkdata + cblkdataindex, seg->len);
 		}
 		cblkdataindex += seg->len;
 
@@ -1370,8 +1353,6 @@ bool t1_decode_cblk(t1_t *t1, tcd_cblk_dec_t *cblk,
 				bpno_plus_one--;
 			}
 		}
-
-		opq_mqc_finish_dec(mqc);
 	}
 
 	if (check_pterm) {
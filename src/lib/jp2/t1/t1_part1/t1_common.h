@@ -18,9 +18,6 @@
 
 #pragma once
 
-
-#define GRK_FAKE_MARKER_BYTES   2    /**< Margin for a fake FFFF marker */
-
 #include "grok.h"
 #include <stdbool.h>
 
@@ -60,13 +60,80 @@
 
 namespace grk {
 
+/**
+ * Flat index of the precincts of a tile, in component, resolution and
+ * precinct order
+ */
+struct PrecinctIndex {
+	explicit PrecinctIndex(grk_tcd_tile *tile) :
+			num_precincts(0) {
+		for (uint32_t compno = 0; compno < tile->numcomps; ++compno) {
+			auto tilec = tile->comps + compno;
+			first_resolution.push_back((uint32_t) first_precinct.size());
+			for (uint32_t resno = 0; resno < tilec->numresolutions; ++resno) {
+				auto res = tilec->resolutions + resno;
+				first_precinct.push_back(num_precincts);
+				num_precincts += res->pw * res->ph;
+			}
+		}
+	}
+	uint32_t get(uint32_t compno, uint32_t resno, uint32_t precno) const {
+		return first_precinct[first_resolution[compno] + resno] + precno;
+	}
+
+	uint32_t num_precincts;
+	// index of the first resolution of each component
+	std::vector<uint32_t> first_resolution;
+	// index of the first precinct of each resolution
+	std::vector<uint32_t> first_precinct;
+};
+
+/**
+ * Find which precincts of the decoded resolutions of a tile meet the
+ * decoded region in at least one band. Done once per tile, so that
+ * packets are not checked against the region one by one.
+ */
+static std::vector<uint8_t> precincts_in_region(grk_tcd_tile *tile,
+		const PrecinctIndex &index) {
+	std::vector<uint8_t> in_region(index.num_precincts, 0);
+	for (uint32_t compno = 0; compno < tile->numcomps; ++compno) {
+		auto tilec = tile->comps + compno;
+		for (uint32_t resno = 0; resno < tilec->minimum_num_resolutions;
+				++resno) {
+			auto res = tilec->resolutions + resno;
+			auto tile_res =
+					tilec->buf->resolutions[tilec->buf->resolutions.size() - 1
+							- resno];
+			for (uint32_t bandno = 0; bandno < res->numbands; ++bandno) {
+				auto band = res->bands + bandno;
+				auto region = tile_res->band_region + bandno;
+				for (uint32_t precno = 0; precno < band->numPrecincts;
+						++precno) {
+					auto flag = &in_region[index.get(compno, resno, precno)];
+					if (*flag)
+						continue;
+					auto prec = band->precincts + precno;
+					auto prec_rect = grk_rect(prec->x0, prec->y0, prec->x1,
+							prec->y1);
+					grk_rect dummy;
+					if (region->clip(prec_rect, &dummy))
+						*flag = 1;
+				}
+			}
+		}
+	}
+	return in_region;
+}
+
 
 bool T2::encode_packets(uint16_t tile_no, grk_tcd_tile *p_tile,
 		uint32_t max_layers, BufferedStream *p_stream, uint64_t *p_data_written,
 		uint64_t max_len,  grk_codestream_info  *cstr_info, uint32_t tp_num,
-		uint32_t tp_pos, uint32_t pino) {
+		uint32_t tp_pos, uint32_t pino,
+		const std::vector<uint32_t> *packet_lengths) {
 
 	uint64_t l_nb_bytes = 0;
+	size_t l_packet_index = 0;
 	auto l_image = image;
 	auto l_cp = cp;
 	auto l_tcp = &l_cp->tcps[tile_no];
@@ -96,6 +163,16 @@ bool T2::encode_packets(uint16_t tile_no, grk_tcd_tile *p_tile,
 				return false;
 			}
 
+			if (packet_lengths
+					&& (l_packet_index >= packet_lengths->size()
+							|| (*packet_lengths)[l_packet_index] != l_nb_bytes)) {
+				pi_destroy(l_pi, l_nb_pocs);
+				GROK_ERROR(
+						"encode_packets: packet %u of tile %u does not have its simulated length",
+						(uint32_t) l_packet_index, tile_no);
+				return false;
+			}
+			++l_packet_index;
 			max_len -= l_nb_bytes;
 			*p_data_written += l_nb_bytes;
 
@@ -130,6 +207,41 @@ bool T2::encode_packets(uint16_t tile_no, grk_tcd_tile *p_tile,
 	return true;
 }
 
+bool T2::get_packet_lengths(uint16_t tile_no, grk_tcd_tile *p_tile,
+		uint32_t max_layers, uint64_t max_len, uint32_t tp_num,
+		uint32_t tp_pos, uint32_t pino, std::vector<uint32_t> *packet_lengths) {
+	auto l_tcp = cp->tcps + tile_no;
+	uint32_t l_nb_pocs = l_tcp->numpocs + 1;
+
+	auto l_pi = pi_initialise_encode(image, cp, tile_no, FINAL_PASS);
+	if (!l_pi) {
+		return false;
+	}
+	pi_init_encode(l_pi, cp, tile_no, pino, tp_num, tp_pos, FINAL_PASS);
+
+	auto l_current_pi = &l_pi[pino];
+	if (l_current_pi->poc.prg == GRK_PROG_UNKNOWN) {
+		pi_destroy(l_pi, l_nb_pocs);
+		GROK_ERROR("get_packet_lengths: Unknown progression order");
+		return false;
+	}
+	while (pi_next(l_current_pi)) {
+		if (l_current_pi->layno < max_layers) {
+			uint64_t bytesInPacket = 0;
+			if (!encode_packet_simulate(p_tile, l_tcp, l_current_pi,
+					&bytesInPacket, max_len)) {
+				pi_destroy(l_pi, l_nb_pocs);
+				return false;
+			}
+			max_len -= bytesInPacket;
+			packet_lengths->push_back((uint32_t) bytesInPacket);
+		}
+	}
+	pi_destroy(l_pi, l_nb_pocs);
+
+	return true;
+}
+
 bool T2::encode_packets_simulate(uint16_t tile_no,
 		grk_tcd_tile *p_tile, uint32_t max_layers, uint64_t *p_data_written,
 		uint64_t max_len, uint32_t tp_pos) {
@@ -153,6 +265,21 @@ bool T2::encode_packets_simulate(uint16_t tile_no,
 	*p_data_written = 0;
 	auto l_current_pi = l_pi;
 
+	// without a size limit per component, the packets of different
+	// precincts can be simulated concurrently
+	if (pocno == 1 && l_max_comp == 1 && Scheduler::g_tp->num_threads() > 1) {
+		pi_init_encode(l_pi, l_cp, tile_no, 0, 0, tp_pos, THRESH_CALC);
+		if (l_pi->poc.prg == GRK_PROG_UNKNOWN) {
+			pi_destroy(l_pi, l_nb_pocs);
+			GROK_ERROR("decode_packets_simulate: Unknown progression order");
+			return false;
+		}
+		bool rc = encode_packets_simulate_concurrent(p_tile, l_tcp, l_pi,
+				max_layers, p_data_written, max_len);
+		pi_destroy(l_pi, l_nb_pocs);
+		return rc;
+	}
+
 	for (uint32_t compno = 0; compno < l_max_comp; ++compno) {
 		uint64_t l_comp_len = 0;
 		l_current_pi = l_pi;
@@ -196,6 +323,72 @@ bool T2::encode_packets_simulate(uint16_t tile_no,
 	pi_destroy(l_pi, l_nb_pocs);
 	return true;
 }
+
+bool T2::encode_packets_simulate_concurrent(grk_tcd_tile *p_tile,
+		grk_tcp *tcp, PacketIter *pi, uint32_t max_layers,
+		uint64_t *p_data_written, uint64_t max_len) {
+	PrecinctIndex index(p_tile);
+
+	// packets of each precinct, in progression order
+	struct Packet {
+		uint32_t precinct;
+		uint32_t compno;
+		uint32_t resno;
+		uint32_t precno;
+		uint32_t layno;
+	};
+	std::vector<Packet> packets;
+	while (pi_next(pi)) {
+		if (pi->layno < max_layers) {
+			packets.push_back(
+					{ index.get(pi->compno, pi->resno, pi->precno), pi->compno,
+							pi->resno, pi->precno, pi->layno });
+		}
+	}
+	std::stable_sort(packets.begin(), packets.end(),
+			[](const Packet &a, const Packet &b) {
+				return a.precinct < b.precinct;
+			});
+	std::vector<size_t> groups;
+	for (size_t i = 0; i < packets.size(); ++i) {
+		if (i == 0 || packets[i].precinct != packets[i - 1].precinct)
+			groups.push_back(i);
+	}
+	groups.push_back(packets.size());
+
+	// each packet only changes the state of its own precinct.
+	// One copy of the iterator per worker, plus one for a calling thread
+	// outside of the pool: the simulation of a group never waits on other
+	// tasks, so no two groups use the same copy at the same time.
+	auto tp = Scheduler::g_tp;
+	std::vector<PacketIter> worker_pi(tp->num_threads() + 1, *pi);
+	std::vector<uint64_t> group_bytes(groups.size() - 1, 0);
+	std::atomic<bool> success(true);
+	tp->parallel_for(groups.size() - 1,
+			[this, p_tile, tcp, tp, max_len, &packets, &groups, &group_bytes,
+			 &worker_pi, &success](size_t g) {
+		int worker = tp->thread_number();
+		auto &packet_pi = worker_pi[worker < 0 ? worker_pi.size() - 1 : (size_t) worker];
+		for (size_t i = groups[g]; i < groups[g + 1] && success; ++i) {
+			packet_pi.compno = packets[i].compno;
+			packet_pi.resno = packets[i].resno;
+			packet_pi.precno = packets[i].precno;
+			packet_pi.layno = packets[i].layno;
+			uint64_t bytes = 0;
+			if (!encode_packet_simulate(p_tile, tcp, &packet_pi, &bytes,
+					max_len)) {
+				success = false;
+				return;
+			}
+			group_bytes[g] += bytes;
+		}
+	});
+	for (auto bytes : group_bytes)
+		*p_data_written += bytes;
+
+	return success && *p_data_written <= max_len;
+}
+
 bool T2::decode_packets(uint16_t tile_no, grk_tcd_tile *p_tile,
 		ChunkBuffer *src_buf, uint64_t *p_data_read) {
 
@@ -207,6 +400,29 @@ bool T2::decode_packets(uint16_t tile_no, grk_tcd_tile *p_tile,
 	if (!l_pi)
 		return false;
 
+	// With the packet lengths from the PLT markers, packets that are not
+	// decoded are jumped over without reading their headers. Every packet
+	// of a precinct after a skipped one is also skipped, so the precinct
+	// state that the header would have updated is never needed.
+	// Packed packet headers (PPM/PPT) must be read in order, though.
+	auto packet_lengths = l_tcp->m_packet_lengths;
+	if (packet_lengths && (l_cp->ppm || l_tcp->ppt))
+		packet_lengths = nullptr;
+	if (packet_lengths) {
+		uint64_t total = 0;
+		for (auto len : *packet_lengths)
+			total += len;
+		if (total != src_buf->data_len) {
+			GROK_WARN("PLT packet lengths do not add up to the data of tile %d: "
+					"reading every packet header", tile_no);
+			packet_lengths = nullptr;
+		}
+	}
+	size_t packet_index = 0;
+
+	PrecinctIndex index(p_tile);
+	auto in_region = precincts_in_region(p_tile, index);
+
 	auto l_current_pi = l_pi;
 	for (uint32_t pino = 0; pino <= l_tcp->numpocs; ++pino) {
 
@@ -237,36 +453,32 @@ bool T2::decode_packets(uint16_t tile_no, grk_tcd_tile *p_tile,
 					l_current_pi->resno, l_current_pi->precno,
 					l_current_pi->layno);
 */
-			if (!skip_layer_or_res) {
-				auto res = tilec->resolutions + l_current_pi->resno;
-				skip_precinct = true;
-				for (uint32_t bandno = 0; bandno < res->numbands && skip_precinct;
-						++bandno) {
-					auto band = res->bands + bandno;
-					auto num_precincts = band->numPrecincts;
-					for (uint32_t precno = 0; precno < num_precincts && skip_precinct;
-							++precno) {
-						auto prec = band->precincts + precno;
-						auto prec_rect = grk_rect(prec->x0, prec->y0, prec->x1,
-								prec->y1);
-						grk_rect dummy;
-						auto tile_res =
-								tilec->buf->resolutions[tilec->buf->resolutions.size() - 1 - l_current_pi->resno];
-						bool clip =
-								(tile_res->band_region + bandno)->clip(prec_rect, &dummy);
-						if (clip) {
-							skip_precinct = false;
-							break;
-						}
-					}
-				}
-			}
+			// skip the packet if its precinct lies outside of the
+			// decoded region in every band of the resolution
+			if (!skip_layer_or_res)
+				skip_precinct = !in_region[index.get(l_current_pi->compno,
+						l_current_pi->resno, l_current_pi->precno)];
 			uint64_t l_nb_bytes_read = 0;
+			if (packet_lengths && packet_index >= packet_lengths->size()) {
+				GROK_WARN("PLT markers of tile %d are missing packets: "
+						"reading every packet header", tile_no);
+				packet_lengths = nullptr;
+			}
 			if (!skip_layer_or_res && !skip_precinct) {
 				if (!decode_packet(	p_tile, l_tcp, l_current_pi, src_buf, &l_nb_bytes_read)) {
 					pi_destroy(l_pi, l_nb_pocs);
 					return false;
 				}
+				if (packet_lengths
+						&& l_nb_bytes_read != (*packet_lengths)[packet_index]) {
+					GROK_WARN("Packet length %d in PLT marker of tile %d does "
+							"not match packet header: reading every packet header",
+							(*packet_lengths)[packet_index], tile_no);
+					packet_lengths = nullptr;
+				}
+			} else if (packet_lengths) {
+				skip_packet_with_length(p_tile, l_tcp, src_buf,
+						(*packet_lengths)[packet_index], &l_nb_bytes_read);
 			} else {
 				if (!skip_packet(p_tile, l_tcp, l_current_pi, src_buf,
 						&l_nb_bytes_read)) {
@@ -279,6 +491,7 @@ bool T2::decode_packets(uint16_t tile_no, grk_tcd_tile *p_tile,
 				l_img_comp->resno_decoded = std::max<uint32_t>(
 						l_current_pi->resno, l_img_comp->resno_decoded);
 			*p_data_read += l_nb_bytes_read;
+			++packet_index;
 		}
 		++l_current_pi;
 	}
@@ -398,10 +611,9 @@ bool T2::read_packet_header(grk_tcd_tile *p_tile,
 	}
 
 	uint32_t l_present = 0;
-	std::unique_ptr<BitIO> l_bio(
-			new BitIO(l_header_data, *l_modified_length_ptr, false));
+	BitIO l_bio(l_header_data, *l_modified_length_ptr, false);
 	if (*l_modified_length_ptr) {
-		if (!l_bio->read(&l_present, 1)) {
+		if (!l_bio.read(&l_present, 1)) {
 			GROK_ERROR(
 					"read_packet_header: failed to read `present` bit ");
 			return false;
@@ -409,9 +621,9 @@ bool T2::read_packet_header(grk_tcd_tile *p_tile,
 	}
 	//GROK_INFO("present=%d \n", l_present);
 	if (!l_present) {
-		if (!l_bio->inalign())
+		if (!l_bio.inalign())
 			return false;
-		l_header_data += l_bio->numbytes();
+		l_header_data += l_bio.numbytes();
 
 		/* EPH markers */
 		if (p_tcp->csty & J2K_CP_CSTY_EPH) {
@@ -436,6 +648,10 @@ bool T2::read_packet_header(grk_tcd_tile *p_tile,
 		src_buf->incr_cur_chunk_offset(*p_data_read);
 		return true;
 	}
+	// HT code blocks have their own segments: see init_seg
+	uint8_t cblk_sty = p_tcp->tccps[p_pi->compno].cblk_sty;
+	if (p_tcp->isHT)
+		cblk_sty |= GRK_CBLKSTY_HT;
 	for (uint32_t bandno = 0; bandno < l_res->numbands; ++bandno) {
 		auto l_band = l_res->bands + bandno;
 		if (l_band->isEmpty()) {
@@ -451,7 +667,7 @@ bool T2::read_packet_header(grk_tcd_tile *p_tile,
 			/* if cblk not yet included before --> inclusion tagtree */
 			if (!l_cblk->numSegments) {
 				uint64_t value;
-				if (!l_prc->incltree->decodeValue(l_bio.get(), cblkno,
+				if (!l_prc->incltree->decodeValue(&l_bio, cblkno,
 						p_pi->layno + 1, &value)) {
 					GROK_ERROR(
 							"read_packet_header: failed to read `inclusion` bit ");
@@ -482,7 +698,7 @@ bool T2::read_packet_header(grk_tcd_tile *p_tile,
 			}
 			/* else one bit */
 			else {
-				if (!l_bio->read(&l_included, 1)) {
+				if (!l_bio.read(&l_included, 1)) {
 					GROK_ERROR(
 							"read_packet_header: failed to read `inclusion` bit ");
 					return false;
@@ -508,7 +724,7 @@ bool T2::read_packet_header(grk_tcd_tile *p_tile,
 
 				// see Taubman + Marcellin page 388
 				// loop below stops at (# of missing bit planes  + 1)
-				while ((rc = l_prc->imsbtree->decode(l_bio.get(), cblkno,
+				while ((rc = l_prc->imsbtree->decode(&l_bio, cblkno,
 						K_msbs, &value)) && !value) {
 					++K_msbs;
 				}
@@ -541,12 +757,12 @@ bool T2::read_packet_header(grk_tcd_tile *p_tile,
 			}
 
 			/* number of coding passes */
-			if (!l_bio->getnumpasses(&l_cblk->numPassesInPacket)) {
+			if (!l_bio.getnumpasses(&l_cblk->numPassesInPacket)) {
 				GROK_ERROR(
 						"read_packet_header: failed to read numpasses.");
 				return false;
 			}
-			if (!l_bio->getcommacode(&l_increment)) {
+			if (!l_bio.getcommacode(&l_increment)) {
 				GROK_ERROR(
 						"read_packet_header: failed to read length indicator increment.");
 				return false;
@@ -558,7 +774,7 @@ bool T2::read_packet_header(grk_tcd_tile *p_tile,
 
 			if (!l_cblk->numSegments) {
 				if (!T2::init_seg(l_cblk, l_segno,
-						p_tcp->tccps[p_pi->compno].cblk_sty, true)) {
+						cblk_sty, true)) {
 					return false;
 				}
 			} else {
@@ -567,7 +783,7 @@ bool T2::read_packet_header(grk_tcd_tile *p_tile,
 						== l_cblk->segs[l_segno].maxpasses) {
 					++l_segno;
 					if (!T2::init_seg(l_cblk, l_segno,
-							p_tcp->tccps[p_pi->compno].cblk_sty, false)) {
+							cblk_sty, false)) {
 						return false;
 					}
 				}
@@ -600,7 +816,7 @@ bool T2::read_packet_header(grk_tcd_tile *p_tile,
 							"read_packet_header: too many bits in segment length ");
 					return false;
 				}
-				if (!l_bio->read(&l_seg->numBytesInPacket,bits_to_read)) {
+				if (!l_bio.read(&l_seg->numBytesInPacket,bits_to_read)) {
 					GROK_WARN(
 							"read_packet_header: failed to read segment length ");
 				}
@@ -618,7 +834,7 @@ bool T2::read_packet_header(grk_tcd_tile *p_tile,
 				if (blockPassesInPacket > 0) {
 					++l_segno;
 					if (!T2::init_seg(l_cblk, l_segno,
-							p_tcp->tccps[p_pi->compno].cblk_sty, false)) {
+							cblk_sty, false)) {
 						return false;
 					}
 				}
@@ -626,12 +842,12 @@ bool T2::read_packet_header(grk_tcd_tile *p_tile,
 		}
 	}
 
-	if (!l_bio->inalign()) {
+	if (!l_bio.inalign()) {
 		GROK_ERROR( "Unable to read packet header");
 		return false;
 	}
 
-	l_header_data += l_bio->numbytes();
+	l_header_data += l_bio.numbytes();
 
 	/* EPH markers */
 	if (p_tcp->csty & J2K_CP_CSTY_EPH) {
@@ -710,7 +926,18 @@ bool T2::read_packet_data(grk_tcd_resolution *l_res, PacketIter *p_pi,
 				}
 				// only add segment to seg_buffers if length is greater than zero
 				if (l_seg->numBytesInPacket) {
-					l_cblk->seg_buffers.push_back(src_buf->get_global_ptr(),
+					auto ptr = src_buf->get_global_ptr();
+					// the block can be decoded in place while its segments
+					// follow on from each other in one tile part
+					bool in_place = src_buf->is_guarded(l_seg->numBytesInPacket,
+							cblk_dec_guard_bytes);
+					if (in_place && l_cblk->seg_buffers.size()) {
+						auto prev = (grk_buf*) l_cblk->seg_buffers.back();
+						in_place = l_cblk->seg_in_place
+								&& prev->buf + prev->len == ptr;
+					}
+					l_cblk->seg_in_place = in_place;
+					l_cblk->seg_buffers.push_back(ptr,
 							(uint16_t) l_seg->numBytesInPacket);
 					*(p_data_read) += l_seg->numBytesInPacket;
 					src_buf->incr_cur_chunk_offset(l_seg->numBytesInPacket);
@@ -718,6 +945,7 @@ bool T2::read_packet_data(grk_tcd_resolution *l_res, PacketIter *p_pi,
 					l_seg->len += l_seg->numBytesInPacket;
 				}
 				l_seg->numpasses += l_seg->numPassesInPacket;
+				l_seg->real_num_passes = l_seg->numpasses;
 				numPassesInPacket -= l_seg->numPassesInPacket;
 				if (numPassesInPacket > 0) {
 					++l_seg;
@@ -763,6 +991,17 @@ bool T2::skip_packet(grk_tcd_tile *p_tile, grk_tcp *p_tcp,
 	return true;
 }
 
+void T2::skip_packet_with_length(grk_tcd_tile *p_tile, grk_tcp *p_tcp,
+		ChunkBuffer *src_buf, uint32_t len, uint64_t *p_data_read) {
+	// keep the SOP packet counter in step for the packets that are decoded
+	if (p_tcp->csty & J2K_CP_CSTY_SOP)
+		p_tile->packno++;
+	uint64_t remaining = src_buf->data_len
+			- (uint64_t) src_buf->get_global_offset();
+	*p_data_read = std::min<uint64_t>(len, remaining);
+	src_buf->skip((int64_t) *p_data_read);
+}
+
 bool T2::skip_packet_data(grk_tcd_resolution *l_res, PacketIter *p_pi,
 		uint64_t *p_data_read, uint64_t max_length) {
 	uint32_t bandno;
@@ -844,7 +1083,10 @@ bool T2::init_seg(grk_tcd_cblk_dec *cblk, uint32_t index,
 	auto seg = &cblk->segs[index];
 	seg->clear();
 
-	if (cblk_sty & J2K_CCP_CBLKSTY_TERMALL) {
+	if (cblk_sty & GRK_CBLKSTY_HT) {
+		// HT cleanup pass, followed by SigProp and MagRef passes
+		seg->maxpasses = first ? 1 : 2;
+	} else if (cblk_sty & J2K_CCP_CBLKSTY_TERMALL) {
 		seg->maxpasses = 1;
 	} else if (cblk_sty & J2K_CCP_CBLKSTY_LAZY) {
 		if (first) {
@@ -929,10 +1171,10 @@ bool T2::encode_packet(uint16_t tileno, grk_tcd_tile *tile, grk_tcp *tcp,
 		}
 	}
 
-	std::unique_ptr<BitIO> bio(new BitIO(p_stream, true));
+	BitIO bio(p_stream, true);
 	// Empty header bit. Grok always sets this to 1,
 	// even though there is also an option to set it to zero.
-	if (!bio->write(1, 1))
+	if (!bio.write(1, 1))
 		return false;
 
 	/* Writing Packet header */
@@ -965,7 +1207,7 @@ bool T2::encode_packet(uint16_t tileno, grk_tcd_tile *tile, grk_tcp *tcp,
 
 			/* cblk inclusion bits */
 			if (!cblk->num_passes_included_in_current_layer) {
-				prc->incltree->encode(bio.get(), cblkno, (int32_t) (layno + 1));
+				prc->incltree->encode(&bio, cblkno, (int32_t) (layno + 1));
 #ifdef DEBUG_LOSSLESS_T2
 					cblk->included = layno;
 #endif
@@ -973,7 +1215,7 @@ bool T2::encode_packet(uint16_t tileno, grk_tcd_tile *tile, grk_tcp *tcp,
 #ifdef DEBUG_LOSSLESS_T2
 					cblk->included = layer->numpasses != 0 ? 1 : 0;
 #endif
-				if (!bio->write(layer->numpasses != 0, 1))
+				if (!bio.write(layer->numpasses != 0, 1))
 					return false;
 			}
 
@@ -986,11 +1228,11 @@ bool T2::encode_packet(uint16_t tileno, grk_tcd_tile *tile, grk_tcp *tcp,
 			/* if first instance of cblk --> zero bit-planes information */
 			if (!cblk->num_passes_included_in_current_layer) {
 				cblk->numlenbits = 3;
-				prc->imsbtree->encode(bio.get(), cblkno,
+				prc->imsbtree->encode(&bio, cblkno,
 						tag_tree_uninitialized_node_value);
 			}
 			/* number of coding passes included */
-			bio->putnumpasses(layer->numpasses);
+			bio.putnumpasses(layer->numpasses);
 			uint32_t l_nb_passes = cblk->num_passes_included_in_current_layer
 					+ layer->numpasses;
 			auto pass = cblk->passes
@@ -1013,7 +1255,7 @@ bool T2::encode_packet(uint16_t tileno, grk_tcd_tile *tile, grk_tcp *tcp,
 				}
 				++pass;
 			}
-			bio->putcommacode((int32_t) increment);
+			bio.putcommacode((int32_t) increment);
 
 			/* computation of the new Length indicator */
 			cblk->numlenbits += increment;
@@ -1029,7 +1271,7 @@ bool T2::encode_packet(uint16_t tileno, grk_tcd_tile *tile, grk_tcp *tcp,
 #ifdef DEBUG_LOSSLESS_T2
 						cblk->packet_length_info->push_back(grk_packet_length_info(len, cblk->numlenbits + (uint32_t)int_floorlog2((int32_t)nump)));
 #endif
-					if (!bio->write(len,
+					if (!bio.write(len,
 							cblk->numlenbits
 									+ (uint32_t) int_floorlog2((int32_t) nump)))
 						return false;
@@ -1043,13 +1285,13 @@ bool T2::encode_packet(uint16_t tileno, grk_tcd_tile *tile, grk_tcp *tcp,
 		++band;
 	}
 
-	if (!bio->flush()) {
+	if (!bio.flush()) {
 		GROK_ERROR(
 				"encode_packet: Bit IO flush failed while encoding packet");
 		return false;
 	}
 
-	auto temp = bio->numbytes();
+	auto temp = bio.numbytes();
 	num_bytes_available -= (uint64_t) temp;
 	numHeaderBytes += (uint64_t) temp;
 
@@ -1321,6 +1563,8 @@ bool T2::encode_packet_simulate(grk_tcd_tile *tile, grk_tcp *tcp,
 
 	/* <SOP 0xff91> */
 	if (tcp->csty & J2K_CP_CSTY_SOP) {
+		if (length < 6)
+			return false;
 		length -= 6;
 		packet_bytes_written += 6;
 	}
@@ -1349,10 +1593,10 @@ bool T2::encode_packet_simulate(grk_tcd_tile *tile, grk_tcp *tcp,
 		}
 	}
 
-	std::unique_ptr<BitIO> bio(new BitIO(0, length, true));
-	bio->simulateOutput(true);
+	BitIO bio(0, length, true);
+	bio.simulateOutput(true);
 	/* Empty header bit */
-	if (!bio->write(1, 1))
+	if (!bio.write(1, 1))
 		return false;
 
 	/* Writing Packet header */
@@ -1384,9 +1628,9 @@ bool T2::encode_packet_simulate(grk_tcd_tile *tile, grk_tcp *tcp,
 
 			/* cblk inclusion bits */
 			if (!cblk->num_passes_included_in_current_layer) {
-				prc->incltree->encode(bio.get(), cblkno, (int32_t) (layno + 1));
+				prc->incltree->encode(&bio, cblkno, (int32_t) (layno + 1));
 			} else {
-				if (!bio->write(layer->numpasses != 0, 1))
+				if (!bio.write(layer->numpasses != 0, 1))
 					return false;
 			}
 
@@ -1399,12 +1643,12 @@ bool T2::encode_packet_simulate(grk_tcd_tile *tile, grk_tcp *tcp,
 			/* if first instance of cblk --> zero bit-planes information */
 			if (!cblk->num_passes_included_in_current_layer) {
 				cblk->numlenbits = 3;
-				prc->imsbtree->encode(bio.get(), cblkno,
+				prc->imsbtree->encode(&bio, cblkno,
 						tag_tree_uninitialized_node_value);
 			}
 
 			/* number of coding passes included */
-			bio->putnumpasses(layer->numpasses);
+			bio.putnumpasses(layer->numpasses);
 			l_nb_passes = cblk->num_passes_included_in_current_layer
 					+ layer->numpasses;
 			pass = cblk->passes + cblk->num_passes_included_in_current_layer;
@@ -1430,7 +1674,7 @@ bool T2::encode_packet_simulate(grk_tcd_tile *tile, grk_tcp *tcp,
 
 				++pass;
 			}
-			bio->putcommacode((int32_t) increment);
+			bio.putcommacode((int32_t) increment);
 
 			/* computation of the new Length indicator */
 			cblk->numlenbits += increment;
@@ -1446,7 +1690,7 @@ bool T2::encode_packet_simulate(grk_tcd_tile *tile, grk_tcp *tcp,
 						|| passno
 								== (cblk->num_passes_included_in_current_layer
 										+ layer->numpasses) - 1) {
-					if (!bio->write(len,
+					if (!bio.write(len,
 							cblk->numlenbits
 									+ (uint32_t) int_floorlog2((int32_t) nump)))
 						return false;
@@ -1462,16 +1706,18 @@ bool T2::encode_packet_simulate(grk_tcd_tile *tile, grk_tcp *tcp,
 		++band;
 	}
 
-	if (!bio->flush()) {
+	if (!bio.flush()) {
 		return false;
 	}
 
-	l_nb_bytes = (uint64_t) bio->numbytes();
+	l_nb_bytes = (uint64_t) bio.numbytes();
 	packet_bytes_written += l_nb_bytes;
 	length -= l_nb_bytes;
 
 	/* <EPH 0xff92> */
 	if (tcp->csty & J2K_CP_CSTY_EPH) {
+		if (length < 2)
+			return false;
 		length -= 2;
 		packet_bytes_written += 2;
 	}
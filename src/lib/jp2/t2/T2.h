@@ -85,11 +85,32 @@ struct T2 {
 	 @param tpnum            Tile part number of the current tile
 	 @param tppos            The position of the tile part flag in the progression order
 	 @param pino             FIXME DOC
+	 @param packet_lengths   if not null, the length that each packet must have,
+	 	 	 	 	 	 	 as found by get_packet_lengths
 	 */
 	bool encode_packets(uint16_t tileno, grk_tcd_tile *tile,
 			uint32_t maxlayers, BufferedStream *p_stream, uint64_t *p_data_written,
 			uint64_t len,  grk_codestream_info  *cstr_info, uint32_t tpnum,
-			uint32_t tppos, uint32_t pino);
+			uint32_t tppos, uint32_t pino,
+			const std::vector<uint32_t> *packet_lengths);
+
+	/**
+	 Simulate the encoding of the packets of a tile part, as encode_packets
+	 will write them, to find the length of each packet
+	 @param tileno           number of the tile encoded
+	 @param tile             the tile for which to simulate the packets
+	 @param maxlayers        maximum number of layers
+	 @param max_len          the length available for the packets
+	 @param tpnum            Tile part number of the current tile
+	 @param tppos            The position of the tile part flag in the progression order
+	 @param pino             packet iterator number of the tile part
+	 @param packet_lengths   the length of each packet is appended to it
+	 @return true if all packets were simulated and fit in max_len
+	 */
+	bool get_packet_lengths(uint16_t tileno, grk_tcd_tile *tile,
+			uint32_t maxlayers, uint64_t max_len, uint32_t tpnum,
+			uint32_t tppos, uint32_t pino,
+			std::vector<uint32_t> *packet_lengths);
 
 	/**
 	 Encode the packets of a tile to a destination buffer
@@ -157,6 +178,21 @@ private:
 	bool encode_packet_simulate(grk_tcd_tile *tile, grk_tcp *tcp,
 			PacketIter *pi, uint64_t *p_data_written, uint64_t len);
 
+	/**
+	 Simulate the packets that pi iterates over, up to max_layers, with
+	 the packets of different precincts encoded concurrently
+	 @param tile Tile for which to simulate the packets
+	 @param tcp Tile coding parameters
+	 @param pi Packet iterator, initialized for encoding
+	 @param max_layers maximum number of layers
+	 @param p_data_written total size of the packets
+	 @param max_len maximum total size of the packets
+	 @return true if all packets were simulated and fit in max_len
+	 */
+	bool encode_packets_simulate_concurrent(grk_tcd_tile *tile, grk_tcp *tcp,
+			PacketIter *pi, uint32_t max_layers, uint64_t *p_data_written,
+			uint64_t max_len);
+
 	/**
 	 Decode a packet of a tile from a source buffer
 	 @param tile Tile for which to write the packets
@@ -175,6 +211,18 @@ private:
 	bool skip_packet(grk_tcd_tile *p_tile, grk_tcp *p_tcp,
 			PacketIter *p_pi, ChunkBuffer *src_buf, uint64_t *p_data_read);
 
+	/**
+	 Skip a packet whose length is known from a PLT marker, without
+	 reading its header
+	 @param tile Tile for which to skip the packet
+	 @param tcp Tile coding parameters
+	 @param src_buf Source buffer
+	 @param len length of the packet
+	 @param data_read number of bytes skipped
+	 */
+	void skip_packet_with_length(grk_tcd_tile *p_tile, grk_tcp *p_tcp,
+			ChunkBuffer *src_buf, uint32_t len, uint64_t *p_data_read);
+
 	bool read_packet_header(grk_tcd_tile *p_tile,
 			grk_tcp *p_tcp, PacketIter *p_pi, bool *p_is_data_present,
 			ChunkBuffer *src_buf, uint64_t *p_data_read);
@@ -54,5 +54,13 @@ bool Wavelet::decode(TileProcessor *p_tcd,  TileComponent* tilec,
 	return false;
 }
 
+bool Wavelet::decode_resolution(TileComponent* tilec, uint32_t resno,
+								uint8_t qmfbid){
+	if (qmfbid == 1)
+		return decode_resolution_53(tilec, resno);
+	else if (qmfbid == 0)
+		return decode_resolution_97(tilec, resno);
+	return false;
 }
 
+}
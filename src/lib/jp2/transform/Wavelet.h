@@ -30,6 +30,13 @@ public:
 	static bool decode(TileProcessor *p_tcd,  TileComponent* tilec,
 	                             uint32_t numres, uint8_t qmfbid);
 
+	/**
+	 * Compute resolution resno of a whole tile component from resolution
+	 * resno - 1 and the decoded bands of resno
+	 */
+	static bool decode_resolution(TileComponent* tilec, uint32_t resno,
+									uint8_t qmfbid);
+
 };
 
 }
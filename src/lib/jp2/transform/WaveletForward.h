@@ -41,8 +41,11 @@ template <typename DWT> bool WaveletForward<DWT>::run(TileComponent *tilec){
 	if (tilec->numresolutions == 1U)
 		return true;
 
+	/* number of columns (vertical pass) or rows (horizontal pass)
+	 * transformed together */
+	const uint32_t pll = Kernels::g_kernels->pll_lines_encode;
 	size_t l_data_size = dwt_utils::max_resolution(tilec->resolutions,
-			tilec->numresolutions) * sizeof(int32_t);
+			tilec->numresolutions) * pll * sizeof(int32_t);
 	/* overflow check */
 	if (l_data_size > SIZE_MAX) {
 		GROK_ERROR("Wavelet encode: overflow");
@@ -51,7 +54,10 @@ template <typename DWT> bool WaveletForward<DWT>::run(TileComponent *tilec){
 	if (!l_data_size)
 		return false;
 
-	bool rc = true;
+	std::atomic<bool> rc(true);
+	/* one strip job per worker; each job leases its line buffer from the
+	 * arena of the worker running it */
+	const uint32_t num_jobs = (uint32_t)Scheduler::g_tp->num_threads();
 	uint32_t rw,rh,rw_next,rh_next;
 	uint8_t cas_row,cas_col;
 	uint32_t stride = tilec->width();
@@ -60,19 +66,7 @@ template <typename DWT> bool WaveletForward<DWT>::run(TileComponent *tilec){
 	grk_tcd_resolution *cur_res = tilec->resolutions + num_decomps;
 	grk_tcd_resolution *next_res = cur_res - 1;
 
-	int32_t **bj_array = new int32_t*[hardware_concurrency()];
-	for (uint32_t i = 0; i < hardware_concurrency(); ++i){
-		bj_array[i] = nullptr;
-	}
-	for (uint32_t i = 0; i < hardware_concurrency(); ++i){
-		bj_array[i] = (int32_t*)grok_aligned_malloc(l_data_size);
-		if (!bj_array[i]){
-			rc = false;
-			goto cleanup;
-		}
-	}
-
-	for (int32_t i = 0; i < num_decomps; ++i) {
+	for (int32_t i = 0; i < num_decomps && rc; ++i) {
 
 		/* width of the resolution level computed   */
 		rw = cur_res->x1 - cur_res->x0;
@@ -90,74 +84,77 @@ template <typename DWT> bool WaveletForward<DWT>::run(TileComponent *tilec){
 
 		// transform vertical
 		if (rw) {
-			const uint32_t linesPerThreadV = static_cast<uint32_t>(std::ceil((float)rw / (float)hardware_concurrency()));
 			const uint32_t s_n = rh_next;
 			const uint32_t d_n = rh - rh_next;
-			std::vector< std::future<int> > results;
-			for(uint32_t i = 0; i < hardware_concurrency(); ++i) {
-				uint32_t index = i;
-				results.emplace_back(
-					Scheduler::g_tp->enqueue([this, index, bj_array,a,
-												 stride, rw,rh,
-												 d_n, s_n, cas_col,
-												 linesPerThreadV] {
-						DWT wavelet;
-						for (uint32_t m = index * linesPerThreadV;
-								m < std::min<uint32_t>((index+1)*linesPerThreadV, rw); ++m) {
-							int32_t *bj = bj_array[index];
-							int32_t *aj = a + m;
-							for (uint32_t k = 0; k < rh; ++k) {
-								bj[k] = aj[k * stride];
-							}
-							wavelet.encode_line(bj, d_n, s_n, cas_col);
-							dwt_utils::deinterleave_v(bj, aj, d_n, s_n, stride, cas_col);
-						}
-						return 0;
-					})
-				);
-			}
-			for(auto && result: results){
-				result.get();
-			}
+			const uint32_t num_strips = (rw + pll - 1) / pll;
+			const uint32_t stripsPerThreadV = (num_strips + num_jobs - 1) / num_jobs;
+			Scheduler::g_tp->parallel_for(num_jobs,
+					[&rc, l_data_size, a, stride, rw,rh, d_n, s_n, cas_col, pll,
+					 num_strips, stripsPerThreadV](size_t i) {
+				uint32_t index = (uint32_t)i;
+				DWT wavelet;
+				auto arena = WorkerArena::get();
+				int32_t *bj = (int32_t*)arena->get_buffer(l_data_size);
+				if (!bj) {
+					GROK_ERROR("Wavelet encode: out of memory");
+					rc = false;
+					return;
+				}
+				for (uint32_t m = index * stripsPerThreadV;
+						m < std::min<uint32_t>((index+1)*stripsPerThreadV, num_strips); ++m) {
+					uint32_t ncols = std::min<uint32_t>(pll, rw - m * pll);
+					int32_t *aj = a + m * pll;
+					// pad the last strip, so that the unused lanes hold valid samples
+					if (ncols < pll)
+						memset(bj, 0, (size_t)rh * pll * sizeof(int32_t));
+					for (uint32_t k = 0; k < rh; ++k)
+						memcpy(bj + k * pll, aj + (size_t)k * stride, ncols * sizeof(int32_t));
+					wavelet.encode_line(bj, d_n, s_n, cas_col);
+					dwt_utils::deinterleave_v(bj, aj, d_n, s_n, stride, cas_col, pll, ncols);
+				}
+				arena->put_buffer(bj);
+			});
 		}
 
 		// transform horizontal
 		if (rh){
 			const uint32_t s_n = rw_next;
 			const uint32_t d_n = rw - rw_next;
-			const uint32_t linesPerThreadH = static_cast<uint32_t>(std::ceil((float)rh / (float)hardware_concurrency()));
-			std::vector< std::future<int> > results;
-			for(uint32_t i = 0; i < hardware_concurrency(); ++i) {
-				uint32_t index = i;
-				results.emplace_back(
-					Scheduler::g_tp->enqueue([this, index, bj_array,a,
-												 stride, rw,rh,
-												 d_n, s_n, cas_row,
-												 linesPerThreadH] {
-						DWT wavelet;
-						for (auto m = index * linesPerThreadH;
-								m < std::min<uint32_t>((index+1)*linesPerThreadH, rh); ++m) {
-							int32_t *bj = bj_array[index];
-							int32_t *aj = a + m * stride;
-							memcpy(bj,aj,rw << 2);
-							wavelet.encode_line(bj, d_n, s_n, cas_row);
-							dwt_utils::deinterleave_h(bj, aj, d_n, s_n, cas_row);
-						}
-						return 0;
-					})
-				);
-			}
-			for(auto && result: results){
-				result.get();
-			}
+			const uint32_t num_strips = (rh + pll - 1) / pll;
+			const uint32_t stripsPerThreadH = (num_strips + num_jobs - 1) / num_jobs;
+			Scheduler::g_tp->parallel_for(num_jobs,
+					[&rc, l_data_size, a, stride, rw,rh, d_n, s_n, cas_row, pll,
+					 num_strips, stripsPerThreadH](size_t i) {
+				uint32_t index = (uint32_t)i;
+				DWT wavelet;
+				auto arena = WorkerArena::get();
+				int32_t *bj = (int32_t*)arena->get_buffer(l_data_size);
+				if (!bj) {
+					GROK_ERROR("Wavelet encode: out of memory");
+					rc = false;
+					return;
+				}
+				for (uint32_t m = index * stripsPerThreadH;
+						m < std::min<uint32_t>((index+1)*stripsPerThreadH, num_strips); ++m) {
+					uint32_t nrows = std::min<uint32_t>(pll, rh - m * pll);
+					int32_t *aj = a + (size_t)m * pll * stride;
+					if (nrows < pll)
+						memset(bj, 0, (size_t)rw * pll * sizeof(int32_t));
+					// transpose the rows, so that lifting runs over several rows at once
+					for (uint32_t r = 0; r < nrows; ++r) {
+						int32_t *row = aj + (size_t)r * stride;
+						for (uint32_t k = 0; k < rw; ++k)
+							bj[k * pll + r] = row[k];
+					}
+					wavelet.encode_line(bj, d_n, s_n, cas_row);
+					dwt_utils::deinterleave_h(bj, aj, d_n, s_n, stride, cas_row, pll, nrows);
+				}
+				arena->put_buffer(bj);
+			});
 		}
 		cur_res = next_res;
 		next_res--;
 	}
-cleanup:
-	for (uint32_t i = 0; i < hardware_concurrency(); ++i)
-		grok_aligned_free(bj_array[i]);
-	delete[] bj_array;
 	return rc;
 }
 
@@ -72,9 +72,6 @@ namespace grk {
 #define GRK_WS(i) v->mem[(i)*2]
 #define GRK_WD(i) v->mem[(1+(i)*2)]
 
-/** Number of columns that we can process in parallel in the vertical pass */
-#define PLL_COLS_53     (2*VREG_INT_COUNT)
-
 /** @name Local data structures */
 /*@{*/
 
@@ -105,12 +102,9 @@ template <typename T> struct decode_job{
 } ;
 
 
-typedef union {
-    float f[4];
-} v4_data;
-
 struct dwt_data_97 {
-    v4_data*   wavelet ;
+    float*        wavelet ; /* elements of cols interleaved rows or columns */
+    uint32_t      cols ;
     int32_t       dn ;  /* number of elements in high pass band */
     int32_t       sn ;  /* number of elements in low pass band */
     int32_t       cas ; /* 0 = start on even coord, 1 = start on odd coord */
@@ -134,9 +128,10 @@ static const float c13318 = 1.625732422f;
 /*@{*/
 
 /**
-Inverse wavelet transform in 2-D.
+Inverse wavelet transform in 2-D, for resolutions first_res to numres - 1.
 */
-static bool decode_tile_53(TileComponent* tilec, uint32_t i);
+static bool decode_tile_53(TileComponent* tilec, uint32_t first_res,
+		uint32_t numres);
 
 static bool decode_partial_tile_53(
     TileComponent* tilec,
@@ -149,7 +144,7 @@ static uint32_t max_resolution(grk_tcd_resolution* restrict r,
 /* <summary>                             */
 /* Inverse 9-7 wavelet transform in 1-D. */
 /* </summary>                            */
-static void decode_step_97(dwt_data_97* restrict dwt);
+static void decode_step_97(dwt_data_97* restrict dwt, bool vertical);
 
 static void interleave_h_97(dwt_data_97* restrict dwt,
                                    float* restrict a,
@@ -161,31 +156,6 @@ static void interleave_v_97(dwt_data_97* restrict dwt,
                                    uint32_t width,
                                    uint32_t nb_elts_read);
 
-#ifdef __SSE__
-static void decode_step1_sse_97(v4_data* w,
-                                       uint32_t start,
-                                       uint32_t end,
-                                       const __m128 c);
-
-static void decode_step2_sse_97(v4_data* l, v4_data* w,
-                                       uint32_t start,
-                                       uint32_t end,
-                                       uint32_t m, __m128 c);
-
-#else
-static void decode_step1_97(v4_data* w,
-                                   uint32_t start,
-                                   uint32_t end,
-                                   const float c);
-
-static void decode_step2_97(v4_data* l, v4_data* w,
-                                   uint32_t start,
-                                   uint32_t end,
-                                   uint32_t m,
-                                   float c);
-
-#endif
-
 /*@}*/
 
 /*@}*/
@@ -322,328 +292,6 @@ static void decode_h_53(const dwt_data_53 *dwt,
     }
 }
 
-#if (defined(__SSE2__) || defined(__AVX2__))
-
-#define ADD3(x,y,z) ADD(ADD(x,y),z)
-
-static
-void decode_v_final_memcpy_53(int32_t* tiledp_col,
-                               const int32_t* tmp,
-                               int32_t len,
-                               size_t stride){
-    int32_t i;
-    for (i = 0; i < len; ++i) {
-        /* A memcpy(&tiledp_col[i * stride + 0],
-                    &tmp[PARALLEL_COLS_53 * i + 0],
-                    PARALLEL_COLS_53 * sizeof(int32_t))
-           would do but would be a tiny bit slower.
-           We can take here advantage of our knowledge of alignment */
-        STOREU(&tiledp_col[(size_t)i * stride + 0],
-               LOAD(&tmp[PLL_COLS_53 * i + 0]));
-        STOREU(&tiledp_col[(size_t)i * stride + VREG_INT_COUNT],
-               LOAD(&tmp[PLL_COLS_53 * i + VREG_INT_COUNT]));
-    }
-}
-
-/** Vertical inverse 5x3 wavelet transform for 8 columns in SSE2, or
- * 16 in AVX2, when top-most pixel is on even coordinate */
-static void decode_v_cas0_mcols_SSE2_OR_AVX2_53(int32_t* tmp,
-												const int32_t sn,
-												const int32_t len,
-												int32_t* tiledp_col,
-												const size_t stride){
-    const int32_t* in_even = &tiledp_col[0];
-    const int32_t* in_odd = &tiledp_col[(size_t)sn * stride];
-
-    int32_t i;
-    size_t j;
-    VREG d1c_0, d1n_0, s1n_0, s0c_0, s0n_0;
-    VREG d1c_1, d1n_1, s1n_1, s0c_1, s0n_1;
-    const VREG two = LOAD_CST(2);
-
-    assert(len > 1);
-#if __AVX2__
-    assert(PLL_COLS_53 == 16);
-    assert(VREG_INT_COUNT == 8);
-#else
-    assert(PLL_COLS_53 == 8);
-    assert(VREG_INT_COUNT == 4);
-#endif
-
-    /* Note: loads of input even/odd values must be done in a unaligned */
-    /* fashion. But stores in tmp can be done with aligned store, since */
-    /* the temporary buffer is properly aligned */
-    assert((size_t)tmp % (sizeof(int32_t) * VREG_INT_COUNT) == 0);
-
-    s1n_0 = LOADU(in_even + 0);
-    s1n_1 = LOADU(in_even + VREG_INT_COUNT);
-    d1n_0 = LOADU(in_odd);
-    d1n_1 = LOADU(in_odd + VREG_INT_COUNT);
-
-    /* s0n = s1n - ((d1n + 1) >> 1); <==> */
-    /* s0n = s1n - ((d1n + d1n + 2) >> 2); */
-    s0n_0 = SUB(s1n_0, SAR(ADD3(d1n_0, d1n_0, two), 2));
-    s0n_1 = SUB(s1n_1, SAR(ADD3(d1n_1, d1n_1, two), 2));
-
-    for (i = 0, j = 1; i < (len - 3); i += 2, j++) {
-        d1c_0 = d1n_0;
-        s0c_0 = s0n_0;
-        d1c_1 = d1n_1;
-        s0c_1 = s0n_1;
-
-        s1n_0 = LOADU(in_even + j * stride);
-        s1n_1 = LOADU(in_even + j * stride + VREG_INT_COUNT);
-        d1n_0 = LOADU(in_odd + j * stride);
-        d1n_1 = LOADU(in_odd + j * stride + VREG_INT_COUNT);
-
-        /*s0n = s1n - ((d1c + d1n + 2) >> 2);*/
-        s0n_0 = SUB(s1n_0, SAR(ADD3(d1c_0, d1n_0, two), 2));
-        s0n_1 = SUB(s1n_1, SAR(ADD3(d1c_1, d1n_1, two), 2));
-
-        STORE(tmp + PLL_COLS_53 * (i + 0), s0c_0);
-        STORE(tmp + PLL_COLS_53 * (i + 0) + VREG_INT_COUNT, s0c_1);
-
-        /* d1c + ((s0c + s0n) >> 1) */
-        STORE(tmp + PLL_COLS_53 * (i + 1) + 0,
-              ADD(d1c_0, SAR(ADD(s0c_0, s0n_0), 1)));
-        STORE(tmp + PLL_COLS_53 * (i + 1) + VREG_INT_COUNT,
-              ADD(d1c_1, SAR(ADD(s0c_1, s0n_1), 1)));
-    }
-
-    STORE(tmp + PLL_COLS_53 * (i + 0) + 0, s0n_0);
-    STORE(tmp + PLL_COLS_53 * (i + 0) + VREG_INT_COUNT, s0n_1);
-
-    if (len & 1) {
-        VREG tmp_len_minus_1;
-        s1n_0 = LOADU(in_even + (size_t)((len - 1) / 2) * stride);
-        /* tmp_len_minus_1 = s1n - ((d1n + 1) >> 1); */
-        tmp_len_minus_1 = SUB(s1n_0, SAR(ADD3(d1n_0, d1n_0, two), 2));
-        STORE(tmp + PLL_COLS_53 * (len - 1), tmp_len_minus_1);
-        /* d1n + ((s0n + tmp_len_minus_1) >> 1) */
-        STORE(tmp + PLL_COLS_53 * (len - 2),
-              ADD(d1n_0, SAR(ADD(s0n_0, tmp_len_minus_1), 1)));
-
-        s1n_1 = LOADU(in_even + (size_t)((len - 1) / 2) * stride + VREG_INT_COUNT);
-        /* tmp_len_minus_1 = s1n - ((d1n + 1) >> 1); */
-        tmp_len_minus_1 = SUB(s1n_1, SAR(ADD3(d1n_1, d1n_1, two), 2));
-        STORE(tmp + PLL_COLS_53 * (len - 1) + VREG_INT_COUNT,
-              tmp_len_minus_1);
-        /* d1n + ((s0n + tmp_len_minus_1) >> 1) */
-        STORE(tmp + PLL_COLS_53 * (len - 2) + VREG_INT_COUNT,
-              ADD(d1n_1, SAR(ADD(s0n_1, tmp_len_minus_1), 1)));
-    } else {
-        STORE(tmp + PLL_COLS_53 * (len - 1) + 0,
-              ADD(d1n_0, s0n_0));
-        STORE(tmp + PLL_COLS_53 * (len - 1) + VREG_INT_COUNT,
-              ADD(d1n_1, s0n_1));
-    }
-    decode_v_final_memcpy_53(tiledp_col, tmp, len, stride);
-}
-
-
-/** Vertical inverse 5x3 wavelet transform for 8 columns in SSE2, or
- * 16 in AVX2, when top-most pixel is on odd coordinate */
-static void decode_v_cas1_mcols_SSE2_OR_AVX2_53(
-    int32_t* tmp,
-    const int32_t sn,
-    const int32_t len,
-    int32_t* tiledp_col,
-    const size_t stride){
-    int32_t i;
-    size_t j;
-
-    VREG s1_0, s2_0, dc_0, dn_0;
-    VREG s1_1, s2_1, dc_1, dn_1;
-    const VREG two = LOAD_CST(2);
-
-    const int32_t* in_even = &tiledp_col[(size_t)sn * stride];
-    const int32_t* in_odd = &tiledp_col[0];
-
-    assert(len > 2);
-#if __AVX2__
-    assert(PLL_COLS_53 == 16);
-    assert(VREG_INT_COUNT == 8);
-#else
-    assert(PLL_COLS_53 == 8);
-    assert(VREG_INT_COUNT == 4);
-#endif
-
-    /* Note: loads of input even/odd values must be done in a unaligned */
-    /* fashion. But stores in tmp can be done with aligned store, since */
-    /* the temporary buffer is properly aligned */
-    assert((size_t)tmp % (sizeof(int32_t) * VREG_INT_COUNT) == 0);
-
-    s1_0 = LOADU(in_even + stride);
-    /* in_odd[0] - ((in_even[0] + s1 + 2) >> 2); */
-    dc_0 = SUB(LOADU(in_odd + 0),
-               SAR(ADD3(LOADU(in_even + 0), s1_0, two), 2));
-    STORE(tmp + PLL_COLS_53 * 0, ADD(LOADU(in_even + 0), dc_0));
-
-    s1_1 = LOADU(in_even + stride + VREG_INT_COUNT);
-    /* in_odd[0] - ((in_even[0] + s1 + 2) >> 2); */
-    dc_1 = SUB(LOADU(in_odd + VREG_INT_COUNT),
-               SAR(ADD3(LOADU(in_even + VREG_INT_COUNT), s1_1, two), 2));
-    STORE(tmp + PLL_COLS_53 * 0 + VREG_INT_COUNT,
-          ADD(LOADU(in_even + VREG_INT_COUNT), dc_1));
-
-    for (i = 1, j = 1; i < (len - 2 - !(len & 1)); i += 2, j++) {
-
-        s2_0 = LOADU(in_even + (j + 1) * stride);
-        s2_1 = LOADU(in_even + (j + 1) * stride + VREG_INT_COUNT);
-
-        /* dn = in_odd[j * stride] - ((s1 + s2 + 2) >> 2); */
-        dn_0 = SUB(LOADU(in_odd + j * stride),
-                   SAR(ADD3(s1_0, s2_0, two), 2));
-        dn_1 = SUB(LOADU(in_odd + j * stride + VREG_INT_COUNT),
-                   SAR(ADD3(s1_1, s2_1, two), 2));
-
-        STORE(tmp + PLL_COLS_53 * i, dc_0);
-        STORE(tmp + PLL_COLS_53 * i + VREG_INT_COUNT, dc_1);
-
-        /* tmp[i + 1] = s1 + ((dn + dc) >> 1); */
-        STORE(tmp + PLL_COLS_53 * (i + 1) + 0,
-              ADD(s1_0, SAR(ADD(dn_0, dc_0), 1)));
-        STORE(tmp + PLL_COLS_53 * (i + 1) + VREG_INT_COUNT,
-              ADD(s1_1, SAR(ADD(dn_1, dc_1), 1)));
-
-        dc_0 = dn_0;
-        s1_0 = s2_0;
-        dc_1 = dn_1;
-        s1_1 = s2_1;
-    }
-    STORE(tmp + PLL_COLS_53 * i, dc_0);
-    STORE(tmp + PLL_COLS_53 * i + VREG_INT_COUNT, dc_1);
-
-    if (!(len & 1)) {
-        /*dn = in_odd[(len / 2 - 1) * stride] - ((s1 + 1) >> 1); */
-        dn_0 = SUB(LOADU(in_odd + (size_t)(len / 2 - 1) * stride),
-                   SAR(ADD3(s1_0, s1_0, two), 2));
-        dn_1 = SUB(LOADU(in_odd + (size_t)(len / 2 - 1) * stride + VREG_INT_COUNT),
-                   SAR(ADD3(s1_1, s1_1, two), 2));
-
-        /* tmp[len - 2] = s1 + ((dn + dc) >> 1); */
-        STORE(tmp + PLL_COLS_53 * (len - 2) + 0,
-              ADD(s1_0, SAR(ADD(dn_0, dc_0), 1)));
-        STORE(tmp + PLL_COLS_53 * (len - 2) + VREG_INT_COUNT,
-              ADD(s1_1, SAR(ADD(dn_1, dc_1), 1)));
-
-        STORE(tmp + PLL_COLS_53 * (len - 1) + 0, dn_0);
-        STORE(tmp + PLL_COLS_53 * (len - 1) + VREG_INT_COUNT, dn_1);
-    } else {
-        STORE(tmp + PLL_COLS_53 * (len - 1) + 0, ADD(s1_0, dc_0));
-        STORE(tmp + PLL_COLS_53 * (len - 1) + VREG_INT_COUNT,
-              ADD(s1_1, dc_1));
-    }
-    decode_v_final_memcpy_53(tiledp_col, tmp, len, stride);
-}
-
-#undef VREG
-#undef LOAD_CST
-#undef LOADU
-#undef LOAD
-#undef STORE
-#undef STOREU
-#undef ADD
-#undef ADD3
-#undef SUB
-#undef SAR
-
-#endif /* (defined(__SSE2__) || defined(__AVX2__)) */
-
-/** Vertical inverse 5x3 wavelet transform for one column, when top-most
- * pixel is on even coordinate */
-static void decode_v_cas0_53(int32_t* tmp,
-                             const int32_t sn,
-                             const int32_t len,
-                             int32_t* tiledp_col,
-                             const size_t stride){
-    int32_t i, j;
-    int32_t d1c, d1n, s1n, s0c, s0n;
-
-    assert(len > 1);
-
-    /* Performs lifting in one single iteration. Saves memory */
-    /* accesses and explicit interleaving. */
-
-    s1n = tiledp_col[0];
-    d1n = tiledp_col[(size_t)sn * stride];
-    s0n = s1n - ((d1n + 1) >> 1);
-
-    for (i = 0, j = 0; i < (len - 3); i += 2, j++) {
-        d1c = d1n;
-        s0c = s0n;
-
-        s1n = tiledp_col[(size_t)(j + 1) * stride];
-        d1n = tiledp_col[(size_t)(sn + j + 1) * stride];
-
-        s0n = s1n - ((d1c + d1n + 2) >> 2);
-
-        tmp[i  ] = s0c;
-        tmp[i + 1] = d1c + ((s0c + s0n) >> 1);
-    }
-
-    tmp[i] = s0n;
-
-    if (len & 1) {
-        tmp[len - 1] =
-            tiledp_col[(size_t)((len - 1) / 2) * stride] -
-            ((d1n + 1) >> 1);
-        tmp[len - 2] = d1n + ((s0n + tmp[len - 1]) >> 1);
-    } else {
-        tmp[len - 1] = d1n + s0n;
-    }
-
-    for (i = 0; i < len; ++i) {
-        tiledp_col[(size_t)i * stride] = tmp[i];
-    }
-}
-
-
-/** Vertical inverse 5x3 wavelet transform for one column, when top-most
- * pixel is on odd coordinate */
-static void decode_v_cas1_53(int32_t* tmp,
-                             const int32_t sn,
-                             const int32_t len,
-                             int32_t* tiledp_col,
-                             const size_t stride){
-    int32_t i, j;
-    int32_t s1, s2, dc, dn;
-    const int32_t* in_even = &tiledp_col[(size_t)sn * stride];
-    const int32_t* in_odd = &tiledp_col[0];
-
-    assert(len > 2);
-
-    /* Performs lifting in one single iteration. Saves memory */
-    /* accesses and explicit interleaving. */
-
-    s1 = in_even[stride];
-    dc = in_odd[0] - ((in_even[0] + s1 + 2) >> 2);
-    tmp[0] = in_even[0] + dc;
-    for (i = 1, j = 1; i < (len - 2 - !(len & 1)); i += 2, j++) {
-
-        s2 = in_even[(size_t)(j + 1) * stride];
-
-        dn = in_odd[(size_t)j * stride] - ((s1 + s2 + 2) >> 2);
-        tmp[i  ] = dc;
-        tmp[i + 1] = s1 + ((dn + dc) >> 1);
-
-        dc = dn;
-        s1 = s2;
-    }
-    tmp[i] = dc;
-    if (!(len & 1)) {
-        dn = in_odd[(size_t)(len / 2 - 1) * stride] - ((s1 + 1) >> 1);
-        tmp[len - 2] = s1 + ((dn + dc) >> 1);
-        tmp[len - 1] = dn;
-    } else {
-        tmp[len - 1] = s1 + dc;
-    }
-
-    for (i = 0; i < len; ++i) {
-        tiledp_col[(size_t)i * stride] = tmp[i];
-    }
-}
-
 /* <summary>                            */
 /* Inverse vertical 5-3 wavelet transform in 1-D for several columns. */
 /* </summary>                           */
@@ -656,20 +304,9 @@ static void decode_v_53(const dwt_data_53 *dwt,
     const int32_t len = sn + dwt->dn;
     if (dwt->cas == 0) {
         /* If len == 1, unmodified value */
-
-#if (defined(__SSE2__) || defined(__AVX2__))
-        if (len > 1 && nb_cols == PLL_COLS_53) {
-            /* Same as below general case, except that thanks to SSE2/AVX2 */
-            /* we can efficiently process 8/16 columns in parallel */
-            decode_v_cas0_mcols_SSE2_OR_AVX2_53(dwt->mem, sn, len, tiledp_col, stride);
-            return;
-        }
-#endif
         if (len > 1) {
-            int32_t c;
-            for (c = 0; c < nb_cols; c++, tiledp_col++) {
-                decode_v_cas0_53(dwt->mem, sn, len, tiledp_col, stride);
-            }
+            Kernels::g_kernels->decode_v_cas0_53(dwt->mem, sn, len, tiledp_col,
+                                                 stride, nb_cols);
             return;
         }
     } else {
@@ -700,19 +337,9 @@ static void decode_v_53(const dwt_data_53 *dwt,
             return;
         }
 
-#if (defined(__SSE2__) || defined(__AVX2__))
-        if (len > 2 && nb_cols == PLL_COLS_53) {
-            /* Same as below general case, except that thanks to SSE2/AVX2 */
-            /* we can efficiently process 8/16 columns in parallel */
-            decode_v_cas1_mcols_SSE2_OR_AVX2_53(dwt->mem, sn, len, tiledp_col, stride);
-            return;
-        }
-#endif
         if (len > 2) {
-            int32_t c;
-            for (c = 0; c < nb_cols; c++, tiledp_col++) {
-                decode_v_cas1_53(dwt->mem, sn, len, tiledp_col, stride);
-            }
+            Kernels::g_kernels->decode_v_cas1_53(dwt->mem, sn, len, tiledp_col,
+                                                 stride, nb_cols);
             return;
         }
     }
@@ -733,7 +360,7 @@ bool decode_53(TileProcessor *p_tcd, TileComponent* tilec,
                         uint32_t numres)
 {
     if (p_tcd->whole_tile_decoding) {
-        return decode_tile_53(tilec,numres);
+        return decode_tile_53(tilec, 1, numres);
     } else {
         return decode_partial_tile_53(tilec, numres);
     }
@@ -760,13 +387,15 @@ static uint32_t max_resolution(grk_tcd_resolution* restrict r,
 }
 
 /* <summary>                            */
-/* Inverse wavelet transform in 2-D.    */
+/* Inverse wavelet transform in 2-D,    */
+/* for resolutions first_res..numres-1  */
 /* </summary>                           */
-static bool decode_tile_53( TileComponent* tilec, uint32_t numres){
-    if (numres == 1U)
+static bool decode_tile_53( TileComponent* tilec, uint32_t first_res, uint32_t numres){
+    if (numres <= first_res)
         return true;
 
-    auto tr = tilec->resolutions;
+    auto tr = tilec->resolutions + first_res - 1;
+    numres -= first_res - 1;
 
     /* width of the resolution level computed */
     uint32_t rw = (uint32_t)(tr->x1 - tr->x0);
@@ -777,27 +406,30 @@ static bool decode_tile_53( TileComponent* tilec, uint32_t numres){
                                 tilec->resolutions[tilec->minimum_num_resolutions - 1].x0);
 
     size_t num_threads = Scheduler::g_tp->num_threads();
+    /* number of columns that the vertical pass processes at a time */
+    const uint32_t pll_cols = Kernels::g_kernels->pll_cols_53;
     size_t h_mem_size = max_resolution(tr, numres);
     /* overflow check */
-    if (h_mem_size > (SIZE_MAX / PLL_COLS_53 / sizeof(int32_t))) {
+    if (h_mem_size > (SIZE_MAX / pll_cols / sizeof(int32_t))) {
         GROK_ERROR("Overflow");
         return false;
     }
-    /* We need PLL_COLS_53 times the height of the array, */
+    /* We need pll_cols times the height of the array, */
     /* since for the vertical pass */
-    /* we process PLL_COLS_53 columns at a time */
+    /* we process pll_cols columns at a time */
     dwt_data_53 h;
-    h_mem_size *= PLL_COLS_53 * sizeof(int32_t);
-    h.mem = (int32_t*)grok_aligned_malloc(h_mem_size);
+    h_mem_size *= pll_cols * sizeof(int32_t);
+    auto arena = WorkerArena::get();
+    h.mem = (int32_t*)arena->get_buffer(h_mem_size);
     if (! h.mem) {
         GROK_ERROR("Out of memory");
         return false;
     }
     dwt_data_53 v;
     v.mem = h.mem;
-    bool rc = true;
+    std::atomic<bool> rc(true);
     int32_t * restrict tiledp = tilec->buf->get_ptr( 0, 0, 0, 0);
-    while (--numres) {
+    while (--numres && rc) {
         ++tr;
         h.sn = (int32_t)rw;
         v.sn = (int32_t)rh;
@@ -816,31 +448,28 @@ static bool decode_tile_53( TileComponent* tilec, uint32_t numres){
             if (rh < num_jobs)
                 num_jobs = rh;
             uint32_t step_j = (rh / num_jobs);
-			std::vector< std::future<int> > results;
+			std::vector< decode_job<dwt_data_53> > jobs;
 			for(uint32_t j = 0; j < num_jobs; ++j) {
-               auto job = new decode_job<dwt_data_53>(h,
-											w,
-											tiledp,
-											j * step_j,
-											j < (num_jobs - 1U) ? (j + 1U) * step_j : rh);
-                job->data.mem = (int32_t*)grok_aligned_malloc(h_mem_size);
-                if (!job->data.mem) {
-                    GROK_ERROR("Out of memory");
-                    grok_aligned_free(h.mem);
-                    return false;
-                }
-				results.emplace_back(
-					Scheduler::g_tp->enqueue([job] {
-					    for (uint32_t j = job->min_j; j < job->max_j; j++)
-					        decode_h_53(&job->data, &job->tiledp[j * job->w]);
-					    grok_aligned_free(job->data.mem);
-					    delete job;
-						return 0;
-					})
-				);
+				jobs.emplace_back(h,
+								w,
+								tiledp,
+								j * step_j,
+								j < (num_jobs - 1U) ? (j + 1U) * step_j : rh);
 			}
-			for(auto && result: results)
-				result.get();
+			Scheduler::g_tp->parallel_for(num_jobs, [&jobs, &rc, h_mem_size](size_t index) {
+				auto job = &jobs[index];
+				// lease from the arena of the worker that runs the job
+				auto job_arena = WorkerArena::get();
+				job->data.mem = (int32_t*)job_arena->get_buffer(h_mem_size);
+				if (!job->data.mem) {
+					GROK_ERROR("Out of memory");
+					rc = false;
+					return;
+				}
+				for (uint32_t j = job->min_j; j < job->max_j; j++)
+					decode_h_53(&job->data, &job->tiledp[j * job->w]);
+				job_arena->put_buffer(job->data.mem);
+			});
         }
 
         v.dn = (int32_t)(rh - (uint32_t)v.sn);
@@ -848,8 +477,8 @@ static bool decode_tile_53( TileComponent* tilec, uint32_t numres){
 
         if (num_threads <= 1 || rw <= 1) {
             uint32_t j;
-            for (j = 0; j + PLL_COLS_53 <= rw; j += PLL_COLS_53)
-                decode_v_53(&v, &tiledp[j], (size_t)w, PLL_COLS_53);
+            for (j = 0; j + pll_cols <= rw; j += pll_cols)
+                decode_v_53(&v, &tiledp[j], (size_t)w, (int32_t)pll_cols);
             if (j < rw)
                 decode_v_53(&v, &tiledp[j], (size_t)w, (int32_t)(rw - j));
         } else {
@@ -857,37 +486,33 @@ static bool decode_tile_53( TileComponent* tilec, uint32_t numres){
             if (rw < num_jobs)
                 num_jobs = rw;
             uint32_t step_j = (rw / num_jobs);
-			std::vector< std::future<int> > results;
+			std::vector< decode_job<dwt_data_53> > jobs;
             for (uint32_t j = 0; j < num_jobs; j++) {
-                auto job = new decode_job<dwt_data_53>(v,
-											w,
-											tiledp,
-											j * step_j,
-											j < (num_jobs - 1U) ? (j + 1U) * step_j : rw);
-                job->data.mem = (int32_t*)grok_aligned_malloc(h_mem_size);
-                if (!job->data.mem) {
-                    GROK_ERROR("Out of memory");
-                    grok_aligned_free(v.mem);
-                    return false;
-                }
-				results.emplace_back(
-					Scheduler::g_tp->enqueue([job] {
-						uint32_t j;
-						for (j = job->min_j; j + PLL_COLS_53 <= job->max_j;	j += PLL_COLS_53)
-							decode_v_53(&job->data, &job->tiledp[j], (size_t)job->w, PLL_COLS_53);
-						if (j < job->max_j)
-							decode_v_53(&job->data, &job->tiledp[j], (size_t)job->w, (int32_t)(job->max_j - j));
-						grok_aligned_free(job->data.mem);
-						delete job;
-					return 0;
-					})
-				);
+				jobs.emplace_back(v,
+								w,
+								tiledp,
+								j * step_j,
+								j < (num_jobs - 1U) ? (j + 1U) * step_j : rw);
             }
-			for(auto && result: results)
-				result.get();
+			Scheduler::g_tp->parallel_for(num_jobs, [&jobs, &rc, h_mem_size, pll_cols](size_t index) {
+				auto job = &jobs[index];
+				auto job_arena = WorkerArena::get();
+				job->data.mem = (int32_t*)job_arena->get_buffer(h_mem_size);
+				if (!job->data.mem) {
+					GROK_ERROR("Out of memory");
+					rc = false;
+					return;
+				}
+				uint32_t j;
+				for (j = job->min_j; j + pll_cols <= job->max_j;	j += pll_cols)
+					decode_v_53(&job->data, &job->tiledp[j], (size_t)job->w, (int32_t)pll_cols);
+				if (j < job->max_j)
+					decode_v_53(&job->data, &job->tiledp[j], (size_t)job->w, (int32_t)(job->max_j - j));
+				job_arena->put_buffer(job->data.mem);
+			});
         }
     }
-    grok_aligned_free(h.mem);
+    arena->put_buffer(h.mem);
 
     return rc;
 }
@@ -1328,7 +953,8 @@ static bool decode_partial_tile_53(
     }
 
     h_mem_size *= 4 * sizeof(int32_t);
-    h.mem = (int32_t*)grok_aligned_malloc(h_mem_size);
+    auto arena = WorkerArena::get();
+    h.mem = (int32_t*)arena->get_buffer(h_mem_size);
     if (! h.mem) {
         /* FIXME event manager error callback */
         sparse_array_int32_free(sa);
@@ -1457,7 +1083,7 @@ static bool decode_partial_tile_53(
                                                   1, 0, true)) {
                     /* FIXME event manager error callback */
                     sparse_array_int32_free(sa);
-                    grok_aligned_free(h.mem);
+                    arena->put_buffer(h.mem);
                     return false;
                 }
             }
@@ -1487,14 +1113,14 @@ static bool decode_partial_tile_53(
                                               1, 4, true)) {
                 /* FIXME event manager error callback */
                 sparse_array_int32_free(sa);
-                grok_aligned_free(h.mem);
+                arena->put_buffer(h.mem);
                 return false;
             }
 
             i += nb_cols;
         }
     }
-    grok_aligned_free(h.mem);
+    arena->put_buffer(h.mem);
 	bool ret = sparse_array_int32_read(sa,
 				   tr_max->win_x0 - (uint32_t)tr_max->x0,
 				   tr_max->win_y0 - (uint32_t)tr_max->y0,
@@ -1514,7 +1140,7 @@ static void interleave_h_97(dwt_data_97* restrict dwt,
                                    float* restrict a,
                                    uint32_t width,
                                    uint32_t remaining_height){
-    float* restrict bi = (float*)(dwt->wavelet + dwt->cas);
+    float* restrict bi = dwt->wavelet + dwt->cas * 4;
     uint32_t i, k;
     uint32_t x0 = dwt->win_l_x0;
     uint32_t x1 = dwt->win_l_x1;
@@ -1556,7 +1182,7 @@ static void interleave_h_97(dwt_data_97* restrict dwt,
             }
         }
 
-        bi = (float*)(dwt->wavelet + 1 - dwt->cas);
+        bi = dwt->wavelet + (1 - dwt->cas) * 4;
         a += dwt->sn;
         x0 = dwt->win_h_x0;
         x1 = dwt->win_h_x1;
@@ -1574,14 +1200,14 @@ static void interleave_partial_h_97(dwt_data_97* dwt,
                                           dwt->win_l_x0, sa_line + i,
                                           dwt->win_l_x1, sa_line + i + 1,
                                           /* Nasty cast from float* to int32* */
-                                          (int32_t*)(dwt->wavelet + dwt->cas + 2 * dwt->win_l_x0) + i,
+                                          (int32_t*)(dwt->wavelet + (dwt->cas + 2 * dwt->win_l_x0) * 4) + i,
                                           8, 0, true);
         assert(ret);
         ret = sparse_array_int32_read(sa,
                                           (uint32_t)dwt->sn + dwt->win_h_x0, sa_line + i,
                                           (uint32_t)dwt->sn + dwt->win_h_x1, sa_line + i + 1,
                                           /* Nasty cast from float* to int32* */
-                                          (int32_t*)(dwt->wavelet + 1 - dwt->cas + 2 * dwt->win_h_x0) + i,
+                                          (int32_t*)(dwt->wavelet + (1 - dwt->cas + 2 * dwt->win_h_x0) * 4) + i,
                                           8, 0, true);
         assert(ret);
         GRK_UNUSED(ret);
@@ -1592,19 +1218,20 @@ static void interleave_v_97(dwt_data_97* restrict dwt,
                                    float* restrict a,
                                    uint32_t width,
                                    uint32_t nb_elts_read){
-    v4_data* restrict bi = dwt->wavelet + dwt->cas;
+    const uint32_t cols = dwt->cols;
+    float* restrict bi = dwt->wavelet + dwt->cas * cols;
     uint32_t i;
 
     for (i = dwt->win_l_x0; i < dwt->win_l_x1; ++i) {
-        memcpy(&bi[i * 2], &a[i * (size_t)width],
+        memcpy(&bi[i * 2 * cols], &a[i * (size_t)width],
                (size_t)nb_elts_read * sizeof(float));
     }
 
     a += (uint32_t)dwt->sn * (size_t)width;
-    bi = dwt->wavelet + 1 - dwt->cas;
+    bi = dwt->wavelet + (1 - dwt->cas) * cols;
 
     for (i = dwt->win_h_x0; i < dwt->win_h_x1; ++i) {
-        memcpy(&bi[i * 2], &a[i * (size_t)width],
+        memcpy(&bi[i * 2 * cols], &a[i * (size_t)width],
                (size_t)nb_elts_read * sizeof(float));
     }
 }
@@ -1613,164 +1240,27 @@ static void interleave_partial_v_97(dwt_data_97* restrict dwt,
         sparse_array_int32_t* sa,
         uint32_t sa_col,
         uint32_t nb_elts_read){
+    const uint32_t cols = dwt->cols;
     bool ret;
     ret = sparse_array_int32_read(sa,
                                       sa_col, dwt->win_l_x0,
                                       sa_col + nb_elts_read, dwt->win_l_x1,
-                                      (int32_t*)(dwt->wavelet + dwt->cas + 2 * dwt->win_l_x0),
-                                      1, 8, true);
+                                      (int32_t*)(dwt->wavelet + (dwt->cas + 2 * dwt->win_l_x0) * cols),
+                                      1, 2 * cols, true);
     assert(ret);
     ret = sparse_array_int32_read(sa,
                                       sa_col, (uint32_t)dwt->sn + dwt->win_h_x0,
                                       sa_col + nb_elts_read, (uint32_t)dwt->sn + dwt->win_h_x1,
-                                      (int32_t*)(dwt->wavelet + 1 - dwt->cas + 2 * dwt->win_h_x0),
-                                      1, 8, true);
+                                      (int32_t*)(dwt->wavelet + (1 - dwt->cas + 2 * dwt->win_h_x0) * cols),
+                                      1, 2 * cols, true);
     assert(ret);
     GRK_UNUSED(ret);
 }
 
-#ifdef __SSE__
-static void decode_step1_sse_97(v4_data* w,
-                                       uint32_t start,
-                                       uint32_t end,
-                                       const __m128 c){
-    __m128* restrict vw = (__m128*) w;
-    uint32_t i;
-    /* 4x unrolled loop */
-    vw += 2 * start;
-    for (i = start; i + 3 < end; i += 4, vw += 8) {
-        __m128 xmm0 = _mm_mul_ps(vw[0], c);
-        __m128 xmm2 = _mm_mul_ps(vw[2], c);
-        __m128 xmm4 = _mm_mul_ps(vw[4], c);
-        __m128 xmm6 = _mm_mul_ps(vw[6], c);
-        vw[0] = xmm0;
-        vw[2] = xmm2;
-        vw[4] = xmm4;
-        vw[6] = xmm6;
-    }
-    for (; i < end; ++i, vw += 2) {
-        vw[0] = _mm_mul_ps(vw[0], c);
-    }
-}
-
-static void decode_step2_sse_97(v4_data* l, v4_data* w,
-                                       uint32_t start,
-                                       uint32_t end,
-                                       uint32_t m,
-                                       __m128 c){
-    __m128* restrict vl = (__m128*) l;
-    __m128* restrict vw = (__m128*) w;
-    uint32_t i;
-    uint32_t imax = min<uint32_t>(end, m);
-    __m128 tmp1, tmp2, tmp3;
-    if (start == 0) {
-        tmp1 = vl[0];
-    } else {
-        vw += start * 2;
-        tmp1 = vw[-3];
-    }
-
-    i = start;
-
-    /* 4x loop unrolling */
-    for (; i + 3 < imax; i += 4) {
-        __m128 tmp4, tmp5, tmp6, tmp7, tmp8, tmp9;
-        tmp2 = vw[-1];
-        tmp3 = vw[ 0];
-        tmp4 = vw[ 1];
-        tmp5 = vw[ 2];
-        tmp6 = vw[ 3];
-        tmp7 = vw[ 4];
-        tmp8 = vw[ 5];
-        tmp9 = vw[ 6];
-        vw[-1] = _mm_add_ps(tmp2, _mm_mul_ps(_mm_add_ps(tmp1, tmp3), c));
-        vw[ 1] = _mm_add_ps(tmp4, _mm_mul_ps(_mm_add_ps(tmp3, tmp5), c));
-        vw[ 3] = _mm_add_ps(tmp6, _mm_mul_ps(_mm_add_ps(tmp5, tmp7), c));
-        vw[ 5] = _mm_add_ps(tmp8, _mm_mul_ps(_mm_add_ps(tmp7, tmp9), c));
-        tmp1 = tmp9;
-        vw += 8;
-    }
-
-    for (; i < imax; ++i) {
-        tmp2 = vw[-1];
-        tmp3 = vw[ 0];
-        vw[-1] = _mm_add_ps(tmp2, _mm_mul_ps(_mm_add_ps(tmp1, tmp3), c));
-        tmp1 = tmp3;
-        vw += 2;
-    }
-    if (m < end) {
-        assert(m + 1 == end);
-        c = _mm_add_ps(c, c);
-        c = _mm_mul_ps(c, vw[-2]);
-        vw[-1] = _mm_add_ps(vw[-1], c);
-    }
-}
-#else
-static void decode_step1_97(v4_data* w,
-                                   uint32_t start,
-                                   uint32_t end,
-                                   const float c){
-    float* restrict fw = (float*) w;
-    uint32_t i;
-    for (i = start; i < end; ++i) {
-        float tmp1 = fw[i * 8    ];
-        float tmp2 = fw[i * 8 + 1];
-        float tmp3 = fw[i * 8 + 2];
-        float tmp4 = fw[i * 8 + 3];
-        fw[i * 8    ] = tmp1 * c;
-        fw[i * 8 + 1] = tmp2 * c;
-        fw[i * 8 + 2] = tmp3 * c;
-        fw[i * 8 + 3] = tmp4 * c;
-    }
-}
-static void decode_step2_97(v4_data* l, v4_data* w,
-                                   uint32_t start,
-                                   uint32_t end,
-                                   uint32_t m,
-                                   float c){
-    float* fl = (float*) l;
-    float* fw = (float*) w;
-    uint32_t i;
-    uint32_t imax = min<uint32_t>(end, m);
-    if (start > 0) {
-        fw += 8 * start;
-        fl = fw - 8;
-    }
-    for (i = start; i < imax; ++i) {
-        float tmp1_1 = fl[0];
-        float tmp1_2 = fl[1];
-        float tmp1_3 = fl[2];
-        float tmp1_4 = fl[3];
-        float tmp2_1 = fw[-4];
-        float tmp2_2 = fw[-3];
-        float tmp2_3 = fw[-2];
-        float tmp2_4 = fw[-1];
-        float tmp3_1 = fw[0];
-        float tmp3_2 = fw[1];
-        float tmp3_3 = fw[2];
-        float tmp3_4 = fw[3];
-        fw[-4] = tmp2_1 + ((tmp1_1 + tmp3_1) * c);
-        fw[-3] = tmp2_2 + ((tmp1_2 + tmp3_2) * c);
-        fw[-2] = tmp2_3 + ((tmp1_3 + tmp3_3) * c);
-        fw[-1] = tmp2_4 + ((tmp1_4 + tmp3_4) * c);
-        fl = fw;
-        fw += 8;
-    }
-    if (m < end) {
-        assert(m + 1 == end);
-        c += c;
-        fw[-4] = fw[-4] + fl[0] * c;
-        fw[-3] = fw[-3] + fl[1] * c;
-        fw[-2] = fw[-2] + fl[2] * c;
-        fw[-1] = fw[-1] + fl[3] * c;
-    }
-}
-#endif
-
 /* <summary>                             */
 /* Inverse 9-7 wavelet transform in 1-D. */
 /* </summary>                            */
-static void decode_step_97(dwt_data_97* restrict dwt)
+static void decode_step_97(dwt_data_97* restrict dwt, bool vertical)
 {
     int32_t a, b;
 
@@ -1787,49 +1277,30 @@ static void decode_step_97(dwt_data_97* restrict dwt)
         a = 1;
         b = 0;
     }
-#ifdef __SSE__
-    decode_step1_sse_97(dwt->wavelet + a, dwt->win_l_x0, dwt->win_l_x1,
-                               _mm_set1_ps(K));
-    decode_step1_sse_97(dwt->wavelet + b, dwt->win_h_x0, dwt->win_h_x1,
-                               _mm_set1_ps(c13318));
-    decode_step2_sse_97(dwt->wavelet + b, dwt->wavelet + a + 1,
-                               dwt->win_l_x0, dwt->win_l_x1,
-                               (uint32_t)min<int32_t>(dwt->sn, dwt->dn - a),
-                               _mm_set1_ps(dwt_delta));
-    decode_step2_sse_97(dwt->wavelet + a, dwt->wavelet + b + 1,
-                               dwt->win_h_x0, dwt->win_h_x1,
-                               (uint32_t)min<int32_t>(dwt->dn, dwt->sn - b),
-                               _mm_set1_ps(dwt_gamma));
-    decode_step2_sse_97(dwt->wavelet + b, dwt->wavelet + a + 1,
-                               dwt->win_l_x0, dwt->win_l_x1,
-                               (uint32_t)min<int32_t>(dwt->sn, dwt->dn - a),
-                               _mm_set1_ps(dwt_beta));
-    decode_step2_sse_97(dwt->wavelet + a, dwt->wavelet + b + 1,
-                               dwt->win_h_x0, dwt->win_h_x1,
-                               (uint32_t)min<int32_t>(dwt->dn, dwt->sn - b),
-                               _mm_set1_ps(dwt_alpha));
-#else
-    decode_step1_97(dwt->wavelet + a, dwt->win_l_x0, dwt->win_l_x1,
-                           K);
-    decode_step1_97(dwt->wavelet + b, dwt->win_h_x0, dwt->win_h_x1,
-                           c13318);
-    decode_step2_97(dwt->wavelet + b, dwt->wavelet + a + 1,
-                           dwt->win_l_x0, dwt->win_l_x1,
-                           (uint32_t)min<int32_t>(dwt->sn, dwt->dn - a),
-                           dwt_delta);
-    decode_step2_97(dwt->wavelet + a, dwt->wavelet + b + 1,
-                           dwt->win_h_x0, dwt->win_h_x1,
-                           (uint32_t)min<int32_t>(dwt->dn, dwt->sn - b),
-                           dwt_gamma);
-    decode_step2_97(dwt->wavelet + b, dwt->wavelet + a + 1,
-                           dwt->win_l_x0, dwt->win_l_x1,
-                           (uint32_t)min<int32_t>(dwt->sn, dwt->dn - a),
-                           dwt_beta);
-    decode_step2_97(dwt->wavelet + a, dwt->wavelet + b + 1,
-                           dwt->win_h_x0, dwt->win_h_x1,
-                           (uint32_t)min<int32_t>(dwt->dn, dwt->sn - b),
-                           dwt_alpha);
-#endif
+    auto kernels = Kernels::g_kernels;
+    auto step1 = vertical ? kernels->decode_v_step1_97 : kernels->decode_h_step1_97;
+    auto step2 = vertical ? kernels->decode_v_step2_97 : kernels->decode_h_step2_97;
+    const uint32_t cols = dwt->cols;
+    float* wa = dwt->wavelet + a * cols;
+    float* wb = dwt->wavelet + b * cols;
+    step1(wa, dwt->win_l_x0, dwt->win_l_x1, K);
+    step1(wb, dwt->win_h_x0, dwt->win_h_x1, c13318);
+    step2(wb, wa + cols,
+          dwt->win_l_x0, dwt->win_l_x1,
+          (uint32_t)min<int32_t>(dwt->sn, dwt->dn - a),
+          dwt_delta);
+    step2(wa, wb + cols,
+          dwt->win_h_x0, dwt->win_h_x1,
+          (uint32_t)min<int32_t>(dwt->dn, dwt->sn - b),
+          dwt_gamma);
+    step2(wb, wa + cols,
+          dwt->win_l_x0, dwt->win_l_x1,
+          (uint32_t)min<int32_t>(dwt->sn, dwt->dn - a),
+          dwt_beta);
+    step2(wa, wb + cols,
+          dwt->win_h_x0, dwt->win_h_x1,
+          (uint32_t)min<int32_t>(dwt->dn, dwt->sn - b),
+          dwt_alpha);
 }
 
 
@@ -1837,11 +1308,12 @@ static void decode_step_97(dwt_data_97* restrict dwt)
 /* Inverse 9-7 wavelet transform in 2-D. */
 /* </summary>                            */
 static
-bool decode_tile_97(TileComponent* restrict tilec,uint32_t numres){
-    if (numres == 1U)
+bool decode_tile_97(TileComponent* restrict tilec, uint32_t first_res, uint32_t numres){
+    if (numres <= first_res)
         return true;
 
-    grk_tcd_resolution* res = tilec->resolutions;
+    grk_tcd_resolution* res = tilec->resolutions + first_res - 1;
+    numres -= first_res - 1;
     /* width of the resolution level computed */
     uint32_t rw = (uint32_t)(res->x1 - res->x0);
     /* height of the resolution level computed */
@@ -1856,19 +1328,25 @@ bool decode_tile_97(TileComponent* restrict tilec,uint32_t numres){
         return false;
     }
     l_data_size += 5U;
+    /* the vertical pass interleaves pll_cols columns, the horizontal pass 4 rows */
+    const uint32_t pll_cols = Kernels::g_kernels->pll_cols_97;
+    const uint32_t max_cols = max<uint32_t>(pll_cols, 4);
     /* overflow check */
-    if (l_data_size > (SIZE_MAX / sizeof(v4_data))) {
+    if (l_data_size > (SIZE_MAX / (max_cols * sizeof(float)))) {
         /* FIXME event manager error callback */
         return false;
     }
     dwt_data_97 h;
     dwt_data_97 v;
-    h.wavelet = (v4_data*) grok_aligned_malloc(l_data_size * sizeof(v4_data));
+    auto arena = WorkerArena::get();
+    h.wavelet = (float*) arena->get_buffer(l_data_size * max_cols * sizeof(float));
     if (!h.wavelet) {
         /* FIXME event manager error callback */
         return false;
     }
+    h.cols = 4;
     v.wavelet = h.wavelet;
+    v.cols = pll_cols;
     while (--numres) {
         h.sn = (int32_t)rw;
         v.sn = (int32_t)rh;
@@ -1887,28 +1365,28 @@ bool decode_tile_97(TileComponent* restrict tilec,uint32_t numres){
         float * restrict tiledp = (float*) tilec->buf->get_ptr( 0, 0, 0, 0);
         for (j = 0; j + 3 < rh; j += 4) {
             interleave_h_97(&h, tiledp, w, rh - j);
-            decode_step_97(&h);
+            decode_step_97(&h, false);
             for (uint32_t k = 0; k < rw; k++) {
-                tiledp[k      ] 			= h.wavelet[k].f[0];
-                tiledp[k + (size_t)w  ] 	= h.wavelet[k].f[1];
-                tiledp[k + (size_t)w * 2] 	= h.wavelet[k].f[2];
-                tiledp[k + (size_t)w * 3] 	= h.wavelet[k].f[3];
+                tiledp[k      ] 			= h.wavelet[k * 4];
+                tiledp[k + (size_t)w  ] 	= h.wavelet[k * 4 + 1];
+                tiledp[k + (size_t)w * 2] 	= h.wavelet[k * 4 + 2];
+                tiledp[k + (size_t)w * 3] 	= h.wavelet[k * 4 + 3];
             }
             tiledp += w * 4;
         }
         if (j < rh) {
             interleave_h_97(&h, tiledp, w, rh - j);
-            decode_step_97(&h);
+            decode_step_97(&h, false);
             for (uint32_t k = 0; k < rw; k++) {
                 switch (rh - j) {
                 case 3:
-                    tiledp[k + (size_t)w * 2] = h.wavelet[k].f[2];
+                    tiledp[k + (size_t)w * 2] = h.wavelet[k * 4 + 2];
                 /* FALLTHRU */
                 case 2:
-                    tiledp[k + (size_t)w  ] = h.wavelet[k].f[1];
+                    tiledp[k + (size_t)w  ] = h.wavelet[k * 4 + 1];
                 /* FALLTHRU */
                 case 1:
-                    tiledp[k] = h.wavelet[k].f[0];
+                    tiledp[k] = h.wavelet[k * 4];
                 }
             }
         }
@@ -1919,22 +1397,22 @@ bool decode_tile_97(TileComponent* restrict tilec,uint32_t numres){
         v.win_h_x0 = 0;
         v.win_h_x1 = (uint32_t)v.dn;
         tiledp = (float*) tilec->buf->get_ptr( 0, 0, 0, 0);
-        for (j = rw; j > 3; j -= 4) {
-            interleave_v_97(&v, tiledp, w, 4);
-            decode_step_97(&v);
+        for (j = rw; j >= pll_cols; j -= pll_cols) {
+            interleave_v_97(&v, tiledp, w, pll_cols);
+            decode_step_97(&v, true);
             for (uint32_t k = 0; k < rh; ++k)
-                memcpy(&tiledp[k * (size_t)w], &v.wavelet[k], 4 * sizeof(float));
-             tiledp += 4;
+                memcpy(&tiledp[k * (size_t)w], v.wavelet + k * pll_cols,
+                		pll_cols * sizeof(float));
+             tiledp += pll_cols;
         }
-        if (rw & 0x03) {
-            j = rw & 0x03;
+        if (j) {
             interleave_v_97(&v, tiledp, w, j);
-            decode_step_97(&v);
+            decode_step_97(&v, true);
             for (uint32_t k = 0; k < rh; ++k)
-                memcpy(&tiledp[k * (size_t)w], &v.wavelet[k],(size_t)j * sizeof(float));
+                memcpy(&tiledp[k * (size_t)w], v.wavelet + k * pll_cols,(size_t)j * sizeof(float));
         }
     }
-    grok_aligned_free(h.wavelet);
+    arena->put_buffer(h.wavelet);
 
     return true;
 }
@@ -1961,6 +1439,7 @@ bool decode_partial_tile_97(TileComponent* restrict tilec,
                                  tr->y0);    /* height of the resolution level computed */
 
     size_t l_data_size;
+    uint32_t pll_cols, max_cols;
 
     /* Compute the intersection of the area of interest, expressed in tile coordinates */
     /* with the tile coordinates */
@@ -2003,19 +1482,25 @@ bool decode_partial_tile_97(TileComponent* restrict tilec,
         return false;
     }
     l_data_size += 5U;
+    /* the vertical pass interleaves pll_cols columns, the horizontal pass 4 rows */
+    pll_cols = Kernels::g_kernels->pll_cols_97;
+    max_cols = max<uint32_t>(pll_cols, 4);
     /* overflow check */
-    if (l_data_size > (SIZE_MAX / sizeof(v4_data))) {
+    if (l_data_size > (SIZE_MAX / (max_cols * sizeof(float)))) {
         /* FIXME event manager error callback */
         sparse_array_int32_free(sa);
         return false;
     }
-    h.wavelet = (v4_data*) grok_aligned_malloc(l_data_size * sizeof(v4_data));
+    auto arena = WorkerArena::get();
+    h.wavelet = (float*) arena->get_buffer(l_data_size * max_cols * sizeof(float));
     if (!h.wavelet) {
         /* FIXME event manager error callback */
         sparse_array_int32_free(sa);
         return false;
     }
+    h.cols = 4;
     v.wavelet = h.wavelet;
+    v.cols = pll_cols;
 
     for (resno = 1; resno < numres; resno ++) {
         uint32_t j;
@@ -2105,15 +1590,15 @@ bool decode_partial_tile_97(TileComponent* restrict tilec,
                     (j + 3 >= win_lh_y0 + (uint32_t)v.sn &&
                      j < win_lh_y1 + (uint32_t)v.sn)) {
                 interleave_partial_h_97(&h, sa, j, min<uint32_t>(4U, rh - j));
-                decode_step_97(&h);
+                decode_step_97(&h, false);
                 if (!sparse_array_int32_write(sa,
                                                   win_tr_x0, j,
                                                   win_tr_x1, j + 4,
-                                                  (int32_t*)&h.wavelet[win_tr_x0].f[0],
+                                                  (int32_t*)(h.wavelet + win_tr_x0 * 4),
                                                   4, 1, true)) {
                     /* FIXME event manager error callback */
                     sparse_array_int32_free(sa);
-                    grok_aligned_free(h.wavelet);
+                    arena->put_buffer(h.wavelet);
                     return false;
                 }
             }
@@ -2123,15 +1608,15 @@ bool decode_partial_tile_97(TileComponent* restrict tilec,
                  (j + 3 >= win_lh_y0 + (uint32_t)v.sn &&
                   j < win_lh_y1 + (uint32_t)v.sn))) {
             interleave_partial_h_97(&h, sa, j, rh - j);
-            decode_step_97(&h);
+            decode_step_97(&h, false);
             if (!sparse_array_int32_write(sa,
                                               win_tr_x0, j,
                                               win_tr_x1, rh,
-                                              (int32_t*)&h.wavelet[win_tr_x0].f[0],
+                                              (int32_t*)(h.wavelet + win_tr_x0 * 4),
                                               4, 1, true)) {
                 /* FIXME event manager error callback */
                 sparse_array_int32_free(sa);
-                grok_aligned_free(h.wavelet);
+                arena->put_buffer(h.wavelet);
                 return false;
             }
         }
@@ -2139,19 +1624,19 @@ bool decode_partial_tile_97(TileComponent* restrict tilec,
         v.win_l_x1 = win_ll_y1;
         v.win_h_x0 = win_lh_y0;
         v.win_h_x1 = win_lh_y1;
-        for (j = win_tr_x0; j < win_tr_x1; j += 4) {
-            uint32_t nb_elts = min<uint32_t>(4U, win_tr_x1 - j);
+        for (j = win_tr_x0; j < win_tr_x1; j += pll_cols) {
+            uint32_t nb_elts = min<uint32_t>(pll_cols, win_tr_x1 - j);
 
             interleave_partial_v_97(&v, sa, j, nb_elts);
-            decode_step_97(&v);
+            decode_step_97(&v, true);
             if (!sparse_array_int32_write(sa,
                                               j, win_tr_y0,
                                               j + nb_elts, win_tr_y1,
-                                              (int32_t*)&h.wavelet[win_tr_y0].f[0],
-                                              1, 4, true)) {
+                                              (int32_t*)(v.wavelet + win_tr_y0 * pll_cols),
+                                              1, pll_cols, true)) {
                 /* FIXME event manager error callback */
                 sparse_array_int32_free(sa);
-                grok_aligned_free(h.wavelet);
+                arena->put_buffer(h.wavelet);
                 return false;
             }
         }
@@ -2167,7 +1652,7 @@ bool decode_partial_tile_97(TileComponent* restrict tilec,
 	assert(ret);
 	GRK_UNUSED(ret);
     sparse_array_int32_free(sa);
-    grok_aligned_free(h.wavelet);
+    arena->put_buffer(h.wavelet);
 
     return true;
 }
@@ -2176,10 +1661,18 @@ bool decode_97(TileProcessor *p_tcd,
                              TileComponent* restrict tilec,
                              uint32_t numres){
     if (p_tcd->whole_tile_decoding) {
-        return decode_tile_97(tilec, numres);
+        return decode_tile_97(tilec, 1, numres);
     } else {
         return decode_partial_tile_97(tilec, numres);
     }
 }
 
+bool decode_resolution_53(TileComponent* tilec, uint32_t resno) {
+	return resno == 0 || decode_tile_53(tilec, resno, resno + 1);
+}
+
+bool decode_resolution_97(TileComponent* tilec, uint32_t resno) {
+	return resno == 0 || decode_tile_97(tilec, resno, resno + 1);
+}
+
 }
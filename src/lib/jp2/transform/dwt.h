@@ -79,4 +79,21 @@ bool decode_97(TileProcessor *p_tcd,
                              TileComponent* restrict tilec,
 							 uint32_t numres);
 
+/**
+Inverse 5-3 wavelet transform of a single resolution level of a whole
+tile component: resolution resno is computed from resolution resno - 1
+and the bands of resno, which must all be decoded.
+@param tilec Tile component information (current tile)
+@param resno Resolution to compute
+*/
+bool decode_resolution_53(TileComponent* tilec, uint32_t resno);
+
+/**
+Inverse 9-7 wavelet transform of a single resolution level of a whole
+tile component, as decode_resolution_53
+@param tilec Tile component information (current tile)
+@param resno Resolution to compute
+*/
+bool decode_resolution_97(TileComponent* tilec, uint32_t resno);
+
 }
@@ -106,14 +106,6 @@
 
 namespace grk {
 
-#define GROK_S(i) a[(i)<<1]
-#define GROK_D(i) a[(1+((i)<<1))]
-#define GROK_S_(i) ((i)<0?GROK_S(0):((i)>=s_n?GROK_S(s_n-1):GROK_S(i)))
-#define GROK_D_(i) ((i)<0?GROK_D(0):((i)>=d_n?GROK_D(d_n-1):GROK_D(i)))
-
-#define GROK_SS_(i) ((i)<0?GROK_S(0):((i)>=d_n?GROK_S(d_n-1):GROK_S(i)))
-#define GROK_DD_(i) ((i)<0?GROK_D(0):((i)>=s_n?GROK_D(s_n-1):GROK_D(i)))
-
 // before DWT
 #ifdef DEBUG_LOSSLESS_DWT
 	int32_t rw_full = l_cur_res->x1 - l_cur_res->x0;
@@ -148,24 +140,7 @@ namespace grk {
 /* Forward 5-3 wavelet transform in 1-D. */
 /* </summary>                           */
 void dwt53::encode_line(int32_t *a, int32_t d_n, int32_t s_n, uint8_t cas) {
-	if (!cas) {
-		if ((d_n > 0) || (s_n > 1)) {
-			for (int32_t i = 0; i < d_n; i++)
-				GROK_D(i)-= (GROK_S_(i) + GROK_S_(i + 1)) >> 1;
-			for (int32_t i = 0; i < s_n; i++)
-				GROK_S(i) += (GROK_D_(i - 1) + GROK_D_(i) + 2) >> 2;
-		}
-	}
-	else {
-		if (!s_n && d_n == 1) /* NEW :  CASE ONE ELEMENT */
-			GROK_S(0) <<= 1;
-		else {
-			for (int32_t i = 0; i < d_n; i++)
-				GROK_S(i) -= (GROK_DD_(i) + GROK_DD_(i - 1)) >> 1;
-			for (int32_t i = 0; i < s_n; i++)
-				GROK_D(i) += (GROK_SS_(i) + GROK_SS_(i + 1) + 2) >> 2;
-		}
-	}
+	Kernels::g_kernels->encode_53(a, d_n, s_n, cas);
 }
 
 }
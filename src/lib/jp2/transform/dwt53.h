@@ -74,6 +74,10 @@ struct grk_dwt53 {
 
 class dwt53 {
 public:
+	/**
+	 Forward 5-3 wavelet transform in 1-D, on Kernels::pll_lines_encode
+	 interleaved lines: element i of a holds sample i of every line
+	 */
 	void encode_line(int32_t* restrict a, int32_t d_n, int32_t s_n, uint8_t cas);
 
 
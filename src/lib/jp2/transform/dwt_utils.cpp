@@ -81,48 +81,50 @@ uint32_t dwt_utils::max_resolution(grk_tcd_resolution *restrict r, uint32_t i) {
 /* Forward lazy transform (vertical).    */
 /* </summary>                            */
 void dwt_utils::deinterleave_v(int32_t *a, int32_t *b, int32_t d_n, int32_t s_n,
-		int32_t x, int32_t cas) {
+		uint32_t stride, int32_t cas, uint32_t pll, uint32_t ncols) {
 	int32_t i = s_n;
 	int32_t *l_dest = b;
-	int32_t *l_src = a + cas;
+	int32_t *l_src = a + cas * pll;
 
 	while (i--) {
-		*l_dest = *l_src;
-		l_dest += x;
-		l_src += 2;
-	} /* b[i*x]=a[2*i+cas]; */
+		memcpy(l_dest, l_src, ncols * sizeof(int32_t));
+		l_dest += stride;
+		l_src += 2 * pll;
+	} /* b[i*stride]=a[2*i+cas]; */
 
-	l_dest = b + s_n * x;
-	l_src = a + 1 - cas;
+	l_dest = b + (size_t)s_n * stride;
+	l_src = a + (1 - cas) * pll;
 
 	i = d_n;
 	while (i--) {
-		*l_dest = *l_src;
-		l_dest += x;
-		l_src += 2;
-	} /*b[(s_n+i)*x]=a[(2*i+1-cas)];*/
+		memcpy(l_dest, l_src, ncols * sizeof(int32_t));
+		l_dest += stride;
+		l_src += 2 * pll;
+	} /*b[(s_n+i)*stride]=a[(2*i+1-cas)];*/
 }
 
 /* <summary>			                 */
 /* Forward lazy transform (horizontal).  */
 /* </summary>                            */
 void dwt_utils::deinterleave_h(int32_t *a, int32_t *b, int32_t d_n, int32_t s_n,
-		int32_t cas) {
-	int32_t i;
-	int32_t *l_dest = b;
-	int32_t *l_src = a + cas;
-
-	for (i = 0; i < s_n; ++i) {
-		*l_dest++ = *l_src;
-		l_src += 2;
-	}
-
-	l_dest = b + s_n;
-	l_src = a + 1 - cas;
-
-	for (i = 0; i < d_n; ++i) {
-		*l_dest++ = *l_src;
-		l_src += 2;
+		uint32_t stride, int32_t cas, uint32_t pll, uint32_t nrows) {
+	for (uint32_t r = 0; r < nrows; ++r) {
+		int32_t i;
+		int32_t *l_dest = b + (size_t)r * stride;
+		int32_t *l_src = a + cas * pll + r;
+
+		for (i = 0; i < s_n; ++i) {
+			*l_dest++ = *l_src;
+			l_src += 2 * pll;
+		}
+
+		l_dest = b + (size_t)r * stride + s_n;
+		l_src = a + (1 - cas) * pll + r;
+
+		for (i = 0; i < d_n; ++i) {
+			*l_dest++ = *l_src;
+			l_src += 2 * pll;
+		}
 	}
 }
 
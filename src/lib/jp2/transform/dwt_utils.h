@@ -86,10 +86,18 @@ public:
 
 
 	static uint32_t max_resolution(grk_tcd_resolution* restrict r, uint32_t i);
+	/**
+	 Forward lazy transform (vertical) of ncols columns, from a buffer of
+	 interleaved lines pll samples wide to the column strip b
+	 */
 	static void deinterleave_v(int32_t *a, int32_t *b, int32_t d_n, int32_t s_n,
-			int32_t x, int32_t cas);
+			uint32_t stride, int32_t cas, uint32_t pll, uint32_t ncols);
+	/**
+	 Forward lazy transform (horizontal) of nrows rows, from a buffer of
+	 interleaved lines pll samples wide to the row strip b
+	 */
 	static void deinterleave_h(int32_t *a, int32_t *b, int32_t d_n, int32_t s_n,
-			int32_t cas);
+			uint32_t stride, int32_t cas, uint32_t pll, uint32_t nrows);
 };
 
 }
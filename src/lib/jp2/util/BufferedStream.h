@@ -340,4 +340,21 @@ template<typename TYPE> void grok_write(uint8_t *p_buffer, TYPE value,
 	}
 #endif
 }
+
+template<typename TYPE> void grok_read(const uint8_t *p_buffer, TYPE *value,
+		uint32_t nb_bytes) {
+#if defined(GROK_BIG_ENDIAN)
+	uint8_t * l_data_ptr = ((uint8_t *)value);
+	assert(nb_bytes > 0 && nb_bytes <= sizeof(TYPE));
+	*value = 0;
+	memcpy(l_data_ptr + sizeof(TYPE) - nb_bytes, p_buffer, nb_bytes);
+#else
+	uint8_t *l_data_ptr = ((uint8_t*) value) + nb_bytes - 1;
+	assert(nb_bytes > 0 && nb_bytes <= sizeof(TYPE));
+	*value = 0;
+	for (uint32_t i = 0; i < nb_bytes; ++i) {
+		*(l_data_ptr--) = *(p_buffer++);
+	}
+#endif
+}
 }
@@ -255,57 +255,93 @@ const InstructionSet::InstructionSet_Internal InstructionSet::CPU_Rep;
 namespace grk {
 
 
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define GRK_CPU_SUPPORTS(feature) __builtin_cpu_supports(feature)
+#endif
+
+bool CPUArch::AVX512F(){
+#ifdef __AVX512F__
+	return true;
+#elif defined(WIN32)
+	return InstructionSet::AVX512F();
+#elif defined(GRK_CPU_SUPPORTS)
+	return GRK_CPU_SUPPORTS("avx512f");
+#else
+	return false;
+#endif
+}
 bool CPUArch::AVX2(){
 #ifdef __AVX2__
 	return true;
-#else
-#ifdef WIN32
+#elif defined(WIN32)
 	return InstructionSet::AVX2();
-#endif
-#endif
+#elif defined(GRK_CPU_SUPPORTS)
+	return GRK_CPU_SUPPORTS("avx2");
+#else
 	return false;
+#endif
 }
 bool CPUArch::AVX(){
 #ifdef __AVX__
 	return true;
-#else
-#ifdef WIN32
+#elif defined(WIN32)
 	return InstructionSet::AVX();
-#endif
-#endif
+#elif defined(GRK_CPU_SUPPORTS)
+	return GRK_CPU_SUPPORTS("avx");
+#else
 	return false;
+#endif
 }
 bool CPUArch::SSE4_1(){
 #ifdef __SSE4_1__
 	return true;
-#else
-#ifdef WIN32
+#elif defined(WIN32)
 	return InstructionSet::SSE41();
-#endif
-#endif
+#elif defined(GRK_CPU_SUPPORTS)
+	return GRK_CPU_SUPPORTS("sse4.1");
+#else
 	return false;
+#endif
 }
 bool CPUArch::SSE3(){
 #ifdef __SSE3__
 	return true;
-#else
-#ifdef WIN32
+#elif defined(WIN32)
 	return InstructionSet::SSE3();
+#elif defined(GRK_CPU_SUPPORTS)
+	return GRK_CPU_SUPPORTS("sse3");
+#else
+	return false;
 #endif
-#endif
+}
+bool CPUArch::SSE2(){
+#if defined(__SSE2__) || defined(_M_X64)
+	return true;
+#elif defined(WIN32)
+	return InstructionSet::SSE2();
+#elif defined(GRK_CPU_SUPPORTS)
+	return GRK_CPU_SUPPORTS("sse2");
+#else
 	return false;
+#endif
 }
 bool CPUArch::BMI1(){
 #ifdef WIN32
 	return InstructionSet::BMI1();
-#endif
+#elif defined(GRK_CPU_SUPPORTS)
+	return GRK_CPU_SUPPORTS("bmi");
+#else
 	return false;
+#endif
 }
 bool CPUArch::BMI2(){
 #ifdef WIN32
 	return InstructionSet::BMI2();
-#endif
+#elif defined(GRK_CPU_SUPPORTS)
+	return GRK_CPU_SUPPORTS("bmi2");
+#else
 	return false;
+#endif
 }
 
 }
@@ -34,12 +34,19 @@
 
 namespace grk {
 
+/**
+ * Instruction sets supported by the CPU we are running on. With GCC
+ * and Clang on x86, and with MSVC, this is detected at run time, so that
+ * it does not depend on the compiler flags of the library.
+ */
 class CPUArch {
 public:
+	bool AVX512F();
 	bool AVX2();
 	bool AVX();
 	bool SSE4_1();
 	bool SSE3();
+	bool SSE2();
 	bool BMI1();
 	bool BMI2();
 
@@ -103,12 +103,11 @@ int64_t ChunkBuffer::skip(int64_t nb_bytes)
         bytes_in_current_segment = 	(size_t)(cur_chunk->len -cur_chunk->offset);
 
         /* hoover up all the bytes in this chunk, and move to the next one */
-        if (bytes_in_current_segment > bytes_remaining) {
+        if (bytes_remaining >= bytes_in_current_segment) {
 
             incr_cur_chunk_offset(bytes_in_current_segment);
 
             bytes_remaining	-= bytes_in_current_segment;
-            cur_chunk = chunks[cur_chunk_id];
         } else { /* bingo! we found the chunk */
             incr_cur_chunk_offset(bytes_remaining);
             return nb_bytes;
@@ -227,6 +226,14 @@ size_t ChunkBuffer::get_cur_chunk_len(void) {
 	return (cur_chunk) ? (cur_chunk->len - (size_t) cur_chunk->offset) : 0;
 }
 
+bool ChunkBuffer::is_guarded(size_t len, size_t guard) {
+	auto cur_chunk = chunks[cur_chunk_id];
+	if (!cur_chunk)
+		return false;
+	return (size_t) cur_chunk->offset >= guard
+			&& len + guard <= cur_chunk->len - (size_t) cur_chunk->offset;
+}
+
 int64_t ChunkBuffer::get_cur_chunk_offset(void) {
 	auto cur_chunk = chunks[cur_chunk_id];
 	return (cur_chunk) ? (int64_t) (cur_chunk->offset) : 0;
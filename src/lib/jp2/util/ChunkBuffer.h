@@ -55,6 +55,12 @@ struct ChunkBuffer {
 	 */
 	int64_t get_cur_chunk_offset(void);
 
+	/*
+	 True if len bytes at the current offset lie in the current chunk, with
+	 at least guard bytes of the same chunk on either side
+	 */
+	bool is_guarded(size_t len, size_t guard);
+
 	/*
 	 Treat segmented buffer as single contiguous buffer, and get current pointer
 	 */
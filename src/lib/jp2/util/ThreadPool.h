@@ -20,8 +20,12 @@
 
 namespace grk {
 
+class WorkerArena;
+
 struct Scheduler {
 	static ThreadPool* g_tp;
+	/** one scratch arena per worker of g_tp, indexed by thread number */
+	static std::vector<WorkerArena*> g_arenas;
 };
 
 }
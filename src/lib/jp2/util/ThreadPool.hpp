@@ -19,109 +19,301 @@
 #pragma once
 
 #include <vector>
-#include <queue>
+#include <deque>
+#include <algorithm>
 #include <memory>
 #include <thread>
 #include <mutex>
+#include <atomic>
 #include <condition_variable>
 #include <future>
 #include <functional>
 #include <stdexcept>
-#include <map>
+#include <exception>
 
 
+/*
+ * Work-stealing thread pool.
+ *
+ * Each worker owns a deque of tasks. A worker pushes and pops at the back of
+ * its own deque, and steals from the front of other workers' deques when its
+ * own deque is empty. Tasks submitted from outside the pool are spread
+ * round-robin across the worker deques, so there is no single queue that
+ * every submission and every worker contends on.
+ *
+ * parallel_for runs a loop body over an index range without a future per
+ * task. A worker that calls parallel_for (nested parallelism) runs tasks
+ * while it waits instead of blocking, so that tile-level and block-level
+ * parallelism share the same workers.
+ */
 class ThreadPool {
 public:
     ThreadPool(size_t);
     template<class F, class... Args>
-    auto enqueue(F&& f, Args&&... args) 
+    auto enqueue(F&& f, Args&&... args)
         -> std::future<typename std::result_of<F(Args...)>::type>;
+    template<class F>
+    void parallel_for(size_t n, F&& f);
+    template<class F>
+    void parallel_for(size_t n, size_t grain, F&& f);
     ~ThreadPool();
-    int thread_number(std::thread::id id){
-    	if (id_map.find(id) != id_map.end())
-    		return id_map[id];
-    	return -1;
+    // index of the calling thread in [0, num_threads), or -1 if the
+    // calling thread is not a worker of this pool
+    int thread_number() const {
+    	return current_pool() == this ? current_index() : -1;
     }
     size_t num_threads(){return m_num_threads;}
 private:
+    // type-erased task: no allocation beyond whatever arg points to
+    struct Task {
+    	void (*run)(void*);
+    	void *arg;
+    };
+    struct Worker {
+    	std::mutex mutex;
+    	std::deque<Task> tasks;
+    };
+
+    void push(Task task);
+    bool pop(size_t index, Task &task);
+    bool steal(size_t index, Task &task);
+    bool run_one(size_t index);
+    void work(size_t index);
+
+    template<class T> static void run_and_delete(void *arg){
+    	auto t = (T*)arg;
+    	(*t)();
+    	delete t;
+    }
+    static const ThreadPool*& current_pool(){
+    	static thread_local const ThreadPool* pool = nullptr;
+    	return pool;
+    }
+    static int& current_index(){
+    	static thread_local int index = -1;
+    	return index;
+    }
+
     // need to keep track of threads so we can join them
     std::vector< std::thread > workers;
-    // the task queue
-    std::queue< std::function<void()> > tasks;
-    
-    // synchronization
-    std::mutex queue_mutex;
+    // one task deque per worker
+    std::vector< std::unique_ptr<Worker> > queues;
+    // number of tasks sitting in the deques
+    std::atomic<size_t> pending;
+    // round-robin target for tasks submitted from outside the pool
+    std::atomic<size_t> next_queue;
+
+    // idle workers sleep here
+    std::mutex sleep_mutex;
     std::condition_variable condition;
-    bool stop;
+    std::atomic<size_t> num_sleeping;
+    std::atomic<bool> stop;
 
-    std::map<std::thread::id, int> id_map;
-    std::atomic<int> thread_count;
     size_t m_num_threads;
 };
- 
+
 // the constructor just launches some amount of workers
 inline ThreadPool::ThreadPool(size_t threads)
-    :   stop(false), thread_count(-1), m_num_threads(threads)
+    :   pending(0), next_queue(0), num_sleeping(0),
+		stop(false), m_num_threads(threads)
 {
     for(size_t i = 0;i<threads;++i)
-        workers.emplace_back(
-            [this]
-            {
-    			{
-    			std::unique_lock<std::mutex> lock(this->queue_mutex);
-    			auto thread_num = ++thread_count;
-    			id_map[std::this_thread::get_id()] = thread_num;
-    			}
-                for(;;)
-                {
-                    std::function<void()> task;
-
-                    {
-                        std::unique_lock<std::mutex> lock(this->queue_mutex);
-                        this->condition.wait(lock,
-                            [this]{ return this->stop || !this->tasks.empty(); });
-                        if(this->stop && this->tasks.empty())
-                            return;
-                        task = std::move(this->tasks.front());
-                        this->tasks.pop();
-                    }
-
-                    task();
-                }
-            }
-        );
+    	queues.emplace_back(new Worker());
+    for(size_t i = 0;i<threads;++i)
+        workers.emplace_back([this, i] { work(i); });
+}
+
+inline void ThreadPool::work(size_t index){
+	current_pool() = this;
+	current_index() = (int)index;
+	for(;;) {
+		// spin briefly before going to sleep, since tasks tend to arrive in bursts
+		bool found = false;
+		for (int spin = 0; spin < 16 && !found; ++spin){
+			found = run_one(index);
+			if (!found)
+				std::this_thread::yield();
+		}
+		if (found)
+			continue;
+		std::unique_lock<std::mutex> lock(sleep_mutex);
+		++num_sleeping;
+		condition.wait(lock,
+			[this]{ return stop || pending.load() > 0; });
+		--num_sleeping;
+		if(stop && pending.load() == 0)
+			return;
+	}
+}
+
+inline void ThreadPool::push(Task task){
+	int index = thread_number();
+	auto queue = queues[index >= 0 ? (size_t)index :
+							next_queue++ % m_num_threads].get();
+	// count the task before it becomes visible, so that pending
+	// never underflows when a thief takes it straight away
+	++pending;
+	{
+		std::unique_lock<std::mutex> lock(queue->mutex);
+		queue->tasks.push_back(task);
+	}
+	// only touch the sleep mutex if a worker may be sleeping:
+	// a worker increments num_sleeping before it checks pending
+	if (num_sleeping.load() > 0) {
+		{
+			std::unique_lock<std::mutex> lock(sleep_mutex);
+		}
+		condition.notify_one();
+	}
+}
+
+inline bool ThreadPool::pop(size_t index, Task &task){
+	auto queue = queues[index].get();
+	std::unique_lock<std::mutex> lock(queue->mutex);
+	if (queue->tasks.empty())
+		return false;
+	task = queue->tasks.back();
+	queue->tasks.pop_back();
+	--pending;
+	return true;
+}
+
+inline bool ThreadPool::steal(size_t index, Task &task){
+	for (size_t i = 1; i < m_num_threads; ++i){
+		auto queue = queues[(index + i) % m_num_threads].get();
+		std::unique_lock<std::mutex> lock(queue->mutex, std::try_to_lock);
+		if (!lock.owns_lock() || queue->tasks.empty())
+			continue;
+		task = queue->tasks.front();
+		queue->tasks.pop_front();
+		--pending;
+		return true;
+	}
+	return false;
+}
+
+inline bool ThreadPool::run_one(size_t index){
+	Task task;
+	if (!pop(index, task) && !steal(index, task))
+		return false;
+	task.run(task.arg);
+	return true;
 }
 
 // add new work item to the pool
 template<class F, class... Args>
-auto ThreadPool::enqueue(F&& f, Args&&... args) 
+auto ThreadPool::enqueue(F&& f, Args&&... args)
     -> std::future<typename std::result_of<F(Args...)>::type>
 {
     using return_type = typename std::result_of<F(Args...)>::type;
+    using task_type = std::packaged_task<return_type()>;
 
-    auto task = std::make_shared< std::packaged_task<return_type()> >(
+    auto task = new task_type(
             std::bind(std::forward<F>(f), std::forward<Args>(args)...)
         );
-        
-    std::future<return_type> res = task->get_future();
-    {
-        std::unique_lock<std::mutex> lock(queue_mutex);
-
-        // don't allow enqueueing after stopping the pool
-        if(stop)
-            throw std::runtime_error("enqueue on stopped ThreadPool");
 
-        tasks.emplace([task](){ (*task)(); });
+    std::future<return_type> res = task->get_future();
+    // a worker that blocks on a future it has queued can deadlock the pool
+    // once every worker is blocked, so nested tasks are run in place.
+    // Use parallel_for for nested parallelism.
+    if (thread_number() >= 0) {
+    	run_and_delete<task_type>(task);
+    	return res;
+    }
+    if(stop) {
+    	delete task;
+        throw std::runtime_error("enqueue on stopped ThreadPool");
     }
-    condition.notify_one();
+    push({&run_and_delete<task_type>, task});
     return res;
 }
 
+// run f(i) for i in [0,n), and wait for all iterations to complete.
+// Iterations are claimed dynamically by up to num_threads workers;
+// f may call thread_number() to index per-worker state.
+template<class F>
+void ThreadPool::parallel_for(size_t n, F&& f)
+{
+	parallel_for(n, 1, std::forward<F>(f));
+}
+
+// as above, with iterations claimed grain at a time, so that short
+// iterations do not all contend on the shared counter
+template<class F>
+void ThreadPool::parallel_for(size_t n, size_t grain, F&& f)
+{
+	if (!n)
+		return;
+	if (!grain)
+		grain = 1;
+	using body_type = typename std::remove_reference<F>::type;
+	struct Loop {
+		Loop(body_type *f, size_t n, size_t grain, size_t runners) : body(f),
+											n(n),
+											grain(grain),
+											next(0),
+											remaining(runners)
+		{}
+		static void run(void *arg){
+			auto loop = (Loop*)arg;
+			size_t begin;
+			while ((begin = loop->next.fetch_add(loop->grain)) < loop->n) {
+				size_t end = std::min<size_t>(begin + loop->grain, loop->n);
+				try {
+					for (size_t i = begin; i < end; ++i)
+						(*loop->body)(i);
+				} catch (...) {
+					std::unique_lock<std::mutex> lock(loop->mutex);
+					if (!loop->error)
+						loop->error = std::current_exception();
+					// skip the remaining iterations
+					loop->next = loop->n;
+				}
+			}
+			// the waiting thread destroys the loop once it can take
+			// the mutex after remaining reaches zero
+			std::unique_lock<std::mutex> lock(loop->mutex);
+			if (--loop->remaining == 0)
+				loop->done.notify_all();
+		}
+		body_type *body;
+		size_t n;
+		size_t grain;
+		std::atomic<size_t> next;
+		std::atomic<size_t> remaining;
+		std::mutex mutex;
+		std::condition_variable done;
+		std::exception_ptr error;
+	};
+	int index = thread_number();
+	size_t runners = std::min<size_t>((n + grain - 1) / grain, m_num_threads);
+	Loop loop(&f, n, grain, runners);
+	if (index >= 0) {
+		// the calling worker is one of the runners, and keeps
+		// running tasks until the other runners have finished
+		for (size_t i = 1; i < runners; ++i)
+			push({&Loop::run, &loop});
+		Loop::run(&loop);
+		while (loop.remaining.load() != 0) {
+			if (!run_one((size_t)index))
+				std::this_thread::yield();
+		}
+		std::unique_lock<std::mutex> lock(loop.mutex);
+	} else {
+		for (size_t i = 0; i < runners; ++i)
+			push({&Loop::run, &loop});
+		std::unique_lock<std::mutex> lock(loop.mutex);
+		loop.done.wait(lock, [&loop]{ return loop.remaining.load() == 0; });
+	}
+	if (loop.error)
+		std::rethrow_exception(loop.error);
+}
+
 // the destructor joins all threads
 inline ThreadPool::~ThreadPool()
 {
     {
-        std::unique_lock<std::mutex> lock(queue_mutex);
+        std::unique_lock<std::mutex> lock(sleep_mutex);
         stop = true;
     }
     condition.notify_all();
@@ -0,0 +1,188 @@
+/*
+ *    Copyright (C) 2016-2020 Grok Image Compression Inc.
+ *
+ *    This source code is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This source code is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "grok_includes.h"
+#include "T1Factory.h"
+#include "T1Interface.h"
+
+namespace grk {
+
+WorkerArena::WorkerArena() :
+		retained_bytes(0) {
+}
+
+WorkerArena::~WorkerArena() {
+	for (auto &b : free_buffers)
+		grok_aligned_free(b.data);
+	for (auto &b : leased_buffers)
+		grok_aligned_free(b.data);
+	for (auto &c : free_coders)
+		delete c.t1;
+	for (auto &c : leased_coders)
+		delete c.t1;
+	for (auto b : free_decode_blocks)
+		delete b;
+	for (auto b : free_encode_blocks)
+		delete b;
+}
+
+WorkerArena* WorkerArena::get(void) {
+	auto tp = Scheduler::g_tp;
+	int index = tp ? tp->thread_number() : -1;
+	if (index >= 0 && (size_t) index < Scheduler::g_arenas.size())
+		return Scheduler::g_arenas[(size_t) index];
+	static thread_local WorkerArena arena;
+
+	return &arena;
+}
+
+void* WorkerArena::get_buffer(size_t len) {
+	// smallest free buffer that is large enough
+	size_t best = free_buffers.size();
+	for (size_t i = 0; i < free_buffers.size(); ++i) {
+		if (free_buffers[i].len >= len
+				&& (best == free_buffers.size()
+						|| free_buffers[i].len < free_buffers[best].len))
+			best = i;
+	}
+	Buffer buf;
+	if (best != free_buffers.size()) {
+		buf = free_buffers[best];
+		free_buffers.erase(free_buffers.begin() + (ptrdiff_t) best);
+		retained_bytes -= buf.len;
+	} else {
+		// every free buffer is too small: replace the smallest one,
+		// rather than keep it around as well
+		if (!free_buffers.empty()) {
+			size_t smallest = 0;
+			for (size_t i = 1; i < free_buffers.size(); ++i) {
+				if (free_buffers[i].len < free_buffers[smallest].len)
+					smallest = i;
+			}
+			grok_aligned_free(free_buffers[smallest].data);
+			retained_bytes -= free_buffers[smallest].len;
+			free_buffers.erase(
+					free_buffers.begin() + (ptrdiff_t) smallest);
+		}
+		buf.data = grok_aligned_malloc(len);
+		if (!buf.data)
+			return nullptr;
+		buf.len = len;
+	}
+	leased_buffers.push_back(buf);
+
+	return buf.data;
+}
+
+void WorkerArena::put_buffer(void *buf) {
+	if (!buf)
+		return;
+	for (size_t i = leased_buffers.size(); i > 0; --i) {
+		if (leased_buffers[i - 1].data == buf) {
+			free_buffers.push_back(leased_buffers[i - 1]);
+			retained_bytes += leased_buffers[i - 1].len;
+			leased_buffers.erase(leased_buffers.begin() + (ptrdiff_t) (i - 1));
+			// keep the free buffers within bounds, giving back the
+			// largest first
+			while (retained_bytes > max_retained_bytes) {
+				size_t largest = 0;
+				for (size_t j = 1; j < free_buffers.size(); ++j) {
+					if (free_buffers[j].len > free_buffers[largest].len)
+						largest = j;
+				}
+				grok_aligned_free(free_buffers[largest].data);
+				retained_bytes -= free_buffers[largest].len;
+				free_buffers.erase(
+						free_buffers.begin() + (ptrdiff_t) largest);
+			}
+			return;
+		}
+	}
+	assert(false);
+}
+
+T1Interface* WorkerArena::get_t1(bool isEncoder, grk_tcp *tcp,
+		uint16_t maxCblkW, uint16_t maxCblkH) {
+	Coder coder;
+	bool found = false;
+	for (size_t i = 0; i < free_coders.size(); ++i) {
+		auto &c = free_coders[i];
+		if (c.isEncoder != isEncoder || c.isHT != tcp->isHT)
+			continue;
+		if (c.maxCblkW >= maxCblkW && c.maxCblkH >= maxCblkH) {
+			coder = c;
+			found = true;
+		} else {
+			// too small for these code blocks
+			delete c.t1;
+		}
+		free_coders.erase(free_coders.begin() + (ptrdiff_t) i);
+		break;
+	}
+	if (!found) {
+		coder.t1 = T1Factory::get_t1(isEncoder, tcp, maxCblkW, maxCblkH);
+		coder.isEncoder = isEncoder;
+		coder.isHT = tcp->isHT;
+		coder.maxCblkW = maxCblkW;
+		coder.maxCblkH = maxCblkH;
+	}
+	leased_coders.push_back(coder);
+
+	return coder.t1;
+}
+
+void WorkerArena::put_t1(T1Interface *t1) {
+	for (size_t i = leased_coders.size(); i > 0; --i) {
+		if (leased_coders[i - 1].t1 == t1) {
+			free_coders.push_back(leased_coders[i - 1]);
+			leased_coders.erase(leased_coders.begin() + (ptrdiff_t) (i - 1));
+			return;
+		}
+	}
+	assert(false);
+}
+
+std::vector<decodeBlockInfo>* WorkerArena::get_decode_blocks(void) {
+	if (free_decode_blocks.empty())
+		return new std::vector<decodeBlockInfo>();
+	auto blocks = free_decode_blocks.back();
+	free_decode_blocks.pop_back();
+
+	return blocks;
+}
+
+void WorkerArena::put_decode_blocks(std::vector<decodeBlockInfo> *blocks) {
+	// keep the capacity for the next tile
+	blocks->clear();
+	free_decode_blocks.push_back(blocks);
+}
+
+std::vector<encodeBlockInfo>* WorkerArena::get_encode_blocks(void) {
+	if (free_encode_blocks.empty())
+		return new std::vector<encodeBlockInfo>();
+	auto blocks = free_encode_blocks.back();
+	free_encode_blocks.pop_back();
+
+	return blocks;
+}
+
+void WorkerArena::put_encode_blocks(std::vector<encodeBlockInfo> *blocks) {
+	blocks->clear();
+	free_encode_blocks.push_back(blocks);
+}
+
+}
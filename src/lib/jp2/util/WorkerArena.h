@@ -0,0 +1,111 @@
+/*
+ *    Copyright (C) 2016-2020 Grok Image Compression Inc.
+ *
+ *    This source code is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This source code is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+namespace grk {
+
+struct grk_tcp;
+struct decodeBlockInfo;
+struct encodeBlockInfo;
+class T1Interface;
+
+/**
+ * Scratch memory and tier-1 coders belonging to one worker of the
+ * thread pool.
+ *
+ * The scheduler creates one arena per worker, and the arenas live as long
+ * as the pool, so that wavelet buffers, tier-1 coders and code block lists
+ * are reused across tiles and images instead of going back to the
+ * allocator for every tile.
+ *
+ * Everything is leased: take it, use it and give it back on the same
+ * thread. A worker waiting in parallel_for runs other tasks, which may
+ * take a second lease of the same kind while the first is still held, so
+ * two leases never share memory.
+ */
+class WorkerArena {
+public:
+	WorkerArena();
+	~WorkerArena();
+
+	/**
+	 * Bytes of free buffers that an arena keeps for later leases;
+	 * larger buffers are given back to the system
+	 */
+	static const size_t max_retained_bytes = (size_t) 64 << 20;
+
+	/**
+	 * Arena of the calling thread: the worker's own arena on a pool
+	 * thread, or a thread local arena on any other thread
+	 */
+	static WorkerArena* get(void);
+
+	/**
+	 * Lease an aligned buffer of at least len bytes
+	 * @return nullptr if out of memory
+	 */
+	void* get_buffer(size_t len);
+	/** Give back a buffer leased with get_buffer */
+	void put_buffer(void *buf);
+
+	/**
+	 * Lease a tier-1 coder for the code block style of tcp, and for
+	 * code blocks of up to maxCblkW x maxCblkH samples
+	 */
+	T1Interface* get_t1(bool isEncoder, grk_tcp *tcp, uint16_t maxCblkW,
+			uint16_t maxCblkH);
+	/** Give back a coder leased with get_t1 */
+	void put_t1(T1Interface *t1);
+
+	/** Lease an empty list of code blocks to decode */
+	std::vector<decodeBlockInfo>* get_decode_blocks(void);
+	/** Give back a list leased with get_decode_blocks */
+	void put_decode_blocks(std::vector<decodeBlockInfo> *blocks);
+	/** Lease an empty list of code blocks to encode */
+	std::vector<encodeBlockInfo>* get_encode_blocks(void);
+	/** Give back a list leased with get_encode_blocks */
+	void put_encode_blocks(std::vector<encodeBlockInfo> *blocks);
+
+private:
+	struct Buffer {
+		void *data;
+		size_t len;
+	};
+	struct Coder {
+		T1Interface *t1;
+		bool isEncoder;
+		bool isHT;
+		uint16_t maxCblkW;
+		uint16_t maxCblkH;
+	};
+
+	std::vector<Buffer> free_buffers;
+	// total length of free_buffers
+	size_t retained_bytes;
+	std::vector<Buffer> leased_buffers;
+	std::vector<Coder> free_coders;
+	std::vector<Coder> leased_coders;
+	std::vector<std::vector<decodeBlockInfo>*> free_decode_blocks;
+	std::vector<std::vector<encodeBlockInfo>*> free_encode_blocks;
+};
+
+}
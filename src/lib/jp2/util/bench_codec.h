@@ -0,0 +1,173 @@
+/*
+ *    Copyright (C) 2016-2020 Grok Image Compression Inc.
+ *
+ *    This source code is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This source code is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ *    Helpers for benchmarks that run the whole codec through the public
+ *    API: a synthetic test image, and in-memory compress and decompress.
+ */
+
+#pragma once
+
+#include "grok_includes.h"
+#include <chrono>  // for high_resolution_clock
+
+namespace grk {
+
+/**
+ * Create an image with a smooth gradient plus noise whose amplitude
+ * changes from one 256x256 cell to the next, so that code blocks range
+ * from nearly empty to full of detail
+ */
+inline grk_image* bench_make_image(uint32_t w, uint32_t h, uint32_t numcomps,
+		uint32_t prec) {
+	std::vector<grk_image_cmptparm> params(numcomps);
+	for (auto &p : params) {
+		memset(&p, 0, sizeof(p));
+		p.dx = 1;
+		p.dy = 1;
+		p.w = w;
+		p.h = h;
+		p.prec = prec;
+	}
+	auto image = grk_image_create(numcomps, params.data(),
+			numcomps == 3 ? GRK_CLRSPC_SRGB : GRK_CLRSPC_GRAY);
+	if (!image)
+		return nullptr;
+	image->x1 = w;
+	image->y1 = h;
+	int32_t max = (1 << prec) - 1;
+	uint32_t seed = 12345;
+	for (uint32_t c = 0; c < numcomps; ++c) {
+		auto data = image->comps[c].data;
+		for (uint32_t y = 0; y < h; ++y) {
+			for (uint32_t x = 0; x < w; ++x) {
+				uint32_t cell = (x >> 8) * 2654435761U + (y >> 8) * 40503U + c;
+				int32_t amplitude = (int32_t)((cell >> 7) % 9) * (max >> 3);
+				seed = seed * 1664525U + 1013904223U;
+				int32_t noise = amplitude ? (int32_t)(seed >> 8) % (amplitude + 1) : 0;
+				int32_t v = (int32_t)(((uint64_t)(x + y) * (uint64_t)max) / (w + h)) / 2 + noise / 2;
+				data[(size_t)y * w + x] = std::min<int32_t>(std::max<int32_t>(v, 0), max);
+			}
+		}
+	}
+
+	return image;
+}
+
+/**
+ * Compress image to a J2K codestream in memory
+ * @return length of the codestream, or 0 on failure
+ */
+inline size_t bench_compress(grk_image *image, grk_cparameters *parameters,
+		std::vector<uint8_t> &out) {
+	size_t len = 1024 * 1024;
+	for (uint32_t c = 0; c < image->numcomps; ++c)
+		len += (size_t) image->comps[c].w * image->comps[c].h
+				* ((image->comps[c].prec + 7) / 8) * 2;
+	out.resize(len);
+	auto stream = grk_stream_create_mem_stream(out.data(), len, false, false);
+	if (!stream)
+		return 0;
+	auto codec = grk_create_compress(GRK_CODEC_J2K, stream);
+	bool rc = codec && grk_setup_encoder(codec, parameters, image)
+			&& grk_start_compress(codec, image) && grk_encode(codec)
+			&& grk_end_compress(codec);
+	len = rc ? grk_stream_get_write_mem_stream_length(stream) : 0;
+	grk_stream_destroy(stream);
+	grk_destroy_codec(codec);
+	out.resize(len);
+
+	return len;
+}
+
+/**
+ * Decompress a J2K codestream held in memory
+ * @return wall clock time in ms, or a negative value on failure
+ */
+inline double bench_decompress(std::vector<uint8_t> &in,
+		grk_dparameters *parameters) {
+	auto start = std::chrono::high_resolution_clock::now();
+	auto stream = grk_stream_create_mem_stream(in.data(), in.size(), false,
+			true);
+	if (!stream)
+		return -1;
+	grk_image *image = nullptr;
+	auto codec = grk_create_decompress(GRK_CODEC_J2K, stream);
+	bool rc = codec && grk_setup_decoder(codec, parameters)
+			&& grk_read_header(codec, nullptr, &image)
+			&& grk_decode(codec, nullptr, image) && grk_end_decompress(codec);
+	grk_stream_destroy(stream);
+	grk_destroy_codec(codec);
+	grk_image_destroy(image);
+	std::chrono::duration<double> elapsed =
+			std::chrono::high_resolution_clock::now() - start;
+
+	return rc ? elapsed.count() * 1000 : -1;
+}
+
+/**
+ * Decompress the region [x0,x1) x [y0,y1) of a J2K codestream held in memory
+ * @return wall clock time in ms, or a negative value on failure
+ */
+inline double bench_decompress_region(std::vector<uint8_t> &in,
+		grk_dparameters *parameters, uint32_t x0, uint32_t y0, uint32_t x1,
+		uint32_t y1) {
+	auto start = std::chrono::high_resolution_clock::now();
+	auto stream = grk_stream_create_mem_stream(in.data(), in.size(), false,
+			true);
+	if (!stream)
+		return -1;
+	grk_image *image = nullptr;
+	auto codec = grk_create_decompress(GRK_CODEC_J2K, stream);
+	bool rc = codec && grk_setup_decoder(codec, parameters)
+			&& grk_read_header(codec, nullptr, &image)
+			&& grk_set_decode_area(codec, image, x0, y0, x1, y1)
+			&& grk_decode(codec, nullptr, image) && grk_end_decompress(codec);
+	grk_stream_destroy(stream);
+	grk_destroy_codec(codec);
+	grk_image_destroy(image);
+	std::chrono::duration<double> elapsed =
+			std::chrono::high_resolution_clock::now() - start;
+
+	return rc ? elapsed.count() * 1000 : -1;
+}
+
+/**
+ * Decompress a single tile of a J2K codestream held in memory, with a new
+ * codec, as a server that answers each tile request on its own would
+ * @return wall clock time in ms, or a negative value on failure
+ */
+inline double bench_decompress_tile(std::vector<uint8_t> &in,
+		grk_dparameters *parameters, uint16_t tile_index) {
+	auto start = std::chrono::high_resolution_clock::now();
+	auto stream = grk_stream_create_mem_stream(in.data(), in.size(), false,
+			true);
+	if (!stream)
+		return -1;
+	grk_image *image = nullptr;
+	auto codec = grk_create_decompress(GRK_CODEC_J2K, stream);
+	bool rc = codec && grk_setup_decoder(codec, parameters)
+			&& grk_read_header(codec, nullptr, &image)
+			&& grk_get_decoded_tile(codec, image, tile_index);
+	grk_stream_destroy(stream);
+	grk_destroy_codec(codec);
+	grk_image_destroy(image);
+	std::chrono::duration<double> elapsed =
+			std::chrono::high_resolution_clock::now() - start;
+
+	return rc ? elapsed.count() * 1000 : -1;
+}
+
+}
@@ -68,6 +68,20 @@ int32_t getValue(uint32_t i)
     return ((int32_t)i % 511) - 256;
 }
 
+void fill_tilec(TileComponent * l_tilec, bool irreversible)
+{
+    size_t i, nValues;
+
+    nValues = (size_t)(l_tilec->x1 - l_tilec->x0) *
+              (size_t)(l_tilec->y1 - l_tilec->y0);
+    for (i = 0; i < nValues; i++) {
+        if (irreversible)
+            ((float*)l_tilec->buf->data)[i] = (float)getValue((uint32_t)i);
+        else
+            l_tilec->buf->data[i] = getValue((uint32_t)i);
+    }
+}
+
 void init_tilec(TileComponent * l_tilec,
                 int32_t x0,
                 int32_t y0,
@@ -77,7 +91,7 @@ void init_tilec(TileComponent * l_tilec,
 {
     grk_tcd_resolution* l_res;
     uint32_t resno, l_level_no;
-    size_t i, nValues;
+    size_t nValues;
 
     l_tilec->x0 = x0;
     l_tilec->y0 = y0;
@@ -88,9 +102,7 @@ void init_tilec(TileComponent * l_tilec,
     nValues = (size_t)(l_tilec->x1 - l_tilec->x0) *
               (size_t)(l_tilec->y1 - l_tilec->y0);
     l_tilec->buf->data = (int32_t*) grok_malloc(sizeof(int32_t) * nValues);
-    for (i = 0; i < nValues; i++) {
-        l_tilec->buf->data[i] = getValue((uint32_t)i);
-    }
+    fill_tilec(l_tilec, false);
     l_tilec->numresolutions = numresolutions;
     l_tilec->minimum_num_resolutions = numresolutions;
     l_tilec->resolutions = (grk_tcd_resolution*) grok_calloc(
@@ -216,16 +228,49 @@ int main(int argc, char** argv)
     image_comp.dy = 1;
 
 
-	std::chrono::time_point<std::chrono::high_resolution_clock> start, finish;
-	std::chrono::duration<double> elapsed;
-
-	start = std::chrono::high_resolution_clock::now();
-    decode_97(&tcd, &tilec, tilec.numresolutions);
-	finish = std::chrono::high_resolution_clock::now();
-	elapsed = finish - start;
-    printf("time for dwt_decode: %.03f ms\n", elapsed.count()*1000);
+	/* time the inverse and forward transforms with each instruction set */
+	/* supported by both the build and the CPU */
+	auto best_kernels = Kernels::g_kernels;
+	double mpixels = (double)size * (double)size / 1000000;
+	printf("throughput in Mpixel/s\n");
+	printf("%-8s %12s %12s %12s %12s\n", "isa", "inverse 5/3", "inverse 9/7",
+			"forward 5/3", "forward 9/7");
+	for (uint32_t isa = GRK_ISA_SCALAR; isa < GRK_ISA_COUNT; ++isa) {
+		auto kernels = Kernels::get((GRK_KERNEL_ISA)isa);
+		if (!kernels)
+			continue;
+		Kernels::g_kernels = kernels;
+		printf("%-8s", kernels->name);
+		for (uint32_t transform = 0; transform < 4; ++transform) {
+			/* the inverse 9/7 transform works on float samples */
+			fill_tilec(&tilec, transform == 1);
+			auto start = std::chrono::high_resolution_clock::now();
+			switch (transform) {
+			case 0:
+				decode_53(&tcd, &tilec, tilec.numresolutions);
+				break;
+			case 1:
+				decode_97(&tcd, &tilec, tilec.numresolutions);
+				break;
+			case 2:
+				Wavelet::encode(&tilec, 1);
+				break;
+			case 3:
+				Wavelet::encode(&tilec, 0);
+				break;
+			}
+			std::chrono::duration<double> elapsed =
+					std::chrono::high_resolution_clock::now() - start;
+			printf(" %12.1f", mpixels / elapsed.count());
+		}
+		printf("\n");
+	}
+	Kernels::g_kernels = best_kernels;
 
     if (display || check) {
+        /* the forward transform below is the reversible one */
+        fill_tilec(&tilec, false);
+        decode_53(&tcd, &tilec, tilec.numresolutions);
         if (display) {
             printf("After IDWT\n");
             k = 0;
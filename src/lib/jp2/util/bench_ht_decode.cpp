@@ -0,0 +1,191 @@
+/*
+ *    Copyright (C) 2016-2020 Grok Image Compression Inc.
+ *
+ *    This source code is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This source code is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ *    Decompress time of HTJ2K code streams with the HT block decoder of
+ *    each instruction set, and a check that every instruction set decodes
+ *    the same image. The rate controlled code streams have SigProp and
+ *    MagRef passes, which the lossless and lossy ones do not.
+ */
+
+#include "bench_codec.h"
+
+using namespace grk;
+
+namespace grk {
+
+void usage(void) {
+	printf("bench_ht_decode [-num_threads val] [-w val] [-h val] [-cblk val]\n");
+	printf("          [-runs val]\n");
+	exit(1);
+}
+
+struct HTConfig {
+	const char *name;
+	bool irreversible;
+	// compression ratios of the layers, or 0 for a single lossless layer
+	double rates[4];
+	// number of layers to decode, or 0 for all of them
+	uint32_t layers;
+};
+
+/**
+ * Decompress a J2K codestream held in memory, and hash the samples
+ * of the decoded image
+ * @return wall clock time in ms, or a negative value on failure
+ */
+double decompress_hash(std::vector<uint8_t> &in, grk_dparameters *parameters,
+		uint64_t &hash) {
+	auto start = std::chrono::high_resolution_clock::now();
+	auto stream = grk_stream_create_mem_stream(in.data(), in.size(), false,
+			true);
+	if (!stream)
+		return -1;
+	grk_image *image = nullptr;
+	auto codec = grk_create_decompress(GRK_CODEC_J2K, stream);
+	bool rc = codec && grk_setup_decoder(codec, parameters)
+			&& grk_read_header(codec, nullptr, &image)
+			&& grk_decode(codec, nullptr, image) && grk_end_decompress(codec);
+	std::chrono::duration<double> elapsed =
+			std::chrono::high_resolution_clock::now() - start;
+	// FNV-1a
+	hash = 14695981039346656037ULL;
+	for (uint32_t c = 0; rc && c < image->numcomps; ++c) {
+		auto comp = image->comps + c;
+		auto data = (const uint8_t*) comp->data;
+		size_t len = (size_t) comp->w * comp->h * sizeof(int32_t);
+		for (size_t i = 0; i < len; ++i)
+			hash = (hash ^ data[i]) * 1099511628211ULL;
+	}
+	grk_stream_destroy(stream);
+	grk_destroy_codec(codec);
+	grk_image_destroy(image);
+
+	return rc ? elapsed.count() * 1000 : -1;
+}
+
+}
+
+int main(int argc, char **argv) {
+	uint32_t num_threads = 0;
+	uint32_t w = 4096;
+	uint32_t h = 4096;
+	uint32_t cblk = 64;
+	uint32_t runs = 5;
+
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-num_threads") == 0 && i + 1 < argc) {
+			num_threads = (uint32_t) atoi(argv[i + 1]);
+			i++;
+		} else if (strcmp(argv[i], "-w") == 0 && i + 1 < argc) {
+			w = (uint32_t) atoi(argv[i + 1]);
+			i++;
+		} else if (strcmp(argv[i], "-h") == 0 && i + 1 < argc) {
+			h = (uint32_t) atoi(argv[i + 1]);
+			i++;
+		} else if (strcmp(argv[i], "-cblk") == 0 && i + 1 < argc) {
+			cblk = (uint32_t) atoi(argv[i + 1]);
+			i++;
+		} else if (strcmp(argv[i], "-runs") == 0 && i + 1 < argc) {
+			runs = (uint32_t) atoi(argv[i + 1]);
+			i++;
+		} else {
+			usage();
+		}
+	}
+	if (!w || !h || !runs || cblk < 4 || cblk > 1024 || (cblk & (cblk - 1)))
+		usage();
+	grk_initialize(nullptr, num_threads);
+
+	const uint32_t numconfigs = 4;
+	const HTConfig configs[numconfigs] = {
+			{ "lossless", false, { 0 }, 0 },
+			{ "lossy 9/7", true, { 0 }, 0 },
+			{ "rate 5/3", false, { 10, 5, 2.5, 1.25 }, 0 },
+			{ "rate 9/7", true, { 10, 5, 2.5, 1.25 }, 0 } };
+	auto best_kernels = Kernels::g_kernels;
+	bool match = true;
+	printf("%-14s %10s", "code stream", "bytes");
+	for (uint32_t isa = GRK_ISA_SCALAR; isa < GRK_ISA_COUNT; ++isa) {
+		auto kernels = Kernels::get((GRK_KERNEL_ISA) isa);
+		if (kernels)
+			printf(" %10s", kernels->name);
+	}
+	printf("   (ms)\n");
+	for (uint32_t c = 0; c < numconfigs; ++c) {
+		auto config = configs + c;
+		grk_cparameters cparams;
+		grk_set_default_encoder_parameters(&cparams);
+		cparams.isHT = true;
+		cparams.cblockw_init = cblk;
+		cparams.cblockh_init = std::min<uint32_t>(cblk, 4096 / cblk);
+		cparams.irreversible = config->irreversible;
+		if (config->rates[0] > 0) {
+			cparams.tcp_numlayers = 4;
+			for (uint32_t l = 0; l < 4; ++l)
+				cparams.tcp_rates[l] = config->rates[l];
+			cparams.cp_disto_alloc = 1;
+		}
+		auto image = bench_make_image(w, h, 3, 8);
+		if (!image) {
+			fprintf(stderr, "Unable to create %ux%u image\n", w, h);
+			return 1;
+		}
+		std::vector<uint8_t> codestream;
+		size_t len = bench_compress(image, &cparams, codestream);
+		grk_image_destroy(image);
+		if (!len) {
+			fprintf(stderr, "Compress failed\n");
+			return 1;
+		}
+		printf("%-14s %10u", config->name, (uint32_t) len);
+
+		grk_dparameters dparams;
+		grk_set_default_decoder_parameters(&dparams);
+		dparams.cp_layer = config->layers;
+		uint64_t scalar_hash = 0;
+		for (uint32_t isa = GRK_ISA_SCALAR; isa < GRK_ISA_COUNT; ++isa) {
+			auto kernels = Kernels::get((GRK_KERNEL_ISA) isa);
+			if (!kernels)
+				continue;
+			Kernels::g_kernels = kernels;
+			double ms = 0;
+			for (uint32_t r = 0; r < runs; ++r) {
+				uint64_t hash;
+				double t = decompress_hash(codestream, &dparams, hash);
+				if (t < 0) {
+					fprintf(stderr, "Decompress failed\n");
+					return 1;
+				}
+				if (isa == GRK_ISA_SCALAR)
+					scalar_hash = hash;
+				else if (hash != scalar_hash)
+					match = false;
+				ms += t;
+			}
+			printf(" %10.03f", ms / runs);
+		}
+		printf("\n");
+	}
+	Kernels::g_kernels = best_kernels;
+	grk_deinitialize();
+	if (!match) {
+		fprintf(stderr, "Decoded images differ between instruction sets\n");
+		return 1;
+	}
+	printf("decoded images match\n");
+
+	return 0;
+}
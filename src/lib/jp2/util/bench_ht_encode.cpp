@@ -0,0 +1,160 @@
+/*
+ *    Copyright (C) 2016-2020 Grok Image Compression Inc.
+ *
+ *    This source code is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This source code is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ *    Compress time of HTJ2K code streams with the kernels of each
+ *    instruction set, and a check that every instruction set writes the
+ *    same code stream. Without rate control, the HT block encoder quantizes
+ *    the samples as it codes them; with rate control, they are quantized
+ *    up front. Throughput is given per thread, and as 8K (7680x4320)
+ *    frames per second, to size real time encoders.
+ */
+
+#include "bench_codec.h"
+
+using namespace grk;
+
+namespace grk {
+
+void usage(void) {
+	printf("bench_ht_encode [-num_threads val] [-w val] [-h val] [-cblk val]\n");
+	printf("          [-runs val]\n");
+	exit(1);
+}
+
+struct HTConfig {
+	const char *name;
+	bool irreversible;
+	// compression ratios of the layers, or 0 for a single layer
+	// without rate control
+	double rates[4];
+};
+
+}
+
+int main(int argc, char **argv) {
+	uint32_t num_threads = 1;
+	uint32_t w = 3840;
+	uint32_t h = 2160;
+	uint32_t cblk = 64;
+	uint32_t runs = 3;
+
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-num_threads") == 0 && i + 1 < argc) {
+			num_threads = (uint32_t) atoi(argv[i + 1]);
+			i++;
+		} else if (strcmp(argv[i], "-w") == 0 && i + 1 < argc) {
+			w = (uint32_t) atoi(argv[i + 1]);
+			i++;
+		} else if (strcmp(argv[i], "-h") == 0 && i + 1 < argc) {
+			h = (uint32_t) atoi(argv[i + 1]);
+			i++;
+		} else if (strcmp(argv[i], "-cblk") == 0 && i + 1 < argc) {
+			cblk = (uint32_t) atoi(argv[i + 1]);
+			i++;
+		} else if (strcmp(argv[i], "-runs") == 0 && i + 1 < argc) {
+			runs = (uint32_t) atoi(argv[i + 1]);
+			i++;
+		} else {
+			usage();
+		}
+	}
+	if (!w || !h || !runs || cblk < 4 || cblk > 1024 || (cblk & (cblk - 1)))
+		usage();
+	grk_initialize(nullptr, num_threads);
+	num_threads = Scheduler::g_tp->num_threads();
+
+	const uint32_t numconfigs = 3;
+	const HTConfig configs[numconfigs] = {
+			{ "lossless", false, { 0 } },
+			{ "lossy 9/7", true, { 0 } },
+			{ "rate 9/7", true, { 20, 10, 5, 2.5 } } };
+	auto best_kernels = Kernels::g_kernels;
+	bool match = true;
+	printf("%u thread(s)\n", num_threads);
+	printf("%-14s %10s", "code stream", "bytes");
+	for (uint32_t isa = GRK_ISA_SCALAR; isa < GRK_ISA_COUNT; ++isa) {
+		auto kernels = Kernels::get((GRK_KERNEL_ISA) isa);
+		if (kernels)
+			printf(" %10s", kernels->name);
+	}
+	printf(" %12s %12s\n", "MPix/s/thr", "8K fps/thr");
+	for (uint32_t c = 0; c < numconfigs; ++c) {
+		auto config = configs + c;
+		printf("%-14s", config->name);
+		std::vector<uint8_t> scalar_stream;
+		double best_ms = 0;
+		for (uint32_t isa = GRK_ISA_SCALAR; isa < GRK_ISA_COUNT; ++isa) {
+			auto kernels = Kernels::get((GRK_KERNEL_ISA) isa);
+			if (!kernels)
+				continue;
+			Kernels::g_kernels = kernels;
+			double ms = 0;
+			for (uint32_t r = 0; r < runs; ++r) {
+				grk_cparameters cparams;
+				grk_set_default_encoder_parameters(&cparams);
+				cparams.isHT = true;
+				cparams.cblockw_init = cblk;
+				cparams.cblockh_init = std::min<uint32_t>(cblk, 4096 / cblk);
+				cparams.irreversible = config->irreversible;
+				if (config->rates[0] > 0) {
+					cparams.tcp_numlayers = 4;
+					for (uint32_t l = 0; l < 4; ++l)
+						cparams.tcp_rates[l] = config->rates[l];
+					cparams.cp_disto_alloc = 1;
+				}
+				// the compressor takes over the sample buffers of the image
+				auto image = bench_make_image(w, h, 3, 8);
+				if (!image) {
+					fprintf(stderr, "Unable to create %ux%u image\n", w, h);
+					return 1;
+				}
+				std::vector<uint8_t> codestream;
+				auto start = std::chrono::high_resolution_clock::now();
+				size_t len = bench_compress(image, &cparams, codestream);
+				std::chrono::duration<double> elapsed =
+						std::chrono::high_resolution_clock::now() - start;
+				grk_image_destroy(image);
+				if (!len) {
+					fprintf(stderr, "Compress failed\n");
+					return 1;
+				}
+				ms += elapsed.count() * 1000;
+				if (isa == GRK_ISA_SCALAR && r == 0) {
+					scalar_stream = codestream;
+					printf(" %10u", (uint32_t) len);
+				} else if (codestream != scalar_stream) {
+					match = false;
+				}
+			}
+			ms /= runs;
+			printf(" %10.03f", ms);
+			if (kernels == best_kernels)
+				best_ms = ms;
+		}
+		// throughput of the best instruction set
+		double mpix = (double) w * h / (best_ms * 1000) / num_threads;
+		printf(" %12.03f %12.03f\n", mpix, mpix * 1e6 / (7680.0 * 4320.0));
+	}
+	Kernels::g_kernels = best_kernels;
+	grk_deinitialize();
+	if (!match) {
+		fprintf(stderr, "Code streams differ between instruction sets\n");
+		return 1;
+	}
+	printf("code streams match\n");
+
+	return 0;
+}
@@ -0,0 +1,211 @@
+/*
+ *    Copyright (C) 2016-2020 Grok Image Compression Inc.
+ *
+ *    This source code is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This source code is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ *    Time of the custom (array based) multi-component transform with the
+ *    kernels of each instruction set, against a per pixel scalar loop, for
+ *    the many components of hyperspectral images. Every instruction set
+ *    must give the same samples as the scalar loop.
+ */
+
+#include "grok_includes.h"
+#include <chrono>  // for high_resolution_clock
+
+using namespace grk;
+
+namespace grk {
+
+void usage(void) {
+	printf("bench_mct [-num_threads val] [-w val] [-h val] [-comps val]\n");
+	printf("          [-runs val]\n");
+	exit(1);
+}
+
+/* one sample at a time, gathering every component of the pixel */
+void reference_float(const float *matrix, uint32_t numcomps, float **chan,
+		uint64_t n) {
+	std::vector<float> pixel(numcomps);
+	for (uint64_t i = 0; i < n; ++i) {
+		for (uint32_t k = 0; k < numcomps; ++k)
+			pixel[k] = chan[k][i];
+		auto m = matrix;
+		for (uint32_t j = 0; j < numcomps; ++j) {
+			float acc = 0;
+			for (uint32_t k = 0; k < numcomps; ++k)
+				acc += *(m++) * pixel[k];
+			chan[j][i] = acc;
+		}
+	}
+}
+
+/* as above, on integer samples with a 13 bit fixed point matrix */
+void reference_int(const float *matrix, uint32_t numcomps, int32_t **chan,
+		uint64_t n) {
+	std::vector<int32_t> fix_matrix(numcomps * numcomps);
+	for (size_t i = 0; i < fix_matrix.size(); ++i)
+		fix_matrix[i] = (int32_t) (matrix[i] * (float) (1 << 13));
+	std::vector<int32_t> pixel(numcomps);
+	for (uint64_t i = 0; i < n; ++i) {
+		for (uint32_t k = 0; k < numcomps; ++k)
+			pixel[k] = chan[k][i];
+		auto m = fix_matrix.data();
+		for (uint32_t j = 0; j < numcomps; ++j) {
+			int32_t acc = 0;
+			for (uint32_t k = 0; k < numcomps; ++k)
+				acc += int_fix_mul(*(m++), pixel[k]);
+			chan[j][i] = acc;
+		}
+	}
+}
+
+struct MctConfig {
+	const char *name;
+	bool reversible;
+};
+
+}
+
+int main(int argc, char **argv) {
+	uint32_t num_threads = 1;
+	uint32_t w = 256;
+	uint32_t h = 256;
+	uint32_t numcomps = 224;
+	uint32_t runs = 3;
+
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-num_threads") == 0 && i + 1 < argc) {
+			num_threads = (uint32_t) atoi(argv[i + 1]);
+			i++;
+		} else if (strcmp(argv[i], "-w") == 0 && i + 1 < argc) {
+			w = (uint32_t) atoi(argv[i + 1]);
+			i++;
+		} else if (strcmp(argv[i], "-h") == 0 && i + 1 < argc) {
+			h = (uint32_t) atoi(argv[i + 1]);
+			i++;
+		} else if (strcmp(argv[i], "-comps") == 0 && i + 1 < argc) {
+			numcomps = (uint32_t) atoi(argv[i + 1]);
+			i++;
+		} else if (strcmp(argv[i], "-runs") == 0 && i + 1 < argc) {
+			runs = (uint32_t) atoi(argv[i + 1]);
+			i++;
+		} else {
+			usage();
+		}
+	}
+	if (!w || !h || !runs || !numcomps)
+		usage();
+	grk_initialize(nullptr, num_threads);
+	num_threads = Scheduler::g_tp->num_threads();
+
+	uint64_t n = (uint64_t) w * h;
+	uint32_t seed = 12345;
+	auto rand = [&seed]() {
+		seed = seed * 1664525U + 1013904223U;
+		return seed >> 8;
+	};
+	// diagonally dominant, as a decorrelation matrix is
+	std::vector<float> matrix((size_t) numcomps * numcomps);
+	for (uint32_t j = 0; j < numcomps; ++j) {
+		for (uint32_t k = 0; k < numcomps; ++k) {
+			float v = ((float) (rand() % 2001) - 1000.0f)
+					/ (1000.0f * (float) numcomps);
+			matrix[(size_t) j * numcomps + k] = j == k ? 1.0f + v : v;
+		}
+	}
+	std::vector<int32_t> source(n * numcomps);
+	for (auto &v : source)
+		v = (int32_t) (rand() % 4096) - 2048;
+	std::vector<int32_t> expected(source.size());
+	std::vector<int32_t> work(source.size());
+	std::vector<int32_t*> chan(numcomps);
+	for (uint32_t c = 0; c < numcomps; ++c)
+		chan[c] = work.data() + c * n;
+
+	const uint32_t numconfigs = 2;
+	const MctConfig configs[numconfigs] = { { "float", false },
+			{ "integer", true } };
+	auto best_kernels = Kernels::g_kernels;
+	bool match = true;
+	printf("%u thread(s), %u components, %ux%u\n", num_threads, numcomps, w,
+			h);
+	printf("%-10s %10s", "transform", "per pixel");
+	for (uint32_t isa = GRK_ISA_SCALAR; isa < GRK_ISA_COUNT; ++isa) {
+		auto kernels = Kernels::get((GRK_KERNEL_ISA) isa);
+		if (kernels)
+			printf(" %10s", kernels->name);
+	}
+	printf(" %12s\n", "MPix/s");
+	for (uint32_t c = 0; c < numconfigs; ++c) {
+		auto config = configs + c;
+		printf("%-10s", config->name);
+		// the components of the irreversible transform hold float samples
+		work = source;
+		if (!config->reversible) {
+			for (auto &v : work) {
+				float f = (float) v;
+				memcpy(&v, &f, sizeof(f));
+			}
+		}
+		std::vector<int32_t> input = work;
+		auto start = std::chrono::high_resolution_clock::now();
+		if (config->reversible)
+			reference_int(matrix.data(), numcomps, chan.data(), n);
+		else
+			reference_float(matrix.data(), numcomps, (float**) chan.data(),
+					n);
+		std::chrono::duration<double> elapsed =
+				std::chrono::high_resolution_clock::now() - start;
+		printf(" %10.03f", elapsed.count() * 1000);
+		expected = work;
+		double best_ms = 0;
+		for (uint32_t isa = GRK_ISA_SCALAR; isa < GRK_ISA_COUNT; ++isa) {
+			auto kernels = Kernels::get((GRK_KERNEL_ISA) isa);
+			if (!kernels)
+				continue;
+			Kernels::g_kernels = kernels;
+			double ms = 0;
+			for (uint32_t r = 0; r < runs; ++r) {
+				work = input;
+				start = std::chrono::high_resolution_clock::now();
+				bool rc = mct::decode_custom((uint8_t*) matrix.data(), n,
+						(uint8_t**) chan.data(), numcomps, 0,
+						config->reversible);
+				elapsed = std::chrono::high_resolution_clock::now() - start;
+				if (!rc) {
+					fprintf(stderr, "Custom MCT failed\n");
+					return 1;
+				}
+				ms += elapsed.count() * 1000;
+				if (work != expected)
+					match = false;
+			}
+			ms /= runs;
+			printf(" %10.03f", ms);
+			if (kernels == best_kernels)
+				best_ms = ms;
+		}
+		// throughput of the best instruction set
+		printf(" %12.03f\n", (double) n / (best_ms * 1000));
+	}
+	Kernels::g_kernels = best_kernels;
+	grk_deinitialize();
+	if (!match) {
+		fprintf(stderr, "Samples differ from the per pixel transform\n");
+		return 1;
+	}
+	printf("samples match\n");
+
+	return 0;
+}
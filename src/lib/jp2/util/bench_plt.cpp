@@ -0,0 +1,139 @@
+/*
+ *    Copyright (C) 2016-2020 Grok Image Compression Inc.
+ *
+ *    This source code is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This source code is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ *    Cost of writing PLT and TLM markers when compressing, and the time
+ *    they save when decoding a small region: with packet lengths, the
+ *    decoder skips the packets of precincts outside the region without
+ *    reading their headers.
+ */
+
+#include "bench_codec.h"
+
+using namespace grk;
+
+namespace grk {
+
+void usage(void) {
+	printf("bench_plt [-num_threads val] [-w val] [-h val] [-precinct val]\n");
+	printf("          [-region val] [-runs val]\n");
+	exit(1);
+}
+
+}
+
+int main(int argc, char **argv) {
+	uint32_t num_threads = 0;
+	uint32_t w = 8192;
+	uint32_t h = 8192;
+	uint32_t precinct = 128;
+	uint32_t region = 256;
+	uint32_t runs = 5;
+
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-num_threads") == 0 && i + 1 < argc) {
+			num_threads = (uint32_t) atoi(argv[i + 1]);
+			i++;
+		} else if (strcmp(argv[i], "-w") == 0 && i + 1 < argc) {
+			w = (uint32_t) atoi(argv[i + 1]);
+			i++;
+		} else if (strcmp(argv[i], "-h") == 0 && i + 1 < argc) {
+			h = (uint32_t) atoi(argv[i + 1]);
+			i++;
+		} else if (strcmp(argv[i], "-precinct") == 0 && i + 1 < argc) {
+			precinct = (uint32_t) atoi(argv[i + 1]);
+			i++;
+		} else if (strcmp(argv[i], "-region") == 0 && i + 1 < argc) {
+			region = (uint32_t) atoi(argv[i + 1]);
+			i++;
+		} else if (strcmp(argv[i], "-runs") == 0 && i + 1 < argc) {
+			runs = (uint32_t) atoi(argv[i + 1]);
+			i++;
+		} else {
+			usage();
+		}
+	}
+	if (!w || !h || !runs || !region || region > w || region > h)
+		usage();
+	if (precinct < 4 || (precinct & (precinct - 1)))
+		usage();
+	grk_initialize(nullptr, num_threads);
+
+	const char *names[] = { "without PLT", "with PLT" };
+	std::vector<uint8_t> codestream[2];
+	double compress_ms[2];
+	for (uint32_t s = 0; s < 2; ++s) {
+		grk_cparameters cparams;
+		grk_set_default_encoder_parameters(&cparams);
+		cparams.csty |= 0x01;
+		cparams.res_spec = 1;
+		cparams.prcw_init[0] = precinct;
+		cparams.prch_init[0] = precinct;
+		cparams.write_plt = s == 1;
+		cparams.write_tlm = s == 1;
+		compress_ms[s] = 0;
+		for (uint32_t r = 0; r < runs; ++r) {
+			// the codec takes the image data, so each run needs a new image
+			auto image = bench_make_image(w, h, 1, 8);
+			if (!image) {
+				fprintf(stderr, "Unable to create %ux%u image\n", w, h);
+				return 1;
+			}
+			auto start = std::chrono::high_resolution_clock::now();
+			size_t len = bench_compress(image, &cparams, codestream[s]);
+			std::chrono::duration<double> elapsed =
+					std::chrono::high_resolution_clock::now() - start;
+			grk_image_destroy(image);
+			if (!len) {
+				fprintf(stderr, "Compress failed\n");
+				return 1;
+			}
+			compress_ms[s] += elapsed.count() * 1000;
+		}
+		compress_ms[s] /= runs;
+		printf("compress %-12s %10.03f ms %10u bytes\n", names[s],
+				compress_ms[s], (uint32_t) codestream[s].size());
+	}
+	printf("compress overhead: %.1f%% time, %.2f%% size\n",
+			100.0 * (compress_ms[1] / compress_ms[0] - 1.0),
+			100.0 * ((double) codestream[1].size() / codestream[0].size() - 1.0));
+
+	// a region in the middle of the image
+	double decompress_ms[2];
+	for (uint32_t s = 0; s < 2; ++s) {
+		grk_dparameters dparams;
+		grk_set_default_decoder_parameters(&dparams);
+		uint32_t x0 = (w - region) / 2;
+		uint32_t y0 = (h - region) / 2;
+		decompress_ms[s] = 0;
+		for (uint32_t r = 0; r < runs; ++r) {
+			double ms = bench_decompress_region(codestream[s], &dparams, x0,
+					y0, x0 + region, y0 + region);
+			if (ms < 0) {
+				fprintf(stderr, "Decompress failed\n");
+				return 1;
+			}
+			decompress_ms[s] += ms;
+		}
+		decompress_ms[s] /= runs;
+		printf("region %ux%u %-12s %10.03f ms\n", region, region, names[s],
+				decompress_ms[s]);
+	}
+	printf("region decompress: %.1f%% faster\n",
+			100.0 * (1.0 - decompress_ms[1] / decompress_ms[0]));
+	grk_deinitialize();
+
+	return 0;
+}
@@ -0,0 +1,182 @@
+/*
+ *    Copyright (C) 2016-2020 Grok Image Compression Inc.
+ *
+ *    This source code is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This source code is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ *    Compress time and layer sizes of the rate control algorithms, for
+ *    a single tile with many quality layers. Layer sizes are read from
+ *    the PLT markers: with LRCP progression, the packets of a layer
+ *    follow those of the previous layer.
+ */
+
+#include "bench_codec.h"
+
+using namespace grk;
+
+namespace grk {
+
+void usage(void) {
+	printf("bench_ratecontrol [-num_threads val] [-w val] [-h val] [-layers val]\n");
+	printf("          [-runs val]\n");
+	exit(1);
+}
+
+/**
+ * Sum the PLT packet lengths of each layer
+ * @return false if the code stream does not hold one packet length
+ * per packet of every layer
+ */
+bool layer_sizes(const std::vector<uint8_t> &cs, uint32_t numlayers,
+		std::vector<uint64_t> &sizes) {
+	std::vector<uint32_t> lengths;
+	size_t pos = 2;
+	while (pos + 4 <= cs.size()) {
+		uint32_t marker = (uint32_t) (cs[pos] << 8) | cs[pos + 1];
+		if (marker == 0xFF93)
+			break;
+		uint32_t seglen = (uint32_t) (cs[pos + 2] << 8) | cs[pos + 3];
+		if (marker == 0xFF58) {
+			uint32_t len = 0;
+			for (size_t i = pos + 5; i < pos + 2 + seglen; ++i) {
+				len = (len << 7) | (cs[i] & 0x7F);
+				if (!(cs[i] & 0x80)) {
+					lengths.push_back(len);
+					len = 0;
+				}
+			}
+		}
+		pos += 2 + seglen;
+	}
+	if (lengths.empty() || lengths.size() % numlayers)
+		return false;
+	size_t per_layer = lengths.size() / numlayers;
+	sizes.assign(numlayers, 0);
+	for (size_t i = 0; i < lengths.size(); ++i)
+		sizes[i / per_layer] += lengths[i];
+	for (uint32_t l = 1; l < numlayers; ++l)
+		sizes[l] += sizes[l - 1];
+
+	return true;
+}
+
+}
+
+int main(int argc, char **argv) {
+	uint32_t num_threads = 0;
+	uint32_t w = 2048;
+	uint32_t h = 2048;
+	uint32_t layers = 20;
+	uint32_t runs = 3;
+
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-num_threads") == 0 && i + 1 < argc) {
+			num_threads = (uint32_t) atoi(argv[i + 1]);
+			i++;
+		} else if (strcmp(argv[i], "-w") == 0 && i + 1 < argc) {
+			w = (uint32_t) atoi(argv[i + 1]);
+			i++;
+		} else if (strcmp(argv[i], "-h") == 0 && i + 1 < argc) {
+			h = (uint32_t) atoi(argv[i + 1]);
+			i++;
+		} else if (strcmp(argv[i], "-layers") == 0 && i + 1 < argc) {
+			layers = (uint32_t) atoi(argv[i + 1]);
+			i++;
+		} else if (strcmp(argv[i], "-runs") == 0 && i + 1 < argc) {
+			runs = (uint32_t) atoi(argv[i + 1]);
+			i++;
+		} else {
+			usage();
+		}
+	}
+	if (!w || !h || !runs || layers < 2 || layers > 100)
+		usage();
+	grk_initialize(nullptr, num_threads);
+
+	// compression ratios from 200 down to 4, evenly spaced in log scale
+	std::vector<double> ratios(layers);
+	for (uint32_t l = 0; l < layers; ++l)
+		ratios[l] = 200.0 * pow(4.0 / 200.0, (double) l / (layers - 1));
+
+	const uint32_t numalgos = 3;
+	const char *names[numalgos] = { "bisect all", "bisect feasible",
+			"incremental" };
+	std::vector<uint64_t> sizes[numalgos];
+	double compress_ms[numalgos];
+	for (uint32_t a = 0; a < numalgos; ++a) {
+		grk_cparameters cparams;
+		grk_set_default_encoder_parameters(&cparams);
+		cparams.tcp_numlayers = layers;
+		for (uint32_t l = 0; l < layers; ++l)
+			cparams.tcp_rates[l] = ratios[l];
+		cparams.cp_disto_alloc = 1;
+		cparams.rateControlAlgorithm = a;
+		cparams.write_plt = true;
+		std::vector<uint8_t> codestream;
+		compress_ms[a] = 0;
+		for (uint32_t r = 0; r < runs; ++r) {
+			// the codec takes the image data, so each run needs a new image
+			auto image = bench_make_image(w, h, 3, 8);
+			if (!image) {
+				fprintf(stderr, "Unable to create %ux%u image\n", w, h);
+				return 1;
+			}
+			auto start = std::chrono::high_resolution_clock::now();
+			size_t len = bench_compress(image, &cparams, codestream);
+			std::chrono::duration<double> elapsed =
+					std::chrono::high_resolution_clock::now() - start;
+			grk_image_destroy(image);
+			if (!len) {
+				fprintf(stderr, "Compress failed\n");
+				return 1;
+			}
+			compress_ms[a] += elapsed.count() * 1000;
+		}
+		compress_ms[a] /= runs;
+		if (!layer_sizes(codestream, layers, sizes[a])) {
+			fprintf(stderr, "Unable to read layer sizes from PLT markers\n");
+			return 1;
+		}
+		printf("compress %-16s %10.03f ms %10u bytes\n", names[a],
+				compress_ms[a], (uint32_t) codestream.size());
+	}
+
+	// target: raw size over compression ratio, before marker overhead
+	printf("\n%5s %12s", "layer", "target");
+	for (uint32_t a = 0; a < numalgos; ++a)
+		printf(" %16s", names[a]);
+	printf("\n");
+	double fill[numalgos] = { };
+	double max_dev = 0;
+	for (uint32_t l = 0; l < layers; ++l) {
+		double target = 3.0 * w * h / ratios[l];
+		printf("%5u %12.0f", l, target);
+		for (uint32_t a = 0; a < numalgos; ++a) {
+			printf(" %16llu", (unsigned long long) sizes[a][l]);
+			fill[a] += sizes[a][l] / target;
+		}
+		printf("\n");
+		max_dev = std::max<double>(max_dev,
+				fabs((double) sizes[2][l] / sizes[1][l] - 1.0));
+	}
+	printf("\nmean layer size relative to target:");
+	for (uint32_t a = 0; a < numalgos; ++a)
+		printf(" %s %.2f%%", names[a], 100.0 * fill[a] / layers);
+	printf("\nlargest layer size deviation of incremental from bisect feasible: %.2f%%\n",
+			100.0 * max_dev);
+	printf("incremental compress: %.1f%% faster than bisect feasible\n",
+			100.0 * (1.0 - compress_ms[2] / compress_ms[1]));
+	grk_deinitialize();
+
+	return 0;
+}
@@ -0,0 +1,193 @@
+/*
+ *    Copyright (C) 2016-2020 Grok Image Compression Inc.
+ *
+ *    This source code is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This source code is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ *    Time of the Part 1 block encoder (T1) alone, on one thread, for code
+ *    blocks of Laplacian distributed samples, as the wavelet transform gives.
+ *    The checksum of the code block bytes and pass rates lets runs of two
+ *    builds be compared: a change to the MQ coder must not change it.
+ */
+
+#include "grok_includes.h"
+#include "t1_common.h"
+#include <chrono>  // for high_resolution_clock
+#include <cmath>
+
+using namespace grk;
+
+namespace grk {
+
+void usage(void) {
+	printf("bench_t1_encode [-w val] [-h val] [-cblk val] [-bits val]\n");
+	printf("          [-runs val]\n");
+	exit(1);
+}
+
+struct T1Config {
+	const char *name;
+	uint32_t cblksty;
+};
+
+/* FNV-1a */
+void checksum(uint64_t &hash, const void *data, size_t len) {
+	auto p = (const uint8_t*) data;
+	for (size_t i = 0; i < len; ++i) {
+		hash ^= p[i];
+		hash *= 0x100000001b3ULL;
+	}
+}
+
+}
+
+int main(int argc, char **argv) {
+	uint32_t w = 2048;
+	uint32_t h = 1080;
+	uint32_t cblk = 64;
+	uint32_t bits = 10;
+	uint32_t runs = 3;
+
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-w") == 0 && i + 1 < argc) {
+			w = (uint32_t) atoi(argv[i + 1]);
+			i++;
+		} else if (strcmp(argv[i], "-h") == 0 && i + 1 < argc) {
+			h = (uint32_t) atoi(argv[i + 1]);
+			i++;
+		} else if (strcmp(argv[i], "-cblk") == 0 && i + 1 < argc) {
+			cblk = (uint32_t) atoi(argv[i + 1]);
+			i++;
+		} else if (strcmp(argv[i], "-bits") == 0 && i + 1 < argc) {
+			bits = (uint32_t) atoi(argv[i + 1]);
+			i++;
+		} else if (strcmp(argv[i], "-runs") == 0 && i + 1 < argc) {
+			runs = (uint32_t) atoi(argv[i + 1]);
+			i++;
+		} else {
+			usage();
+		}
+	}
+	if (!w || !h || !runs || cblk < 4 || cblk > 64 || (cblk & (cblk - 1))
+			|| !bits || bits > 20)
+		usage();
+
+	// code blocks of the image, the last column and row possibly partial
+	struct Block {
+		uint32_t w, h;
+		uint8_t orient;
+		uint32_t max;
+		std::vector<int32_t> samples;
+	};
+	std::vector<Block> blocks;
+	uint32_t seed = 12345;
+	auto rand = [&seed]() {
+		seed = seed * 1664525U + 1013904223U;
+		return seed >> 8;
+	};
+	for (uint32_t y = 0; y < h; y += cblk) {
+		for (uint32_t x = 0; x < w; x += cblk) {
+			Block block;
+			block.w = std::min<uint32_t>(cblk, w - x);
+			block.h = std::min<uint32_t>(cblk, h - y);
+			block.orient = (uint8_t) (blocks.size() & 3);
+			block.max = 0;
+			// the spread of the samples varies from block to block,
+			// as it does between sub-bands and regions of an image
+			double scale = (double) (1 << (rand() % bits)) / 4;
+			for (uint32_t i = 0; i < block.w * block.h; ++i) {
+				double u = ((double) (rand() & 0xFFFF) + 1) / 65537.0;
+				auto mag = (int32_t) (-scale * log(u)
+						* (1 << T1_NMSEDEC_FRACBITS));
+				mag = std::min<int32_t>(mag,
+						(1 << (bits + T1_NMSEDEC_FRACBITS)) - 1);
+				block.max = std::max<uint32_t>(block.max, (uint32_t) mag);
+				block.samples.push_back((rand() & 1) ? -mag : mag);
+			}
+			blocks.push_back(std::move(block));
+		}
+	}
+
+	auto t1 = t1_create(true);
+	if (!t1) {
+		fprintf(stderr, "Unable to create block encoder\n");
+		return 1;
+	}
+	std::vector<uint8_t> buffer(
+			(size_t) cblk * cblk * sizeof(int32_t)
+					+ cblk_compressed_data_pad_left);
+
+	const uint32_t numconfigs = 3;
+	const T1Config configs[numconfigs] = { { "default", 0 },
+			{ "bypass", J2K_CCP_CBLKSTY_LAZY },
+			{ "all modes", J2K_CCP_CBLKSTY_LAZY | J2K_CCP_CBLKSTY_RESET
+					| J2K_CCP_CBLKSTY_TERMALL | J2K_CCP_CBLKSTY_VSC
+					| J2K_CCP_CBLKSTY_PTERM | J2K_CCP_CBLKSTY_SEGSYM } };
+	printf("%u code blocks of %ux%u, %u bits\n", (uint32_t) blocks.size(),
+			cblk, cblk, bits);
+	printf("%-10s %10s %10s %10s %18s\n", "mode", "bytes", "ms", "MPix/s",
+			"checksum");
+	for (uint32_t c = 0; c < numconfigs; ++c) {
+		auto config = configs + c;
+		uint64_t hash = 0xcbf29ce484222325ULL;
+		uint64_t bytes = 0;
+		double ms = 0;
+		for (uint32_t r = 0; r < runs; ++r) {
+			for (auto &block : blocks) {
+				if (!t1_allocate_buffers(t1, block.w, block.h)) {
+					fprintf(stderr, "Unable to allocate block encoder\n");
+					return 1;
+				}
+				t1->data_stride = block.w;
+				memcpy(t1->data, block.samples.data(),
+						block.samples.size() * sizeof(int32_t));
+				tcd_cblk_enc_t cblkopj;
+				memset(&cblkopj, 0, sizeof(tcd_cblk_enc_t));
+				cblkopj.x1 = (int32_t) block.w;
+				cblkopj.y1 = (int32_t) block.h;
+				buffer[0] = 0;
+				buffer[1] = 0;
+				cblkopj.data = buffer.data() + cblk_compressed_data_pad_left;
+				cblkopj.data_size = (uint32_t) (buffer.size()
+						- cblk_compressed_data_pad_left);
+				auto start = std::chrono::high_resolution_clock::now();
+				t1_encode_cblk(t1, &cblkopj, block.max, block.orient, 0, 1, 1,
+						1.0, config->cblksty, 1, nullptr, 0, true);
+				std::chrono::duration<double> elapsed =
+						std::chrono::high_resolution_clock::now() - start;
+				ms += elapsed.count() * 1000;
+				if (r == 0 && cblkopj.totalpasses) {
+					auto last = cblkopj.passes + cblkopj.totalpasses - 1;
+					bytes += last->rate;
+					checksum(hash, cblkopj.data, last->rate);
+					for (uint32_t p = 0; p < cblkopj.totalpasses; ++p) {
+						auto pass = cblkopj.passes + p;
+						checksum(hash, &pass->rate, sizeof(pass->rate));
+						uint32_t term = pass->term;
+						checksum(hash, &term, sizeof(term));
+						checksum(hash, &pass->distortiondec,
+								sizeof(pass->distortiondec));
+					}
+				}
+				t1_code_block_enc_deallocate(&cblkopj);
+			}
+		}
+		ms /= runs;
+		printf("%-10s %10llu %10.03f %10.03f  %016llx\n", config->name,
+				(unsigned long long) bytes, ms, (double) w * h / (ms * 1000),
+				(unsigned long long) hash);
+	}
+	t1_destroy(t1);
+
+	return 0;
+}
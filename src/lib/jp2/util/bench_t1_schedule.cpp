@@ -0,0 +1,119 @@
+/*
+ *    Copyright (C) 2016-2020 Grok Image Compression Inc.
+ *
+ *    This source code is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This source code is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ *    Tile decode latency with code blocks handed to the tier-1 threads in
+ *    codestream order, compared with largest estimated cost first.
+ *    Tiles are decoded one at a time, so each tile's latency includes
+ *    the tail where the last blocks finish on a few threads.
+ */
+
+#include "bench_codec.h"
+
+using namespace grk;
+
+namespace grk {
+
+void usage(void) {
+	printf("bench_t1_schedule [-num_threads val] [-w val] [-h val] [-tile val]\n");
+	printf("                  [-runs val] [-ht]\n");
+	exit(1);
+}
+
+}
+
+int main(int argc, char **argv) {
+	uint32_t num_threads = 0;
+	uint32_t w = 7680;
+	uint32_t h = 4320;
+	uint32_t tile = 1024;
+	uint32_t runs = 3;
+	bool ht = false;
+
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-num_threads") == 0 && i + 1 < argc) {
+			num_threads = (uint32_t) atoi(argv[i + 1]);
+			i++;
+		} else if (strcmp(argv[i], "-w") == 0 && i + 1 < argc) {
+			w = (uint32_t) atoi(argv[i + 1]);
+			i++;
+		} else if (strcmp(argv[i], "-h") == 0 && i + 1 < argc) {
+			h = (uint32_t) atoi(argv[i + 1]);
+			i++;
+		} else if (strcmp(argv[i], "-tile") == 0 && i + 1 < argc) {
+			tile = (uint32_t) atoi(argv[i + 1]);
+			i++;
+		} else if (strcmp(argv[i], "-runs") == 0 && i + 1 < argc) {
+			runs = (uint32_t) atoi(argv[i + 1]);
+			i++;
+		} else if (strcmp(argv[i], "-ht") == 0) {
+			ht = true;
+		} else {
+			usage();
+		}
+	}
+	if (!w || !h || !tile || !runs)
+		usage();
+	grk_initialize(nullptr, num_threads);
+
+	auto image = bench_make_image(w, h, 3, 8);
+	if (!image) {
+		fprintf(stderr, "Unable to create %ux%u image\n", w, h);
+		return 1;
+	}
+	grk_cparameters cparams;
+	grk_set_default_encoder_parameters(&cparams);
+	cparams.tile_size_on = true;
+	cparams.cp_tdx = tile;
+	cparams.cp_tdy = tile;
+	cparams.isHT = ht;
+	std::vector<uint8_t> codestream;
+	size_t len = bench_compress(image, &cparams, codestream);
+	grk_image_destroy(image);
+	if (!len) {
+		fprintf(stderr, "Compress failed\n");
+		return 1;
+	}
+	uint32_t num_tiles = ((w + tile - 1) / tile) * ((h + tile - 1) / tile);
+	printf("%ux%u, %u tiles of %u, %s, %u bytes\n", w, h, num_tiles, tile,
+			ht ? "HT" : "Part-1", (uint32_t) len);
+
+	const GRK_T1_SCHEDULE schedules[] = { GRK_T1_SCHEDULE_CODESTREAM,
+			GRK_T1_SCHEDULE_COST };
+	const char *names[] = { "codestream order", "largest cost first" };
+	double best[2];
+	for (uint32_t s = 0; s < 2; ++s) {
+		grk_dparameters dparams;
+		grk_set_default_decoder_parameters(&dparams);
+		dparams.max_tiles_in_flight = 1;
+		dparams.t1_schedule = schedules[s];
+		best[s] = 0;
+		for (uint32_t r = 0; r < runs; ++r) {
+			double ms = bench_decompress(codestream, &dparams);
+			if (ms < 0) {
+				fprintf(stderr, "Decompress failed\n");
+				return 1;
+			}
+			if (r == 0 || ms < best[s])
+				best[s] = ms;
+		}
+		printf("%-20s %10.03f ms per image %10.03f ms per tile\n", names[s],
+				best[s], best[s] / num_tiles);
+	}
+	printf("tile latency: %.1f%% lower\n", 100.0 * (1.0 - best[1] / best[0]));
+	grk_deinitialize();
+
+	return 0;
+}
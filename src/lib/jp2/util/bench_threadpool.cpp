@@ -0,0 +1,215 @@
+/*
+ *    Copyright (C) 2016-2020 Grok Image Compression Inc.
+ *
+ *    This source code is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This source code is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ *    Task throughput of the work-stealing ThreadPool, compared with a
+ *    single queue pool guarded by one mutex (the previous ThreadPool).
+ */
+
+#include "grok_includes.h"
+#include <chrono>  // for high_resolution_clock
+#include <queue>
+
+using namespace grk;
+
+namespace grk {
+
+/**
+ * Thread pool with a single task queue behind a single mutex
+ */
+class MutexThreadPool {
+public:
+	MutexThreadPool(size_t threads) : stop(false) {
+		for (size_t i = 0; i < threads; ++i) {
+			workers.emplace_back([this] {
+				for (;;) {
+					std::function<void()> task;
+					{
+						std::unique_lock<std::mutex> lock(queue_mutex);
+						condition.wait(lock,
+								[this] {return stop || !tasks.empty();});
+						if (stop && tasks.empty())
+							return;
+						task = std::move(tasks.front());
+						tasks.pop();
+					}
+					task();
+				}
+			});
+		}
+	}
+	~MutexThreadPool() {
+		{
+			std::unique_lock<std::mutex> lock(queue_mutex);
+			stop = true;
+		}
+		condition.notify_all();
+		for (auto &worker : workers)
+			worker.join();
+	}
+	template<class F> std::future<void> enqueue(F &&f) {
+		auto task = std::make_shared<std::packaged_task<void()> >(
+				std::forward<F>(f));
+		auto res = task->get_future();
+		{
+			std::unique_lock<std::mutex> lock(queue_mutex);
+			tasks.emplace([task]() {(*task)();});
+		}
+		condition.notify_one();
+		return res;
+	}
+private:
+	std::vector<std::thread> workers;
+	std::queue<std::function<void()> > tasks;
+	std::mutex queue_mutex;
+	std::condition_variable condition;
+	bool stop;
+};
+
+static std::atomic<uint64_t> sink(0);
+
+// a small amount of work, standing in for a code block or a line of a transform
+static void work(uint32_t iterations) {
+	uint64_t x = iterations;
+	for (uint32_t i = 0; i < iterations; ++i)
+		x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+	sink += x;
+}
+
+static double elapsed_ms(
+		std::chrono::time_point<std::chrono::high_resolution_clock> start) {
+	std::chrono::duration<double> elapsed =
+			std::chrono::high_resolution_clock::now() - start;
+	return elapsed.count() * 1000;
+}
+
+static void report(const char *name, uint64_t num_tasks, double ms) {
+	printf("%-34s %10.03f ms  %12.0f tasks/s\n", name, ms,
+			(double) num_tasks / (ms / 1000));
+}
+
+void usage(void) {
+	printf("bench_threadpool [-num_threads val] [-tasks val] [-work val]\n");
+	printf("                 [-outer val]\n");
+	exit(1);
+}
+
+}
+
+int main(int argc, char **argv) {
+	uint32_t num_threads = 0;
+	uint32_t num_tasks = 1 << 18;
+	uint32_t iterations = 256;
+	uint32_t outer = 64;
+
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-num_threads") == 0 && i + 1 < argc) {
+			num_threads = (uint32_t) atoi(argv[i + 1]);
+			i++;
+		} else if (strcmp(argv[i], "-tasks") == 0 && i + 1 < argc) {
+			num_tasks = (uint32_t) atoi(argv[i + 1]);
+			i++;
+		} else if (strcmp(argv[i], "-work") == 0 && i + 1 < argc) {
+			iterations = (uint32_t) atoi(argv[i + 1]);
+			i++;
+		} else if (strcmp(argv[i], "-outer") == 0 && i + 1 < argc) {
+			outer = (uint32_t) atoi(argv[i + 1]);
+			if (outer == 0)
+				usage();
+			i++;
+		} else {
+			usage();
+		}
+	}
+	if (!num_threads)
+		num_threads = std::thread::hardware_concurrency();
+	printf("%u threads, %u tasks, %u iterations per task\n", num_threads,
+			num_tasks, iterations);
+
+	std::chrono::time_point<std::chrono::high_resolution_clock> start;
+	{
+		MutexThreadPool pool(num_threads);
+
+		// one future per task
+		start = std::chrono::high_resolution_clock::now();
+		std::vector<std::future<void> > results;
+		results.reserve(num_tasks);
+		for (uint32_t i = 0; i < num_tasks; ++i)
+			results.emplace_back(pool.enqueue([iterations] {work(iterations);}));
+		for (auto &result : results)
+			result.get();
+		report("mutex pool: enqueue", num_tasks, elapsed_ms(start));
+
+		// one task per thread, claiming iterations from a shared counter
+		start = std::chrono::high_resolution_clock::now();
+		std::atomic<uint32_t> next(0);
+		results.clear();
+		for (uint32_t t = 0; t < num_threads; ++t) {
+			results.emplace_back(pool.enqueue([&next, num_tasks, iterations] {
+				while (next++ < num_tasks)
+					work(iterations);
+			}));
+		}
+		for (auto &result : results)
+			result.get();
+		report("mutex pool: counter loop", num_tasks, elapsed_ms(start));
+
+		// nested: inner loops run serially inside each outer task,
+		// since waiting on the pool from a worker can deadlock it
+		start = std::chrono::high_resolution_clock::now();
+		results.clear();
+		uint32_t inner = num_tasks / outer;
+		for (uint32_t t = 0; t < outer; ++t) {
+			results.emplace_back(pool.enqueue([inner, iterations] {
+				for (uint32_t i = 0; i < inner; ++i)
+					work(iterations);
+			}));
+		}
+		for (auto &result : results)
+			result.get();
+		report("mutex pool: nested (serial inner)", inner * outer,
+				elapsed_ms(start));
+	}
+	{
+		ThreadPool pool(num_threads);
+
+		start = std::chrono::high_resolution_clock::now();
+		std::vector<std::future<void> > results;
+		results.reserve(num_tasks);
+		for (uint32_t i = 0; i < num_tasks; ++i)
+			results.emplace_back(pool.enqueue([iterations] {work(iterations);}));
+		for (auto &result : results)
+			result.get();
+		report("work stealing: enqueue", num_tasks, elapsed_ms(start));
+
+		start = std::chrono::high_resolution_clock::now();
+		pool.parallel_for(num_tasks, [iterations](size_t) {
+			work(iterations);
+		});
+		report("work stealing: parallel_for", num_tasks, elapsed_ms(start));
+
+		// nested: each outer task runs its inner loop with parallel_for
+		start = std::chrono::high_resolution_clock::now();
+		uint32_t inner = num_tasks / outer;
+		pool.parallel_for(outer, [&pool, inner, iterations](size_t) {
+			pool.parallel_for(inner, [iterations](size_t) {
+				work(iterations);
+			});
+		});
+		report("work stealing: nested", inner * outer, elapsed_ms(start));
+	}
+
+	return 0;
+}
@@ -0,0 +1,177 @@
+/*
+ *    Copyright (C) 2016-2020 Grok Image Compression Inc.
+ *
+ *    This source code is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This source code is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ *    Latency of decoding one random tile of a many-tile codestream with a
+ *    fresh codec, with and without TLM markers in the main header. Without
+ *    TLM, the decoder reads the tile-part headers in front of the tile.
+ */
+
+#include "bench_codec.h"
+
+using namespace grk;
+
+namespace grk {
+
+static uint32_t read_be(const uint8_t *p, uint32_t n) {
+	uint32_t v = 0;
+	for (uint32_t i = 0; i < n; ++i)
+		v = (v << 8) | p[i];
+	return v;
+}
+
+static void write_be(std::vector<uint8_t> &out, uint32_t v, uint32_t n) {
+	for (uint32_t i = n; i > 0; --i)
+		out.push_back((uint8_t) (v >> (8 * (i - 1))));
+}
+
+/**
+ * Copy a codestream, adding TLM markers with 16 bit tile numbers and
+ * 32 bit tile-part lengths to the end of its main header
+ * @return false if the codestream can't be parsed
+ */
+static bool add_tlm(const std::vector<uint8_t> &in, std::vector<uint8_t> &out) {
+	// find the first SOT marker
+	size_t pos = 2;
+	while (pos + 4 <= in.size() && read_be(&in[pos], 2) != 0xff90)
+		pos += 2 + read_be(&in[pos + 2], 2);
+	if (pos + 4 > in.size())
+		return false;
+	size_t first_sot = pos;
+
+	// collect tile numbers and lengths of the tile-parts
+	std::vector<std::pair<uint16_t, uint32_t> > tile_parts;
+	while (pos + 12 <= in.size() && read_be(&in[pos], 2) == 0xff90) {
+		uint32_t psot = read_be(&in[pos + 6], 4);
+		if (psot < 14)
+			return false;
+		tile_parts.push_back(
+				std::make_pair((uint16_t) read_be(&in[pos + 4], 2), psot));
+		pos += psot;
+	}
+
+	out.assign(in.begin(), in.begin() + (ptrdiff_t) first_sot);
+	const size_t per_marker = (0xffff - 4) / 6;
+	for (size_t i = 0; i < tile_parts.size(); i += per_marker) {
+		size_t n = std::min<size_t>(per_marker, tile_parts.size() - i);
+		write_be(out, 0xff55, 2);
+		write_be(out, (uint32_t) (4 + 6 * n), 2);
+		write_be(out, (uint32_t) (i / per_marker), 1);
+		write_be(out, 0x60, 1);
+		for (size_t j = i; j < i + n; ++j) {
+			write_be(out, tile_parts[j].first, 2);
+			write_be(out, tile_parts[j].second, 4);
+		}
+	}
+	out.insert(out.end(), in.begin() + (ptrdiff_t) first_sot, in.end());
+
+	return true;
+}
+
+void usage(void) {
+	printf("bench_tlm [-num_threads val] [-w val] [-h val] [-tile val]\n");
+	printf("          [-runs val]\n");
+	exit(1);
+}
+
+}
+
+int main(int argc, char **argv) {
+	uint32_t num_threads = 0;
+	uint32_t w = 8192;
+	uint32_t h = 8192;
+	uint32_t tile = 128;
+	uint32_t runs = 50;
+
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-num_threads") == 0 && i + 1 < argc) {
+			num_threads = (uint32_t) atoi(argv[i + 1]);
+			i++;
+		} else if (strcmp(argv[i], "-w") == 0 && i + 1 < argc) {
+			w = (uint32_t) atoi(argv[i + 1]);
+			i++;
+		} else if (strcmp(argv[i], "-h") == 0 && i + 1 < argc) {
+			h = (uint32_t) atoi(argv[i + 1]);
+			i++;
+		} else if (strcmp(argv[i], "-tile") == 0 && i + 1 < argc) {
+			tile = (uint32_t) atoi(argv[i + 1]);
+			i++;
+		} else if (strcmp(argv[i], "-runs") == 0 && i + 1 < argc) {
+			runs = (uint32_t) atoi(argv[i + 1]);
+			i++;
+		} else {
+			usage();
+		}
+	}
+	if (!w || !h || !tile || !runs)
+		usage();
+	uint32_t num_tiles = ((w + tile - 1) / tile) * ((h + tile - 1) / tile);
+	if (num_tiles > 65535) {
+		fprintf(stderr, "Too many tiles\n");
+		return 1;
+	}
+	grk_initialize(nullptr, num_threads);
+
+	auto image = bench_make_image(w, h, 1, 8);
+	if (!image) {
+		fprintf(stderr, "Unable to create %ux%u image\n", w, h);
+		return 1;
+	}
+	grk_cparameters cparams;
+	grk_set_default_encoder_parameters(&cparams);
+	cparams.tile_size_on = true;
+	cparams.cp_tdx = tile;
+	cparams.cp_tdy = tile;
+	std::vector<uint8_t> codestream[2];
+	size_t len = bench_compress(image, &cparams, codestream[0]);
+	grk_image_destroy(image);
+	if (!len || !add_tlm(codestream[0], codestream[1])) {
+		fprintf(stderr, "Compress failed\n");
+		return 1;
+	}
+	printf("%ux%u, %u tiles of %u, %u bytes\n", w, h, num_tiles, tile,
+			(uint32_t) len);
+
+	// the same random tiles for both codestreams
+	std::vector<uint16_t> tiles(runs);
+	uint32_t seed = 12345;
+	for (auto &t : tiles) {
+		seed = seed * 1664525U + 1013904223U;
+		t = (uint16_t) ((seed >> 8) % num_tiles);
+	}
+	const char *names[] = { "without TLM", "with TLM" };
+	double mean[2];
+	for (uint32_t s = 0; s < 2; ++s) {
+		grk_dparameters dparams;
+		grk_set_default_decoder_parameters(&dparams);
+		double total = 0, worst = 0;
+		for (auto t : tiles) {
+			double ms = bench_decompress_tile(codestream[s], &dparams, t);
+			if (ms < 0) {
+				fprintf(stderr, "Decompress of tile %u failed\n", t);
+				return 1;
+			}
+			total += ms;
+			worst = std::max(worst, ms);
+		}
+		mean[s] = total / runs;
+		printf("%-12s %10.03f ms mean %10.03f ms worst per tile\n", names[s],
+				mean[s], worst);
+	}
+	printf("tile latency: %.1f%% lower\n", 100.0 * (1.0 - mean[1] / mean[0]));
+	grk_deinitialize();
+
+	return 0;
+}
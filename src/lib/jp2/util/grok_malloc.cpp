@@ -230,10 +230,10 @@ void* grok_calloc(size_t num, size_t size) {
 }
 
 void* grok_aligned_malloc(size_t size) {
-	return grk_aligned_alloc_n(32U, size);
+	return grk_aligned_alloc_n(64U, size);
 }
 void* grok_aligned_realloc(void *ptr, size_t size) {
-	return grok_aligned_realloc_n(ptr, 32U, size);
+	return grok_aligned_realloc_n(ptr, 64U, size);
 }
 
 
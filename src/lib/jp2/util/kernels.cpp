@@ -0,0 +1,58 @@
+/*
+ *    Copyright (C) 2016-2020 Grok Image Compression Inc.
+ *
+ *    This source code is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This source code is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "CPUArch.h"
+#include "grok_includes.h"
+
+namespace grk {
+
+// the portable kernels are always safe, until init() finds something better
+const Kernels *Kernels::g_kernels = &scalar_kernels;
+
+const Kernels* Kernels::get(GRK_KERNEL_ISA isa){
+#ifdef GROK_HAVE_X86_KERNELS
+	CPUArch arch;
+#endif
+	switch(isa){
+	case GRK_ISA_SCALAR:
+		return &scalar_kernels;
+#ifdef GROK_HAVE_X86_KERNELS
+	case GRK_ISA_SSE2:
+		return arch.SSE2() ? &sse2_kernels : nullptr;
+	case GRK_ISA_SSE41:
+		return arch.SSE4_1() ? &sse41_kernels : nullptr;
+	case GRK_ISA_AVX2:
+		return arch.AVX2() ? &avx2_kernels : nullptr;
+	case GRK_ISA_AVX512:
+		return arch.AVX512F() ? &avx512_kernels : nullptr;
+#endif
+	default:
+		return nullptr;
+	}
+}
+
+void Kernels::init(void){
+	for (int isa = GRK_ISA_COUNT - 1; isa >= GRK_ISA_SCALAR; --isa){
+		auto kernels = get((GRK_KERNEL_ISA)isa);
+		if (kernels){
+			g_kernels = kernels;
+			return;
+		}
+	}
+}
+
+}
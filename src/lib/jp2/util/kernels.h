@@ -0,0 +1,202 @@
+/*
+ *    Copyright (C) 2016-2020 Grok Image Compression Inc.
+ *
+ *    This source code is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This source code is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+namespace grk {
+
+/**
+ * Instruction sets of the kernel tables, from least to most preferred:
+ * Kernels::init selects the last one that the CPU supports. The values
+ * are only used inside the library, and are never stored.
+ */
+enum GRK_KERNEL_ISA {
+	GRK_ISA_SCALAR,
+	GRK_ISA_SSE2,
+	GRK_ISA_SSE41,
+	GRK_ISA_AVX2,
+	GRK_ISA_AVX512,
+	GRK_ISA_COUNT
+};
+
+/**
+ * Table of the SIMD kernels compiled for one instruction set.
+ *
+ * Each table lives in its own translation unit, built with the compiler
+ * flags for its instruction set, so the library as a whole only assumes
+ * the baseline instruction set of the target. The best table that the
+ * CPU supports is selected once, in grk_initialize.
+ */
+struct Kernels {
+	GRK_KERNEL_ISA isa;
+	const char *name;
+
+	/** number of columns that the vertical 5/3 kernels process together */
+	uint32_t pll_cols_53;
+	/**
+	 * Vertical inverse 5/3 lifting for nb_cols columns, when top-most
+	 * pixel is on even coordinate. tmp holds pll_cols_53 * len values.
+	 */
+	void (*decode_v_cas0_53)(int32_t *tmp, const int32_t sn,
+			const int32_t len, int32_t *tiledp_col, const size_t stride,
+			int32_t nb_cols);
+	/** as above, when top-most pixel is on odd coordinate */
+	void (*decode_v_cas1_53)(int32_t *tmp, const int32_t sn,
+			const int32_t len, int32_t *tiledp_col, const size_t stride,
+			int32_t nb_cols);
+
+	/** number of columns that the vertical 9/7 kernels process together */
+	uint32_t pll_cols_97;
+	/**
+	 * 9/7 scaling step: w[2i] *= c for i in [start,end), where each
+	 * element of w holds 4 interleaved rows (horizontal pass)
+	 */
+	void (*decode_h_step1_97)(float *w, uint32_t start, uint32_t end,
+			float c);
+	/** 9/7 lifting step: w[2i-1] += (w[2i-2] + w[2i]) * c, as above */
+	void (*decode_h_step2_97)(float *l, float *w, uint32_t start,
+			uint32_t end, uint32_t m, float c);
+	/**
+	 * as decode_h_step1_97, where each element of w holds pll_cols_97
+	 * interleaved columns (vertical pass)
+	 */
+	void (*decode_v_step1_97)(float *w, uint32_t start, uint32_t end,
+			float c);
+	/** as decode_h_step2_97, on elements of pll_cols_97 columns */
+	void (*decode_v_step2_97)(float *l, float *w, uint32_t start,
+			uint32_t end, uint32_t m, float c);
+
+	/** number of lines that the forward wavelet kernels transform together */
+	uint32_t pll_lines_encode;
+	/**
+	 * Forward 5/3 lifting on pll_lines_encode interleaved lines:
+	 * element i of a holds sample i of every line
+	 */
+	void (*encode_53)(int32_t *a, int32_t d_n, int32_t s_n, uint8_t cas);
+	/** as above, for the irreversible 9/7 filter */
+	void (*encode_97)(int32_t *a, int32_t d_n, int32_t s_n, uint8_t cas);
+
+	void (*mct_encode_rev)(int32_t *chan0, int32_t *chan1, int32_t *chan2,
+			uint64_t n);
+	void (*mct_decode_rev)(int32_t *chan0, int32_t *chan1, int32_t *chan2,
+			uint64_t n);
+	void (*mct_encode_irrev)(int32_t *chan0, int32_t *chan1, int32_t *chan2,
+			uint64_t n);
+	void (*mct_decode_irrev)(float *chan0, float *chan1, float *chan2,
+			uint64_t n);
+	/**
+	 * Custom (array based) MCT of n samples from offset in each of the
+	 * numcomps channels, in place:
+	 * chan[j][i] = sum over k of matrix[j * numcomps + k] * chan[k][i].
+	 * scratch holds numcomps * n values.
+	 */
+	void (*mct_custom_float)(const float *matrix, uint32_t numcomps,
+			float *const *chan, uint64_t offset, uint32_t n, float *scratch);
+	/** as above, on integer samples, with int_fix_mul for the products */
+	void (*mct_custom_int)(const int32_t *matrix, uint32_t numcomps,
+			int32_t *const *chan, uint64_t offset, uint32_t n,
+			int32_t *scratch);
+
+	/** x -= shift */
+	void (*dc_level_shift_encode_rev)(int32_t *data, uint64_t n,
+			int32_t shift);
+	/** x = (x - shift) << 11 */
+	void (*dc_level_shift_encode_irrev)(int32_t *data, uint64_t n,
+			int32_t shift);
+	/** dest = clamp(src + shift, min, max); src may be dest */
+	void (*dc_level_shift_decode_rev)(const int32_t *src, int32_t *dest,
+			uint64_t n, int32_t shift, int32_t min, int32_t max);
+	/** dest = clamp(lrint(float src) + shift, min, max); src may be dest */
+	void (*dc_level_shift_decode_irrev)(const int32_t *src, int32_t *dest,
+			uint64_t n, int32_t shift, int32_t min, int32_t max);
+	/**
+	 * Inverse reversible MCT of three channels, followed by
+	 * dc_level_shift_decode_rev of each channel with its own shift[c],
+	 * min[c] and max[c], in place and in a single pass
+	 */
+	void (*mct_decode_rev_dc_shift)(int32_t *chan0, int32_t *chan1,
+			int32_t *chan2, uint64_t n, const int32_t *shift,
+			const int32_t *min, const int32_t *max);
+	/**
+	 * as above, for the inverse irreversible MCT: the channels hold float
+	 * samples on entry, and rounded int32_t samples on return
+	 */
+	void (*mct_decode_irrev_dc_shift)(int32_t *chan0, int32_t *chan1,
+			int32_t *chan2, uint64_t n, const int32_t *shift,
+			const int32_t *min, const int32_t *max);
+
+	/**
+	 * Decode an HT code block: the cleanup pass, plus the SigProp and
+	 * MagRef passes when num_passes is 2 or 3. lengths1 and lengths2 are
+	 * the lengths of the cleanup and refinement segments; decoded_data
+	 * receives width x height samples in sign-magnitude form.
+	 */
+	void (*decode_ht_codeblock)(uint8_t *coded_data, int32_t *decoded_data,
+			int missing_msbs, int num_passes, int lengths1, int lengths2,
+			int width, int height, int stride);
+	/**
+	 * Sign-magnitude form of the HT block encoder, for the reversible
+	 * transform: x = sign(x) | (|x| << shift)
+	 */
+	void (*quantize_ht_rev)(const int32_t *src, int32_t *dest, uint32_t n,
+			uint32_t shift);
+	/**
+	 * Sign-magnitude form of the HT block encoder, for the irreversible
+	 * transform: t = (int32_t)(x * scale), x = sign(t) | |t|
+	 */
+	void (*quantize_ht_irrev)(const int32_t *src, int32_t *dest, uint32_t n,
+			float scale);
+
+	/**
+	 * Pack n samples of each of numcomps rows, interleaving the rows when
+	 * numcomps > 1: dest[i * numcomps + c] = low 8 bits of src[c][i]
+	 */
+	void (*pack_u8)(const int32_t *const *src, uint32_t numcomps,
+			uint8_t *dest, uint64_t n);
+	/** as above, keeping the low 16 bits of each sample */
+	void (*pack_u16)(const int32_t *const *src, uint32_t numcomps,
+			uint16_t *dest, uint64_t n);
+	/** as above, converting each sample to float */
+	void (*pack_f32)(const int32_t *const *src, uint32_t numcomps,
+			float *dest, uint64_t n);
+
+	/**
+	 * Select the kernels for the best instruction set supported by
+	 * both the build and the CPU
+	 */
+	static void init(void);
+	/**
+	 * Get the kernels for an instruction set, or nullptr if the build
+	 * or the CPU does not support it
+	 */
+	static const Kernels* get(GRK_KERNEL_ISA isa);
+
+	static const Kernels *g_kernels;
+};
+
+extern const Kernels scalar_kernels;
+#ifdef GROK_HAVE_X86_KERNELS
+extern const Kernels sse2_kernels;
+extern const Kernels sse41_kernels;
+extern const Kernels avx2_kernels;
+extern const Kernels avx512_kernels;
+#endif
+
+}
@@ -0,0 +1,28 @@
+/*
+ *    Copyright (C) 2016-2020 Grok Image Compression Inc.
+ *
+ *    This source code is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This source code is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/* Kernels built with AVX2 enabled */
+
+#ifndef __AVX2__
+#error "kernels_avx2.cpp must be built with AVX2 enabled"
+#endif
+
+#define GRK_KERNELS_ISA     GRK_ISA_AVX2
+#define GRK_KERNELS_NAME    "AVX2"
+#define GRK_KERNELS_TABLE   avx2_kernels
+
+#include "kernels_impl.h"
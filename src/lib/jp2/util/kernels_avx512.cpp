@@ -0,0 +1,33 @@
+/*
+ *    Copyright (C) 2016-2020 Grok Image Compression Inc.
+ *
+ *    This source code is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This source code is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/* Kernels built with AVX-512F enabled */
+
+#ifndef __AVX512F__
+#error "kernels_avx512.cpp must be built with AVX512F enabled"
+#endif
+
+/* some GCC versions warn about _mm512_undefined_epi32 in their own headers */
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+#define GRK_KERNELS_ISA     GRK_ISA_AVX512
+#define GRK_KERNELS_NAME    "AVX-512"
+#define GRK_KERNELS_TABLE   avx512_kernels
+
+#include "kernels_impl.h"
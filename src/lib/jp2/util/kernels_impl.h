@@ -0,0 +1,1658 @@
+/*
+ *    Copyright (C) 2016-2020 Grok Image Compression Inc.
+ *
+ *    This source code is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This source code is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ *    This source code incorporates work covered by the following copyright and
+ *    permission notice:
+ *
+ * The copyright in this software is being made available under the 2-clauses
+ * BSD License, included below. This software may be subject to other third
+ * party and contributor rights, including patent rights, and no such rights
+ * are granted under this license.
+ *
+ * Copyright (c) 2002-2014, Universite catholique de Louvain (UCL), Belgium
+ * Copyright (c) 2002-2014, Professor Benoit Macq
+ * Copyright (c) 2001-2003, David Janssens
+ * Copyright (c) 2002-2003, Yannick Verschueren
+ * Copyright (c) 2003-2007, Francois-Olivier Devaux
+ * Copyright (c) 2003-2014, Antonin Descampe
+ * Copyright (c) 2005, Herve Drolon, FreeImage Team
+ * Copyright (c) 2007, Jonathan Ballard <dzonatas@dzonux.net>
+ * Copyright (c) 2007, Callum Lerwick <seg@haxxed.com>
+ * Copyright (c) 2017, IntoPIX SA <support@intopix.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS `AS IS'
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Kernel bodies shared by the per instruction set translation units.
+ *
+ * Each kernels_<isa>.cpp defines GRK_KERNELS_TABLE (and GRK_KERNELS_SCALAR
+ * for the portable build), then includes this file. The SIMD width follows
+ * from the compiler flags of the including unit, through simd.h.
+ *
+ * Only static functions may be used here: an inline function with external
+ * linkage, compiled with AVX-512 enabled, could be picked by the linker for
+ * callers in the rest of the library. This is why grok_includes.h is not
+ * included.
+ */
+
+#include "grk_config_private.h"
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <cassert>
+#include <cmath>
+#include <algorithm>
+#include "grok_intmath.h"
+#include "kernels.h"
+
+#if !defined(GRK_KERNELS_SCALAR)
+#include "simd.h"
+#if (defined(__SSE2__) || defined(__AVX2__))
+#define GRK_KERNELS_SIMD
+#endif
+#endif
+
+#if defined(_MSC_VER)
+#define GRK_KERNEL_RESTRICT __restrict
+#else
+#define GRK_KERNEL_RESTRICT __restrict__
+#endif
+
+/* the HT block decoder needs SSE4.1; the other tables use the portable one */
+#ifdef GRK_HAVE_SSE41
+#include "ojph_block_decoder_simd.h"
+#define GRK_DECODE_HT_CODEBLOCK ojph::local::decode_codeblock_simd
+#else
+#include "ojph_block_decoder.h"
+#define GRK_DECODE_HT_CODEBLOCK ojph::local::ojph_decode_codeblock
+#endif
+
+namespace grk {
+
+namespace {
+
+#ifdef GRK_KERNELS_SIMD
+
+/** Number of columns that we can process in parallel in the vertical pass */
+#define PLL_COLS_53     (2*VREG_INT_COUNT)
+
+#define ADD3(x,y,z) ADD(ADD(x,y),z)
+
+#if defined(__AVX512F__)
+#define MAXI(x,y)   _mm512_max_epi32((x),(y))
+#define MINI(x,y)   _mm512_min_epi32((x),(y))
+#define SLL(x,y)    _mm512_slli_epi32((x),(y))
+#define LOADUF(x)   _mm512_loadu_ps((float const*)(x))
+#define STOREUF(x,y) _mm512_storeu_ps((float*)(x),(y))
+#define CVTF(x)     _mm512_cvtps_epi32(x)
+#define CVTTF(x)    _mm512_cvttps_epi32(x)
+#define CVTIF(x)    _mm512_cvtepi32_ps(x)
+#define ABSI(x)     _mm512_abs_epi32(x)
+#define ANDI(x,y)   _mm512_and_si512((x),(y))
+#define ORI(x,y)    _mm512_or_si512((x),(y))
+#define SLLC(x,y)   _mm512_sll_epi32((x),(y))
+#elif defined(__AVX2__)
+#define MAXI(x,y)   _mm256_max_epi32((x),(y))
+#define MINI(x,y)   _mm256_min_epi32((x),(y))
+#define SLL(x,y)    _mm256_slli_epi32((x),(y))
+#define LOADUF(x)   _mm256_loadu_ps((float const*)(x))
+#define STOREUF(x,y) _mm256_storeu_ps((float*)(x),(y))
+#define CVTF(x)     _mm256_cvtps_epi32(x)
+#define CVTTF(x)    _mm256_cvttps_epi32(x)
+#define CVTIF(x)    _mm256_cvtepi32_ps(x)
+#define ABSI(x)     _mm256_abs_epi32(x)
+#define ANDI(x,y)   _mm256_and_si256((x),(y))
+#define ORI(x,y)    _mm256_or_si256((x),(y))
+#define SLLC(x,y)   _mm256_sll_epi32((x),(y))
+#else
+/* SSE2 has no signed 32 bit min/max */
+static inline __m128i max_epi32(__m128i x, __m128i y){
+	__m128i mask = _mm_cmpgt_epi32(x, y);
+	return _mm_or_si128(_mm_and_si128(mask, x), _mm_andnot_si128(mask, y));
+}
+static inline __m128i min_epi32(__m128i x, __m128i y){
+	__m128i mask = _mm_cmplt_epi32(x, y);
+	return _mm_or_si128(_mm_and_si128(mask, x), _mm_andnot_si128(mask, y));
+}
+#define MAXI(x,y)   max_epi32((x),(y))
+#define MINI(x,y)   min_epi32((x),(y))
+#define SLL(x,y)    _mm_slli_epi32((x),(y))
+#define LOADUF(x)   _mm_loadu_ps((float const*)(x))
+#define STOREUF(x,y) _mm_storeu_ps((float*)(x),(y))
+#define CVTF(x)     _mm_cvtps_epi32(x)
+#define CVTTF(x)    _mm_cvttps_epi32(x)
+#define CVTIF(x)    _mm_cvtepi32_ps(x)
+#if defined(__SSSE3__)
+#define ABSI(x)     _mm_abs_epi32(x)
+#else
+static inline __m128i abs_epi32(__m128i x){
+	__m128i sign = _mm_srai_epi32(x, 31);
+	return _mm_sub_epi32(_mm_xor_si128(x, sign), sign);
+}
+#define ABSI(x)     abs_epi32(x)
+#endif
+#define ANDI(x,y)   _mm_and_si128((x),(y))
+#define ORI(x,y)    _mm_or_si128((x),(y))
+#define SLLC(x,y)   _mm_sll_epi32((x),(y))
+#endif
+
+#if defined(__AVX2__)
+/* int_fix_mul on each lane: (x * c + 4096) >> 13 */
+static inline VREG fix_mul(VREG x, VREG c){
+#if defined(__AVX512F__)
+	const __m512i round = _mm512_set1_epi64(4096);
+	__m512i lo = _mm512_mul_epi32(x, c);
+	__m512i hi = _mm512_mul_epi32(_mm512_srli_epi64(x, 32), c);
+	lo = _mm512_srli_epi64(_mm512_add_epi64(lo, round), 13);
+	hi = _mm512_slli_epi64(_mm512_add_epi64(hi, round), 32 - 13);
+	return _mm512_mask_blend_epi32(0xAAAA, lo, hi);
+#else
+	const __m256i round = _mm256_set1_epi64x(4096);
+	__m256i lo = _mm256_mul_epi32(x, c);
+	__m256i hi = _mm256_mul_epi32(_mm256_srli_epi64(x, 32), c);
+	lo = _mm256_srli_epi64(_mm256_add_epi64(lo, round), 13);
+	hi = _mm256_slli_epi64(_mm256_add_epi64(hi, round), 32 - 13);
+	return _mm256_blend_epi32(lo, hi, 0xAA);
+#endif
+}
+#else
+/* int_fix_mul on each lane, for c >= 0. SSE2 only has an unsigned
+ * 32x32->64 bit multiply, so the product is corrected for negative x */
+static inline VREG fix_mul(VREG x, VREG c){
+	const __m128i round = _mm_set_epi32(0, 4096, 0, 4096);
+	const __m128i mask_hi = _mm_set_epi32(-1, 0, -1, 0);
+	__m128i corr = _mm_and_si128(_mm_srai_epi32(x, 31), c);
+	__m128i lo = _mm_mul_epu32(x, c);
+	__m128i hi = _mm_mul_epu32(_mm_srli_epi64(x, 32), c);
+	lo = _mm_sub_epi64(lo, _mm_slli_epi64(corr, 32));
+	hi = _mm_sub_epi64(hi, _mm_and_si128(corr, mask_hi));
+	lo = _mm_srli_epi64(_mm_add_epi64(lo, round), 13);
+	hi = _mm_slli_epi64(_mm_add_epi64(hi, round), 32 - 13);
+	return _mm_or_si128(_mm_andnot_si128(mask_hi, lo),
+			_mm_and_si128(mask_hi, hi));
+}
+#endif
+
+static
+void decode_v_final_memcpy_53(int32_t* tiledp_col,
+                               const int32_t* tmp,
+                               int32_t len,
+                               size_t stride){
+    int32_t i;
+    for (i = 0; i < len; ++i) {
+        /* A memcpy(&tiledp_col[i * stride + 0],
+                    &tmp[PARALLEL_COLS_53 * i + 0],
+                    PARALLEL_COLS_53 * sizeof(int32_t))
+           would do but would be a tiny bit slower.
+           We can take here advantage of our knowledge of alignment */
+        STOREU(&tiledp_col[(size_t)i * stride + 0],
+               LOAD(&tmp[PLL_COLS_53 * i + 0]));
+        STOREU(&tiledp_col[(size_t)i * stride + VREG_INT_COUNT],
+               LOAD(&tmp[PLL_COLS_53 * i + VREG_INT_COUNT]));
+    }
+}
+
+/** Vertical inverse 5x3 wavelet transform for 8 columns in SSE2,
+ * 16 in AVX2 or 32 in AVX-512, when top-most pixel is on even coordinate */
+static void decode_v_cas0_mcols_53(int32_t* tmp,
+									const int32_t sn,
+									const int32_t len,
+									int32_t* tiledp_col,
+									const size_t stride){
+    const int32_t* in_even = &tiledp_col[0];
+    const int32_t* in_odd = &tiledp_col[(size_t)sn * stride];
+
+    int32_t i;
+    size_t j;
+    VREG d1c_0, d1n_0, s1n_0, s0c_0, s0n_0;
+    VREG d1c_1, d1n_1, s1n_1, s0c_1, s0n_1;
+    const VREG two = LOAD_CST(2);
+
+    assert(len > 1);
+
+    /* Note: loads of input even/odd values must be done in a unaligned */
+    /* fashion. But stores in tmp can be done with aligned store, since */
+    /* the temporary buffer is properly aligned */
+    assert((size_t)tmp % (sizeof(int32_t) * VREG_INT_COUNT) == 0);
+
+    s1n_0 = LOADU(in_even + 0);
+    s1n_1 = LOADU(in_even + VREG_INT_COUNT);
+    d1n_0 = LOADU(in_odd);
+    d1n_1 = LOADU(in_odd + VREG_INT_COUNT);
+
+    /* s0n = s1n - ((d1n + 1) >> 1); <==> */
+    /* s0n = s1n - ((d1n + d1n + 2) >> 2); */
+    s0n_0 = SUB(s1n_0, SAR(ADD3(d1n_0, d1n_0, two), 2));
+    s0n_1 = SUB(s1n_1, SAR(ADD3(d1n_1, d1n_1, two), 2));
+
+    for (i = 0, j = 1; i < (len - 3); i += 2, j++) {
+        d1c_0 = d1n_0;
+        s0c_0 = s0n_0;
+        d1c_1 = d1n_1;
+        s0c_1 = s0n_1;
+
+        s1n_0 = LOADU(in_even + j * stride);
+        s1n_1 = LOADU(in_even + j * stride + VREG_INT_COUNT);
+        d1n_0 = LOADU(in_odd + j * stride);
+        d1n_1 = LOADU(in_odd + j * stride + VREG_INT_COUNT);
+
+        /*s0n = s1n - ((d1c + d1n + 2) >> 2);*/
+        s0n_0 = SUB(s1n_0, SAR(ADD3(d1c_0, d1n_0, two), 2));
+        s0n_1 = SUB(s1n_1, SAR(ADD3(d1c_1, d1n_1, two), 2));
+
+        STORE(tmp + PLL_COLS_53 * (i + 0), s0c_0);
+        STORE(tmp + PLL_COLS_53 * (i + 0) + VREG_INT_COUNT, s0c_1);
+
+        /* d1c + ((s0c + s0n) >> 1) */
+        STORE(tmp + PLL_COLS_53 * (i + 1) + 0,
+              ADD(d1c_0, SAR(ADD(s0c_0, s0n_0), 1)));
+        STORE(tmp + PLL_COLS_53 * (i + 1) + VREG_INT_COUNT,
+              ADD(d1c_1, SAR(ADD(s0c_1, s0n_1), 1)));
+    }
+
+    STORE(tmp + PLL_COLS_53 * (i + 0) + 0, s0n_0);
+    STORE(tmp + PLL_COLS_53 * (i + 0) + VREG_INT_COUNT, s0n_1);
+
+    if (len & 1) {
+        VREG tmp_len_minus_1;
+        s1n_0 = LOADU(in_even + (size_t)((len - 1) / 2) * stride);
+        /* tmp_len_minus_1 = s1n - ((d1n + 1) >> 1); */
+        tmp_len_minus_1 = SUB(s1n_0, SAR(ADD3(d1n_0, d1n_0, two), 2));
+        STORE(tmp + PLL_COLS_53 * (len - 1), tmp_len_minus_1);
+        /* d1n + ((s0n + tmp_len_minus_1) >> 1) */
+        STORE(tmp + PLL_COLS_53 * (len - 2),
+              ADD(d1n_0, SAR(ADD(s0n_0, tmp_len_minus_1), 1)));
+
+        s1n_1 = LOADU(in_even + (size_t)((len - 1) / 2) * stride + VREG_INT_COUNT);
+        /* tmp_len_minus_1 = s1n - ((d1n + 1) >> 1); */
+        tmp_len_minus_1 = SUB(s1n_1, SAR(ADD3(d1n_1, d1n_1, two), 2));
+        STORE(tmp + PLL_COLS_53 * (len - 1) + VREG_INT_COUNT,
+              tmp_len_minus_1);
+        /* d1n + ((s0n + tmp_len_minus_1) >> 1) */
+        STORE(tmp + PLL_COLS_53 * (len - 2) + VREG_INT_COUNT,
+              ADD(d1n_1, SAR(ADD(s0n_1, tmp_len_minus_1), 1)));
+    } else {
+        STORE(tmp + PLL_COLS_53 * (len - 1) + 0,
+              ADD(d1n_0, s0n_0));
+        STORE(tmp + PLL_COLS_53 * (len - 1) + VREG_INT_COUNT,
+              ADD(d1n_1, s0n_1));
+    }
+    decode_v_final_memcpy_53(tiledp_col, tmp, len, stride);
+}
+
+
+/** Vertical inverse 5x3 wavelet transform for 8 columns in SSE2,
+ * 16 in AVX2 or 32 in AVX-512, when top-most pixel is on odd coordinate */
+static void decode_v_cas1_mcols_53(
+    int32_t* tmp,
+    const int32_t sn,
+    const int32_t len,
+    int32_t* tiledp_col,
+    const size_t stride){
+    int32_t i;
+    size_t j;
+
+    VREG s1_0, s2_0, dc_0, dn_0;
+    VREG s1_1, s2_1, dc_1, dn_1;
+    const VREG two = LOAD_CST(2);
+
+    const int32_t* in_even = &tiledp_col[(size_t)sn * stride];
+    const int32_t* in_odd = &tiledp_col[0];
+
+    assert(len > 2);
+
+    /* Note: loads of input even/odd values must be done in a unaligned */
+    /* fashion. But stores in tmp can be done with aligned store, since */
+    /* the temporary buffer is properly aligned */
+    assert((size_t)tmp % (sizeof(int32_t) * VREG_INT_COUNT) == 0);
+
+    s1_0 = LOADU(in_even + stride);
+    /* in_odd[0] - ((in_even[0] + s1 + 2) >> 2); */
+    dc_0 = SUB(LOADU(in_odd + 0),
+               SAR(ADD3(LOADU(in_even + 0), s1_0, two), 2));
+    STORE(tmp + PLL_COLS_53 * 0, ADD(LOADU(in_even + 0), dc_0));
+
+    s1_1 = LOADU(in_even + stride + VREG_INT_COUNT);
+    /* in_odd[0] - ((in_even[0] + s1 + 2) >> 2); */
+    dc_1 = SUB(LOADU(in_odd + VREG_INT_COUNT),
+               SAR(ADD3(LOADU(in_even + VREG_INT_COUNT), s1_1, two), 2));
+    STORE(tmp + PLL_COLS_53 * 0 + VREG_INT_COUNT,
+          ADD(LOADU(in_even + VREG_INT_COUNT), dc_1));
+
+    for (i = 1, j = 1; i < (len - 2 - !(len & 1)); i += 2, j++) {
+
+        s2_0 = LOADU(in_even + (j + 1) * stride);
+        s2_1 = LOADU(in_even + (j + 1) * stride + VREG_INT_COUNT);
+
+        /* dn = in_odd[j * stride] - ((s1 + s2 + 2) >> 2); */
+        dn_0 = SUB(LOADU(in_odd + j * stride),
+                   SAR(ADD3(s1_0, s2_0, two), 2));
+        dn_1 = SUB(LOADU(in_odd + j * stride + VREG_INT_COUNT),
+                   SAR(ADD3(s1_1, s2_1, two), 2));
+
+        STORE(tmp + PLL_COLS_53 * i, dc_0);
+        STORE(tmp + PLL_COLS_53 * i + VREG_INT_COUNT, dc_1);
+
+        /* tmp[i + 1] = s1 + ((dn + dc) >> 1); */
+        STORE(tmp + PLL_COLS_53 * (i + 1) + 0,
+              ADD(s1_0, SAR(ADD(dn_0, dc_0), 1)));
+        STORE(tmp + PLL_COLS_53 * (i + 1) + VREG_INT_COUNT,
+              ADD(s1_1, SAR(ADD(dn_1, dc_1), 1)));
+
+        dc_0 = dn_0;
+        s1_0 = s2_0;
+        dc_1 = dn_1;
+        s1_1 = s2_1;
+    }
+    STORE(tmp + PLL_COLS_53 * i, dc_0);
+    STORE(tmp + PLL_COLS_53 * i + VREG_INT_COUNT, dc_1);
+
+    if (!(len & 1)) {
+        /*dn = in_odd[(len / 2 - 1) * stride] - ((s1 + 1) >> 1); */
+        dn_0 = SUB(LOADU(in_odd + (size_t)(len / 2 - 1) * stride),
+                   SAR(ADD3(s1_0, s1_0, two), 2));
+        dn_1 = SUB(LOADU(in_odd + (size_t)(len / 2 - 1) * stride + VREG_INT_COUNT),
+                   SAR(ADD3(s1_1, s1_1, two), 2));
+
+        /* tmp[len - 2] = s1 + ((dn + dc) >> 1); */
+        STORE(tmp + PLL_COLS_53 * (len - 2) + 0,
+              ADD(s1_0, SAR(ADD(dn_0, dc_0), 1)));
+        STORE(tmp + PLL_COLS_53 * (len - 2) + VREG_INT_COUNT,
+              ADD(s1_1, SAR(ADD(dn_1, dc_1), 1)));
+
+        STORE(tmp + PLL_COLS_53 * (len - 1) + 0, dn_0);
+        STORE(tmp + PLL_COLS_53 * (len - 1) + VREG_INT_COUNT, dn_1);
+    } else {
+        STORE(tmp + PLL_COLS_53 * (len - 1) + 0, ADD(s1_0, dc_0));
+        STORE(tmp + PLL_COLS_53 * (len - 1) + VREG_INT_COUNT,
+              ADD(s1_1, dc_1));
+    }
+    decode_v_final_memcpy_53(tiledp_col, tmp, len, stride);
+}
+
+#else
+
+#define PLL_COLS_53     1
+
+#endif /* GRK_KERNELS_SIMD */
+
+/** Vertical inverse 5x3 wavelet transform for one column, when top-most
+ * pixel is on even coordinate */
+static void decode_v_cas0_1col_53(int32_t* tmp,
+                             const int32_t sn,
+                             const int32_t len,
+                             int32_t* tiledp_col,
+                             const size_t stride){
+    int32_t i, j;
+    int32_t d1c, d1n, s1n, s0c, s0n;
+
+    assert(len > 1);
+
+    /* Performs lifting in one single iteration. Saves memory */
+    /* accesses and explicit interleaving. */
+
+    s1n = tiledp_col[0];
+    d1n = tiledp_col[(size_t)sn * stride];
+    s0n = s1n - ((d1n + 1) >> 1);
+
+    for (i = 0, j = 0; i < (len - 3); i += 2, j++) {
+        d1c = d1n;
+        s0c = s0n;
+
+        s1n = tiledp_col[(size_t)(j + 1) * stride];
+        d1n = tiledp_col[(size_t)(sn + j + 1) * stride];
+
+        s0n = s1n - ((d1c + d1n + 2) >> 2);
+
+        tmp[i  ] = s0c;
+        tmp[i + 1] = d1c + ((s0c + s0n) >> 1);
+    }
+
+    tmp[i] = s0n;
+
+    if (len & 1) {
+        tmp[len - 1] =
+            tiledp_col[(size_t)((len - 1) / 2) * stride] -
+            ((d1n + 1) >> 1);
+        tmp[len - 2] = d1n + ((s0n + tmp[len - 1]) >> 1);
+    } else {
+        tmp[len - 1] = d1n + s0n;
+    }
+
+    for (i = 0; i < len; ++i) {
+        tiledp_col[(size_t)i * stride] = tmp[i];
+    }
+}
+
+
+/** Vertical inverse 5x3 wavelet transform for one column, when top-most
+ * pixel is on odd coordinate */
+static void decode_v_cas1_1col_53(int32_t* tmp,
+                             const int32_t sn,
+                             const int32_t len,
+                             int32_t* tiledp_col,
+                             const size_t stride){
+    int32_t i, j;
+    int32_t s1, s2, dc, dn;
+    const int32_t* in_even = &tiledp_col[(size_t)sn * stride];
+    const int32_t* in_odd = &tiledp_col[0];
+
+    assert(len > 2);
+
+    /* Performs lifting in one single iteration. Saves memory */
+    /* accesses and explicit interleaving. */
+
+    s1 = in_even[stride];
+    dc = in_odd[0] - ((in_even[0] + s1 + 2) >> 2);
+    tmp[0] = in_even[0] + dc;
+    for (i = 1, j = 1; i < (len - 2 - !(len & 1)); i += 2, j++) {
+
+        s2 = in_even[(size_t)(j + 1) * stride];
+
+        dn = in_odd[(size_t)j * stride] - ((s1 + s2 + 2) >> 2);
+        tmp[i  ] = dc;
+        tmp[i + 1] = s1 + ((dn + dc) >> 1);
+
+        dc = dn;
+        s1 = s2;
+    }
+    tmp[i] = dc;
+    if (!(len & 1)) {
+        dn = in_odd[(size_t)(len / 2 - 1) * stride] - ((s1 + 1) >> 1);
+        tmp[len - 2] = s1 + ((dn + dc) >> 1);
+        tmp[len - 1] = dn;
+    } else {
+        tmp[len - 1] = s1 + dc;
+    }
+
+    for (i = 0; i < len; ++i) {
+        tiledp_col[(size_t)i * stride] = tmp[i];
+    }
+}
+
+static void decode_v_cas0_53(int32_t* tmp,
+                             const int32_t sn,
+                             const int32_t len,
+                             int32_t* tiledp_col,
+                             const size_t stride,
+                             int32_t nb_cols){
+#ifdef GRK_KERNELS_SIMD
+    if (nb_cols == PLL_COLS_53) {
+        /* Same as below general case, except that thanks to SIMD */
+        /* we can efficiently process several columns in parallel */
+        decode_v_cas0_mcols_53(tmp, sn, len, tiledp_col, stride);
+        return;
+    }
+#endif
+    for (int32_t c = 0; c < nb_cols; c++, tiledp_col++)
+        decode_v_cas0_1col_53(tmp, sn, len, tiledp_col, stride);
+}
+
+static void decode_v_cas1_53(int32_t* tmp,
+                             const int32_t sn,
+                             const int32_t len,
+                             int32_t* tiledp_col,
+                             const size_t stride,
+                             int32_t nb_cols){
+#ifdef GRK_KERNELS_SIMD
+    if (nb_cols == PLL_COLS_53) {
+        decode_v_cas1_mcols_53(tmp, sn, len, tiledp_col, stride);
+        return;
+    }
+#endif
+    for (int32_t c = 0; c < nb_cols; c++, tiledp_col++)
+        decode_v_cas1_1col_53(tmp, sn, len, tiledp_col, stride);
+}
+
+#ifdef GRK_KERNELS_SIMD
+/** Number of columns that we can process in parallel in the vertical 9/7 pass */
+#define PLL_COLS_97     VREG_INT_COUNT
+
+/* Float vector operations, overloaded on the vector width */
+static inline __m128 addf(__m128 x, __m128 y){ return _mm_add_ps(x, y); }
+static inline __m128 mulf(__m128 x, __m128 y){ return _mm_mul_ps(x, y); }
+static inline void setf(__m128 &x, float c){ x = _mm_set1_ps(c); }
+#if defined(__AVX2__)
+static inline __m256 addf(__m256 x, __m256 y){ return _mm256_add_ps(x, y); }
+static inline __m256 mulf(__m256 x, __m256 y){ return _mm256_mul_ps(x, y); }
+static inline void setf(__m256 &x, float c){ x = _mm256_set1_ps(c); }
+#endif
+#if defined(__AVX512F__)
+static inline __m512 addf(__m512 x, __m512 y){ return _mm512_add_ps(x, y); }
+static inline __m512 mulf(__m512 x, __m512 y){ return _mm512_mul_ps(x, y); }
+static inline void setf(__m512 &x, float c){ x = _mm512_set1_ps(c); }
+#endif
+
+/* Each element of w is one vector T: 4 rows for the horizontal pass,
+ * VREG_INT_COUNT columns for the vertical pass */
+template<typename T> static void decode_step1_97(float* w,
+                           uint32_t start,
+                           uint32_t end,
+                           const float cst){
+    T* GRK_KERNEL_RESTRICT vw = (T*) w;
+    T c;
+    setf(c, cst);
+    uint32_t i;
+    /* 4x unrolled loop */
+    vw += 2 * start;
+    for (i = start; i + 3 < end; i += 4, vw += 8) {
+        T xmm0 = mulf(vw[0], c);
+        T xmm2 = mulf(vw[2], c);
+        T xmm4 = mulf(vw[4], c);
+        T xmm6 = mulf(vw[6], c);
+        vw[0] = xmm0;
+        vw[2] = xmm2;
+        vw[4] = xmm4;
+        vw[6] = xmm6;
+    }
+    for (; i < end; ++i, vw += 2) {
+        vw[0] = mulf(vw[0], c);
+    }
+}
+
+template<typename T> static void decode_step2_97(float* l, float* w,
+                           uint32_t start,
+                           uint32_t end,
+                           uint32_t m,
+                           float cst){
+    T* GRK_KERNEL_RESTRICT vl = (T*) l;
+    T* GRK_KERNEL_RESTRICT vw = (T*) w;
+    T c;
+    setf(c, cst);
+    uint32_t i;
+    uint32_t imax = end < m ? end : m;
+    T tmp1, tmp2, tmp3;
+    if (start == 0) {
+        tmp1 = vl[0];
+    } else {
+        vw += start * 2;
+        tmp1 = vw[-3];
+    }
+
+    i = start;
+
+    /* 4x loop unrolling */
+    for (; i + 3 < imax; i += 4) {
+        T tmp4, tmp5, tmp6, tmp7, tmp8, tmp9;
+        tmp2 = vw[-1];
+        tmp3 = vw[ 0];
+        tmp4 = vw[ 1];
+        tmp5 = vw[ 2];
+        tmp6 = vw[ 3];
+        tmp7 = vw[ 4];
+        tmp8 = vw[ 5];
+        tmp9 = vw[ 6];
+        vw[-1] = addf(tmp2, mulf(addf(tmp1, tmp3), c));
+        vw[ 1] = addf(tmp4, mulf(addf(tmp3, tmp5), c));
+        vw[ 3] = addf(tmp6, mulf(addf(tmp5, tmp7), c));
+        vw[ 5] = addf(tmp8, mulf(addf(tmp7, tmp9), c));
+        tmp1 = tmp9;
+        vw += 8;
+    }
+
+    for (; i < imax; ++i) {
+        tmp2 = vw[-1];
+        tmp3 = vw[ 0];
+        vw[-1] = addf(tmp2, mulf(addf(tmp1, tmp3), c));
+        tmp1 = tmp3;
+        vw += 2;
+    }
+    if (m < end) {
+        assert(m + 1 == end);
+        c = addf(c, c);
+        c = mulf(c, vw[-2]);
+        vw[-1] = addf(vw[-1], c);
+    }
+}
+
+#define H_STEP_97_T     __m128
+#define V_STEP_97_T     VREGF
+#else
+#define PLL_COLS_97     4
+
+typedef union {
+    float f[PLL_COLS_97];
+} v4_data;
+
+/* Each element of w is one T, holding nb_lanes rows or columns */
+template<typename T> static void decode_step1_97(float* w,
+                           uint32_t start,
+                           uint32_t end,
+                           const float c){
+    const uint32_t nb_lanes = sizeof(T) / sizeof(float);
+    float* GRK_KERNEL_RESTRICT fw = w;
+    uint32_t i;
+    for (i = start; i < end; ++i) {
+        for (uint32_t k = 0; k < nb_lanes; ++k)
+            fw[i * 2 * nb_lanes + k] *= c;
+    }
+}
+template<typename T> static void decode_step2_97(float* l, float* w,
+                           uint32_t start,
+                           uint32_t end,
+                           uint32_t m,
+                           float c){
+    const uint32_t nb_lanes = sizeof(T) / sizeof(float);
+    float* fl = l;
+    float* fw = w;
+    uint32_t i;
+    uint32_t imax = end < m ? end : m;
+    if (start > 0) {
+        fw += 2 * nb_lanes * start;
+        fl = fw - 2 * nb_lanes;
+    }
+    for (i = start; i < imax; ++i) {
+        float* fodd = fw - nb_lanes;
+        for (uint32_t k = 0; k < nb_lanes; ++k)
+            fodd[k] = fodd[k] + ((fl[k] + fw[k]) * c);
+        fl = fw;
+        fw += 2 * nb_lanes;
+    }
+    if (m < end) {
+        assert(m + 1 == end);
+        float* fodd = fw - nb_lanes;
+        c += c;
+        for (uint32_t k = 0; k < nb_lanes; ++k)
+            fodd[k] = fodd[k] + fl[k] * c;
+    }
+}
+
+#define H_STEP_97_T     v4_data
+#define V_STEP_97_T     v4_data
+#endif
+
+#ifdef GRK_KERNELS_SIMD
+/** Number of lines that we transform in parallel in the forward wavelet */
+#define PLL_LINES_ENCODE	VREG_INT_COUNT
+
+typedef VREG ivec;
+static inline ivec iadd(ivec x, ivec y){ return ADD(x, y); }
+static inline ivec isub(ivec x, ivec y){ return SUB(x, y); }
+static inline ivec iset(int32_t c){ return LOAD_CST(c); }
+static inline ivec ifix_mul(ivec x, ivec c){ return fix_mul(x, c); }
+static inline ivec isar(ivec x, int32_t n){
+#if defined(__AVX512F__)
+	return _mm512_sra_epi32(x, _mm_cvtsi32_si128(n));
+#elif defined(__AVX2__)
+	return _mm256_sra_epi32(x, _mm_cvtsi32_si128(n));
+#else
+	return _mm_sra_epi32(x, _mm_cvtsi32_si128(n));
+#endif
+}
+#else
+#define PLL_LINES_ENCODE	4
+
+struct ivec {
+	int32_t v[PLL_LINES_ENCODE];
+};
+static inline ivec iadd(ivec x, ivec y){
+	for (uint32_t k = 0; k < PLL_LINES_ENCODE; ++k)
+		x.v[k] += y.v[k];
+	return x;
+}
+static inline ivec isub(ivec x, ivec y){
+	for (uint32_t k = 0; k < PLL_LINES_ENCODE; ++k)
+		x.v[k] -= y.v[k];
+	return x;
+}
+static inline ivec iset(int32_t c){
+	ivec x;
+	for (uint32_t k = 0; k < PLL_LINES_ENCODE; ++k)
+		x.v[k] = c;
+	return x;
+}
+static inline ivec ifix_mul(ivec x, ivec c){
+	for (uint32_t k = 0; k < PLL_LINES_ENCODE; ++k)
+		x.v[k] = int_fix_mul(x.v[k], c.v[k]);
+	return x;
+}
+static inline ivec isar(ivec x, int32_t n){
+	for (uint32_t k = 0; k < PLL_LINES_ENCODE; ++k)
+		x.v[k] >>= n;
+	return x;
+}
+#endif
+
+#define GROK_S(i) a[(i)<<1]
+#define GROK_D(i) a[(1+((i)<<1))]
+#define GROK_S_(i) ((i)<0?GROK_S(0):((i)>=s_n?GROK_S(s_n-1):GROK_S(i)))
+#define GROK_D_(i) ((i)<0?GROK_D(0):((i)>=d_n?GROK_D(d_n-1):GROK_D(i)))
+#define GROK_SS_(i) ((i)<0?GROK_S(0):((i)>=d_n?GROK_S(d_n-1):GROK_S(i)))
+#define GROK_DD_(i) ((i)<0?GROK_D(0):((i)>=s_n?GROK_D(s_n-1):GROK_D(i)))
+
+/* Forward 5-3 wavelet transform in 1-D, on PLL_LINES_ENCODE lines */
+static void encode_53(int32_t* ai, int32_t d_n, int32_t s_n, uint8_t cas) {
+	ivec* GRK_KERNEL_RESTRICT a = (ivec*)ai;
+	const ivec two = iset(2);
+	if (!cas) {
+		if ((d_n > 0) || (s_n > 1)) {
+			for (int32_t i = 0; i < d_n; i++)
+				GROK_D(i) = isub(GROK_D(i),
+						isar(iadd(GROK_S_(i), GROK_S_(i + 1)), 1));
+			for (int32_t i = 0; i < s_n; i++)
+				GROK_S(i) = iadd(GROK_S(i),
+						isar(iadd(iadd(GROK_D_(i - 1), GROK_D_(i)), two), 2));
+		}
+	}
+	else {
+		if (!s_n && d_n == 1) /* NEW :  CASE ONE ELEMENT */
+			GROK_S(0) = iadd(GROK_S(0), GROK_S(0));
+		else {
+			for (int32_t i = 0; i < d_n; i++)
+				GROK_S(i) = isub(GROK_S(i),
+						isar(iadd(GROK_DD_(i), GROK_DD_(i - 1)), 1));
+			for (int32_t i = 0; i < s_n; i++)
+				GROK_D(i) = iadd(GROK_D(i),
+						isar(iadd(iadd(GROK_SS_(i), GROK_SS_(i + 1)), two), 2));
+		}
+	}
+}
+
+/* Forward 9-7 wavelet transform in 1-D, on PLL_LINES_ENCODE lines */
+static void encode_97(int32_t* ai, int32_t d_n, int32_t s_n, uint8_t cas) {
+	ivec* GRK_KERNEL_RESTRICT a = (ivec*)ai;
+	const ivec alpha = iset(12994);
+	const ivec beta = iset(434);
+	const ivec gamma = iset(7233);
+	const ivec delta = iset(3633);
+	const ivec k_d = iset(5039);
+	const ivec k_s = iset(6659);
+	if (!cas) {
+	  if ((d_n > 0) || (s_n > 1)) { /* NEW :  CASE ONE ELEMENT */
+		for (int32_t i = 0; i < d_n; i++)
+			GROK_D(i) = isub(GROK_D(i), ifix_mul(iadd(GROK_S_(i), GROK_S_(i + 1)), alpha));
+		for (int32_t i = 0; i < s_n; i++)
+			GROK_S(i) = isub(GROK_S(i), ifix_mul(iadd(GROK_D_(i - 1), GROK_D_(i)), beta));
+		for (int32_t i = 0; i < d_n; i++)
+			GROK_D(i) = iadd(GROK_D(i), ifix_mul(iadd(GROK_S_(i), GROK_S_(i + 1)), gamma));
+		for (int32_t i = 0; i < s_n; i++)
+			GROK_S(i) = iadd(GROK_S(i), ifix_mul(iadd(GROK_D_(i - 1), GROK_D_(i)), delta));
+		for (int32_t i = 0; i < d_n; i++)
+			GROK_D(i) = ifix_mul(GROK_D(i), k_d);
+		for (int32_t i = 0; i < s_n; i++)
+			GROK_S(i) = ifix_mul(GROK_S(i), k_s);
+	  }
+	}
+	else {
+		if ((s_n > 0) || (d_n > 1)) { /* NEW :  CASE ONE ELEMENT */
+			for (int32_t i = 0; i < d_n; i++)
+				GROK_S(i) = isub(GROK_S(i), ifix_mul(iadd(GROK_DD_(i), GROK_DD_(i - 1)), alpha));
+			for (int32_t i = 0; i < s_n; i++)
+				GROK_D(i) = isub(GROK_D(i), ifix_mul(iadd(GROK_SS_(i), GROK_SS_(i + 1)), beta));
+			for (int32_t i = 0; i < d_n; i++)
+				GROK_S(i) = iadd(GROK_S(i), ifix_mul(iadd(GROK_DD_(i), GROK_DD_(i - 1)), gamma));
+			for (int32_t i = 0; i < s_n; i++)
+				GROK_D(i) = iadd(GROK_D(i), ifix_mul(iadd(GROK_SS_(i), GROK_SS_(i + 1)), delta));
+			for (int32_t i = 0; i < d_n; i++)
+				GROK_S(i) = ifix_mul(GROK_S(i), k_d);
+			for (int32_t i = 0; i < s_n; i++)
+				GROK_D(i) = ifix_mul(GROK_D(i), k_s);
+		}
+	}
+}
+
+#undef GROK_S
+#undef GROK_D
+#undef GROK_S_
+#undef GROK_D_
+#undef GROK_SS_
+#undef GROK_DD_
+
+/* Forward reversible MCT. */
+static void mct_encode_rev(int32_t *GRK_KERNEL_RESTRICT chan0,
+		int32_t *GRK_KERNEL_RESTRICT chan1,
+		int32_t *GRK_KERNEL_RESTRICT chan2, uint64_t n) {
+	uint64_t i = 0;
+#ifdef GRK_KERNELS_SIMD
+	for (; i + VREG_INT_COUNT <= n; i += VREG_INT_COUNT) {
+		VREG y, u, v;
+		VREG r = LOAD((const VREG*) &chan0[i]);
+		VREG g = LOAD((const VREG*) &chan1[i]);
+		VREG b = LOAD((const VREG*) &chan2[i]);
+		y = ADD(g, g);
+		y = ADD(y, b);
+		y = ADD(y, r);
+		y = SAR(y, 2);
+		u = SUB(b, g);
+		v = SUB(r, g);
+		STORE((VREG*) &chan0[i], y);
+		STORE((VREG*) &chan1[i], u);
+		STORE((VREG*) &chan2[i], v);
+	}
+#endif
+	for (; i < n; ++i) {
+		int32_t r = chan0[i];
+		int32_t g = chan1[i];
+		int32_t b = chan2[i];
+		int32_t y = (r + (g * 2) + b) >> 2;
+		int32_t u = b - g;
+		int32_t v = r - g;
+		chan0[i] = y;
+		chan1[i] = u;
+		chan2[i] = v;
+	}
+}
+
+/* Inverse reversible MCT. */
+static void mct_decode_rev(int32_t *GRK_KERNEL_RESTRICT chan0,
+		int32_t *GRK_KERNEL_RESTRICT chan1,
+		int32_t *GRK_KERNEL_RESTRICT chan2, uint64_t n) {
+	uint64_t i = 0;
+#ifdef GRK_KERNELS_SIMD
+	for (; i + VREG_INT_COUNT <= n; i += VREG_INT_COUNT) {
+		VREG r, g, b;
+		VREG y = LOAD((const VREG*) &(chan0[i]));
+		VREG u = LOAD((const VREG*) &(chan1[i]));
+		VREG v = LOAD((const VREG*) &(chan2[i]));
+		g = y;
+		g = SUB(g, SAR(ADD(u, v), 2));
+		r = ADD(v, g);
+		b = ADD(u, g);
+		STORE((VREG*) &(chan0[i]), r);
+		STORE((VREG*) &(chan1[i]), g);
+		STORE((VREG*) &(chan2[i]), b);
+	}
+#endif
+	for (; i < n; ++i) {
+		int32_t y = chan0[i];
+		int32_t u = chan1[i];
+		int32_t v = chan2[i];
+		int32_t g = y - ((u + v) >> 2);
+		int32_t r = v + g;
+		int32_t b = u + g;
+		chan0[i] = r;
+		chan1[i] = g;
+		chan2[i] = b;
+	}
+}
+
+/* Forward irreversible MCT. */
+static void mct_encode_irrev(int32_t *GRK_KERNEL_RESTRICT chan0,
+		int32_t *GRK_KERNEL_RESTRICT chan1,
+		int32_t *GRK_KERNEL_RESTRICT chan2, uint64_t n) {
+	uint64_t i = 0;
+#if defined(GRK_KERNELS_SIMD) && defined(__AVX2__)
+	/* SSE2 has no signed 32x32->64 bit multiply, so this needs AVX2 */
+	const VREG ry = LOAD_CST(2449);
+	const VREG gy = LOAD_CST(4809);
+	const VREG by = LOAD_CST(934);
+	const VREG ru = LOAD_CST(1382);
+	const VREG gu = LOAD_CST(2714);
+	const VREG gv = LOAD_CST(3430);
+	const VREG bv = LOAD_CST(666);
+	const VREG one = LOAD_CST(4096);
+	for (; i + VREG_INT_COUNT <= n; i += VREG_INT_COUNT) {
+		VREG r = LOAD((const VREG*) &(chan0[i]));
+		VREG g = LOAD((const VREG*) &(chan1[i]));
+		VREG b = LOAD((const VREG*) &(chan2[i]));
+		VREG y = ADD3(fix_mul(r, ry), fix_mul(g, gy), fix_mul(b, by));
+		VREG u = SUB(SUB(fix_mul(b, one), fix_mul(r, ru)), fix_mul(g, gu));
+		VREG v = SUB(SUB(fix_mul(r, one), fix_mul(g, gv)), fix_mul(b, bv));
+		STORE((VREG*) &(chan0[i]), y);
+		STORE((VREG*) &(chan1[i]), u);
+		STORE((VREG*) &(chan2[i]), v);
+	}
+#endif
+	for (; i < n; ++i) {
+		int32_t r = chan0[i];
+		int32_t g = chan1[i];
+		int32_t b = chan2[i];
+		int32_t y =  int_fix_mul(r, 2449) + int_fix_mul(g, 4809) + int_fix_mul(b, 934);
+		int32_t u = -int_fix_mul(r, 1382) - int_fix_mul(g, 2714) + int_fix_mul(b, 4096);
+		int32_t v =  int_fix_mul(r, 4096) - int_fix_mul(g, 3430) - int_fix_mul(b, 666);
+		chan0[i] = y;
+		chan1[i] = u;
+		chan2[i] = v;
+	}
+}
+
+/* Inverse irreversible MCT. */
+static void mct_decode_irrev(float *GRK_KERNEL_RESTRICT c0,
+		float *GRK_KERNEL_RESTRICT c1,
+		float *GRK_KERNEL_RESTRICT c2, uint64_t n) {
+	uint64_t i = 0;
+#ifdef GRK_KERNELS_SIMD
+	const VREGF vrv = SETF(1.402f);
+	const VREGF vgu = SETF(0.34413f);
+	const VREGF vgv = SETF(0.71414f);
+	const VREGF vbu = SETF(1.772f);
+	for (; i + VREG_INT_COUNT <= n; i += VREG_INT_COUNT) {
+		VREGF vy, vu, vv;
+		VREGF vr, vg, vb;
+
+		vy = LOADF(c0 + i);
+		vu = LOADF(c1 + i);
+		vv = LOADF(c2 + i);
+		vr = ADDF(vy, MULF(vv, vrv));
+		vg = SUBF(SUBF(vy, MULF(vu, vgu)),MULF(vv, vgv));
+		vb = ADDF(vy, MULF(vu, vbu));
+		STOREF(c0 + i, vr);
+		STOREF(c1 + i, vg);
+		STOREF(c2 + i, vb);
+	}
+#endif
+	for (; i < n; ++i) {
+		float y = c0[i];
+		float u = c1[i];
+		float v = c2[i];
+		float r = y + (v * 1.402f);
+		float g = y - (u * 0.34413f) - (v * (0.71414f));
+		float b = y + (u * 1.772f);
+		c0[i] = r;
+		c1[i] = g;
+		c2[i] = b;
+	}
+}
+
+#ifdef GRK_KERNELS_SIMD
+/*
+ * R rows of the custom MCT on two vectors of samples from i: the inputs
+ * of each k are loaded once for all R rows
+ */
+template<uint32_t R> static inline void mct_custom_float_rows(
+		const float *matrix, uint32_t numcomps, const float *scratch,
+		uint32_t n, float *const *dest, uint32_t i) {
+	VREGF acc[R][2];
+	for (uint32_t r = 0; r < R; ++r)
+		acc[r][0] = acc[r][1] = SETF(0.0f);
+	for (uint32_t k = 0; k < numcomps; ++k) {
+		const float *src = scratch + (size_t) k * n + i;
+		VREGF x0 = LOADUF(src);
+		VREGF x1 = LOADUF(src + VREG_INT_COUNT);
+		for (uint32_t r = 0; r < R; ++r) {
+			VREGF m = SETF(matrix[(size_t) r * numcomps + k]);
+			acc[r][0] = ADDF(acc[r][0], MULF(m, x0));
+			acc[r][1] = ADDF(acc[r][1], MULF(m, x1));
+		}
+	}
+	for (uint32_t r = 0; r < R; ++r) {
+		STOREUF(dest[r] + i, acc[r][0]);
+		STOREUF(dest[r] + i + VREG_INT_COUNT, acc[r][1]);
+	}
+}
+#endif
+
+/* Custom MCT on float samples */
+static void mct_custom_float(const float *matrix, uint32_t numcomps,
+		float *const *chan, uint64_t offset, uint32_t n, float *scratch) {
+	for (uint32_t k = 0; k < numcomps; ++k)
+		memcpy(scratch + (size_t) k * n, chan[k] + offset, n * sizeof(float));
+	const uint32_t rows = 4;
+	float *dest[rows];
+	for (uint32_t j = 0; j < numcomps; j += rows) {
+		uint32_t num_rows = std::min<uint32_t>(rows, numcomps - j);
+		auto row = matrix + (size_t) j * numcomps;
+		for (uint32_t r = 0; r < num_rows; ++r)
+			dest[r] = chan[j + r] + offset;
+		uint32_t i = 0;
+#ifdef GRK_KERNELS_SIMD
+		for (; i + 2 * VREG_INT_COUNT <= n; i += 2 * VREG_INT_COUNT) {
+			if (num_rows == rows) {
+				mct_custom_float_rows<rows>(row, numcomps, scratch, n, dest, i);
+			} else {
+				for (uint32_t r = 0; r < num_rows; ++r)
+					mct_custom_float_rows<1>(row + (size_t) r * numcomps,
+							numcomps, scratch, n, dest + r, i);
+			}
+		}
+#endif
+		/* samples past the vectors, accumulated in dest one k at a time */
+		for (uint32_t r = 0; r < num_rows; ++r) {
+			auto m = row + (size_t) r * numcomps;
+			auto d = dest[r];
+			for (uint32_t s = i; s < n; ++s)
+				d[s] = 0;
+			for (uint32_t k = 0; k < numcomps; ++k) {
+				auto src = scratch + (size_t) k * n;
+				for (uint32_t s = i; s < n; ++s)
+					d[s] += m[k] * src[s];
+			}
+		}
+	}
+}
+
+#if defined(GRK_KERNELS_SIMD) && defined(__AVX2__)
+/* as mct_custom_float_rows, with a 13 bit fixed point matrix */
+template<uint32_t R> static inline void mct_custom_int_rows(
+		const int32_t *matrix, uint32_t numcomps, const int32_t *scratch,
+		uint32_t n, int32_t *const *dest, uint32_t i) {
+	VREG acc[R][2];
+	for (uint32_t r = 0; r < R; ++r)
+		acc[r][0] = acc[r][1] = LOAD_CST(0);
+	for (uint32_t k = 0; k < numcomps; ++k) {
+		const int32_t *src = scratch + (size_t) k * n + i;
+		VREG x0 = LOADU(src);
+		VREG x1 = LOADU(src + VREG_INT_COUNT);
+		for (uint32_t r = 0; r < R; ++r) {
+			VREG m = LOAD_CST(matrix[(size_t) r * numcomps + k]);
+			acc[r][0] = ADD(acc[r][0], fix_mul(x0, m));
+			acc[r][1] = ADD(acc[r][1], fix_mul(x1, m));
+		}
+	}
+	for (uint32_t r = 0; r < R; ++r) {
+		STOREU(dest[r] + i, acc[r][0]);
+		STOREU(dest[r] + i + VREG_INT_COUNT, acc[r][1]);
+	}
+}
+#endif
+
+/* Custom MCT on integer samples, with a 13 bit fixed point matrix */
+static void mct_custom_int(const int32_t *matrix, uint32_t numcomps,
+		int32_t *const *chan, uint64_t offset, uint32_t n, int32_t *scratch) {
+	for (uint32_t k = 0; k < numcomps; ++k)
+		memcpy(scratch + (size_t) k * n, chan[k] + offset,
+				n * sizeof(int32_t));
+	const uint32_t rows = 4;
+	int32_t *dest[rows];
+	for (uint32_t j = 0; j < numcomps; j += rows) {
+		uint32_t num_rows = std::min<uint32_t>(rows, numcomps - j);
+		auto row = matrix + (size_t) j * numcomps;
+		for (uint32_t r = 0; r < num_rows; ++r)
+			dest[r] = chan[j + r] + offset;
+		uint32_t i = 0;
+#if defined(GRK_KERNELS_SIMD) && defined(__AVX2__)
+		/* SSE2 has no signed 32x32->64 bit multiply, so this needs AVX2 */
+		for (; i + 2 * VREG_INT_COUNT <= n; i += 2 * VREG_INT_COUNT) {
+			if (num_rows == rows) {
+				mct_custom_int_rows<rows>(row, numcomps, scratch, n, dest, i);
+			} else {
+				for (uint32_t r = 0; r < num_rows; ++r)
+					mct_custom_int_rows<1>(row + (size_t) r * numcomps,
+							numcomps, scratch, n, dest + r, i);
+			}
+		}
+#endif
+		for (uint32_t r = 0; r < num_rows; ++r) {
+			auto m = row + (size_t) r * numcomps;
+			auto d = dest[r];
+			for (uint32_t s = i; s < n; ++s)
+				d[s] = 0;
+			for (uint32_t k = 0; k < numcomps; ++k) {
+				auto src = scratch + (size_t) k * n;
+				for (uint32_t s = i; s < n; ++s)
+					d[s] += int_fix_mul(m[k], src[s]);
+			}
+		}
+	}
+}
+
+static void dc_level_shift_encode_rev(int32_t *data, uint64_t n,
+		int32_t shift) {
+	uint64_t i = 0;
+#ifdef GRK_KERNELS_SIMD
+	const VREG vshift = LOAD_CST(shift);
+	for (; i + VREG_INT_COUNT <= n; i += VREG_INT_COUNT)
+		STOREU(data + i, SUB(LOADU(data + i), vshift));
+#endif
+	for (; i < n; ++i)
+		data[i] -= shift;
+}
+
+static void dc_level_shift_encode_irrev(int32_t *data, uint64_t n,
+		int32_t shift) {
+	uint64_t i = 0;
+#ifdef GRK_KERNELS_SIMD
+	const VREG vshift = LOAD_CST(shift);
+	for (; i + VREG_INT_COUNT <= n; i += VREG_INT_COUNT)
+		STOREU(data + i, SLL(SUB(LOADU(data + i), vshift), 11));
+#endif
+	for (; i < n; ++i)
+		data[i] = (data[i] - shift) * (1 << 11);
+}
+
+static void dc_level_shift_decode_rev(const int32_t *src, int32_t *dest,
+		uint64_t n, int32_t shift, int32_t min, int32_t max) {
+	uint64_t i = 0;
+#ifdef GRK_KERNELS_SIMD
+	const VREG vshift = LOAD_CST(shift);
+	const VREG vmin = LOAD_CST(min);
+	const VREG vmax = LOAD_CST(max);
+	for (; i + VREG_INT_COUNT <= n; i += VREG_INT_COUNT) {
+		VREG v = ADD(LOADU(src + i), vshift);
+		STOREU(dest + i, MINI(MAXI(v, vmin), vmax));
+	}
+#endif
+	for (; i < n; ++i)
+		dest[i] = int_clamp(src[i] + shift, min, max);
+}
+
+static void dc_level_shift_decode_irrev(const int32_t *src, int32_t *dest,
+		uint64_t n, int32_t shift, int32_t min, int32_t max) {
+	uint64_t i = 0;
+	auto fsrc = (const float*) src;
+#ifdef GRK_KERNELS_SIMD
+	/* conversion rounds to nearest even, as lrintf does */
+	const VREG vshift = LOAD_CST(shift);
+	const VREG vmin = LOAD_CST(min);
+	const VREG vmax = LOAD_CST(max);
+	for (; i + VREG_INT_COUNT <= n; i += VREG_INT_COUNT) {
+		VREG v = ADD(CVTF(LOADUF(fsrc + i)), vshift);
+		STOREU(dest + i, MINI(MAXI(v, vmin), vmax));
+	}
+#endif
+	for (; i < n; ++i)
+		dest[i] = int_clamp((int32_t) lrintf(fsrc[i]) + shift, min, max);
+}
+
+/*
+ * Inverse reversible MCT, then DC level shift and clamp of each channel,
+ * in a single pass over the samples
+ */
+static void mct_decode_rev_dc_shift(int32_t *GRK_KERNEL_RESTRICT chan0,
+		int32_t *GRK_KERNEL_RESTRICT chan1,
+		int32_t *GRK_KERNEL_RESTRICT chan2, uint64_t n,
+		const int32_t *shift, const int32_t *min, const int32_t *max) {
+	uint64_t i = 0;
+#ifdef GRK_KERNELS_SIMD
+	const VREG vshift0 = LOAD_CST(shift[0]);
+	const VREG vshift1 = LOAD_CST(shift[1]);
+	const VREG vshift2 = LOAD_CST(shift[2]);
+	const VREG vmin0 = LOAD_CST(min[0]);
+	const VREG vmin1 = LOAD_CST(min[1]);
+	const VREG vmin2 = LOAD_CST(min[2]);
+	const VREG vmax0 = LOAD_CST(max[0]);
+	const VREG vmax1 = LOAD_CST(max[1]);
+	const VREG vmax2 = LOAD_CST(max[2]);
+	for (; i + VREG_INT_COUNT <= n; i += VREG_INT_COUNT) {
+		VREG y = LOADU(chan0 + i);
+		VREG u = LOADU(chan1 + i);
+		VREG v = LOADU(chan2 + i);
+		VREG g = SUB(y, SAR(ADD(u, v), 2));
+		VREG r = ADD(v, g);
+		VREG b = ADD(u, g);
+		STOREU(chan0 + i, MINI(MAXI(ADD(r, vshift0), vmin0), vmax0));
+		STOREU(chan1 + i, MINI(MAXI(ADD(g, vshift1), vmin1), vmax1));
+		STOREU(chan2 + i, MINI(MAXI(ADD(b, vshift2), vmin2), vmax2));
+	}
+#endif
+	for (; i < n; ++i) {
+		int32_t y = chan0[i];
+		int32_t u = chan1[i];
+		int32_t v = chan2[i];
+		int32_t g = y - ((u + v) >> 2);
+		int32_t r = v + g;
+		int32_t b = u + g;
+		chan0[i] = int_clamp(r + shift[0], min[0], max[0]);
+		chan1[i] = int_clamp(g + shift[1], min[1], max[1]);
+		chan2[i] = int_clamp(b + shift[2], min[2], max[2]);
+	}
+}
+
+/*
+ * Inverse irreversible MCT on float samples, then rounding, DC level shift
+ * and clamp of each channel, in a single pass: the channels hold int32_t
+ * samples on return
+ */
+static void mct_decode_irrev_dc_shift(int32_t *GRK_KERNEL_RESTRICT chan0,
+		int32_t *GRK_KERNEL_RESTRICT chan1,
+		int32_t *GRK_KERNEL_RESTRICT chan2, uint64_t n,
+		const int32_t *shift, const int32_t *min, const int32_t *max) {
+	uint64_t i = 0;
+	auto c0 = (const float*) chan0;
+	auto c1 = (const float*) chan1;
+	auto c2 = (const float*) chan2;
+#ifdef GRK_KERNELS_SIMD
+	const VREGF vrv = SETF(1.402f);
+	const VREGF vgu = SETF(0.34413f);
+	const VREGF vgv = SETF(0.71414f);
+	const VREGF vbu = SETF(1.772f);
+	const VREG vshift0 = LOAD_CST(shift[0]);
+	const VREG vshift1 = LOAD_CST(shift[1]);
+	const VREG vshift2 = LOAD_CST(shift[2]);
+	const VREG vmin0 = LOAD_CST(min[0]);
+	const VREG vmin1 = LOAD_CST(min[1]);
+	const VREG vmin2 = LOAD_CST(min[2]);
+	const VREG vmax0 = LOAD_CST(max[0]);
+	const VREG vmax1 = LOAD_CST(max[1]);
+	const VREG vmax2 = LOAD_CST(max[2]);
+	/* conversion rounds to nearest even, as lrintf does */
+	for (; i + VREG_INT_COUNT <= n; i += VREG_INT_COUNT) {
+		VREGF vy = LOADUF(c0 + i);
+		VREGF vu = LOADUF(c1 + i);
+		VREGF vv = LOADUF(c2 + i);
+		VREGF vr = ADDF(vy, MULF(vv, vrv));
+		VREGF vg = SUBF(SUBF(vy, MULF(vu, vgu)), MULF(vv, vgv));
+		VREGF vb = ADDF(vy, MULF(vu, vbu));
+		STOREU(chan0 + i, MINI(MAXI(ADD(CVTF(vr), vshift0), vmin0), vmax0));
+		STOREU(chan1 + i, MINI(MAXI(ADD(CVTF(vg), vshift1), vmin1), vmax1));
+		STOREU(chan2 + i, MINI(MAXI(ADD(CVTF(vb), vshift2), vmin2), vmax2));
+	}
+#endif
+	for (; i < n; ++i) {
+		float y = c0[i];
+		float u = c1[i];
+		float v = c2[i];
+		float r = y + (v * 1.402f);
+		float g = y - (u * 0.34413f) - (v * (0.71414f));
+		float b = y + (u * 1.772f);
+		chan0[i] = int_clamp((int32_t) lrintf(r) + shift[0], min[0], max[0]);
+		chan1[i] = int_clamp((int32_t) lrintf(g) + shift[1], min[1], max[1]);
+		chan2[i] = int_clamp((int32_t) lrintf(b) + shift[2], min[2], max[2]);
+	}
+}
+
+static void quantize_ht_rev(const int32_t *GRK_KERNEL_RESTRICT src,
+		int32_t *GRK_KERNEL_RESTRICT dest, uint32_t n, uint32_t shift) {
+	uint32_t i = 0;
+#ifdef GRK_KERNELS_SIMD
+	const VREG vsign = LOAD_CST((int32_t) 0x80000000);
+	const __m128i vshift = _mm_cvtsi32_si128((int32_t) shift);
+	for (; i + VREG_INT_COUNT <= n; i += VREG_INT_COUNT) {
+		VREG v = LOADU(src + i);
+		STOREU(dest + i, ORI(ANDI(v, vsign), SLLC(ABSI(v), vshift)));
+	}
+#endif
+	for (; i < n; ++i) {
+		int32_t temp = src[i];
+		int32_t val = temp >= 0 ? temp : -temp;
+		int32_t sign = temp >= 0 ? 0 : (int32_t) 0x80000000;
+		dest[i] = sign | (val << shift);
+	}
+}
+
+static void quantize_ht_irrev(const int32_t *GRK_KERNEL_RESTRICT src,
+		int32_t *GRK_KERNEL_RESTRICT dest, uint32_t n, float scale) {
+	uint32_t i = 0;
+#ifdef GRK_KERNELS_SIMD
+	/* conversion truncates towards zero, as the cast does */
+	const VREG vsign = LOAD_CST((int32_t) 0x80000000);
+	const VREGF vscale = SETF(scale);
+	for (; i + VREG_INT_COUNT <= n; i += VREG_INT_COUNT) {
+		VREG t = CVTTF(MULF(CVTIF(LOADU(src + i)), vscale));
+		STOREU(dest + i, ORI(ANDI(t, vsign), ABSI(t)));
+	}
+#endif
+	for (; i < n; ++i) {
+		int32_t t = (int32_t) ((float) src[i] * scale);
+		int32_t val = t >= 0 ? t : -t;
+		int32_t sign = t >= 0 ? 0 : (int32_t) 0x80000000;
+		dest[i] = sign | val;
+	}
+}
+
+#ifdef GRK_KERNELS_SIMD
+/* low 8 bits of 4 samples, still 32 bits wide */
+static inline __m128i low_u8(const int32_t *src) {
+	return _mm_and_si128(_mm_loadu_si128((const __m128i*) src),
+			_mm_set1_epi32(0xFF));
+}
+
+/* pack 16 samples from low_u8 to bytes */
+static inline __m128i pack_u8x16(__m128i a, __m128i b, __m128i c,
+		__m128i d) {
+	return _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d));
+}
+
+/* low 8 bits of 16 samples */
+static inline __m128i narrow_u8(const int32_t *src) {
+	return pack_u8x16(low_u8(src), low_u8(src + 4), low_u8(src + 8),
+			low_u8(src + 12));
+}
+
+/* low 16 bits of 4 samples, still 32 bits wide. SSE2 only has a signed
+ * saturating pack from 32 to 16 bits, so the samples are biased into
+ * its range */
+static inline __m128i low_u16(const int32_t *src) {
+	return _mm_sub_epi32(
+			_mm_and_si128(_mm_loadu_si128((const __m128i*) src),
+					_mm_set1_epi32(0xFFFF)), _mm_set1_epi32(0x8000));
+}
+
+/* pack 8 samples from low_u16 to words, removing the bias */
+static inline __m128i pack_u16x8(__m128i a, __m128i b) {
+	return _mm_xor_si128(_mm_packs_epi32(a, b),
+			_mm_set1_epi16((int16_t) 0x8000));
+}
+
+/* low 16 bits of 8 samples */
+static inline __m128i narrow_u16(const int32_t *src) {
+	return pack_u16x8(low_u16(src), low_u16(src + 4));
+}
+
+/* interleave three vectors of 4 floats into 12 floats: c0 c1 c2 c0 ... */
+static inline void interleave3_ps(__m128 c0, __m128 c1, __m128 c2,
+		__m128 *out) {
+	__m128 lo01 = _mm_unpacklo_ps(c0, c1);
+	__m128 hi01 = _mm_unpackhi_ps(c0, c1);
+	out[0] = _mm_shuffle_ps(lo01,
+			_mm_shuffle_ps(c2, c0, _MM_SHUFFLE(1, 1, 0, 0)),
+			_MM_SHUFFLE(2, 0, 1, 0));
+	out[1] = _mm_shuffle_ps(_mm_shuffle_ps(c1, c2, _MM_SHUFFLE(2, 1, 2, 1)),
+			hi01, _MM_SHUFFLE(1, 0, 2, 0));
+	out[2] = _mm_shuffle_ps(_mm_shuffle_ps(c2, c0, _MM_SHUFFLE(3, 3, 2, 2)),
+			_mm_shuffle_ps(c1, c2, _MM_SHUFFLE(3, 3, 3, 3)),
+			_MM_SHUFFLE(2, 0, 2, 0));
+}
+
+#if !defined(__SSSE3__)
+/* interleave three vectors of 4 dwords into 12 dwords: c0 c1 c2 c0 ... */
+static inline void interleave3_epi32(__m128i c0, __m128i c1, __m128i c2,
+		__m128i *out) {
+	__m128 o[3];
+	interleave3_ps(_mm_castsi128_ps(c0), _mm_castsi128_ps(c1),
+			_mm_castsi128_ps(c2), o);
+	for (uint32_t k = 0; k < 3; ++k)
+		out[k] = _mm_castps_si128(o[k]);
+}
+#endif
+
+#if defined(__SSSE3__)
+/* interleave three vectors of 16 bytes into 48 bytes: c0 c1 c2 c0 ... */
+static inline void interleave3_u8(__m128i c0, __m128i c1, __m128i c2,
+		__m128i *out) {
+	_mm_storeu_si128(out + 0, _mm_or_si128(_mm_or_si128(
+		_mm_shuffle_epi8(c0,
+			_mm_setr_epi8(0, -128, -128, 1, -128, -128, 2, -128,
+				-128, 3, -128, -128, 4, -128, -128, 5)),
+		_mm_shuffle_epi8(c1,
+			_mm_setr_epi8(-128, 0, -128, -128, 1, -128, -128, 2,
+				-128, -128, 3, -128, -128, 4, -128, -128))),
+		_mm_shuffle_epi8(c2,
+			_mm_setr_epi8(-128, -128, 0, -128, -128, 1, -128, -128,
+				2, -128, -128, 3, -128, -128, 4, -128))));
+	_mm_storeu_si128(out + 1, _mm_or_si128(_mm_or_si128(
+		_mm_shuffle_epi8(c0,
+			_mm_setr_epi8(-128, -128, 6, -128, -128, 7, -128, -128,
+				8, -128, -128, 9, -128, -128, 10, -128)),
+		_mm_shuffle_epi8(c1,
+			_mm_setr_epi8(5, -128, -128, 6, -128, -128, 7, -128,
+				-128, 8, -128, -128, 9, -128, -128, 10))),
+		_mm_shuffle_epi8(c2,
+			_mm_setr_epi8(-128, 5, -128, -128, 6, -128, -128, 7,
+				-128, -128, 8, -128, -128, 9, -128, -128))));
+	_mm_storeu_si128(out + 2, _mm_or_si128(_mm_or_si128(
+		_mm_shuffle_epi8(c0,
+			_mm_setr_epi8(-128, 11, -128, -128, 12, -128, -128, 13,
+				-128, -128, 14, -128, -128, 15, -128, -128)),
+		_mm_shuffle_epi8(c1,
+			_mm_setr_epi8(-128, -128, 11, -128, -128, 12, -128, -128,
+				13, -128, -128, 14, -128, -128, 15, -128))),
+		_mm_shuffle_epi8(c2,
+			_mm_setr_epi8(10, -128, -128, 11, -128, -128, 12, -128,
+				-128, 13, -128, -128, 14, -128, -128, 15))));
+}
+
+/* interleave three vectors of 8 words into 24 words: c0 c1 c2 c0 ... */
+static inline void interleave3_u16(__m128i c0, __m128i c1, __m128i c2,
+		__m128i *out) {
+	_mm_storeu_si128(out + 0, _mm_or_si128(_mm_or_si128(
+		_mm_shuffle_epi8(c0,
+			_mm_setr_epi8(0, 1, -128, -128, -128, -128, 2, 3,
+				-128, -128, -128, -128, 4, 5, -128, -128)),
+		_mm_shuffle_epi8(c1,
+			_mm_setr_epi8(-128, -128, 0, 1, -128, -128, -128, -128,
+				2, 3, -128, -128, -128, -128, 4, 5))),
+		_mm_shuffle_epi8(c2,
+			_mm_setr_epi8(-128, -128, -128, -128, 0, 1, -128, -128,
+				-128, -128, 2, 3, -128, -128, -128, -128))));
+	_mm_storeu_si128(out + 1, _mm_or_si128(_mm_or_si128(
+		_mm_shuffle_epi8(c0,
+			_mm_setr_epi8(-128, -128, 6, 7, -128, -128, -128, -128,
+				8, 9, -128, -128, -128, -128, 10, 11)),
+		_mm_shuffle_epi8(c1,
+			_mm_setr_epi8(-128, -128, -128, -128, 6, 7, -128, -128,
+				-128, -128, 8, 9, -128, -128, -128, -128))),
+		_mm_shuffle_epi8(c2,
+			_mm_setr_epi8(4, 5, -128, -128, -128, -128, 6, 7,
+				-128, -128, -128, -128, 8, 9, -128, -128))));
+	_mm_storeu_si128(out + 2, _mm_or_si128(_mm_or_si128(
+		_mm_shuffle_epi8(c0,
+			_mm_setr_epi8(-128, -128, -128, -128, 12, 13, -128, -128,
+				-128, -128, 14, 15, -128, -128, -128, -128)),
+		_mm_shuffle_epi8(c1,
+			_mm_setr_epi8(10, 11, -128, -128, -128, -128, 12, 13,
+				-128, -128, -128, -128, 14, 15, -128, -128))),
+		_mm_shuffle_epi8(c2,
+			_mm_setr_epi8(-128, -128, 10, 11, -128, -128, -128, -128,
+				12, 13, -128, -128, -128, -128, 14, 15))));
+}
+#endif
+#endif
+
+static void pack_u8(const int32_t *const *src, uint32_t numcomps,
+		uint8_t *dest, uint64_t n) {
+	uint64_t i = 0;
+#ifdef GRK_KERNELS_SIMD
+	auto out = (__m128i*) dest;
+	switch (numcomps) {
+	case 1:
+		for (; i + 16 <= n; i += 16)
+			_mm_storeu_si128(out++, narrow_u8(src[0] + i));
+		break;
+	case 2:
+		for (; i + 16 <= n; i += 16) {
+			__m128i c0 = narrow_u8(src[0] + i);
+			__m128i c1 = narrow_u8(src[1] + i);
+			_mm_storeu_si128(out++, _mm_unpacklo_epi8(c0, c1));
+			_mm_storeu_si128(out++, _mm_unpackhi_epi8(c0, c1));
+		}
+		break;
+#if defined(__SSSE3__)
+	case 3:
+		for (; i + 16 <= n; i += 16, out += 3)
+			interleave3_u8(narrow_u8(src[0] + i), narrow_u8(src[1] + i),
+					narrow_u8(src[2] + i), out);
+		break;
+#else
+	case 3:
+		/* without a byte shuffle, the samples are interleaved while
+		 * still 32 bits wide, and then packed */
+		for (; i + 16 <= n; i += 16, out += 3) {
+			__m128i s[12];
+			for (uint32_t k = 0; k < 4; ++k)
+				interleave3_epi32(low_u8(src[0] + i + 4 * k),
+						low_u8(src[1] + i + 4 * k),
+						low_u8(src[2] + i + 4 * k), s + 3 * k);
+			for (uint32_t k = 0; k < 3; ++k)
+				_mm_storeu_si128(out + k,
+						pack_u8x16(s[4 * k], s[4 * k + 1], s[4 * k + 2],
+								s[4 * k + 3]));
+		}
+		break;
+#endif
+	case 4:
+		for (; i + 16 <= n; i += 16) {
+			__m128i c0 = narrow_u8(src[0] + i);
+			__m128i c1 = narrow_u8(src[1] + i);
+			__m128i c2 = narrow_u8(src[2] + i);
+			__m128i c3 = narrow_u8(src[3] + i);
+			__m128i lo01 = _mm_unpacklo_epi8(c0, c1);
+			__m128i hi01 = _mm_unpackhi_epi8(c0, c1);
+			__m128i lo23 = _mm_unpacklo_epi8(c2, c3);
+			__m128i hi23 = _mm_unpackhi_epi8(c2, c3);
+			_mm_storeu_si128(out++, _mm_unpacklo_epi16(lo01, lo23));
+			_mm_storeu_si128(out++, _mm_unpackhi_epi16(lo01, lo23));
+			_mm_storeu_si128(out++, _mm_unpacklo_epi16(hi01, hi23));
+			_mm_storeu_si128(out++, _mm_unpackhi_epi16(hi01, hi23));
+		}
+		break;
+	default:
+		break;
+	}
+#endif
+	for (; i < n; ++i) {
+		for (uint32_t c = 0; c < numcomps; ++c)
+			dest[i * numcomps + c] = (uint8_t) src[c][i];
+	}
+}
+
+static void pack_u16(const int32_t *const *src, uint32_t numcomps,
+		uint16_t *dest, uint64_t n) {
+	uint64_t i = 0;
+#ifdef GRK_KERNELS_SIMD
+	auto out = (__m128i*) dest;
+	switch (numcomps) {
+	case 1:
+		for (; i + 8 <= n; i += 8)
+			_mm_storeu_si128(out++, narrow_u16(src[0] + i));
+		break;
+	case 2:
+		for (; i + 8 <= n; i += 8) {
+			__m128i c0 = narrow_u16(src[0] + i);
+			__m128i c1 = narrow_u16(src[1] + i);
+			_mm_storeu_si128(out++, _mm_unpacklo_epi16(c0, c1));
+			_mm_storeu_si128(out++, _mm_unpackhi_epi16(c0, c1));
+		}
+		break;
+#if defined(__SSSE3__)
+	case 3:
+		for (; i + 8 <= n; i += 8, out += 3)
+			interleave3_u16(narrow_u16(src[0] + i), narrow_u16(src[1] + i),
+					narrow_u16(src[2] + i), out);
+		break;
+#else
+	case 3:
+		for (; i + 8 <= n; i += 8, out += 3) {
+			__m128i s[6];
+			for (uint32_t k = 0; k < 2; ++k)
+				interleave3_epi32(low_u16(src[0] + i + 4 * k),
+						low_u16(src[1] + i + 4 * k),
+						low_u16(src[2] + i + 4 * k), s + 3 * k);
+			for (uint32_t k = 0; k < 3; ++k)
+				_mm_storeu_si128(out + k, pack_u16x8(s[2 * k], s[2 * k + 1]));
+		}
+		break;
+#endif
+	case 4:
+		for (; i + 8 <= n; i += 8) {
+			__m128i c0 = narrow_u16(src[0] + i);
+			__m128i c1 = narrow_u16(src[1] + i);
+			__m128i c2 = narrow_u16(src[2] + i);
+			__m128i c3 = narrow_u16(src[3] + i);
+			__m128i lo01 = _mm_unpacklo_epi16(c0, c1);
+			__m128i hi01 = _mm_unpackhi_epi16(c0, c1);
+			__m128i lo23 = _mm_unpacklo_epi16(c2, c3);
+			__m128i hi23 = _mm_unpackhi_epi16(c2, c3);
+			_mm_storeu_si128(out++, _mm_unpacklo_epi32(lo01, lo23));
+			_mm_storeu_si128(out++, _mm_unpackhi_epi32(lo01, lo23));
+			_mm_storeu_si128(out++, _mm_unpacklo_epi32(hi01, hi23));
+			_mm_storeu_si128(out++, _mm_unpackhi_epi32(hi01, hi23));
+		}
+		break;
+	default:
+		break;
+	}
+#endif
+	for (; i < n; ++i) {
+		for (uint32_t c = 0; c < numcomps; ++c)
+			dest[i * numcomps + c] = (uint16_t) src[c][i];
+	}
+}
+
+static void pack_f32(const int32_t *const *src, uint32_t numcomps,
+		float *dest, uint64_t n) {
+	uint64_t i = 0;
+#ifdef GRK_KERNELS_SIMD
+	if (numcomps == 1) {
+		for (; i + VREG_INT_COUNT <= n; i += VREG_INT_COUNT)
+			STOREUF(dest + i, CVTIF(LOADU(src[0] + i)));
+	} else if (numcomps == 3) {
+		for (; i + 4 <= n; i += 4) {
+			__m128 o[3];
+			interleave3_ps(
+					_mm_cvtepi32_ps(
+							_mm_loadu_si128((const __m128i*) (src[0] + i))),
+					_mm_cvtepi32_ps(
+							_mm_loadu_si128((const __m128i*) (src[1] + i))),
+					_mm_cvtepi32_ps(
+							_mm_loadu_si128((const __m128i*) (src[2] + i))),
+					o);
+			_mm_storeu_ps(dest + i * 3, o[0]);
+			_mm_storeu_ps(dest + i * 3 + 4, o[1]);
+			_mm_storeu_ps(dest + i * 3 + 8, o[2]);
+		}
+	} else if (numcomps == 4) {
+		for (; i + 4 <= n; i += 4) {
+			__m128 c0 = _mm_cvtepi32_ps(
+					_mm_loadu_si128((const __m128i*) (src[0] + i)));
+			__m128 c1 = _mm_cvtepi32_ps(
+					_mm_loadu_si128((const __m128i*) (src[1] + i)));
+			__m128 c2 = _mm_cvtepi32_ps(
+					_mm_loadu_si128((const __m128i*) (src[2] + i)));
+			__m128 c3 = _mm_cvtepi32_ps(
+					_mm_loadu_si128((const __m128i*) (src[3] + i)));
+			_MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+			_mm_storeu_ps(dest + i * 4, c0);
+			_mm_storeu_ps(dest + i * 4 + 4, c1);
+			_mm_storeu_ps(dest + i * 4 + 8, c2);
+			_mm_storeu_ps(dest + i * 4 + 12, c3);
+		}
+	}
+#endif
+	for (; i < n; ++i) {
+		for (uint32_t c = 0; c < numcomps; ++c)
+			dest[i * numcomps + c] = (float) src[c][i];
+	}
+}
+
+}
+
+extern const Kernels GRK_KERNELS_TABLE = {
+	GRK_KERNELS_ISA,
+	GRK_KERNELS_NAME,
+	PLL_COLS_53,
+	decode_v_cas0_53,
+	decode_v_cas1_53,
+	PLL_COLS_97,
+	decode_step1_97<H_STEP_97_T>,
+	decode_step2_97<H_STEP_97_T>,
+	decode_step1_97<V_STEP_97_T>,
+	decode_step2_97<V_STEP_97_T>,
+	PLL_LINES_ENCODE,
+	encode_53,
+	encode_97,
+	mct_encode_rev,
+	mct_decode_rev,
+	mct_encode_irrev,
+	mct_decode_irrev,
+	mct_custom_float,
+	mct_custom_int,
+	dc_level_shift_encode_rev,
+	dc_level_shift_encode_irrev,
+	dc_level_shift_decode_rev,
+	dc_level_shift_decode_irrev,
+	mct_decode_rev_dc_shift,
+	mct_decode_irrev_dc_shift,
+	GRK_DECODE_HT_CODEBLOCK,
+	quantize_ht_rev,
+	quantize_ht_irrev,
+	pack_u8,
+	pack_u16,
+	pack_f32
+};
+
+}
@@ -0,0 +1,25 @@
+/*
+ *    Copyright (C) 2016-2020 Grok Image Compression Inc.
+ *
+ *    This source code is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This source code is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/* Portable kernels, built without any instruction set flags */
+
+#define GRK_KERNELS_SCALAR
+#define GRK_KERNELS_ISA     GRK_ISA_SCALAR
+#define GRK_KERNELS_NAME    "scalar"
+#define GRK_KERNELS_TABLE   scalar_kernels
+
+#include "kernels_impl.h"
@@ -0,0 +1,33 @@
+/*
+ *    Copyright (C) 2016-2020 Grok Image Compression Inc.
+ *
+ *    This source code is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This source code is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/* Kernels built with SSE2 enabled */
+
+/* MSVC does not define __SSE2__, although SSE2 is always enabled on x64 */
+#if defined(_MSC_VER) && !defined(__SSE2__) && \
+	(defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define __SSE2__ 1
+#endif
+#ifndef __SSE2__
+#error "kernels_sse2.cpp must be built with SSE2 enabled"
+#endif
+
+#define GRK_KERNELS_ISA     GRK_ISA_SSE2
+#define GRK_KERNELS_NAME    "SSE2"
+#define GRK_KERNELS_TABLE   sse2_kernels
+
+#include "kernels_impl.h"
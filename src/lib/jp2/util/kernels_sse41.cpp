@@ -0,0 +1,30 @@
+/*
+ *    Copyright (C) 2016-2020 Grok Image Compression Inc.
+ *
+ *    This source code is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This source code is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/* Kernels built with SSE4.1 enabled */
+
+/* CMake defines GRK_HAVE_SSE41 for the tables that may use SSE4.1:
+ * MSVC has no switch for SSE4.1, and does not define __SSE4_1__ */
+#if !defined(GRK_HAVE_SSE41) || (!defined(_MSC_VER) && !defined(__SSE4_1__))
+#error "kernels_sse41.cpp must be built with SSE4.1 enabled"
+#endif
+
+#define GRK_KERNELS_ISA     GRK_ISA_SSE41
+#define GRK_KERNELS_NAME    "SSE4.1"
+#define GRK_KERNELS_TABLE   sse41_kernels
+
+#include "kernels_impl.h"
@@ -68,12 +68,15 @@
 #ifdef __SSSE3__
 #include <tmmintrin.h>
 #endif
-#ifdef __AVX2__
+#if defined(__AVX2__) || defined(__AVX512F__)
 #include <immintrin.h>
 #endif
 
 
-#ifdef __AVX2__
+#if defined(__AVX512F__)
+/** Number of int32 values in a AVX-512 register */
+#define VREG_INT_COUNT       16
+#elif defined(__AVX2__)
 /** Number of int32 values in a AVX2 register */
 #define VREG_INT_COUNT       8
 #else
@@ -86,7 +89,24 @@
 #if (defined(__SSE2__) || defined(__AVX2__))
 
 /* Convenience macros to improve the readability of the formulas */
-#if __AVX2__
+#if defined(__AVX512F__)
+#define VREG        __m512i
+#define LOAD_CST(x) _mm512_set1_epi32(x)
+#define LOAD(x)     _mm512_load_si512((const void*)(x))
+#define LOADU(x)    _mm512_loadu_si512((const void*)(x))
+#define STORE(x,y)  _mm512_store_si512((void*)(x),(y))
+#define STOREU(x,y) _mm512_storeu_si512((void*)(x),(y))
+#define ADD(x,y)    _mm512_add_epi32((x),(y))
+#define SUB(x,y)    _mm512_sub_epi32((x),(y))
+#define SAR(x,y)    _mm512_srai_epi32((x),(y))
+#define VREGF        __m512
+#define LOADF(x)     _mm512_load_ps((float const*)(x))
+#define SETF(x)      _mm512_set1_ps(x)
+#define ADDF(x,y)    _mm512_add_ps((x),(y))
+#define MULF(x,y)    _mm512_mul_ps((x),(y))
+#define SUBF(x,y)    _mm512_sub_ps((x),(y))
+#define STOREF(x,y)  _mm512_store_ps((float*)(x),(y))
+#elif defined(__AVX2__)
 #define VREG        __m256i
 #define LOAD_CST(x) _mm256_set1_epi32(x)
 #define LOAD(x)     _mm256_load_si256((const VREG*)(x))
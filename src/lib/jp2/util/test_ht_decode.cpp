@@ -0,0 +1,232 @@
+/*
+ *    Copyright (C) 2016-2020 Grok Image Compression Inc.
+ *
+ *    This source code is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This source code is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ *    HT block decoder test: HTJ2K code streams with code blocks from 4 to
+ *    1024 samples wide are decoded with the HT block decoder of every
+ *    instruction set. A noisy image exercises the cleanup pass, and a
+ *    smooth one, where most code blocks also carry SigProp and MagRef
+ *    passes, exercises the refinement passes. Every instruction set must decode the same image as
+ *    the scalar decoder, and lossless code streams must decode to the
+ *    source image.
+ */
+
+#include "bench_codec.h"
+
+using namespace grk;
+
+namespace grk {
+
+struct HTShape {
+	uint32_t cblkw;
+	uint32_t cblkh;
+	// with a single resolution, the code blocks cover the image itself,
+	// so blocks wider than 256 are not cut down by the wavelet subbands
+	uint32_t numresolutions;
+};
+
+struct HTConfig {
+	const char *name;
+	uint32_t prec;
+	bool irreversible;
+	// compression ratios of the layers, or 0 for a single layer with
+	// every pass
+	double rates[3];
+	// number of layers to decode, or 0 for all of them
+	uint32_t layers;
+};
+
+/**
+ * Create a smooth image: random values on a 16x16 grid, interpolated
+ * between grid points, plus a gentle ripple
+ * @return the image, to be destroyed by the caller, or null
+ */
+grk_image* make_smooth_image(uint32_t w, uint32_t h, uint32_t numcomps,
+		uint32_t prec) {
+	auto image = bench_make_image(w, h, numcomps, prec);
+	if (!image)
+		return nullptr;
+	double max = (double) ((1 << prec) - 1);
+	uint32_t seed = 12345;
+	const uint32_t grid = 16;
+	uint32_t gw = w / grid + 2;
+	uint32_t gh = h / grid + 2;
+	std::vector<double> field((size_t) gw * gh);
+	for (uint32_t c = 0; c < numcomps; ++c) {
+		for (auto &f : field) {
+			seed = seed * 1664525U + 1013904223U;
+			f = (double) (seed >> 8) / (double) (1U << 24);
+		}
+		auto data = image->comps[c].data;
+		for (uint32_t y = 0; y < h; ++y) {
+			for (uint32_t x = 0; x < w; ++x) {
+				auto f = field.data() + (size_t) (y / grid) * gw + x / grid;
+				double fx = (double) (x % grid) / grid;
+				double fy = (double) (y % grid) / grid;
+				double v = (f[0] * (1 - fx) + f[1] * fx) * (1 - fy)
+						+ (f[gw] * (1 - fx) + f[gw + 1] * fx) * fy;
+				v = 0.6 * v + 0.2 * (1 + sin(x * 0.07 + c) * cos(y * 0.05));
+				data[(size_t) y * w + x] = (int32_t) (v * max);
+			}
+		}
+	}
+
+	return image;
+}
+
+/**
+ * Decompress a J2K codestream held in memory
+ * @return the decoded image, to be destroyed by the caller, or null
+ */
+grk_image* decompress(std::vector<uint8_t> &in, grk_dparameters *parameters) {
+	auto stream = grk_stream_create_mem_stream(in.data(), in.size(), false,
+			true);
+	if (!stream)
+		return nullptr;
+	grk_image *image = nullptr;
+	auto codec = grk_create_decompress(GRK_CODEC_J2K, stream);
+	bool rc = codec && grk_setup_decoder(codec, parameters)
+			&& grk_read_header(codec, nullptr, &image)
+			&& grk_decode(codec, nullptr, image) && grk_end_decompress(codec);
+	grk_stream_destroy(stream);
+	grk_destroy_codec(codec);
+	if (!rc) {
+		grk_image_destroy(image);
+		image = nullptr;
+	}
+
+	return image;
+}
+
+bool same_samples(grk_image *a, grk_image *b) {
+	if (a->numcomps != b->numcomps)
+		return false;
+	for (uint32_t c = 0; c < a->numcomps; ++c) {
+		auto ca = a->comps + c;
+		auto cb = b->comps + c;
+		if (ca->w != cb->w || ca->h != cb->h
+				|| memcmp(ca->data, cb->data,
+						(size_t) ca->w * ca->h * sizeof(int32_t)))
+			return false;
+	}
+
+	return true;
+}
+
+}
+
+int main(int argc, char **argv) {
+	(void) argc;
+	(void) argv;
+	const uint32_t w = 1100;
+	const uint32_t h = 300;
+	// the image is not a multiple of any block width, so that the last
+	// block of each row is narrower than the others
+	const HTShape shapes[] = { { 1024, 4, 1 }, { 512, 8, 1 }, { 256, 16, 1 },
+			{ 64, 64, 6 }, { 16, 256, 1 }, { 4, 1024, 1 }, { 1024, 4, 3 } };
+	const HTConfig configs[] = {
+			{ "lossless", 8, false, { 0 }, 0 },
+			{ "lossless 12 bit", 12, false, { 0 }, 0 },
+			{ "lossy 9/7", 8, true, { 0 }, 0 },
+			{ "rate 5/3", 8, false, { 8, 4, 2 }, 0 },
+			{ "rate 9/7", 8, true, { 20, 6, 2 }, 0 },
+			{ "rate 9/7, 2 layers", 8, true, { 20, 6, 2 }, 2 } };
+	struct {
+		const char *name;
+		grk_image* (*make)(uint32_t, uint32_t, uint32_t, uint32_t);
+	} images[] = { { "noisy", bench_make_image }, { "smooth",
+			make_smooth_image } };
+	int rc = 0;
+
+	grk_initialize(nullptr, 0);
+	auto best_kernels = Kernels::g_kernels;
+	for (auto &img : images) {
+		for (auto &shape : shapes) {
+			for (auto &config : configs) {
+				grk_cparameters cparams;
+				grk_set_default_encoder_parameters(&cparams);
+				cparams.isHT = true;
+				cparams.numresolution = shape.numresolutions;
+				cparams.cblockw_init = shape.cblkw;
+				cparams.cblockh_init = shape.cblkh;
+				cparams.irreversible = config.irreversible;
+				if (config.rates[0] > 0) {
+					cparams.tcp_numlayers = 3;
+					for (uint32_t l = 0; l < 3; ++l)
+						cparams.tcp_rates[l] = config.rates[l];
+					cparams.cp_disto_alloc = 1;
+				}
+				auto image = img.make(w, h, 3, config.prec);
+				std::vector<uint8_t> codestream;
+				size_t len = image ? bench_compress(image, &cparams, codestream) : 0;
+				grk_image_destroy(image);
+				if (!len) {
+					fprintf(stderr, "%s %ux%u %s: compress failed\n",
+							img.name, shape.cblkw, shape.cblkh, config.name);
+					rc = 1;
+					continue;
+				}
+
+				grk_dparameters dparams;
+				grk_set_default_decoder_parameters(&dparams);
+				dparams.cp_layer = config.layers;
+				grk_image *scalar = nullptr;
+				for (uint32_t isa = GRK_ISA_SCALAR; isa < GRK_ISA_COUNT; ++isa) {
+					auto kernels = Kernels::get((GRK_KERNEL_ISA) isa);
+					if (!kernels)
+						continue;
+					Kernels::g_kernels = kernels;
+					auto decoded = decompress(codestream, &dparams);
+					if (!decoded) {
+						fprintf(stderr, "%s %ux%u %s: %s decompress failed\n",
+								img.name, shape.cblkw, shape.cblkh, config.name,
+								kernels->name);
+						rc = 1;
+						continue;
+					}
+					if (isa == GRK_ISA_SCALAR) {
+						scalar = decoded;
+						if (config.irreversible || config.rates[0] > 0)
+							continue;
+						auto source = img.make(w, h, 3, config.prec);
+						if (!source || !same_samples(source, decoded)) {
+							fprintf(stderr,
+									"%s %ux%u %s: scalar decoder does not match the source\n",
+									img.name, shape.cblkw, shape.cblkh, config.name);
+							rc = 1;
+						}
+						grk_image_destroy(source);
+						continue;
+					}
+					if (!scalar || !same_samples(scalar, decoded)) {
+						fprintf(stderr,
+								"%s %ux%u %s: %s decoder does not match the scalar decoder\n",
+								img.name, shape.cblkw, shape.cblkh, config.name,
+								kernels->name);
+						rc = 1;
+					}
+					grk_image_destroy(decoded);
+				}
+				grk_image_destroy(scalar);
+				Kernels::g_kernels = best_kernels;
+			}
+		}
+	}
+	grk_deinitialize();
+	if (!rc)
+		printf("all instruction sets decode the same images\n");
+
+	return rc;
+}
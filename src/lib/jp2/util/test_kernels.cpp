@@ -0,0 +1,215 @@
+/*
+ *    Copyright (C) 2016-2020 Grok Image Compression Inc.
+ *
+ *    This source code is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This source code is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ *    Kernel table test: images are compressed and decompressed, 5/3 and
+ *    9/7, with and without MCT, with the kernels of every instruction set
+ *    in turn, which exercises their forward and inverse wavelet, MCT and
+ *    DC level shift kernels. Every instruction set must write the same
+ *    code stream as the scalar kernels, and decode the scalar code stream
+ *    to the same image, whole, reduced and in a region.
+ */
+
+#include "bench_codec.h"
+
+using namespace grk;
+
+namespace grk {
+
+struct KernelCase {
+	const char *name;
+	uint32_t numcomps;
+	uint32_t prec;
+	bool irreversible;
+	bool mct;
+	// array based MCT, rather than the RCT or ICT
+	bool custom_mct;
+	bool tiles;
+};
+
+struct DecodeMode {
+	const char *name;
+	uint32_t reduce;
+	bool region;
+};
+
+// RGB to YCbCr
+static float matrix[] = { 0.299f, 0.587f, 0.114f, -0.16875f, -0.33126f, 0.5f,
+		0.5f, -0.41869f, -0.08131f };
+
+/**
+ * Compress a new test image with the current kernels
+ * @return length of the codestream, or 0 on failure
+ */
+size_t compress(const KernelCase &c, uint32_t w, uint32_t h,
+		std::vector<uint8_t> &out) {
+	grk_cparameters parameters;
+	grk_set_default_encoder_parameters(&parameters);
+	parameters.irreversible = c.irreversible;
+	parameters.tcp_mct = c.mct ? 1 : 0;
+	if (c.custom_mct) {
+		int32_t dc_shift[3] = { 0, 0, 0 };
+		if (!grk_set_MCT(&parameters, matrix, dc_shift, 3))
+			return 0;
+	}
+	if (c.tiles) {
+		parameters.tile_size_on = true;
+		parameters.cp_tdx = 128;
+		parameters.cp_tdy = 96;
+	}
+	auto image = bench_make_image(w, h, c.numcomps, c.prec);
+	if (!image)
+		return 0;
+	size_t len = bench_compress(image, &parameters, out);
+	grk_image_destroy(image);
+
+	return len;
+}
+
+/**
+ * Decompress a J2K codestream held in memory
+ * @return the decoded image, to be destroyed by the caller, or null
+ */
+grk_image* decompress(std::vector<uint8_t> &in, const DecodeMode &mode,
+		uint32_t w, uint32_t h) {
+	auto stream = grk_stream_create_mem_stream(in.data(), in.size(), false,
+			true);
+	if (!stream)
+		return nullptr;
+	grk_dparameters parameters;
+	grk_set_default_decoder_parameters(&parameters);
+	parameters.cp_reduce = mode.reduce;
+	grk_image *image = nullptr;
+	auto codec = grk_create_decompress(GRK_CODEC_J2K, stream);
+	bool rc = codec && grk_setup_decoder(codec, &parameters)
+			&& grk_read_header(codec, nullptr, &image)
+			&& (!mode.region
+					|| grk_set_decode_area(codec, image, w / 9, h / 7,
+							w - w / 5, h - h / 3))
+			&& grk_decode(codec, nullptr, image) && grk_end_decompress(codec);
+	grk_stream_destroy(stream);
+	grk_destroy_codec(codec);
+	if (!rc) {
+		grk_image_destroy(image);
+		image = nullptr;
+	}
+
+	return image;
+}
+
+bool same_samples(grk_image *a, grk_image *b) {
+	if (a->numcomps != b->numcomps)
+		return false;
+	for (uint32_t c = 0; c < a->numcomps; ++c) {
+		auto ca = a->comps + c;
+		auto cb = b->comps + c;
+		if (ca->w != cb->w || ca->h != cb->h
+				|| memcmp(ca->data, cb->data,
+						(size_t) ca->w * ca->h * sizeof(int32_t)))
+			return false;
+	}
+
+	return true;
+}
+
+}
+
+int main(int argc, char **argv) {
+	(void) argc;
+	(void) argv;
+	// odd dimensions, so that every kernel also runs its scalar tail
+	const uint32_t w = 541;
+	const uint32_t h = 379;
+	const KernelCase cases[] = {
+			{ "5/3 rgb", 3, 8, false, true, false, false },
+			{ "9/7 rgb", 3, 8, true, true, false, false },
+			{ "5/3 gray 12 bit", 1, 12, false, false, false, false },
+			{ "9/7 2 comps tiles", 2, 10, true, false, false, true },
+			{ "5/3 rgb tiles", 3, 12, false, true, false, true },
+			{ "5/3 custom mct", 3, 8, false, false, true, false },
+			{ "9/7 custom mct", 3, 8, true, false, true, false } };
+	const DecodeMode modes[] = { { "full", 0, false },
+			{ "reduced", 1, false }, { "region", 0, true } };
+	int rc = 0;
+
+	grk_initialize(nullptr, 0);
+	auto best_kernels = Kernels::g_kernels;
+	for (auto &c : cases) {
+		Kernels::g_kernels = Kernels::get(GRK_ISA_SCALAR);
+		std::vector<uint8_t> scalar_codestream;
+		if (!compress(c, w, h, scalar_codestream)) {
+			fprintf(stderr, "%s: scalar compress failed\n", c.name);
+			rc = 1;
+			continue;
+		}
+		grk_image *scalar_images[sizeof(modes) / sizeof(modes[0])] = { };
+		for (uint32_t isa = GRK_ISA_SCALAR; isa < GRK_ISA_COUNT; ++isa) {
+			auto kernels = Kernels::get((GRK_KERNEL_ISA) isa);
+			if (!kernels)
+				continue;
+			Kernels::g_kernels = kernels;
+			if (isa != GRK_ISA_SCALAR) {
+				std::vector<uint8_t> codestream;
+				if (!compress(c, w, h, codestream)
+						|| codestream != scalar_codestream) {
+					fprintf(stderr,
+							"%s: %s code stream does not match the scalar code stream\n",
+							c.name, kernels->name);
+					rc = 1;
+				}
+			}
+			for (uint32_t m = 0; m < sizeof(modes) / sizeof(modes[0]); ++m) {
+				auto decoded = decompress(scalar_codestream, modes[m], w, h);
+				if (!decoded) {
+					fprintf(stderr, "%s %s: %s decompress failed\n", c.name,
+							modes[m].name, kernels->name);
+					rc = 1;
+					continue;
+				}
+				if (isa == GRK_ISA_SCALAR) {
+					scalar_images[m] = decoded;
+					continue;
+				}
+				if (!scalar_images[m]
+						|| !same_samples(scalar_images[m], decoded)) {
+					fprintf(stderr,
+							"%s %s: %s kernels do not decode the same image as the scalar kernels\n",
+							c.name, modes[m].name, kernels->name);
+					rc = 1;
+				}
+				grk_image_destroy(decoded);
+			}
+		}
+		// lossless code streams must also decode to the source image;
+		// the array based MCT is not lossless, even with the 5/3 wavelet
+		auto source = bench_make_image(w, h, c.numcomps, c.prec);
+		if (!c.irreversible && !c.custom_mct
+				&& (!source || !scalar_images[0]
+						|| !same_samples(source, scalar_images[0]))) {
+			fprintf(stderr, "%s: scalar kernels do not match the source\n",
+					c.name);
+			rc = 1;
+		}
+		grk_image_destroy(source);
+		for (auto image : scalar_images)
+			grk_image_destroy(image);
+	}
+	Kernels::g_kernels = best_kernels;
+	grk_deinitialize();
+	if (!rc)
+		printf("all instruction sets code the same images\n");
+
+	return rc;
+}
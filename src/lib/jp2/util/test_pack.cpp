@@ -0,0 +1,88 @@
+/*
+ *    Copyright (C) 2016-2020 Grok Image Compression Inc.
+ *
+ *    This source code is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This source code is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ *    Sample packing test: rows of 1 to 5 components, of every length up to
+ *    a few vectors, are packed to 8 bit, 16 bit and float samples by the
+ *    kernels of every instruction set, which must write the same bytes as
+ *    the scalar kernels and nothing past the end of the packed row.
+ */
+
+#include "grok_includes.h"
+
+using namespace grk;
+
+int main(int argc, char **argv) {
+	(void) argc;
+	(void) argv;
+	const uint32_t max_comps = 5;
+	const uint64_t max_len = 80;
+	// tail of the destination, which no kernel may write
+	const uint64_t guard = 64;
+	const uint8_t guard_byte = 0xA5;
+	int rc = 0;
+
+	// samples well past the 16 bit range, so that a kernel which
+	// saturates rather than keeping the low bits shows up
+	std::vector<int32_t> rows[max_comps];
+	uint32_t seed = 12345;
+	for (uint32_t c = 0; c < max_comps; ++c) {
+		rows[c].resize(max_len);
+		for (auto &v : rows[c]) {
+			seed = seed * 1664525U + 1013904223U;
+			v = (int32_t) (seed >> 14) - (1 << 17);
+		}
+	}
+	const int32_t *src[max_comps];
+	for (uint32_t c = 0; c < max_comps; ++c)
+		src[c] = rows[c].data();
+
+	auto scalar = Kernels::get(GRK_ISA_SCALAR);
+	for (uint32_t isa = GRK_ISA_SCALAR + 1; isa < GRK_ISA_COUNT; ++isa) {
+		auto kernels = Kernels::get((GRK_KERNEL_ISA) isa);
+		if (!kernels)
+			continue;
+		for (uint32_t numcomps = 1; numcomps <= max_comps; ++numcomps) {
+			for (uint64_t n = 0; n <= max_len; ++n) {
+				uint64_t samples = n * numcomps;
+				for (uint32_t bytes : { 1, 2, 4 }) {
+					std::vector<uint8_t> expected(samples * bytes + guard,
+							guard_byte);
+					std::vector<uint8_t> actual(expected);
+					for (uint32_t k = 0; k < 2; ++k) {
+						auto kern = k ? kernels : scalar;
+						auto dest = k ? actual.data() : expected.data();
+						if (bytes == 1)
+							kern->pack_u8(src, numcomps, dest, n);
+						else if (bytes == 2)
+							kern->pack_u16(src, numcomps, (uint16_t*) dest, n);
+						else
+							kern->pack_f32(src, numcomps, (float*) dest, n);
+					}
+					if (expected != actual) {
+						fprintf(stderr,
+								"%s: %u bit pack of %u components x %u samples does not match the scalar kernel\n",
+								kernels->name, bytes * 8, numcomps, (uint32_t) n);
+						rc = 1;
+					}
+				}
+			}
+		}
+	}
+	if (!rc)
+		printf("all instruction sets pack the same samples\n");
+
+	return rc;
+}
@@ -0,0 +1,277 @@
+/*
+ *    Copyright (C) 2016-2020 Grok Image Compression Inc.
+ *
+ *    This source code is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This source code is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ *    Helpers for tests that run the whole codec through the public API:
+ *    a synthetic test image, in-memory compress and decompress, and
+ *    checksums and PSNR of the decoded images.
+ */
+
+#pragma once
+
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <vector>
+#include <algorithm>
+
+#include "grk_config.h"
+#include "grok.h"
+
+/**
+ * Create an image with a smooth gradient plus noise whose amplitude
+ * changes from one 64x64 cell to the next, so that code blocks range
+ * from nearly empty to full of detail
+ */
+static inline grk_image* test_make_image(uint32_t w, uint32_t h,
+		uint32_t numcomps, uint32_t prec) {
+	std::vector<grk_image_cmptparm> params(numcomps);
+	for (auto &p : params) {
+		memset(&p, 0, sizeof(p));
+		p.dx = 1;
+		p.dy = 1;
+		p.w = w;
+		p.h = h;
+		p.prec = prec;
+	}
+	auto image = grk_image_create(numcomps, params.data(),
+			numcomps == 3 ? GRK_CLRSPC_SRGB : GRK_CLRSPC_GRAY);
+	if (!image)
+		return nullptr;
+	image->x1 = w;
+	image->y1 = h;
+	int32_t max = (1 << prec) - 1;
+	uint32_t seed = 12345;
+	for (uint32_t c = 0; c < numcomps; ++c) {
+		auto data = image->comps[c].data;
+		for (uint32_t y = 0; y < h; ++y) {
+			for (uint32_t x = 0; x < w; ++x) {
+				uint32_t cell = (x >> 6) * 2654435761U + (y >> 6) * 40503U
+						+ c;
+				int32_t amplitude = (int32_t) ((cell >> 7) % 9) * (max >> 3);
+				seed = seed * 1664525U + 1013904223U;
+				int32_t noise =
+						amplitude ?
+								(int32_t) ((seed >> 8)
+										% (uint32_t) (amplitude + 1)) :
+								0;
+				int32_t v = (int32_t) (((uint64_t) (x + y) * (uint64_t) max)
+						/ (w + h)) / 2 + noise / 2;
+				data[(size_t) y * w + x] = std::min<int32_t>(
+						std::max<int32_t>(v, 0), max);
+			}
+		}
+	}
+
+	return image;
+}
+
+/**
+ * Create an image of smooth random shapes, without the sample to sample
+ * noise of test_make_image, so that its wavelet coefficients have few
+ * isolated bits
+ */
+static inline grk_image* test_make_smooth_image(uint32_t w, uint32_t h,
+		uint32_t numcomps, uint32_t prec) {
+	std::vector<grk_image_cmptparm> params(numcomps);
+	for (auto &p : params) {
+		memset(&p, 0, sizeof(p));
+		p.dx = 1;
+		p.dy = 1;
+		p.w = w;
+		p.h = h;
+		p.prec = prec;
+	}
+	auto image = grk_image_create(numcomps, params.data(),
+			numcomps == 3 ? GRK_CLRSPC_SRGB : GRK_CLRSPC_GRAY);
+	if (!image)
+		return nullptr;
+	image->x1 = w;
+	image->y1 = h;
+	double max = (double) ((1 << prec) - 1);
+	uint32_t seed = 12345;
+	// random values on a 16x16 grid, interpolated between grid points
+	const uint32_t grid = 16;
+	uint32_t gw = w / grid + 2;
+	uint32_t gh = h / grid + 2;
+	std::vector<double> field((size_t) gw * gh);
+	for (uint32_t c = 0; c < numcomps; ++c) {
+		for (auto &f : field) {
+			seed = seed * 1664525U + 1013904223U;
+			f = (double) (seed >> 8) / (double) (1U << 24);
+		}
+		auto data = image->comps[c].data;
+		for (uint32_t y = 0; y < h; ++y) {
+			for (uint32_t x = 0; x < w; ++x) {
+				auto f = field.data() + (size_t) (y / grid) * gw + x / grid;
+				double fx = (double) (x % grid) / grid;
+				double fy = (double) (y % grid) / grid;
+				double v = (f[0] * (1 - fx) + f[1] * fx) * (1 - fy)
+						+ (f[gw] * (1 - fx) + f[gw + 1] * fx) * fy;
+				v = 0.6 * v + 0.2 * (1 + sin(x * 0.07 + c) * cos(y * 0.05));
+				data[(size_t) y * w + x] = (int32_t) (v * max);
+			}
+		}
+	}
+
+	return image;
+}
+
+/**
+ * Compress image to a J2K codestream, or a JP2 file, in memory. The
+ * encoder may take over the image's sample buffers, so the image is not
+ * reusable.
+ * @return length of the codestream, or 0 on failure
+ */
+static inline size_t test_compress(grk_image *image,
+		grk_cparameters *parameters, std::vector<uint8_t> &out,
+		GRK_CODEC_FORMAT format = GRK_CODEC_J2K) {
+	size_t len = 1024 * 1024;
+	for (uint32_t c = 0; c < image->numcomps; ++c)
+		len += (size_t) image->comps[c].w * image->comps[c].h
+				* ((image->comps[c].prec + 7) / 8) * 2;
+	out.resize(len);
+	auto stream = grk_stream_create_mem_stream(out.data(), len, false, false);
+	if (!stream)
+		return 0;
+	auto codec = grk_create_compress(format, stream);
+	bool rc = codec && grk_setup_encoder(codec, parameters, image)
+			&& grk_start_compress(codec, image) && grk_encode(codec)
+			&& grk_end_compress(codec);
+	len = rc ? grk_stream_get_write_mem_stream_length(stream) : 0;
+	grk_stream_destroy(stream);
+	grk_destroy_codec(codec);
+	out.resize(len);
+
+	return len;
+}
+
+/**
+ * Decompress a J2K codestream held in memory
+ * @param area	if not null, the region x0,y0,x1,y1 to decode
+ * @return the decoded image, to be destroyed by the caller, or null
+ */
+static inline grk_image* test_decompress(std::vector<uint8_t> &in,
+		grk_dparameters *parameters, const uint32_t *area) {
+	auto stream = grk_stream_create_mem_stream(in.data(), in.size(), false,
+			true);
+	if (!stream)
+		return nullptr;
+	grk_image *image = nullptr;
+	auto codec = grk_create_decompress(GRK_CODEC_J2K, stream);
+	bool rc = codec && grk_setup_decoder(codec, parameters)
+			&& grk_read_header(codec, nullptr, &image)
+			&& (!area
+					|| grk_set_decode_area(codec, image, area[0], area[1],
+							area[2], area[3]))
+			&& grk_decode(codec, nullptr, image) && grk_end_decompress(codec);
+	grk_stream_destroy(stream);
+	grk_destroy_codec(codec);
+	if (!rc) {
+		grk_image_destroy(image);
+		image = nullptr;
+	}
+
+	return image;
+}
+
+/* FNV-1a */
+static inline uint64_t test_hash(uint64_t hash, const void *data, size_t len) {
+	auto p = (const uint8_t*) data;
+	for (size_t i = 0; i < len; ++i) {
+		hash ^= p[i];
+		hash *= 0x100000001b3ULL;
+	}
+
+	return hash;
+}
+
+static const uint64_t test_hash_init = 0xcbf29ce484222325ULL;
+
+/**
+ * Checksum of the dimensions and samples of every component of an image
+ */
+static inline uint64_t test_image_hash(grk_image *image) {
+	uint64_t hash = test_hash_init;
+	for (uint32_t c = 0; c < image->numcomps; ++c) {
+		auto comp = image->comps + c;
+		uint32_t dims[4] = { comp->x0, comp->y0, comp->w, comp->h };
+		hash = test_hash(hash, dims, sizeof(dims));
+		hash = test_hash(hash, comp->data,
+				(size_t) comp->w * comp->h * sizeof(int32_t));
+	}
+
+	return hash;
+}
+
+/**
+ * PSNR of image against a reference image of the same dimensions
+ * @return PSNR in dB, or a negative value if the dimensions differ
+ */
+static inline double test_psnr(grk_image *ref, grk_image *image) {
+	if (ref->numcomps != image->numcomps)
+		return -1;
+	double se = 0;
+	uint64_t n = 0;
+	double max = 0;
+	for (uint32_t c = 0; c < ref->numcomps; ++c) {
+		auto a = ref->comps + c;
+		auto b = image->comps + c;
+		if (a->w != b->w || a->h != b->h)
+			return -1;
+		max = std::max<double>(max, (double) ((1 << a->prec) - 1));
+		for (size_t i = 0; i < (size_t) a->w * a->h; ++i) {
+			double d = (double) a->data[i] - (double) b->data[i];
+			se += d * d;
+		}
+		n += (uint64_t) a->w * a->h;
+	}
+	if (se == 0)
+		return INFINITY;
+
+	return 10 * log10(max * max * (double) n / se);
+}
+
+/**
+ * Size of the codestream up to the end of each tile part
+ */
+static inline bool test_tile_part_ends(const std::vector<uint8_t> &codestream,
+		std::vector<size_t> &ends) {
+	size_t pos = 2;
+	while (pos + 4 <= codestream.size()) {
+		uint32_t marker = (uint32_t) (codestream[pos] << 8)
+				| codestream[pos + 1];
+		if (marker == 0xff90)
+			break;
+		pos += 2 + ((uint32_t) (codestream[pos + 2] << 8)
+				| codestream[pos + 3]);
+	}
+	while (pos + 12 <= codestream.size()) {
+		uint32_t marker = (uint32_t) (codestream[pos] << 8)
+				| codestream[pos + 1];
+		if (marker != 0xff90)
+			break;
+		uint32_t psot = ((uint32_t) codestream[pos + 6] << 24)
+				| ((uint32_t) codestream[pos + 7] << 16)
+				| ((uint32_t) codestream[pos + 8] << 8) | codestream[pos + 9];
+		if (!psot)
+			return false;
+		pos += psot;
+		ends.push_back(pos);
+	}
+
+	return !ends.empty();
+}
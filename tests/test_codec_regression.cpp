@@ -0,0 +1,299 @@
+/*
+ *    Copyright (C) 2016-2020 Grok Image Compression Inc.
+ *
+ *    This source code is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This source code is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ *    Round trip regression test: synthetic images are compressed and
+ *    decompressed with a range of coding options, on one thread and on
+ *    several, and the checksums of the codestreams and decoded images
+ *    must match those of the reference encoder and decoder, that is the
+ *    codec before concurrent tile coding and the T2 and PLT changes.
+ *    Some of the codestreams are also decoded in part: a region, at a
+ *    reduced resolution or up to a given layer, to cover the paths that
+ *    compose tiles into the output image.
+ *
+ *    Run with -print to print the checksums of this build, in the layout
+ *    of the tables below.
+ */
+
+#include "test_codec_common.h"
+
+struct EncodeCase {
+	const char *name;
+	uint32_t w;
+	uint32_t h;
+	uint32_t numcomps;
+	uint32_t prec;
+	void (*setup)(grk_cparameters *parameters);
+	// checksum of the codestream, and of the image decoded at full
+	// resolution
+	uint64_t codestream_hash;
+	uint64_t image_hash;
+};
+
+static void setup_lossless(grk_cparameters *parameters) {
+	(void) parameters;
+}
+
+static void setup_tiles(grk_cparameters *parameters) {
+	parameters->tile_size_on = true;
+	parameters->cp_tdx = 128;
+	parameters->cp_tdy = 96;
+}
+
+static void setup_layers(grk_cparameters *parameters) {
+	parameters->irreversible = true;
+	parameters->tile_size_on = true;
+	parameters->cp_tdx = 256;
+	parameters->cp_tdy = 256;
+	parameters->cp_disto_alloc = 1;
+	parameters->tcp_numlayers = 3;
+	parameters->tcp_rates[0] = 40;
+	parameters->tcp_rates[1] = 20;
+	parameters->tcp_rates[2] = 10;
+	parameters->cblockw_init = 32;
+	parameters->cblockh_init = 32;
+}
+
+// layer 1 of setup_layers on its own
+static void setup_layer_1(grk_cparameters *parameters) {
+	setup_layers(parameters);
+	parameters->tcp_numlayers = 1;
+}
+
+static void setup_precincts(grk_cparameters *parameters) {
+	parameters->csty |= 0x01;
+	parameters->prog_order = GRK_RPCL;
+	parameters->res_spec = 2;
+	parameters->prcw_init[0] = 64;
+	parameters->prch_init[0] = 64;
+	parameters->prcw_init[1] = 32;
+	parameters->prch_init[1] = 32;
+	parameters->cp_disto_alloc = 1;
+	parameters->tcp_numlayers = 4;
+	parameters->tcp_rates[0] = 80;
+	parameters->tcp_rates[1] = 30;
+	parameters->tcp_rates[2] = 8;
+	parameters->tcp_rates[3] = 0;
+}
+
+static void setup_sop_eph(grk_cparameters *parameters) {
+	parameters->csty |= 0x02 | 0x04;
+	parameters->prog_order = GRK_PCRL;
+}
+
+static void setup_quality(grk_cparameters *parameters) {
+	parameters->irreversible = true;
+	parameters->cp_fixed_quality = 1;
+	parameters->tcp_numlayers = 2;
+	parameters->tcp_distoratio[0] = 30;
+	parameters->tcp_distoratio[1] = 45;
+}
+
+static void setup_modes(grk_cparameters *parameters) {
+	parameters->cblk_sty = 0x01 | 0x02 | 0x04 | 0x08 | 0x10 | 0x20;
+	parameters->cp_disto_alloc = 1;
+	parameters->tcp_numlayers = 2;
+	parameters->tcp_rates[0] = 20;
+	parameters->tcp_rates[1] = 0;
+}
+
+static void setup_tile_parts(grk_cparameters *parameters) {
+	setup_tiles(parameters);
+	parameters->prog_order = GRK_RLCP;
+	parameters->tp_on = 1;
+	parameters->tp_flag = 'R';
+}
+
+static void setup_plt(grk_cparameters *parameters) {
+	setup_tiles(parameters);
+	parameters->write_plt = true;
+}
+
+static void setup_plt_layers(grk_cparameters *parameters) {
+	setup_layers(parameters);
+	parameters->tp_on = 1;
+	parameters->tp_flag = 'L';
+	parameters->write_plt = true;
+}
+
+static EncodeCase encode_cases[] = {
+	{ "lossless", 400, 300, 3, 8, setup_lossless,
+			0x5efa5764edd420cdULL, 0xdc2821f4a4f03650ULL },
+	{ "tiles", 400, 300, 3, 8, setup_tiles,
+			0x46e8b6160b22cdf5ULL, 0xdc2821f4a4f03650ULL },
+	{ "layers", 640, 480, 3, 8, setup_layers,
+			0xfc952be34e0d33a4ULL, 0xc9a1832078bf7782ULL },
+	{ "layer_1", 640, 480, 3, 8, setup_layer_1,
+			0x0cb3c0334b5f4566ULL, 0x67a7a61a0478421cULL },
+	{ "precincts", 333, 257, 1, 12, setup_precincts,
+			0x402bc89a59f04f6bULL, 0xe7ae0b2fc3bfcc2aULL },
+	{ "sop_eph", 400, 300, 3, 8, setup_sop_eph,
+			0x140de437de3e4f44ULL, 0xdc2821f4a4f03650ULL },
+	{ "quality", 320, 240, 1, 16, setup_quality,
+			0x8b255ed7d9d9233aULL, 0xbb83cf85f2b7522fULL },
+	{ "modes", 300, 200, 3, 8, setup_modes,
+			0x68c299d7133303d6ULL, 0x86f346ba20b41428ULL },
+	{ "tile_parts", 400, 300, 3, 8, setup_tile_parts,
+			0x0a631b8647c7bbfaULL, 0xdc2821f4a4f03650ULL },
+	// the reference encoder does not write PLT markers: the decoded
+	// images are those of the same options without them
+	{ "plt", 400, 300, 3, 8, setup_plt,
+			0xf4b3a2404e538f8cULL, 0xdc2821f4a4f03650ULL },
+	{ "plt_layers", 640, 480, 3, 8, setup_plt_layers,
+			0xfcd5392bd03f516dULL, 0x7e7969be3a64a379ULL },
+};
+
+struct DecodeCase {
+	// name of the encode case whose codestream is decoded
+	const char *source;
+	uint32_t reduce;
+	uint32_t layer;
+	// region x0,y0,x1,y1 to decode, or all zero for the whole image
+	uint32_t area[4];
+	uint64_t image_hash;
+};
+
+static DecodeCase decode_cases[] = {
+	{ "lossless", 0, 0, { 17, 33, 211, 190 }, 0x344249d24de6967cULL },
+	{ "tiles", 0, 0, { 37, 51, 301, 222 }, 0x677ad06a34976c7eULL },
+	{ "tiles", 1, 0, { 0, 0, 0, 0 }, 0x3e3b4a4e72e8490cULL },
+	{ "tiles", 2, 0, { 100, 90, 390, 299 }, 0xff5b31f33247c934ULL },
+	{ "precincts", 1, 0, { 40, 20, 300, 250 }, 0x22c226d5f89e85e4ULL },
+	{ "tile_parts", 1, 0, { 130, 0, 399, 150 }, 0x369189d6c41b3648ULL },
+	{ "plt", 0, 0, { 129, 97, 383, 191 }, 0x7be93a1ad74b6552ULL },
+	// the reference decoder also decoded the passes of layers that were
+	// not read, so these checksums are those of this decoder. Layer 1 of
+	// "layers" decodes to the same image as "layer_1"
+	{ "layers", 0, 1, { 0, 0, 0, 0 }, 0x67a7a61a0478421cULL },
+	{ "layers", 1, 1, { 0, 0, 0, 0 }, 0xbf58fb1a1744b989ULL },
+	{ "layers", 0, 2, { 200, 150, 520, 401 }, 0x8004437da30971d9ULL },
+	{ "precincts", 0, 2, { 0, 0, 0, 0 }, 0xc9adfeb2c61822f0ULL },
+	{ "plt_layers", 0, 1, { 255, 255, 513, 260 }, 0x443fb97bd60a9d61ULL },
+};
+
+static const uint32_t num_threads[] = { 1, 4 };
+
+/**
+ * Decode the parts of codestream given by the decode cases of an encode case
+ * @return true if all decoded images have the expected checksums
+ */
+static bool decode_parts(const char *source, std::vector<uint8_t> &codestream,
+		uint32_t threads, bool print) {
+	bool rc = true;
+	for (auto &d : decode_cases) {
+		if (strcmp(d.source, source))
+			continue;
+		grk_dparameters dparameters;
+		grk_set_default_decoder_parameters(&dparameters);
+		dparameters.cp_reduce = d.reduce;
+		dparameters.cp_layer = d.layer;
+		bool region = d.area[2] || d.area[3];
+		auto decoded = test_decompress(codestream, &dparameters,
+				region ? d.area : nullptr);
+		if (!decoded) {
+			fprintf(stderr,
+					"%s: decompress of reduce %u layer %u region %u,%u,%u,%u failed with %u threads\n",
+					source, d.reduce, d.layer, d.area[0], d.area[1],
+					d.area[2], d.area[3], threads);
+			rc = false;
+			continue;
+		}
+		uint64_t image_hash = test_image_hash(decoded);
+		grk_image_destroy(decoded);
+		if (print) {
+			if (threads == num_threads[0])
+				printf("\t{ \"%s\", %u, %u, { %u, %u, %u, %u }, 0x%016llxULL },\n",
+						source, d.reduce, d.layer, d.area[0], d.area[1],
+						d.area[2], d.area[3], (unsigned long long) image_hash);
+			continue;
+		}
+		if (image_hash != d.image_hash) {
+			fprintf(stderr,
+					"%s: checksum %016llx of reduce %u layer %u region %u,%u,%u,%u, expected %016llx, with %u threads\n",
+					source, (unsigned long long) image_hash, d.reduce,
+					d.layer, d.area[0], d.area[1], d.area[2], d.area[3],
+					(unsigned long long) d.image_hash, threads);
+			rc = false;
+		}
+	}
+
+	return rc;
+}
+
+int main(int argc, char *argv[]) {
+	bool print = argc > 1 && !strcmp(argv[1], "-print");
+	int rc = 0;
+
+	for (auto threads : num_threads) {
+		grk_initialize(nullptr, threads);
+		for (auto &c : encode_cases) {
+			grk_cparameters parameters;
+			grk_set_default_encoder_parameters(&parameters);
+			c.setup(&parameters);
+			auto image = test_make_image(c.w, c.h, c.numcomps, c.prec);
+			std::vector<uint8_t> codestream;
+			size_t len = image ?
+					test_compress(image, &parameters, codestream) : 0;
+			grk_image_destroy(image);
+			if (!len) {
+				fprintf(stderr, "%s: compress failed with %u threads\n",
+						c.name, threads);
+				rc = 1;
+				continue;
+			}
+			uint64_t codestream_hash = test_hash(test_hash_init,
+					codestream.data(), codestream.size());
+
+			grk_dparameters dparameters;
+			grk_set_default_decoder_parameters(&dparameters);
+			auto decoded = test_decompress(codestream, &dparameters, nullptr);
+			if (!decoded) {
+				fprintf(stderr, "%s: decompress failed with %u threads\n",
+						c.name, threads);
+				rc = 1;
+				continue;
+			}
+			uint64_t image_hash = test_image_hash(decoded);
+			grk_image_destroy(decoded);
+			if (!decode_parts(c.name, codestream, threads, print))
+				rc = 1;
+
+			if (print) {
+				if (threads == num_threads[0])
+					printf("\t{ \"%s\", ... 0x%016llxULL, 0x%016llxULL },\n",
+							c.name, (unsigned long long) codestream_hash,
+							(unsigned long long) image_hash);
+				continue;
+			}
+			if (codestream_hash != c.codestream_hash) {
+				fprintf(stderr,
+						"%s: codestream checksum %016llx, expected %016llx, with %u threads\n",
+						c.name, (unsigned long long) codestream_hash,
+						(unsigned long long) c.codestream_hash, threads);
+				rc = 1;
+			}
+			if (image_hash != c.image_hash) {
+				fprintf(stderr,
+						"%s: image checksum %016llx, expected %016llx, with %u threads\n",
+						c.name, (unsigned long long) image_hash,
+						(unsigned long long) c.image_hash, threads);
+				rc = 1;
+			}
+		}
+	}
+	grk_deinitialize();
+
+	return rc;
+}
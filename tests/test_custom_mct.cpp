@@ -0,0 +1,143 @@
+/*
+ *    Copyright (C) 2016-2020 Grok Image Compression Inc.
+ *
+ *    This source code is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This source code is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ *    Custom (array based, MCT=2) multi-component transform test: images
+ *    compressed with a Part 2 MCT matrix and DC offsets must carry MCT, MCC
+ *    and MCO markers, and decompress to the source image within the coding
+ *    loss, with the same result on one thread and on several.
+ */
+
+#include "test_codec_common.h"
+
+struct MctCase {
+	const char *name;
+	uint32_t w;
+	uint32_t h;
+	uint32_t prec;
+	bool tiles;
+	int32_t dc_shift[3];
+	double min_psnr;
+};
+
+static const MctCase mct_cases[] = {
+	{ "8 bit", 400, 300, 8, false, { 0, 0, 0 }, 45 },
+	{ "8 bit offsets", 400, 300, 8, false, { 17, -40, 93 }, 45 },
+	{ "12 bit tiles", 333, 257, 12, true, { 0, 1000, -1000 }, 60 },
+};
+
+// RGB to YCbCr
+static float matrix[] = { 0.299f, 0.587f, 0.114f, -0.16875f, -0.33126f, 0.5f,
+		0.5f, -0.41869f, -0.08131f };
+
+static const uint32_t num_threads[] = { 1, 4 };
+
+/**
+ * Check that the main header of codestream has the markers of an array
+ * based transform
+ */
+static bool has_mct_markers(const std::vector<uint8_t> &codestream) {
+	bool mct = false, mcc = false, mco = false;
+	size_t pos = 2;
+	while (pos + 4 <= codestream.size()) {
+		uint32_t marker = (uint32_t) (codestream[pos] << 8)
+				| codestream[pos + 1];
+		if (marker == 0xff90)
+			break;
+		mct |= marker == 0xff74;
+		mcc |= marker == 0xff75;
+		mco |= marker == 0xff77;
+		pos += 2 + ((uint32_t) (codestream[pos + 2] << 8)
+				| codestream[pos + 3]);
+	}
+
+	return mct && mcc && mco;
+}
+
+int main(int argc, char *argv[]) {
+	(void) argc;
+	(void) argv;
+	int rc = 0;
+
+	for (auto &c : mct_cases) {
+		uint64_t image_hash = 0;
+		for (auto threads : num_threads) {
+			grk_initialize(nullptr, threads);
+			grk_cparameters parameters;
+			grk_set_default_encoder_parameters(&parameters);
+			if (c.tiles) {
+				parameters.tile_size_on = true;
+				parameters.cp_tdx = 128;
+				parameters.cp_tdy = 96;
+			}
+			int32_t dc_shift[3] = { c.dc_shift[0], c.dc_shift[1],
+					c.dc_shift[2] };
+			if (!grk_set_MCT(&parameters, matrix, dc_shift, 3)) {
+				rc = 1;
+				break;
+			}
+			auto ref = test_make_image(c.w, c.h, 3, c.prec);
+			auto image = test_make_image(c.w, c.h, 3, c.prec);
+			std::vector<uint8_t> codestream;
+			size_t len = image ?
+					test_compress(image, &parameters, codestream) : 0;
+			// the encoder frees parameters.mct_data
+			grk_image_destroy(image);
+			if (!ref || !len) {
+				fprintf(stderr, "%s: compress failed with %u threads\n",
+						c.name, threads);
+				grk_image_destroy(ref);
+				rc = 1;
+				continue;
+			}
+			if (!has_mct_markers(codestream)) {
+				fprintf(stderr, "%s: no MCT, MCC or MCO marker\n", c.name);
+				rc = 1;
+			}
+
+			grk_dparameters dparameters;
+			grk_set_default_decoder_parameters(&dparameters);
+			auto decoded = test_decompress(codestream, &dparameters, nullptr);
+			if (!decoded) {
+				fprintf(stderr, "%s: decompress failed with %u threads\n",
+						c.name, threads);
+				grk_image_destroy(ref);
+				rc = 1;
+				continue;
+			}
+			double psnr = test_psnr(ref, decoded);
+			uint64_t hash = test_image_hash(decoded);
+			grk_image_destroy(decoded);
+			grk_image_destroy(ref);
+			printf("%-13s %u threads: %.2f dB\n", c.name, threads, psnr);
+			if (psnr < c.min_psnr) {
+				fprintf(stderr, "%s: %.2f dB with %u threads, below %.2f dB\n",
+						c.name, psnr, threads, c.min_psnr);
+				rc = 1;
+			}
+			if (threads == num_threads[0]) {
+				image_hash = hash;
+			} else if (hash != image_hash) {
+				fprintf(stderr,
+						"%s: decoded image differs between %u and %u threads\n",
+						c.name, num_threads[0], threads);
+				rc = 1;
+			}
+		}
+	}
+	grk_deinitialize();
+
+	return rc;
+}
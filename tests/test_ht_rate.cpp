@@ -0,0 +1,212 @@
+/*
+ *    Copyright (C) 2016-2020 Grok Image Compression Inc.
+ *
+ *    This source code is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This source code is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ *    HTJ2K rate control test: images are compressed with HT code blocks
+ *    into several layers, at target rates (-r) or at target qualities
+ *    (-q), and then decompressed up to each layer in turn. Every layer
+ *    must meet its target rate, or come close to its target quality,
+ *    quality must increase from one layer to the next, and a reversible
+ *    code stream whose last layer has no rate must decode to the source
+ *    image. When every layer has a target rate, the last layer must also
+ *    come close to the quality of Part-1 code blocks at the same rates.
+ *
+ *    Each layer is written to its own tile part, so that the size of the
+ *    codestream up to the end of each layer can be read from the SOT
+ *    markers.
+ */
+
+#include "test_codec_common.h"
+
+struct HTRateCase {
+	const char *name;
+	// smooth image, where most code blocks get SigProp and MagRef passes,
+	// or noisy image, where most keep a single cleanup pass
+	bool smooth;
+	uint32_t prec;
+	bool irreversible;
+	// target PSNR of each layer, rather than target rate
+	bool fixed_quality;
+	uint32_t numlayers;
+	// compression ratios, where 0 is lossless, or PSNR in dB
+	double targets[4];
+};
+
+static const HTRateCase ht_rate_cases[] = {
+	{ "smooth rev -r", true, 8, false, false, 4, { 80, 40, 10, 0 } },
+	{ "smooth irrev -r", true, 8, true, false, 4, { 80, 40, 20, 10 } },
+	{ "noisy rev -r", false, 8, false, false, 3, { 40, 10, 0 } },
+	{ "noisy irrev -r", false, 8, true, false, 3, { 40, 15, 5 } },
+	{ "smooth 12 bit -r", true, 12, true, false, 3, { 60, 20, 6 } },
+	{ "smooth irrev -q", true, 8, true, true, 3, { 30, 38, 45 } },
+	{ "noisy irrev -q", false, 8, true, true, 2, { 28, 36 } },
+	{ "smooth rev -r 32", true, 8, false, false, 1, { 32 } },
+	{ "smooth irrev -r 20", true, 8, true, false, 1, { 20 } },
+	{ "smooth irrev -r 60", true, 8, true, false, 1, { 60 } },
+	{ "noisy rev -r 8", false, 8, false, false, 1, { 8 } },
+	{ "noisy irrev -r 8", false, 8, true, false, 1, { 8 } },
+};
+
+static const uint32_t width = 512;
+static const uint32_t height = 384;
+// fixed quality estimates the distortion of each pass in the wavelet
+// domain, and the smooth image decodes up to 4 dB below the estimate,
+// with or without refinement passes
+static const double max_psnr_shortfall = 4;
+// the HT cleanup pass is coded at a single bit plane, chosen by rate
+// control, with refinement passes of the bit plane below it, where
+// Part-1 code blocks can be truncated after any pass
+static const double max_part1_shortfall = 2;
+
+/**
+ * Compress a new test image, with HT or Part-1 code blocks
+ * @return true if the code stream has a tile part per layer,
+ * whose ends are returned in ends
+ */
+static bool compress(const HTRateCase &c, bool isHT,
+		std::vector<uint8_t> &codestream, std::vector<size_t> &ends) {
+	auto make_image = c.smooth ? test_make_smooth_image : test_make_image;
+	auto image = make_image(width, height, 3, c.prec);
+	if (!image)
+		return false;
+	grk_cparameters parameters;
+	grk_set_default_encoder_parameters(&parameters);
+	parameters.isHT = isHT;
+	parameters.irreversible = c.irreversible;
+	parameters.tcp_numlayers = c.numlayers;
+	for (uint32_t l = 0; l < c.numlayers; ++l) {
+		if (c.fixed_quality)
+			parameters.tcp_distoratio[l] = c.targets[l];
+		else
+			parameters.tcp_rates[l] = c.targets[l];
+	}
+	if (c.fixed_quality)
+		parameters.cp_fixed_quality = 1;
+	else
+		parameters.cp_disto_alloc = 1;
+	parameters.prog_order = GRK_LRCP;
+	parameters.tp_on = 1;
+	parameters.tp_flag = 'L';
+	bool rc = test_compress(image, &parameters, codestream)
+			&& test_tile_part_ends(codestream, ends)
+			&& ends.size() == c.numlayers;
+	grk_image_destroy(image);
+
+	return rc;
+}
+
+/**
+ * Decompress the first numlayers layers of a code stream
+ * @return PSNR of the decoded image against ref, or -1 on failure
+ */
+static double decompress_psnr(std::vector<uint8_t> &codestream,
+		uint32_t numlayers, grk_image *ref) {
+	grk_dparameters dparameters;
+	grk_set_default_decoder_parameters(&dparameters);
+	dparameters.cp_layer = numlayers;
+	auto decoded = test_decompress(codestream, &dparameters, nullptr);
+	double psnr = decoded ? test_psnr(ref, decoded) : -1;
+	grk_image_destroy(decoded);
+
+	return psnr;
+}
+
+int main(int argc, char *argv[]) {
+	(void) argc;
+	(void) argv;
+	int rc = 0;
+
+	grk_initialize(nullptr, 0);
+	for (auto &c : ht_rate_cases) {
+		auto make_image =
+				c.smooth ? test_make_smooth_image : test_make_image;
+		auto ref = make_image(width, height, 3, c.prec);
+		std::vector<uint8_t> codestream;
+		std::vector<size_t> ends;
+		if (!ref || !compress(c, true, codestream, ends)) {
+			fprintf(stderr, "%s: compress failed\n", c.name);
+			grk_image_destroy(ref);
+			rc = 1;
+			continue;
+		}
+
+		double raw_bytes = (double) width * height * 3 * c.prec / 8;
+		double prev_psnr = 0;
+		for (uint32_t l = 0; l < c.numlayers; ++l) {
+			double psnr = decompress_psnr(codestream, l + 1, ref);
+			printf("%-16s layer %u: %7u bytes %6.2f dB\n", c.name, l,
+					(uint32_t) ends[l], psnr);
+			if (psnr < 0) {
+				fprintf(stderr, "%s: decompress of layer %u failed\n", c.name,
+						l);
+				rc = 1;
+				continue;
+			}
+			if (psnr <= prev_psnr) {
+				fprintf(stderr,
+						"%s: layer %u is %.2f dB, no better than the %.2f dB of the layer before\n",
+						c.name, l, psnr, prev_psnr);
+				rc = 1;
+			}
+			prev_psnr = psnr;
+			if (c.fixed_quality) {
+				if (psnr < c.targets[l] - max_psnr_shortfall) {
+					fprintf(stderr,
+							"%s: layer %u is %.2f dB, too far below %.2f dB\n",
+							c.name, l, psnr, c.targets[l]);
+					rc = 1;
+				}
+			} else if (c.targets[l] > 0) {
+				size_t target = (size_t) (raw_bytes / c.targets[l]);
+				if (ends[l] > target) {
+					fprintf(stderr, "%s: layer %u is %u bytes, over %u\n",
+							c.name, l, (uint32_t) ends[l], (uint32_t) target);
+					rc = 1;
+				}
+			} else if (!c.irreversible && psnr != INFINITY) {
+				fprintf(stderr, "%s: lossless layer %u is %.2f dB\n", c.name, l,
+						psnr);
+				rc = 1;
+			}
+		}
+
+		bool all_rates = !c.fixed_quality && c.targets[c.numlayers - 1] > 0;
+		if (all_rates) {
+			std::vector<uint8_t> part1_codestream;
+			std::vector<size_t> part1_ends;
+			double part1_psnr =
+					compress(c, false, part1_codestream, part1_ends) ?
+							decompress_psnr(part1_codestream, c.numlayers,
+									ref) :
+							-1;
+			printf("%-16s Part-1:  %7u bytes %6.2f dB\n", c.name,
+					part1_ends.empty() ? 0 : (uint32_t) part1_ends.back(),
+					part1_psnr);
+			if (part1_psnr < 0) {
+				fprintf(stderr, "%s: Part-1 compress failed\n", c.name);
+				rc = 1;
+			} else if (prev_psnr < part1_psnr - max_part1_shortfall) {
+				fprintf(stderr,
+						"%s: last layer is %.2f dB, too far below the %.2f dB of Part-1\n",
+						c.name, prev_psnr, part1_psnr);
+				rc = 1;
+			}
+		}
+		grk_image_destroy(ref);
+	}
+	grk_deinitialize();
+
+	return rc;
+}
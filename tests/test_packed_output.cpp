@@ -0,0 +1,248 @@
+/*
+ *    Copyright (C) 2016-2020 Grok Image Compression Inc.
+ *
+ *    This source code is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This source code is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ *    Packed output test: code streams are decompressed to the default
+ *    int32_t component planes, and then again to 8 bit, 16 bit and float
+ *    samples, planar and interleaved, in buffers allocated by the library
+ *    or by the caller with padded rows. Every packed sample must match the
+ *    planar sample, no planes may be left in the image, and the row
+ *    padding of the caller's buffer must not be written.
+ */
+
+#include "test_codec_common.h"
+
+struct PackedCase {
+	const char *name;
+	// JP2 file whose last component is alpha, so that the channel
+	// definitions are applied before the samples are packed
+	bool jp2;
+	uint32_t numcomps;
+	uint32_t prec;
+	bool sgnd;
+	bool irreversible;
+	bool tiles;
+	uint32_t reduce;
+	bool region;
+};
+
+static const PackedCase packed_cases[] = {
+	{ "8 bit rgb", false, 3, 8, false, false, false, 0, false },
+	{ "8 bit rgb 9/7 tiles", false, 3, 8, false, true, true, 0, false },
+	{ "8 bit gray", false, 1, 8, false, false, false, 0, false },
+	{ "10 bit 2 comps tiles", false, 2, 10, false, false, true, 0, false },
+	{ "12 bit signed tiles", false, 3, 12, true, false, true, 0, false },
+	{ "12 bit region reduced", false, 3, 12, false, false, true, 1, true },
+	{ "16 bit 5 comps", false, 5, 16, false, false, false, 0, false },
+	{ "8 bit rgba jp2", true, 4, 8, false, false, false, 0, false },
+};
+
+static const GRK_SAMPLE_TYPE sample_types[] = { GRK_SAMPLE_UINT8,
+		GRK_SAMPLE_UINT16, GRK_SAMPLE_FLOAT32 };
+static const uint32_t num_threads[] = { 1, 4 };
+static const uint32_t width = 333;
+static const uint32_t height = 257;
+static const uint32_t area[4] = { 37, 21, 290, 200 };
+static const uint8_t padding = 0xA5;
+
+/**
+ * Decompress a code stream held in memory, in the given output format
+ * @return the decoded image, to be destroyed by the caller, or null
+ */
+static grk_image* decompress(std::vector<uint8_t> &in, GRK_CODEC_FORMAT codec_format,
+		const PackedCase &c, GRK_SAMPLE_TYPE sample_type, bool interleaved,
+		uint64_t stride, std::vector<uint8_t> *buffer) {
+	auto stream = grk_stream_create_mem_stream(in.data(), in.size(), false,
+			true);
+	if (!stream)
+		return nullptr;
+	grk_dparameters parameters;
+	grk_set_default_decoder_parameters(&parameters);
+	parameters.cp_reduce = c.reduce;
+	grk_image *image = nullptr;
+	auto codec = grk_create_decompress(codec_format, stream);
+	bool rc = codec && grk_setup_decoder(codec, &parameters)
+			&& grk_set_output_format(codec, sample_type, interleaved, stride,
+					buffer ? buffer->data() : nullptr,
+					buffer ? buffer->size() : 0)
+			&& grk_read_header(codec, nullptr, &image)
+			&& (!c.region
+					|| grk_set_decode_area(codec, image, area[0], area[1],
+							area[2], area[3]))
+			&& grk_decode(codec, nullptr, image) && grk_end_decompress(codec);
+	grk_stream_destroy(stream);
+	grk_destroy_codec(codec);
+	if (!rc) {
+		grk_image_destroy(image);
+		image = nullptr;
+	}
+
+	return image;
+}
+
+/**
+ * Compare the packed samples of image with the planes of ref
+ * @return false on the first sample that differs
+ */
+static bool same_samples(grk_image *ref, grk_image *image,
+		GRK_SAMPLE_TYPE sample_type, bool interleaved) {
+	uint32_t numcomps = ref->numcomps;
+	uint32_t w = ref->comps->w;
+	uint32_t h = ref->comps->h;
+	uint32_t comps_per_row = interleaved ? numcomps : 1;
+	for (uint32_t compno = 0; compno < numcomps; ++compno) {
+		for (uint32_t y = 0; y < h; ++y) {
+			auto row = image->packed_data
+					+ ((uint64_t) (interleaved ? 0 : compno) * h + y)
+							* image->packed_stride;
+			for (uint32_t x = 0; x < w; ++x) {
+				int32_t v = ref->comps[compno].data[(uint64_t) y * w + x];
+				uint64_t i = (uint64_t) x * comps_per_row
+						+ (interleaved ? compno : 0);
+				bool same;
+				switch (sample_type) {
+				case GRK_SAMPLE_UINT8:
+					same = row[i] == (uint8_t) v;
+					break;
+				case GRK_SAMPLE_UINT16:
+					same = ((const uint16_t*) row)[i] == (uint16_t) v;
+					break;
+				default:
+					same = ((const float*) row)[i] == (float) v;
+					break;
+				}
+				if (!same) {
+					fprintf(stderr, "component %u differs at %u,%u\n",
+							compno, x, y);
+					return false;
+				}
+			}
+		}
+	}
+
+	return true;
+}
+
+int main(int argc, char *argv[]) {
+	(void) argc;
+	(void) argv;
+	int rc = 0;
+
+	for (auto threads : num_threads) {
+		grk_initialize(nullptr, threads);
+		for (auto &c : packed_cases) {
+			auto image = test_make_image(width, height, c.numcomps, c.prec);
+			if (!image) {
+				rc = 1;
+				continue;
+			}
+			for (uint32_t compno = 0; compno < c.numcomps; ++compno) {
+				auto comp = image->comps + compno;
+				if (c.sgnd) {
+					comp->sgnd = 1;
+					for (uint64_t i = 0; i < (uint64_t) comp->w * comp->h; ++i)
+						comp->data[i] -= 1 << (c.prec - 1);
+				}
+			}
+			if (c.jp2) {
+				image->color_space = GRK_CLRSPC_SRGB;
+				image->comps[c.numcomps - 1].alpha = 1;
+			}
+			grk_cparameters parameters;
+			grk_set_default_encoder_parameters(&parameters);
+			parameters.irreversible = c.irreversible;
+			if (c.numcomps >= 3)
+				parameters.tcp_mct = 1;
+			if (c.tiles) {
+				parameters.tile_size_on = true;
+				parameters.cp_tdx = 128;
+				parameters.cp_tdy = 96;
+			}
+			auto codec_format = c.jp2 ? GRK_CODEC_JP2 : GRK_CODEC_J2K;
+			std::vector<uint8_t> codestream;
+			size_t len = test_compress(image, &parameters, codestream,
+					codec_format);
+			grk_image_destroy(image);
+			auto ref =
+					len ? decompress(codestream, codec_format, c,
+									GRK_SAMPLE_INT32, false, 0, nullptr) :
+							nullptr;
+			if (!ref || ref->packed_data) {
+				fprintf(stderr, "%s: planar decode failed\n", c.name);
+				grk_image_destroy(ref);
+				rc = 1;
+				continue;
+			}
+			uint32_t w = ref->comps->w;
+			uint32_t h = ref->comps->h;
+			for (auto sample_type : sample_types) {
+				uint32_t sample_bytes =
+						sample_type == GRK_SAMPLE_UINT8 ? 1 :
+						sample_type == GRK_SAMPLE_UINT16 ? 2 : 4;
+				if (sample_type != GRK_SAMPLE_FLOAT32
+						&& c.prec > sample_bytes * 8)
+					continue;
+				for (uint32_t layout = 0; layout < 4; ++layout) {
+					bool interleaved = layout & 1;
+					bool caller_buffer = layout & 2;
+					uint32_t comps_per_row = interleaved ? c.numcomps : 1;
+					uint64_t row_len = (uint64_t) w * comps_per_row
+							* sample_bytes;
+					uint64_t num_rows = (uint64_t) h
+							* (c.numcomps / comps_per_row);
+					// the caller's rows are padded to an odd stride
+					uint64_t stride = caller_buffer ? row_len + 7 : 0;
+					std::vector<uint8_t> buffer;
+					if (caller_buffer)
+						buffer.resize(stride * num_rows, padding);
+					auto packed = decompress(codestream, codec_format, c,
+							sample_type, interleaved, stride,
+							caller_buffer ? &buffer : nullptr);
+					bool ok = packed && packed->packed_data
+							&& packed->numcomps == ref->numcomps
+							&& packed->comps->w == w && packed->comps->h == h
+							&& (!caller_buffer
+									|| (packed->packed_data == buffer.data()
+											&& !packed->owns_packed_data));
+					for (uint32_t compno = 0; ok && compno < c.numcomps;
+							++compno)
+						ok = !packed->comps[compno].data;
+					ok = ok && same_samples(ref, packed, sample_type,
+									interleaved);
+					for (uint64_t row = 0; ok && caller_buffer && row < num_rows;
+							++row) {
+						for (uint64_t i = row_len; ok && i < stride; ++i)
+							ok = buffer[row * stride + i] == padding;
+					}
+					if (!ok) {
+						fprintf(stderr,
+								"%s: %u bit %s%s output differs from planar output with %u threads\n",
+								c.name, sample_bytes * 8,
+								interleaved ? "interleaved" : "planar",
+								caller_buffer ? " padded" : "", threads);
+						rc = 1;
+					}
+					grk_image_destroy(packed);
+				}
+			}
+			grk_image_destroy(ref);
+		}
+	}
+	grk_deinitialize();
+	if (!rc)
+		printf("packed output matches planar output\n");
+
+	return rc;
+}
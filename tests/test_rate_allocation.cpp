@@ -0,0 +1,132 @@
+/*
+ *    Copyright (C) 2016-2020 Grok Image Compression Inc.
+ *
+ *    This source code is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This source code is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *
+ *    Rate allocation test: wherever the bisect allocators meet the target
+ *    rate of a layer, the incremental allocator (-A 2) must meet it too,
+ *    at a quality close to theirs.
+ *
+ *    Each layer is written to its own tile part, so that the size of the
+ *    codestream up to the end of each layer can be read from the SOT
+ *    markers.
+ */
+
+#include "test_codec_common.h"
+
+struct RateCase {
+	const char *name;
+	uint32_t numcomps;
+	uint32_t prec;
+	bool irreversible;
+	uint32_t numlayers;
+	double rates[4];
+};
+
+static const RateCase rate_cases[] = {
+	{ "rgb lossy", 3, 8, true, 4, { 80, 40, 20, 10 } },
+	{ "rgb lossless", 3, 8, false, 3, { 60, 15, 5 } },
+	{ "gray 12 bit", 1, 12, true, 2, { 30, 6 } },
+	{ "single layer", 3, 8, true, 1, { 25 } },
+};
+
+static const uint32_t width = 512;
+static const uint32_t height = 384;
+// the incremental allocator may lose this much PSNR to the bisect
+// allocators, at the same target rate
+static const double max_psnr_loss = 0.5;
+
+int main(int argc, char *argv[]) {
+	(void) argc;
+	(void) argv;
+	int rc = 0;
+
+	grk_initialize(nullptr, 0);
+	for (auto &c : rate_cases) {
+		auto ref = test_make_image(width, height, c.numcomps, c.prec);
+		if (!ref) {
+			rc = 1;
+			break;
+		}
+		double raw_bytes = (double) width * height * c.numcomps * c.prec / 8;
+		std::vector<size_t> ends[3];
+		double psnr[3][4];
+		for (uint32_t algo = 0; algo < 3; ++algo) {
+			grk_cparameters parameters;
+			grk_set_default_encoder_parameters(&parameters);
+			parameters.irreversible = c.irreversible;
+			parameters.cp_disto_alloc = 1;
+			parameters.tcp_numlayers = c.numlayers;
+			for (uint32_t l = 0; l < c.numlayers; ++l)
+				parameters.tcp_rates[l] = c.rates[l];
+			parameters.prog_order = GRK_LRCP;
+			parameters.tp_on = 1;
+			parameters.tp_flag = 'L';
+			parameters.rateControlAlgorithm = algo;
+			auto image = test_make_image(width, height, c.numcomps, c.prec);
+			std::vector<uint8_t> codestream;
+			if (!image || !test_compress(image, &parameters, codestream)
+					|| !test_tile_part_ends(codestream, ends[algo])
+					|| ends[algo].size() != c.numlayers) {
+				fprintf(stderr, "%s: compress failed with allocator %u\n",
+						c.name, algo);
+				grk_image_destroy(image);
+				rc = 1;
+				continue;
+			}
+			grk_image_destroy(image);
+			for (uint32_t l = 0; l < c.numlayers; ++l) {
+				grk_dparameters dparameters;
+				grk_set_default_decoder_parameters(&dparameters);
+				dparameters.cp_layer = l + 1;
+				auto decoded = test_decompress(codestream, &dparameters,
+						nullptr);
+				psnr[algo][l] = decoded ? test_psnr(ref, decoded) : -1;
+				grk_image_destroy(decoded);
+			}
+		}
+		grk_image_destroy(ref);
+		if (rc)
+			continue;
+
+		for (uint32_t l = 0; l < c.numlayers; ++l) {
+			size_t target = (size_t) (raw_bytes / c.rates[l]);
+			printf("%-13s layer %u target %7u:", c.name, l, (uint32_t) target);
+			for (uint32_t algo = 0; algo < 3; ++algo)
+				printf("  -A %u %7u %6.2f dB", algo, (uint32_t) ends[algo][l],
+						psnr[algo][l]);
+			printf("\n");
+			for (uint32_t algo = 0; algo < 2; ++algo) {
+				if (ends[algo][l] > target)
+					continue;
+				if (ends[2][l] > target) {
+					fprintf(stderr,
+							"%s: layer %u is %u bytes with -A 2, over the target %u that -A %u meets\n",
+							c.name, l, (uint32_t) ends[2][l], (uint32_t) target,
+							algo);
+					rc = 1;
+				}
+				if (psnr[2][l] < psnr[algo][l] - max_psnr_loss) {
+					fprintf(stderr,
+							"%s: layer %u is %.2f dB with -A 2, against %.2f dB with -A %u\n",
+							c.name, l, psnr[2][l], psnr[algo][l], algo);
+					rc = 1;
+				}
+			}
+		}
+	}
+	grk_deinitialize();
+
+	return rc;
+}